@@ -5,6 +5,15 @@ CONFIG += hardening
 
 include(config.pri)
 
+# The encryption layer uses huSB on device and OpenSSL everywhere else (see SFCryptoBackend.h).
+# Add SF_CRYPTO_OPENSSL to DEFINES to also build the OpenSSL backend on device.
+!device:!simulator {
+    LIBS += -lcrypto
+}
+contains(DEFINES, SF_CRYPTO_OPENSSL) {
+    LIBS += -lcrypto
+}
+
 device {
     CONFIG(debug, debug|release) {
         # Device-Debug custom configuration
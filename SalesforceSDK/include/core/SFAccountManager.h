@@ -23,6 +23,7 @@
 #define SFACCOUNTMANAGER_H_
 
 #include <qobject.h>
+#include <QAtomicPointer>
 #include <QList>
 #include <QString>
 #include <bb/cascades/WebView>
@@ -67,7 +68,7 @@ private:
 	SFIdentityCoordinator* mIdCoordinator;
 
 protected:
-	static SFAccountManager * sharedInstance;
+	static QAtomicPointer<SFAccountManager> sharedInstance;
 
 public:
 	/*!
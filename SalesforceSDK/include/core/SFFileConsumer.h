@@ -0,0 +1,75 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFFileConsumer.h
+*/
+
+
+#ifndef SFFILECONSUMER_H_
+#define SFFILECONSUMER_H_
+
+#include <QFile>
+#include "SFResponseConsumer.h"
+
+namespace sf {
+
+/*!
+ * @class SFFileConsumer
+ * @headerfile SFFileConsumer.h <core/SFFileConsumer.h>
+ *
+ * @brief A @c SFResponseConsumer that writes the body of the response to a file as it downloads.
+ *
+ * @details
+ * The file is truncated when a response begins, so a re-tried request doesn't append to the body of the previous attempt.
+ * In append mode, it is truncated back to the size it had before the first response instead, which is how the pages of a CSV document
+ * are concatenated into a single file. The result is the name of the file. Useful for large bodies that are read back later, e.g. the results of a bulk job:
+ * @code
+ * request->setResponseConsumer(new SFFileConsumer(QDir::tempPath() + "/accounts.csv"));
+ * @endcode
+ */
+class SFFileConsumer : public SFResponseConsumer {
+public:
+	/*! @param fileName the file to write, created if it doesn't exist */
+	explicit SFFileConsumer(const QString & fileName);
+	virtual ~SFFileConsumer();
+
+	bool begin(int statusCode, const QByteArray & contentType);
+	bool consume(const QByteArray & chunk);
+	bool finish();
+	QVariant result() const { return mFile.fileName(); }; /*!< @return the name of the file */
+	QString errorString() const { return mError; };
+
+	qint64 size() const { return mSize; }; /*!< @return the number of bytes written so far */
+	bool append() const { return mAppend; }; /*!< @return whether the body is appended to the file */
+	void setAppend(bool append) { mAppend = append; }; /*!< @param append whether to append the body to the file. @b Default: false */
+	bool skipFirstLine() const { return mSkipFirstLine; }; /*!< @return whether the first line of the body is dropped */
+	void setSkipFirstLine(bool skip) { mSkipFirstLine = skip; }; /*!< @param skip whether to drop the first line of the body, e.g. a CSV header already in the file. @b Default: false */
+
+private:
+	Q_DISABLE_COPY(SFFileConsumer)
+
+	QFile mFile;
+	qint64 mSize;
+	qint64 mStartOffset; //the size of the file before the first response, -1 until then
+	bool mAppend;
+	bool mSkipFirstLine;
+	bool mInFirstLine;
+	QString mError;
+
+	bool fail();
+};
+
+} /* namespace sf */
+#endif /* SFFILECONSUMER_H_ */
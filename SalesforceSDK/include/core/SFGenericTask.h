@@ -157,6 +157,9 @@ protected:
 	virtual TaskStatus execute() = 0;
 	virtual void cleanup(); /*!< Called after the @c execute(). The base implementation is responsible to clean up the memory, re-try and emit signals. Subclass should always call base.*/
 	virtual bool retry(); /*!< Called when retry is necessary. This function is responsible to reset the task for re-start. @return whether the task is re-started.*/
+	/*! Called by @c cleanup() when the task will not be re-started. The base implementation emits @c taskResultReady() and @c taskFinished(),
+	 * then deletes the task later. Subclass may override it to deliver the result in another thread.*/
+	Q_INVOKABLE virtual void finish();
 
 	/*! This is a convenient function to push the object to task object's thread and set the task object as the parent. After calling this function.
 	 * it's safe to remove references to the given object without potential memory leak. @note This function is usually called in execution thread, and the
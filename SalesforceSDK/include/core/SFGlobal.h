@@ -26,6 +26,7 @@
 #include <QDebug>
 
 class QNetworkAccessManager;
+class QThreadPool;
 
 /*! @namespace sf
  * @brief The namespace of Blackberry 10 SDK for Salesforce */
@@ -36,6 +37,9 @@ extern const QString SFMobileSDKNativeDesignator; //!< "Native"
 extern const QString kSFRestRequestTag; //!< The key used to retrieve tag object carried in @c SFResult
 extern const QString kSFOAuthError; //!< The key for oAuth error in response
 extern const QString kSFOAuthErrorDescription; //!< The key for oAuth error description in response
+extern const QString kSFTaskEventLoopHopsTag; //!< The key for the number of queued event loop round trips a network task went through, carried in @c SFResult
+extern const QString kSFTaskThreadSwitchesTag; //!< The key for the number of times a network task moved to another thread, carried in @c SFResult
+extern const QString kSFResponseHeadersTag; //!< The key for the response headers a network task was asked to capture, as a @c QVariantMap, carried in @c SFResult
 
 /*
  * Macros for logging
@@ -105,7 +109,7 @@ public:
 		SFRestStatusSuccessCreated = 201, //!< HTTP 201. Created
 		SFRestStatusSuccessNoContent = 204, //!< HTTP 204. Success, and response body is empty.
 		SFRestStatusMultiRecords = 300, //!< HTTP 300. Found multiple records match the given criteria.
-		SFRestStatusNoChanges = 304, //!< HTTP 304. No changes since the given date and time.
+		SFRestStatusNoChanges = 304, //!< HTTP 304. No changes since the given date and time. Reported as a success, see @c SFRestRequest::conditional.
 		SFRestStatusBadData = 400, //!< HTTP 400. Bad request. The request cannot be understood.
 		SFRestStatusInvalidSession = 401, //!< HTTP 401. The session has been expired.
 		SFRestStatusRefused = 403, //!< HTTP 403. The request has been refused, possibly due to insufficient permission.
@@ -117,15 +121,44 @@ public:
 };
 typedef enum SFResultCode::Type SFResultCodeType; //!< @c SFResultCode::Type
 
+/*! @headerfile SFGlobal.h <core/SFGlobal.h>
+ * @brief Scheduling priority of a request. Smaller values are served first. @see SFRequestScheduler, SFRestRequest */
+class SFRequestPriority : public QObject {
+	Q_OBJECT
+	Q_ENUMS(Type)
+public:
+	enum Type {
+		AuthCritical = 0, //!< Authentication traffic such as token refresh. Jumps the queue and ignores concurrency limits. Reserved for the SDK.
+		Interactive = 1, //!< A user is waiting for the result. The default.
+		Prefetch = 2, //!< Data that will likely be needed soon.
+		BackgroundSync = 3 //!< Bulk synchronization. Never delays interactive requests.
+	};
+};
+typedef enum SFRequestPriority::Type SFRequestPriorityType; //!< @c SFRequestPriority::Type
+
 /*
  * Global Function
  */
 /*! Register necessary meta types for the SDK to be accessible from QML */
 void sfRegisterMetaTypes();
 
-/*! Get a shared instance of @c QNetworkAccessManager. The object is created and configured when the first time being called. */
+/*! Get a shared instance of @c QNetworkAccessManager. The object lives in the SDK's network thread (see @c SFNetworkThread),
+ * which is started the first time this function is called. Pass it to @c SFNetworkAccessTask rather than calling it directly,
+ * it must only be used from the network thread. */
 QNetworkAccessManager* getSharedNetworkAccessManager();
 
+/*! Get the thread pool dedicated to parsing responses, so that it doesn't compete with the application's work in
+ * @c QThreadPool::globalInstance(). The pool is created when the first time being called. */
+QThreadPool* getSharedParsingThreadPool();
+
+/*! Parse the date (e.g. "2013-05-01") and date/time (e.g. "2013-05-01T12:30:00.000+0000") formats of the REST API. This is much
+ * faster than @c QDateTime::fromString(), which also doesn't understand the time zone offsets used by the API.
+ * @param text the text to parse
+ * @param dateOnly whether the text is a date rather than a date/time
+ * @param msecs receives the time in milliseconds since the epoch, in UTC. A date is midnight UTC.
+ * @return whether the text is valid */
+bool sfParseIsoDateTime(const QString & text, bool dateOnly, qint64 * msecs);
+
 } /* namespace rest */
 
 #endif /* SFCONSTANTS_H_ */
@@ -26,12 +26,17 @@
 #include <QtNetwork/QNetworkRequest>
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QNetworkAccessManager>
+#include <QSharedPointer>
+#include <QStringList>
 #include "SFGlobal.h"
 
 class QTimer;
 
 namespace sf {
 
+class SFResponseConsumer;
+class SFResponseStream;
+
 /*!
  * @class SFNetworkAccessTask
  * @headerfile SFNetworkAccessTask.h <core/SFNetworkAccessTask.h>
@@ -42,6 +47,15 @@ namespace sf {
  * The class is implemented using Finite-State-Machine(FSM) approach and is capable of running any response processing
  * in a separated thread from QThreadPool.
  *
+ * When started, the task moves itself to the thread of its @c QNetworkAccessManager (the SDK's @c SFNetworkThread for the shared
+ * instance) and runs its whole FSM there. When it is done, it moves back to the thread that started it, where
+ * @c taskResultReady() and @c taskFinished() are emitted. Consecutive states that don't wait for anything run inline, and
+ * the number of event loop round trips and thread switches a task went through is reported in the result's tags
+ * under @c kSFTaskEventLoopHopsTag and @c kSFTaskThreadSwitchesTag.
+ *
+ * If a @c SFResponseConsumer is set, the body of a successful response is read as it arrives and fed to the consumer chunk by chunk
+ * in the parsing pool, instead of being buffered in the @c QNetworkReply until the download completes.
+ *
  * Usage
  * ------
  * For most REST requests with Force.com, developer should use @c SFRestResourceTask which is a subclass of this. However, this class
@@ -85,7 +99,7 @@ namespace sf {
  * Typically, for any Force.com REST API, you should use @c SFRestResourceTask. In addition, the source code of @c SFRestResourceTask
  * provides a good example of subclassing @c SFNetworkAccessTask. You can add your custom logic by overriding following
  * functions:
- * - @c prepare() called as soon as the task is started. The function is executed in main thread (or the thread this task belongs to)
+ * - @c prepare() called as soon as the task is started. The function is executed in the thread that started the task.
  *
  * - @c cleanup() called when the task is finished and ready to deliver the result. The base class implementation does the memory cleanup
  * and emits signals in proper order. This function also attempt to re-try if enabled. So please call base class implementation at the end of your custom logic.
@@ -94,14 +108,15 @@ namespace sf {
  * - @c retry() called when auto re-try is triggered. This function reset the task and cleanup memory allocated during the operation.
  * This function is invoked from @c cleanup(), so it can be executed in any thread.
  *
- * - @c ensureRequest() called before the request is sent. It is executed only in the task's owning thread. Please see @c ensureRequest()
- * for possible returned states.
+ * - @c ensureRequest() called before the request is sent. It is executed in the thread that started the task, before the task moves
+ * to the network thread, so it may read the session and other objects of that thread. Please see @c ensureRequest() for possible returned states.
  *
- * - @c preprocessReply(QNetworkReply*) called when each @c QNetworkReply finished. It is executed only in the task's owning thread.
+ * - @c preprocessReply(QNetworkReply*) called when each @c QNetworkReply finished. It is executed only in the network thread.
  * The main responsibility of this function is to handles HTTP redirect or caching. Please see @c preprocessReply(QNetworkReply*)
  * for possible returned states.
  *
- * - @c processReply(QNetworkReply*) called when the reply is ready to be processed. The function is always executed in a separate thread.
+ * - @c processReply(QNetworkReply*) called when the reply is ready to be processed. The function is always executed in a thread of
+ * @c getSharedParsingThreadPool(), replies of tasks with higher priority are processed first.
  * Please see @c processReply(QNetworkReply*) for possible returned states.
  *
  * @see SFResult, SFGenericTask, SFRestResourceTask
@@ -113,6 +128,9 @@ class SFNetworkAccessTask : public sf::SFGenericTask {
 private slots:
 	void onReplyFinished();
 	void onNetworkTimeout();
+	void onReplyReadyRead();
+	void onReplyProgress(qint64 done, qint64 total);
+	void resumeReading();
 signals:
 	void taskWillRetry(); /*!< Emitted before the task re-start itself. */
 	void taskDidRetry(); /*!< Emitted after the task re-start itself. */
@@ -139,6 +157,9 @@ public:
 	 * @param resultReceiver The object that handles the result
 	 * @param resultReceiverSlot The slot description string. Should be a string generated using macro SLOT() */
 	Q_INVOKABLE void startTaskAsync(QObject* resultReceiver = NULL, const char * resultReceiverSlot = NULL);
+	/*! Request to cancel the task. A reply being downloaded is aborted right away, the result is then a cancel result.
+	 * Has no effect if @c SFGenericTask::cancellable is false. */
+	Q_INVOKABLE void cancel();
 
 	/* Accessors */
 	/*! @return the @c QNetworkRequest instance */
@@ -175,6 +196,25 @@ public:
 	 * @c QIODevice will clear any @c QByteArray assigned earlier via @c setRequestBytesArray() */
 	void setRequestData(QIODevice * data);
 
+	/*! @return the scheduling priority of the task. @see SFRequestScheduler */
+	SFRequestPriorityType priority() const { return this->mPriority;};
+	/*! Set the scheduling priority of the task. It decides when @c SFRequestScheduler starts the task and the order in which
+	 * replies are processed in the parsing pool. @b Default: @c SFRequestPriority::Interactive */
+	void setPriority(SFRequestPriorityType priority) { this->mPriority = priority;};
+
+	/*! @return the consumer the response body is streamed to, or NULL if the body is buffered. @see setResponseConsumer() */
+	SFResponseConsumer *responseConsumer() { return this->mResponseConsumer;};
+	/*! Stream the body of successful responses to the given consumer instead of buffering it. The task doesn't take ownership,
+	 * the consumer must outlive the task. The payload of the result is @c SFResponseConsumer::result().
+	 * @param consumer the consumer, or NULL to buffer the body */
+	void setResponseConsumer(SFResponseConsumer *consumer) { this->mResponseConsumer = consumer;};
+
+	/*! @return the names of the response headers copied into the result. @see setCapturedResponseHeaders() */
+	const QStringList & capturedResponseHeaders() const { return this->mCapturedResponseHeaders;};
+	/*! Copy the given response headers, when present, into the result's tags under @c kSFResponseHeadersTag.
+	 * @param names the names of the headers, e.g. "ETag" */
+	void setCapturedResponseHeaders(const QStringList & names) { this->mCapturedResponseHeaders = names;};
+
 protected:
 	/*! Possible states of the task */
 	enum NetworkTaskState {
@@ -200,6 +240,10 @@ protected:
 	bool mUseCache; /*!< Whether should use cache if possible */
 	unsigned long int mNetworkTimeout; /*!< The network timeout in milliseconds */
 	QTimer *mNetworkTimer; /*!< Holds a timer for current executing network  */
+	QThread *mOwnerThread; /*!< The thread the task lived in when it was first started. The result is delivered in this thread. */
+	SFRequestPriorityType mPriority; /*!< The scheduling priority of the task */
+	SFResponseConsumer *mResponseConsumer; /*!< The consumer the response body is streamed to, not owned */
+	QStringList mCapturedResponseHeaders; /*!< The names of the response headers copied into the result */
 
 	/*! Main entry point for separate thread execution. Subclass should not call this function directly. */
 	void run();
@@ -214,6 +258,8 @@ protected:
 	/*! Responsible to reset the task. Subclass should not call this function directly.
 	 * Please see @ref SFNetworkAccessTask_Subclass "Subclassing Notes" for more details. */
 	virtual bool retry();
+	/*! Hand the task back to the thread that started it and deliver the result there. Subclass should not call this function directly. */
+	virtual void finish();
 
 	/*! Prepare and validate current request
 	 * @return The state of the task:
@@ -243,6 +289,19 @@ protected:
 	 * 	Please see @ref SFNetworkAccessTask_Subclass "Subclassing Notes" for more details. */
 	virtual NetworkTaskState processReply(QNetworkReply * reply);
 
+	/*! @return whether the body of the current reply has been streamed to @c responseConsumer(). If so, the reply holds at
+	 * most the tail of the body and @c processReply(QNetworkReply*) should call @c finishResponseStream(). */
+	bool isResponseStreamed() const { return !this->mResponseStream.isNull();};
+	/*! Feed what is left of the body to the consumer and wait until it has processed everything. Must be called from
+	 * @c processReply(QNetworkReply*).
+	 * @return The state of the task:
+	 * 	+ @c SFNetworkAccessTask::StateFinished indicates that the consumer processed the whole body, its result is ready.
+	 * 	+ @c SFNetworkAccessTask::StateError indicates that the download broke off or the consumer failed. @c SFGenericTask::mResult
+	 * 	is created with the error. */
+	NetworkTaskState finishResponseStream(QNetworkReply * reply);
+	/*! Stop feeding @c responseConsumer(), chunks still queued are dropped. A subclass that owns its consumer calls it before deleting it. */
+	void closeResponseStream();
+
 	//debug
 	/*! Convenient function for debug purpose. Generate a nice formated summary of given reply's headers */
 	QString composeReplyHeader(QNetworkReply * reply);
@@ -250,7 +309,13 @@ protected:
 	QString stateDescription(NetworkTaskState state);
 
 private:
-	Q_INVOKABLE void moveQObjectsToThread(QThread *thread);
+	int mEventLoopHops;
+	int mThreadSwitches;
+	QSharedPointer<SFResponseStream> mResponseStream;
+
+	void readResponseStream();
+	void moveQObjectsToThread(QThread *thread);
+	void queueInvocation(const char * method);
 	Q_INVOKABLE void fsmDispatcher();
 	NetworkTaskState initiateNetworkAccess();
 	QNetworkReply * createReplyAndExit();
@@ -0,0 +1,72 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFNetworkThread.h
+*/
+
+#ifndef SFNETWORKTHREAD_H_
+#define SFNETWORKTHREAD_H_
+
+#include <QThread>
+#include <QSemaphore>
+
+class QNetworkAccessManager;
+
+namespace sf {
+
+/*!
+ * @class SFNetworkThread
+ * @headerfile SFNetworkThread.h <core/SFNetworkThread.h>
+ *
+ * @brief A singleton thread with its own event loop that performs all the network I/O of the SDK.
+ *
+ * @details
+ * The thread owns the shared @c QNetworkAccessManager returned by @c getSharedNetworkAccessManager(). Every @c SFNetworkAccessTask
+ * moves itself to this thread when it is started, so preparing requests, sending them, timeouts and redirects never
+ * run on the application's UI thread. Only the final result is handed back to the thread that started the task.
+ *
+ * The thread is started the first time it is used and stopped when the application is about to quit.
+ */
+class SFNetworkThread : public QThread {
+	Q_OBJECT
+
+public:
+	/*!
+	 * @return the singleton instance. The thread is running when this function returns.
+	 */
+	static SFNetworkThread* instance();
+	/*!
+	 * @return the @c QNetworkAccessManager that lives in this thread. It must only be used from this thread.
+	 */
+	QNetworkAccessManager* networkAccessManager() { return mNetworkAccessManager; };
+
+public slots:
+	/*! Stop the event loop and wait for the thread to finish. */
+	void stop();
+
+protected:
+	void run();
+
+private:
+	static SFNetworkThread* sharedInstance;
+	QNetworkAccessManager* mNetworkAccessManager;
+	QSemaphore mReady;
+
+	SFNetworkThread();
+	virtual ~SFNetworkThread();
+};
+
+} /* namespace sf */
+#endif /* SFNETWORKTHREAD_H_ */
@@ -0,0 +1,109 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRequestScheduler.h
+*/
+
+#ifndef SFREQUESTSCHEDULER_H_
+#define SFREQUESTSCHEDULER_H_
+
+#include <QObject>
+#include <QAtomicPointer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "SFGlobal.h"
+
+namespace sf {
+
+class SFGenericTask;
+class SFNetworkAccessTask;
+
+/*!
+ * @class SFRequestScheduler
+ * @headerfile SFRequestScheduler.h <core/SFRequestScheduler.h>
+ *
+ * @brief A singleton that decides when network tasks are started, based on their priority and on the number of requests
+ * already in flight to the same host.
+ *
+ * @details
+ * Tasks are queued per @c SFRequestPriority::Type and started as soon as their host has a free slot:
+ * - @c SFRequestPriority::AuthCritical tasks are started immediately, regardless of any limit.
+ * - @c SFRequestPriority::Interactive tasks may use all @c maxRequestsPerHost() slots of a host.
+ * - @c SFRequestPriority::Prefetch and @c SFRequestPriority::BackgroundSync tasks never use the last
+ * @c reservedInteractiveSlots() slots of a host, so an interactive request never waits behind bulk traffic. The two classes
+ * share the remaining slots with a weighted round robin, two prefetch tasks for every background task.
+ *
+ * A queued task whose host is busy doesn't hold back tasks to other hosts queued behind it. A task keeps its slot until it
+ * emits @c SFGenericTask::taskFinished(), including while it re-tries. The scheduler lives in the thread that first calls
+ * @c instance() and must only be used from that thread, usually the application's main thread.
+ *
+ * @see SFRestAPI, SFNetworkAccessTask::setPriority()
+ */
+class SFRequestScheduler : public QObject {
+	Q_OBJECT
+
+public:
+	/*!
+	 * @return the singleton instance. This function is thread-safe.
+	 */
+	static SFRequestScheduler* instance();
+
+	/*! Queue the task and start it as soon as its priority and host allow. The task must not be started yet.
+	 * The result receiver should be connected to @c SFGenericTask::taskResultReady() before calling this function.
+	 * @param task the task to schedule, its priority is read from @c SFNetworkAccessTask::priority()
+	 * @param host the host the concurrency limit applies to. If empty, the host of the task's request URL is used. */
+	void submit(SFNetworkAccessTask *task, const QString & host = QString());
+	/*! @return whether the task was started by the scheduler and hasn't finished yet */
+	bool isRunning(SFNetworkAccessTask *task) const;
+
+	/*! @return the maximum number of requests in flight to a single host. @b Default: 6 */
+	int maxRequestsPerHost() const { return mMaxRequestsPerHost; };
+	/*! Set the maximum number of requests in flight to a single host. */
+	void setMaxRequestsPerHost(int count);
+	/*! @return the number of slots per host that only interactive tasks may use. @b Default: 2 */
+	int reservedInteractiveSlots() const { return mReservedInteractiveSlots; };
+	/*! Set the number of slots per host that only interactive tasks may use. Prefetch and background tasks always keep at least one slot. */
+	void setReservedInteractiveSlots(int count);
+
+private slots:
+	void onTaskFinished(sf::SFGenericTask *task);
+	void onTaskDestroyed(QObject *task);
+
+private:
+	struct Entry {
+		SFNetworkAccessTask *task;
+		QString host;
+	};
+
+	static QAtomicPointer<SFRequestScheduler> sharedInstance;
+	QList<Entry> mQueues[SFRequestPriority::BackgroundSync + 1];
+	QHash<QObject*, QString> mRunning;
+	QHash<QString, int> mInFlight;
+	int mMaxRequestsPerHost;
+	int mReservedInteractiveSlots;
+	int mBulkTurn;
+
+	SFRequestScheduler();
+	virtual ~SFRequestScheduler();
+
+	void schedule();
+	bool startNext(SFRequestPriorityType priority, int limit);
+	void start(const Entry & entry);
+	void release(QObject *task);
+};
+
+} /* namespace sf */
+#endif /* SFREQUESTSCHEDULER_H_ */
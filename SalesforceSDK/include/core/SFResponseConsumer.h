@@ -0,0 +1,73 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFResponseConsumer.h
+*/
+
+#ifndef SFRESPONSECONSUMER_H_
+#define SFRESPONSECONSUMER_H_
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+namespace sf {
+
+/*!
+ * @class SFResponseConsumer
+ * @headerfile SFResponseConsumer.h <core/SFResponseConsumer.h>
+ *
+ * @brief An interface for processing the body of a successful HTTP response chunk by chunk, while it is still being downloaded.
+ *
+ * @details
+ * When a consumer is set on a @c SFNetworkAccessTask (or on a @c SFRestRequest), the task reads the reply as soon as
+ * data arrives, with a bounded read buffer, and feeds the chunks to the consumer in a thread of @c getSharedParsingThreadPool().
+ * The whole body is never held in memory at once, and processing overlaps with the download. When the consumer falls behind by
+ * about a megabyte, the task stops reading until it has caught up, which slows the download down instead of queuing the body.
+ *
+ * Only 2xx responses are streamed. Error responses and redirects are handled by the task as usual.
+ *
+ * The calls are never concurrent but may happen in different threads, in this order:
+ * - @c begin() once per response, in the network thread. A task that re-tries or follows a redirect calls it again,
+ * so the implementation must discard anything from a previous response.
+ * - @c consume() for every chunk, in a pool thread.
+ * - @c finish() once the whole body is consumed, in a pool thread. Not called if the transfer failed.
+ *
+ * The task reads @c result() and @c errorString() after @c finish() returns.
+ */
+class SFResponseConsumer {
+public:
+	virtual ~SFResponseConsumer() {};
+
+	/*! Called before the first chunk of a response.
+	 * @param statusCode the HTTP status code of the response
+	 * @param contentType the value of the Content-Type header
+	 * @return false to refuse the response. The task then fails with @c errorString(). */
+	virtual bool begin(int statusCode, const QByteArray & contentType) = 0;
+	/*! Process the next chunk of the body.
+	 * @param chunk the bytes received since the previous call
+	 * @return false to abort. The remaining chunks are dropped and the task fails with @c errorString(). */
+	virtual bool consume(const QByteArray & chunk) = 0;
+	/*! Called after the last chunk.
+	 * @return false if the body is incomplete or invalid. The task then fails with @c errorString(). */
+	virtual bool finish() = 0;
+	/*! @return the value delivered as @c SFResult::payload() when the response is processed successfully */
+	virtual QVariant result() const = 0;
+	/*! @return a description of the last error */
+	virtual QString errorString() const = 0;
+};
+
+} /* namespace sf */
+#endif /* SFRESPONSECONSUMER_H_ */
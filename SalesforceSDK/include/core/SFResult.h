@@ -58,6 +58,7 @@ class SFResult: public QObject {
 	friend class SFGenericTask;
 	friend class SFRestResourceTask;
 	friend class SFNetworkAccessTask;
+	friend class SFCollectionTask;
 public:
 	/*! Task's result code */
 	enum TaskResult {
@@ -140,12 +141,12 @@ private:
 	QVariantHash mTags;
 	QVariant mPayload;
 
-	/*conversion: common Qt data types*/
+	/*conversion: common Qt data types. A payload such as SFJsonView, SFRecordBatch or SFDecodedRecords is decoded first when it isn't what is asked for*/
 	template<class T>
 	class QVariantConverter {
 	public:
 		static inline T convert(const QVariant & payload) {
-			return payload.value<T>();
+			return payload.canConvert<T>() ? payload.value<T>() : materialize(payload).value<T>();
 		}
 	};
 	/*conversion: pointer types*/
@@ -167,6 +168,8 @@ private:
 		static inline void * doConvert(const QVariant & payload, void *) {return payload.value<void*>();};
 	};
 
+	static QVariant materialize(const QVariant & payload);
+
 private:
 };
 
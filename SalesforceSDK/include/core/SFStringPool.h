@@ -0,0 +1,63 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFStringPool.h
+*/
+
+#ifndef SFSTRINGPOOL_H_
+#define SFSTRINGPOOL_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+namespace sf {
+
+/*!
+ * @class SFStringPool
+ * @headerfile SFStringPool.h <core/SFStringPool.h>
+ *
+ * @brief A table of interned strings, so that equal strings decoded many times share a single implicitly shared @c QString.
+ *
+ * @details
+ * The JSON parsers of the SDK use one pool per response for the keys of objects. Every record of a query repeats the same
+ * keys, so with a pool each key is decoded and allocated once instead of once per record.
+ *
+ * Only short strings are interned and the pool stops growing after @c maxSize() entries, so documents whose keys are all
+ * different, such as maps keyed by record ID, don't make it grow without bound. The pool is not thread safe.
+ */
+class SFStringPool {
+public:
+	/*! @param maxSize the maximum number of strings kept in the pool */
+	explicit SFStringPool(int maxSize = 4096);
+
+	/*! @param utf8 the UTF-8 bytes of the string
+	 * @param size the number of bytes
+	 * @return the interned string, or a new one if the string can't be interned */
+	QString intern(const char *utf8, int size);
+	/*! @return the interned string equal to @a bytes */
+	QString intern(const QByteArray & bytes) { return this->intern(bytes.constData(), bytes.size()); };
+
+	void clear(); /*!< Forget all strings */
+	int size() const { return mStrings.size(); }; /*!< @return the number of strings in the pool */
+	int maxSize() const { return mMaxSize; }; /*!< @return the maximum number of strings kept in the pool */
+
+private:
+	QHash<QByteArray, QString> mStrings;
+	int mMaxSize;
+};
+
+} /* namespace sf */
+#endif /* SFSTRINGPOOL_H_ */
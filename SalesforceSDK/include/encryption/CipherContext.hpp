@@ -0,0 +1,37 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef CIPHERCONTEXT_HPP_
+#define CIPHERCONTEXT_HPP_
+
+#include <QByteArray>
+
+namespace sf{
+
+/*
+ * A prepared AES-128-CBC context created by a SFCryptoBackend. It holds the key schedule so that it can be reused
+ * for any number of messages. No padding is applied, the input must be a multiple of the block size.
+ * A context must only be used by one thread at a time.
+ */
+class CipherContext {
+public:
+	virtual ~CipherContext() {}
+
+	virtual bool isValid() = 0;
+	virtual bool crypt(bool isEncrypt, const QByteArray & iv, const QByteArray & in, QByteArray & out) = 0;
+};
+
+}
+#endif /* CIPHERCONTEXT_HPP_ */
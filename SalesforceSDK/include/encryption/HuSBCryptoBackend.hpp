@@ -0,0 +1,53 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef HUSBCRYPTOBACKEND_HPP_
+#define HUSBCRYPTOBACKEND_HPP_
+
+#include <QAtomicPointer>
+#include <QMutex>
+
+#include "SFCryptoBackend.h"
+#include "GlobalContext.hpp"
+
+namespace sf{
+
+class DRBG;
+
+/*
+ * The BlackBerry huSB (Certicom Security Builder) backend, only available on device.
+ */
+class HuSBCryptoBackend : public SFCryptoBackend {
+public:
+	static HuSBCryptoBackend* instance(); //thread-safe
+
+	virtual QString name() const;
+	virtual CipherContext* createCipherContext(const QByteArray & key);
+	virtual bool randomBytes(QByteArray & buffer);
+	virtual QByteArray sha256(const QByteArray & data);
+
+private:
+	static QAtomicPointer<HuSBCryptoBackend> sharedInstance;
+	//guards the global context shared by the random generator and the digests
+	QMutex mLock;
+	GlobalContext mGlobalContext;
+	DRBG* mDrbg;
+
+	HuSBCryptoBackend();
+	virtual ~HuSBCryptoBackend();
+};
+
+}
+#endif /* HUSBCRYPTOBACKEND_HPP_ */
@@ -0,0 +1,46 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef OPENSSLCRYPTOBACKEND_HPP_
+#define OPENSSLCRYPTOBACKEND_HPP_
+
+#include <QAtomicPointer>
+
+#include "SFCryptoBackend.h"
+
+namespace sf{
+
+/*
+ * The OpenSSL backend. It goes through the EVP interface, so AES-NI (or the ARMv8 crypto extensions) is used
+ * whenever the CPU supports it. Used off-device, and on device when built with SF_CRYPTO_OPENSSL.
+ */
+class OpenSSLCryptoBackend : public SFCryptoBackend {
+public:
+	static OpenSSLCryptoBackend* instance(); //thread-safe
+
+	virtual QString name() const;
+	virtual CipherContext* createCipherContext(const QByteArray & key);
+	virtual bool randomBytes(QByteArray & buffer);
+	virtual QByteArray sha256(const QByteArray & data);
+
+private:
+	static QAtomicPointer<OpenSSLCryptoBackend> sharedInstance;
+
+	OpenSSLCryptoBackend();
+	virtual ~OpenSSLCryptoBackend();
+};
+
+}
+#endif /* OPENSSLCRYPTOBACKEND_HPP_ */
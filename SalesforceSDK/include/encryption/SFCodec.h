@@ -0,0 +1,59 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef SFCODEC_H_
+#define SFCODEC_H_
+
+#include <QByteArray>
+
+namespace sf {
+
+/*!
+ * @class SFCodec
+ * @headerfile SFCodec.h <encryption/SFCodec.h>
+ *
+ * @brief Table driven hex and base64 codecs.
+ *
+ * @details
+ * The output is allocated once and filled through lookup tables, two output bytes per input byte for hex
+ * and four per three for base64, instead of appending one character at a time.
+ */
+class SFCodec {
+public:
+	/*!
+	 * @return the lower case hex encoding of the data
+	 */
+	static QByteArray toHex(const QByteArray & in);
+	/*!
+	 * Decode hex. Upper and lower case are accepted, as well as the ' ', ':' and '.' separators.
+	 * @return false if the input is empty or not valid hex, in which case @a out is cleared
+	 */
+	static bool fromHex(const QByteArray & in, QByteArray & out);
+	/*!
+	 * @return the standard, padded base64 encoding of the data
+	 */
+	static QByteArray toBase64(const QByteArray & in);
+	/*!
+	 * Decode standard base64, with or without padding. Whitespace is ignored.
+	 * @return false if the input is not valid base64, in which case @a out is cleared
+	 */
+	static bool fromBase64(const QByteArray & in, QByteArray & out);
+
+private:
+	SFCodec() {}
+};
+
+} /* namespace sf */
+#endif /* SFCODEC_H_ */
@@ -0,0 +1,86 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef SFCRYPTOBACKEND_H_
+#define SFCRYPTOBACKEND_H_
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+/*
+ * The backends compiled into the library. By default the huSB backend is used on device and the OpenSSL backend
+ * everywhere else. Define both SF_CRYPTO_HUSB and SF_CRYPTO_OPENSSL to build both on device.
+ */
+#if !defined(SF_CRYPTO_HUSB) && !defined(SF_CRYPTO_OPENSSL)
+#if defined(__QNX__)
+#define SF_CRYPTO_HUSB
+#else
+#define SF_CRYPTO_OPENSSL
+#endif
+#endif
+
+namespace sf {
+
+class CipherContext;
+
+/*
+ * The primitives SFSecurityManager is built on: AES-128-CBC, a random generator and SHA-256.
+ * All backends produce the same bytes for the same input, so data encrypted by one can be decrypted by another.
+ */
+class SFCryptoBackend {
+public:
+	/*
+	 * @return the default backend of this build
+	 */
+	static SFCryptoBackend* instance();
+	/*
+	 * @param name the name of the backend, "huSB" or "OpenSSL"
+	 * @return the backend, or NULL if it is not compiled in
+	 */
+	static SFCryptoBackend* backend(const QString & name);
+	/*
+	 * @return the names of the backends compiled in, the default one first
+	 */
+	static QStringList availableBackends();
+	/*
+	 * Compare MACs in constant time, so the comparison does not tell how many bytes of a forged MAC are right.
+	 */
+	static bool constantTimeEquals(const QByteArray & a, const QByteArray & b);
+
+	virtual ~SFCryptoBackend() {}
+
+	virtual QString name() const = 0;
+	/*
+	 * @param key the AES-128 key
+	 * @return a new cipher context owned by the caller, or NULL if it can't be created
+	 */
+	virtual CipherContext* createCipherContext(const QByteArray & key) = 0;
+	/*
+	 * Fill the buffer with cryptographically secure random bytes.
+	 */
+	virtual bool randomBytes(QByteArray & buffer) = 0;
+	/*
+	 * @return the SHA-256 digest of the data, or an empty array on failure
+	 */
+	virtual QByteArray sha256(const QByteArray & data) = 0;
+	/*
+	 * HMAC-SHA256 (RFC 2104), built on sha256() so that every backend gets it.
+	 */
+	QByteArray hmacSha256(const QByteArray & key, const QByteArray & data);
+};
+
+} /* namespace sf */
+#endif /* SFCRYPTOBACKEND_H_ */
@@ -23,27 +23,52 @@
 #define SFSECURITYMANAGER_H_
 
 #include <QObject>
+#include <QAtomicPointer>
+#include <QList>
+#include <QMutex>
+#include <QStringList>
 #include <qbytearray.h>
-#include "GlobalContext.hpp"
 
 namespace sf {
+
+class CipherContext;
+class SFCryptoBackend;
+
 /*!
  * @class SFSecurityManager
  * @headerfile SFSecurityManager.h <encryption/SFSecurityManager.h>
  *
  * @brief A singleton class that will provides functions for AES encryption and SHA.
+ *
+ * @details
+ * The key and IV are parsed once, and the AES key schedules are kept in a pool of prepared cipher contexts that
+ * are reused across calls, so @c encrypt() and @c decrypt() can be called from any thread. Random bytes are served
+ * from a buffer that is refilled from the random generator of the backend.
+ *
+ * The primitives come from the default @c SFCryptoBackend of the build: huSB on device, OpenSSL elsewhere.
+ * Both produce the same ciphertext, so data written with one can be read with the other.
  */
 class SFSecurityManager : public QObject {
 	Q_OBJECT
 
 private:
-	static SFSecurityManager* sharedInstance;
+	static QAtomicPointer<SFSecurityManager> sharedInstance;
 	QString mKey,mIv;
-    GlobalContext mGlobalContext;
+	QByteArray mKeyBytes, mIvBytes;
+	QByteArray mKeyId, mEnvelopeMacKey;
+	SFCryptoBackend* mBackend;
+	//prepared cipher contexts, not in use by any thread
+	QMutex mContextLock;
+	QList<CipherContext*> mIdleContexts;
+	int mMaxIdleContexts;
+	//buffered random bytes
+	QMutex mRandomLock;
+	QByteArray mRandomBuffer;
+	int mRandomOffset;
 
 public:
     /*!
-     * @return the singleton instance
+     * @return the singleton instance. This function is thread-safe.
      */
 	static SFSecurityManager* instance();
 	/*!
@@ -56,6 +81,48 @@ public:
 	 * @return decoded string
 	 */
 	QString decrypt(QString cipherTextHex);
+	/*!
+	 * Encrypt data into a compact binary envelope: a version byte, a 4 byte key id, a random IV, the AES-128-CBC
+	 * ciphertext and an HMAC-SHA256 over all of it. Prefer it over @c encrypt() for anything stored,
+	 * the output is half the size of hex and each message gets its own IV.
+	 * @param clearData the data to be encrypted
+	 * @return the envelope, or an empty array on failure
+	 */
+	QByteArray encryptData(const QByteArray & clearData);
+	/*!
+	 * @param envelope an envelope created by @c encryptData()
+	 * @return the clear data, or a null array if the envelope is not valid, was altered or was sealed with another key
+	 */
+	QByteArray decryptData(const QByteArray & envelope);
+	/*!
+	 * @return true if the data looks like an envelope created by @c encryptData(), as opposed to legacy hex text
+	 */
+	static bool isEnvelope(const QByteArray & data);
+	/*!
+	 * Encrypt a batch of strings. Large batches are spread across the threads of the global @c QThreadPool.
+	 * This function blocks until the whole batch is done.
+	 * @param clearTexts the strings to be encrypted
+	 * @return the encrypted strings, in the same order. An entry that fails to encrypt is a null string.
+	 */
+	QStringList encryptMany(const QStringList & clearTexts);
+	/*!
+	 * Decrypt a batch of strings. Large batches are spread across the threads of the global @c QThreadPool.
+	 * This function blocks until the whole batch is done.
+	 * @param cipherTextsHex the encoded strings in hex format
+	 * @return the decoded strings, in the same order. An entry that fails to decrypt is a null string.
+	 */
+	QStringList decryptMany(const QStringList & cipherTextsHex);
+	/*!
+	 * @param length the number of bytes
+	 * @return cryptographically secure random bytes, or an empty array if the random generator failed
+	 */
+	QByteArray randomBytes(int length);
+	/*!
+	 * Derive a key from the key of the manager with HMAC-SHA256. The key of the manager never leaves this class.
+	 * @param label identifies the purpose of the key, different labels give independent keys
+	 * @return a 32 byte key, or an empty array on failure
+	 */
+	QByteArray deriveKey(const QByteArray & label);
 	/*!
 	 * @param clearText to be hashed
 	 * @return the hashed string
@@ -67,15 +134,14 @@ private:
 	virtual ~SFSecurityManager();
 	//generate random string (for use as key and iv)
 	QString generateRandomString();
-	//hex conversion
-	bool fromHex(const QString in, QByteArray & toReturn);
-	QString toHex(const QByteArray & in);
-    char nibble(char);
     //padding
     void pad(QByteArray & in);
     bool removePadding(QByteArray & out);
     //internal function used to encrypt and decrypt
-    bool crypt(bool isEncrypt, const QByteArray & in, QByteArray & out);
+    bool crypt(bool isEncrypt, const QByteArray & iv, const QByteArray & in, QByteArray & out);
+    //cipher context pool
+    CipherContext* acquireContext();
+    void releaseContext(CipherContext* context);
 };
 
 } /* namespace sf */
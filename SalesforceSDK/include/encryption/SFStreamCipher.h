@@ -0,0 +1,153 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+#ifndef SFSTREAMCIPHER_H_
+#define SFSTREAMCIPHER_H_
+
+#include <QByteArray>
+#include <QString>
+
+class QIODevice;
+
+namespace sf {
+
+class CipherContext;
+class SFCryptoBackend;
+
+/*!
+ * @class SFStreamEncryptor
+ * @headerfile SFStreamCipher.h <encryption/SFStreamCipher.h>
+ *
+ * @brief Encrypts a stream of any size into a @c QIODevice, one chunk at a time.
+ *
+ * @details
+ * The format is encrypt-then-MAC AES-128-CBC with HMAC-SHA256. The stream starts with a header:
+ * magic @a SFSC, a version byte, 3 reserved bytes, the chunk size (big endian 32 bits) and a random 16 byte nonce.
+ * The header is followed by one record per chunk: a random IV, the ciphertext and a MAC over the header,
+ * the chunk index, a final flag, the IV and the ciphertext. Every chunk but the last has exactly @c chunkSize bytes
+ * of clear text and no padding, so records have a fixed size and any chunk can be located and verified on its own.
+ * The last chunk is padded and flagged so that truncation is detected.
+ *
+ * The encryption and MAC keys are derived for every stream from the key of @c SFSecurityManager and the nonce.
+ * Memory use is bounded by the chunk size whatever the size of the stream.
+ */
+class SFStreamEncryptor {
+public:
+	static const int DefaultChunkSize = 64 * 1024;
+
+	SFStreamEncryptor();
+	virtual ~SFStreamEncryptor();
+	/*!
+	 * Write the header to the device and get ready to accept data.
+	 * @param device the device receiving the encrypted stream, opened for writing. It is not owned.
+	 * @param chunkSize the clear text size of a chunk, rounded up to a multiple of 16
+	 * @return false if the stream can't be started
+	 */
+	bool begin(QIODevice* device, int chunkSize = DefaultChunkSize);
+	/*!
+	 * Encrypt data. Full chunks are written to the device as soon as they are available.
+	 */
+	bool write(const QByteArray & data);
+	/*!
+	 * Write the final chunk. Must be called once all the data is written, otherwise the stream is seen as truncated.
+	 */
+	bool finish();
+	QString errorString() const { return mErrorString; };
+
+	/*!
+	 * Encrypt a whole device into another one.
+	 */
+	static bool encrypt(QIODevice* source, QIODevice* destination, int chunkSize = DefaultChunkSize);
+
+private:
+	QIODevice* mDevice;
+	SFCryptoBackend* mBackend;
+	CipherContext* mCipher;
+	QByteArray mHeader;
+	QByteArray mMacKey;
+	QByteArray mBuffer;
+	int mChunkSize;
+	qint64 mChunkIndex;
+	QString mErrorString;
+
+	bool writeChunk(const QByteArray & clearText, bool final);
+	bool fail(const QString & error);
+	Q_DISABLE_COPY(SFStreamEncryptor)
+};
+
+/*!
+ * @class SFStreamDecryptor
+ * @headerfile SFStreamCipher.h <encryption/SFStreamCipher.h>
+ *
+ * @brief Decrypts and verifies streams written by @c SFStreamEncryptor, sequentially or one chunk at a time.
+ *
+ * @details
+ * @c readChunk() seeks straight to the record of a chunk, so a part of a large encrypted file can be read without
+ * decrypting what comes before it. Every chunk is authenticated before it is returned.
+ */
+class SFStreamDecryptor {
+public:
+	SFStreamDecryptor();
+	virtual ~SFStreamDecryptor();
+	/*!
+	 * Read and check the header.
+	 * @param device the encrypted stream, opened for reading. It is not owned. Random access needs a seekable device.
+	 * @return false if the device does not hold a stream this version can read
+	 */
+	bool open(QIODevice* device);
+	int chunkSize() const { return mChunkSize; };
+	/*!
+	 * @return the number of chunks of the stream, or -1 if the device is sequential
+	 */
+	qint64 chunkCount() const;
+	/*!
+	 * Decrypt a single chunk.
+	 * @param index the index of the chunk, starting at 0
+	 * @param clearText receives the clear text of the chunk
+	 * @return false if the chunk does not exist or fails verification
+	 */
+	bool readChunk(qint64 index, QByteArray & clearText);
+	/*!
+	 * Decrypt the next chunk of a stream read from start to end.
+	 * @param clearText receives the clear text of the chunk
+	 * @param final set to true when it is the last chunk of the stream
+	 * @return false on read or verification error
+	 */
+	bool readNext(QByteArray & clearText, bool & final);
+	QString errorString() const { return mErrorString; };
+
+	/*!
+	 * Decrypt and verify a whole device into another one. On failure, the destination may hold part of the clear text.
+	 */
+	static bool decrypt(QIODevice* source, QIODevice* destination);
+
+private:
+	QIODevice* mDevice;
+	SFCryptoBackend* mBackend;
+	CipherContext* mCipher;
+	QByteArray mHeader;
+	QByteArray mMacKey;
+	int mChunkSize;
+	qint64 mNextIndex;
+	QString mErrorString;
+
+	int recordSize() const;
+	bool decryptRecord(qint64 index, bool final, const QByteArray & record, QByteArray & clearText);
+	bool fail(const QString & error);
+	Q_DISABLE_COPY(SFStreamDecryptor)
+};
+
+} /* namespace sf */
+#endif /* SFSTREAMCIPHER_H_ */
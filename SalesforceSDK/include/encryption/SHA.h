@@ -22,6 +22,7 @@
 #ifndef SHA_H_
 #define SHA_H_
 
+#include <QByteArray>
 #include "GlobalContext.hpp"
 
 #define SB_SHA256_DIGEST_LEN 32
@@ -36,6 +37,7 @@ public:
 		return sha256Context!=NULL;
 	}
 	int updateDigest(const QString input_data);
+	int updateDigest(const QByteArray & input_bytes);
 	int completeDigest();
 private:
 	GlobalContext & context;
@@ -41,7 +41,8 @@ namespace sf {
  * reauthenticate against Salesforce.com servers using OAuth2. It includes information such as
  * the user's account ID, the protocol to use, and any access or refresh tokens assigned by the server.
  *
- * The secure information contained in this object is stored on in the application's data folder after encrypted with AES encryption
+ * The secure information contained in this object is stored in the application's data folder after encrypted with AES encryption.
+ * Tokens are held in memory by @c SFTokenVault, so reading them (e.g. for every REST request) does not touch the file system.
  *
  * Instances of this object are used to begin the authentication process, by supplying
  * it to an `SFOAuthCoordinator` instance which conducts the authentication workflow.
@@ -128,7 +129,7 @@ private:
 	QString mUserId;
 	QString mIdentifier;
 
-	void saveToken(QString token, QString key) const;
+	bool saveToken(QString token, QString key) const;
 	QString retreiveToken(QString key) const;
 	QString keyForToken(QString serviceType) const;
 };
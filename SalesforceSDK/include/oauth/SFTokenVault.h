@@ -0,0 +1,115 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFTokenVault.h
+*/
+
+#ifndef SFTOKENVAULT_H_
+#define SFTOKENVAULT_H_
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QAtomicPointer>
+#include <QAtomicInt>
+#include <QExplicitlySharedDataPointer>
+#include <QSharedData>
+
+namespace sf {
+
+/*!
+ * @class SFTokenVault
+ * @headerfile SFTokenVault.h <oauth/SFTokenVault.h>
+ *
+ * @brief A singleton in-memory cache of OAuth tokens, backed by a single encrypted vault file.
+ *
+ * @details
+ * All tokens are kept in an immutable, reference counted snapshot, so reading a token (e.g. once per REST request) only
+ * holds a short lock to take a reference to it, and does no file I/O or decryption. Every change builds a new snapshot,
+ * publishes it and writes the whole table through to one file under the @a sf_token_store directory, sealed with the
+ * binary envelope of @c SFSecurityManager. A replaced snapshot is freed when its last reader releases it.
+ *
+ * The per-token files written by earlier versions of the SDK are imported into the vault the first time the vault is loaded,
+ * and removed once the vault holding them is written. A vault stored as hex text is rewritten as an envelope.
+ *
+ * This class is meant to be used by @c SFOAuthCredentials. Application code should not need to use it directly.
+ */
+class SFTokenVault : public QObject {
+	Q_OBJECT
+
+public:
+	/*!
+	 * @return the singleton instance. This function is thread-safe.
+	 */
+	static SFTokenVault* instance();
+	/*!
+	 * @param key the key of the token
+	 * @return the token associated with the key, or a null string if there is none. This function is thread-safe, and doesn't
+	 * wait for a write to disk once the vault is loaded.
+	 */
+	QString token(const QString & key);
+	/*!
+	 * Write the vault through to disk with the token, then store it in memory. Passing a null token removes the key.
+	 * @param key the key of the token
+	 * @param token the clear text token
+	 * @return false if the vault couldn't be written, the token in memory is left unchanged then
+	 */
+	bool setToken(const QString & key, const QString & token);
+	/*!
+	 * Remove the tokens associated with given keys with a single write to disk.
+	 * @param keys the keys of the tokens to remove
+	 * @return false if the vault couldn't be written, the tokens in memory are left unchanged then
+	 */
+	bool removeTokens(const QStringList & keys);
+	/*!
+	 * Drop the in-memory copy of the vault. The next read reloads it from disk.
+	 * Called when the login host changes so that no token of the previous host is served from memory.
+	 */
+	void invalidate();
+	/*!
+	 * @return a counter that is incremented every time the content of the vault changes or is invalidated.
+	 * Useful for callers that derive data (e.g. request headers) from the tokens and want to know when to rebuild it.
+	 */
+	int generation() const { return mGeneration; };
+
+private:
+	/* immutable once published */
+	struct Snapshot : public QSharedData {
+		QHash<QString, QString> tokens;
+	};
+	typedef QExplicitlySharedDataPointer<Snapshot> SnapshotPointer;
+
+	static QAtomicPointer<SFTokenVault> sharedInstance;
+	SnapshotPointer mSnapshot;
+	QMutex mSnapshotLock; //only held to copy or replace mSnapshot
+	QAtomicInt mGeneration;
+	QMutex mWriteLock;
+
+	SFTokenVault();
+	virtual ~SFTokenVault();
+
+	SnapshotPointer currentSnapshot();
+	SnapshotPointer lockedSnapshot();
+	void publish(const SnapshotPointer & snapshot);
+	SnapshotPointer load();
+	bool persist(const QHash<QString, QString> & tokens);
+	QStringList migrateLegacyTokens(QHash<QString, QString> & tokens);
+	QString vaultFilePath() const;
+};
+
+} /* namespace sf */
+#endif /* SFTOKENVAULT_H_ */
@@ -0,0 +1,113 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBodyEncoder.h
+*/
+
+#ifndef SFBODYENCODER_H_
+#define SFBODYENCODER_H_
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+class QIODevice;
+
+namespace sf {
+
+/*!
+ * @class SFBodyEncoder
+ * @headerfile SFBodyEncoder.h <rest/SFBodyEncoder.h>
+ *
+ * @brief A streaming encoder for the parameters of a request, as URL encoded pairs, JSON or multipart/form-data.
+ *
+ * @details
+ * The encoder writes straight into a @c QByteArray or a @c QIODevice. Strings are converted to UTF-8 and escaped as they are
+ * written, without any intermediate @c QString or @c QByteArray. An encoder without target only counts the bytes it would write,
+ * which lets the static helpers size the output buffer exactly before writing into it:
+ * @code
+ * QByteArray body = SFBodyEncoder::encodeUrlEncoded(params); //one allocation
+ *
+ * QFile file(path);
+ * file.open(QIODevice::WriteOnly);
+ * SFBodyEncoder encoder(&file); //written in chunks of a few KB
+ * encoder.writeJson(records);
+ * encoder.flush();
+ * @endcode
+ */
+class SFBodyEncoder {
+public:
+	SFBodyEncoder(); /*!< Creates an encoder that only counts the bytes */
+	explicit SFBodyEncoder(QByteArray * buffer); /*!< Creates an encoder that appends to @a buffer */
+	explicit SFBodyEncoder(QIODevice * device); /*!< Creates an encoder that writes to @a device, which must be open */
+	~SFBodyEncoder(); /*!< Flushes the bytes not yet written to the device */
+
+	qint64 size() const { return mSize; }; /*!< @return the number of bytes written, or counted */
+	bool hasError() const { return mError; }; /*!< @return whether a value couldn't be encoded or the device failed */
+	bool flush(); /*!< Write the buffered bytes to the device. @return false if the device failed */
+
+	/*! Write parameters as "key=value&key=value", percent-encoded. Byte arrays are base64 encoded first. Values that can't be
+	 * converted to a string are skipped. */
+	void writeUrlEncoded(const QVariantMap & params);
+	/*! Write a value as JSON. Maps, hashes, lists, strings, numbers, booleans, dates and invalid values (null) are supported.
+	 * @return false if the value, or a nested value, has another type */
+	bool writeJson(const QVariant & value);
+	/*! Write parameters as multipart/form-data parts. Byte arrays are sent as files, maps and lists as JSON, other values as text.
+	 * @param boundary the boundary, which must also be given in the Content-Type header */
+	void writeMultipart(const QVariantMap & params, const QByteArray & boundary);
+
+	void writeRaw(const char * data, int size); /*!< Write bytes as they are */
+	void writeRaw(const QByteArray & data) { this->writeRaw(data.constData(), data.size()); }; /*!< Write bytes as they are */
+	void writePercentEncoded(const QString & text); /*!< Write a string in UTF-8, percent-encoded */
+	void writeJsonString(const QString & text); /*!< Write a string as a quoted JSON string */
+
+	static QByteArray encodeUrlEncoded(const QVariantMap & params); /*!< @return the URL encoded parameters, in an exactly sized array */
+	/*! Encode a value as JSON in an exactly sized array
+	 * @return false if the value can't be encoded */
+	static bool encodeJson(const QVariant & value, QByteArray * pOutBytes);
+	/*! @return the multipart/form-data body, in an exactly sized array */
+	static QByteArray encodeMultipart(const QVariantMap & params, const QByteArray & boundary);
+
+private:
+	enum Escape {
+		EscapeNone,
+		EscapePercent,
+		EscapeJson
+	};
+	static const int kChunkSize = 4096;
+
+	QByteArray *mBuffer;
+	QIODevice *mDevice;
+	char mChunk[kChunkSize];
+	int mChunkUsed;
+	qint64 mSize;
+	bool mError;
+
+	inline void put(char c);
+	void writeLiteral(const char * text);
+	void writeUtf8(const QString & text, Escape escape);
+	inline void putEscaped(uchar c, Escape escape);
+	void writeNumber(qlonglong number);
+	void writeNumber(qulonglong number);
+	void writeNumber(double number);
+	void writeNumber(float number);
+	bool paramValue(const QVariant & value, QString * pOutText) const;
+	bool isCounting() const { return !mBuffer && !mDevice; };
+
+	Q_DISABLE_COPY(SFBodyEncoder)
+};
+
+} /* namespace sf */
+#endif /* SFBODYENCODER_H_ */
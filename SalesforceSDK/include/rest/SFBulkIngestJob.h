@@ -0,0 +1,200 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBulkIngestJob.h
+*/
+
+#ifndef SFBULKINGESTJOB_H_
+#define SFBULKINGESTJOB_H_
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+#include "SFGlobal.h"
+
+class QTemporaryFile;
+
+namespace sf {
+
+class SFRecordSource;
+class SFRestRequest;
+class SFResult;
+
+/*!
+ * @class SFBulkIngestJob
+ * @headerfile SFBulkIngestJob.h <rest/SFBulkIngestJob.h>
+ * @brief Loads records with a Bulk API 2.0 ingest job: creates the job, uploads the CSV data, closes the job, waits for
+ * Salesforce to process it and downloads the results.
+ *
+ * @details
+ * The CSV data is streamed from a file as it is uploaded, it is never loaded in memory as a whole. It comes either from
+ * @c SFBulkIngestJob::csvFile, whose first line names the fields, or from a @c SFRecordSource, whose records are written to a
+ * temporary file in a worker thread first, so that the size of the upload is known.
+ *
+ * Once the upload is complete, the status of the job is polled. The interval starts at @c SFBulkIngestJob::pollInterval and grows by half
+ * after every poll up to @c SFBulkIngestJob::maxPollInterval, since large jobs take minutes. When the job is complete,
+ * the successful and failed results are streamed to @c SFBulkIngestJob::successfulResultsFile and @c SFBulkIngestJob::failedResultsFile,
+ * if they are set, then @c finished() is emitted.
+ *
+ * All requests go through @c SFRestAPI at @c SFRequestPriority::BackgroundSync, so they wait for a login and never delay interactive requests.
+ *
+ * Example in C++:
+ * @code{.cpp}
+ * SFBulkIngestJob *job = new SFBulkIngestJob(this);
+ * job->setObjectType("Contact");
+ * job->setOperation(SFBulkIngestJob::Insert);
+ * job->setRecordSource(new ContactSource(database), QStringList() << "FirstName" << "LastName" << "Email");
+ * job->setFailedResultsFile(QDir::homePath() + "/contacts-failed.csv");
+ * connect(job, SIGNAL(finished()), this, SLOT(onContactsLoaded()));
+ * connect(job, SIGNAL(failed(int, QString)), this, SLOT(onContactsNotLoaded(int, QString)));
+ * job->start();
+ * @endcode
+ *
+ * @see <a href="https://developer.salesforce.com/docs/atlas.en-us.api_asynch.meta/api_asynch/bulk_api_2_0.htm">Bulk API 2.0</a>
+ */
+class SFBulkIngestJob : public QObject {
+	Q_OBJECT
+	Q_ENUMS(Operation State)
+	Q_PROPERTY(QString objectType READ objectType WRITE setObjectType) /*!< The sObject type of the records, e.g. "Account" */
+	Q_PROPERTY(sf::SFBulkIngestJob::Operation operation READ operation WRITE setOperation) /*!< See @c SFBulkIngestJob::Operation. @b Default: @c SFBulkIngestJob::Insert */
+	Q_PROPERTY(QString externalIdFieldName READ externalIdFieldName WRITE setExternalIdFieldName) /*!< The external ID field that matches records, required by @c SFBulkIngestJob::Upsert */
+	Q_PROPERTY(QString csvFile READ csvFile WRITE setCsvFile) /*!< The CSV file to upload, with LF line endings and the field names on the first line. Ignored if a record source is set. */
+	Q_PROPERTY(QString successfulResultsFile READ successfulResultsFile WRITE setSuccessfulResultsFile) /*!< Where to save the results of the records that were processed, not downloaded if empty */
+	Q_PROPERTY(QString failedResultsFile READ failedResultsFile WRITE setFailedResultsFile) /*!< Where to save the results of the records that failed, not downloaded if empty */
+	Q_PROPERTY(int pollInterval READ pollInterval WRITE setPollInterval) /*!< The time before the first poll of the job status, in milliseconds. @b Default: 1000 */
+	Q_PROPERTY(int maxPollInterval READ maxPollInterval WRITE setMaxPollInterval) /*!< The longest time between two polls, in milliseconds. @b Default: 30000 */
+	Q_PROPERTY(sf::SFBulkIngestJob::State state READ state NOTIFY stateChanged) /*!< See @c SFBulkIngestJob::State */
+	Q_PROPERTY(QString jobId READ jobId) /*!< The ID of the job, known once it is created */
+	Q_PROPERTY(QVariantMap jobInfo READ jobInfo) /*!< The last job information returned by Salesforce, e.g. "numberRecordsProcessed" and "numberRecordsFailed" */
+
+public:
+	/*! The operation of the job */
+	enum Operation {
+		Insert,
+		Update,
+		Upsert,
+		Delete,
+		HardDelete
+	};
+	/*! Where the job is in its lifecycle */
+	enum State {
+		Idle, /*!< Not started yet */
+		Preparing, /*!< The records of the source are written to a temporary file */
+		Opening, /*!< The job is being created */
+		Uploading, /*!< The CSV data is being uploaded */
+		Closing, /*!< The job is being marked as ready for processing */
+		Processing, /*!< Salesforce is processing the job, its status is polled */
+		DownloadingResults, /*!< The results are being downloaded */
+		Complete, /*!< The job is complete and the results are downloaded */
+		Failed, /*!< The job failed, see @c failed() */
+		Aborted /*!< The job was aborted with @c abort() */
+	};
+
+signals:
+	/*! Emitted when the job moves to another step */
+	void stateChanged(sf::SFBulkIngestJob::State state);
+	/*! Emitted once the job is complete and the results are downloaded. Records may still have failed individually,
+	 * see "numberRecordsFailed" in @c SFBulkIngestJob::jobInfo. */
+	void finished();
+	/*! Emitted when the job couldn't be run, or Salesforce failed or aborted it.
+	 * @param code the code of the error, see @c SFResult::code
+	 * @param message the message of the error */
+	void failed(int code, const QString & message);
+
+public:
+	SFBulkIngestJob(QObject *parent = 0);
+	virtual ~SFBulkIngestJob();
+
+	const QString & objectType() const { return this->mObjectType;}; /*!< @see SFBulkIngestJob::objectType */
+	void setObjectType(const QString & objectType) { this->mObjectType = objectType;}; /*!< @see SFBulkIngestJob::objectType */
+	Operation operation() const { return this->mOperation;}; /*!< @see SFBulkIngestJob::operation */
+	void setOperation(Operation operation) { this->mOperation = operation;}; /*!< @see SFBulkIngestJob::operation */
+	const QString & externalIdFieldName() const { return this->mExternalIdFieldName;}; /*!< @see SFBulkIngestJob::externalIdFieldName */
+	void setExternalIdFieldName(const QString & fieldName) { this->mExternalIdFieldName = fieldName;}; /*!< @see SFBulkIngestJob::externalIdFieldName */
+	const QString & csvFile() const { return this->mCsvFile;}; /*!< @see SFBulkIngestJob::csvFile */
+	void setCsvFile(const QString & fileName) { this->mCsvFile = fileName;}; /*!< @see SFBulkIngestJob::csvFile */
+	const QString & successfulResultsFile() const { return this->mSuccessfulResultsFile;}; /*!< @see SFBulkIngestJob::successfulResultsFile */
+	void setSuccessfulResultsFile(const QString & fileName) { this->mSuccessfulResultsFile = fileName;}; /*!< @see SFBulkIngestJob::successfulResultsFile */
+	const QString & failedResultsFile() const { return this->mFailedResultsFile;}; /*!< @see SFBulkIngestJob::failedResultsFile */
+	void setFailedResultsFile(const QString & fileName) { this->mFailedResultsFile = fileName;}; /*!< @see SFBulkIngestJob::failedResultsFile */
+	int pollInterval() const { return this->mPollInterval;}; /*!< @see SFBulkIngestJob::pollInterval */
+	void setPollInterval(int interval) { this->mPollInterval = qMax(100, interval);}; /*!< @see SFBulkIngestJob::pollInterval */
+	int maxPollInterval() const { return this->mMaxPollInterval;}; /*!< @see SFBulkIngestJob::maxPollInterval */
+	void setMaxPollInterval(int interval) { this->mMaxPollInterval = qMax(100, interval);}; /*!< @see SFBulkIngestJob::maxPollInterval */
+	State state() const { return this->mState;}; /*!< @see SFBulkIngestJob::state */
+	const QString & jobId() const { return this->mJobId;}; /*!< @see SFBulkIngestJob::jobId */
+	const QVariantMap & jobInfo() const { return this->mJobInfo;}; /*!< @see SFBulkIngestJob::jobInfo */
+
+	/*! Upload the records of the given source instead of @c SFBulkIngestJob::csvFile.
+	 * The job takes ownership of the source and deletes it once all records are read. @c SFRecordSource::next() is called in a worker thread.
+	 * @param source the records, or NULL to upload @c SFBulkIngestJob::csvFile
+	 * @param columns the field names, in the order of the values of the records */
+	void setRecordSource(SFRecordSource * source, const QStringList & columns);
+
+public slots:
+	/*! Run the job. Does nothing if it is already running, or if the records of an aborted run are still being read. */
+	void start();
+	/*! Stop waiting for the job and ask Salesforce to abort it. Records already processed stay processed. */
+	void abort();
+
+private slots:
+	void onRecordsSpilled();
+	void onJobCreated(sf::SFResult* result);
+	void onDataUploaded(sf::SFResult* result);
+	void onJobClosed(sf::SFResult* result);
+	void onJobStatusReady(sf::SFResult* result);
+	void onResultsDownloaded(sf::SFResult* result);
+	void onAbortResultReady(sf::SFResult* result);
+	void poll();
+
+private:
+	Q_DISABLE_COPY(SFBulkIngestJob)
+
+	QString mObjectType;
+	Operation mOperation;
+	QString mExternalIdFieldName;
+	QString mCsvFile;
+	QString mSuccessfulResultsFile;
+	QString mFailedResultsFile;
+	int mPollInterval;
+	int mMaxPollInterval;
+	int mNextPollInterval;
+	State mState;
+	QString mJobId;
+	QVariantMap mJobInfo;
+	int mGeneration; //tags the requests of the current run, so the ones of an aborted run are ignored
+	int mPendingDownloads;
+	SFRecordSource *mRecordSource;
+	QStringList mColumns;
+	QTemporaryFile *mSpillFile; //the records of the source, written out as CSV
+	QFutureWatcher<QString> mSpillWatcher;
+	QTimer mPollTimer;
+
+	bool isRunning() const;
+	void setState(State state);
+	void openJob();
+	void download(const QString & resultsPath, const QString & fileName);
+	void fail(int code, const QString & message);
+	void sendAbort(const QString & jobId);
+	SFRestRequest * createRequest(const QString & path, const HTTPMethodType & method, const QVariantMap & body = QVariantMap()) const;
+	bool isCurrent(SFResult * result) const;
+};
+
+} /* namespace sf */
+Q_DECLARE_METATYPE(sf::SFBulkIngestJob*)
+#endif /* SFBULKINGESTJOB_H_ */
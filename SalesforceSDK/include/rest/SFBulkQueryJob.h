@@ -0,0 +1,169 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBulkQueryJob.h
+*/
+
+#ifndef SFBULKQUERYJOB_H_
+#define SFBULKQUERYJOB_H_
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVariant>
+#include "SFGlobal.h"
+
+namespace sf {
+
+class SFRestRequest;
+class SFResult;
+
+/*!
+ * @class SFBulkQueryJob
+ * @headerfile SFBulkQueryJob.h <rest/SFBulkQueryJob.h>
+ * @brief Extracts records with a Bulk API 2.0 query job: creates the job, waits for Salesforce to run it and downloads the CSV
+ * results page by page.
+ *
+ * @details
+ * For large extracts, this is much faster than following "nextRecordsUrl" with @c SFQueryCursor, and memory use doesn't depend on the number of records:
+ * - With @c SFBulkQueryJob::resultsFile set, every page is streamed to that file as it downloads, the CSV header is written once.
+ * - Otherwise, every page is parsed while it downloads by @c SFCsvRecordsConsumer and its rows are delivered through @c rowsReady().
+ * At most two pages are held in memory, the one being delivered and the next one, whose size is bounded by @c SFBulkQueryJob::maxRecordsPerPage.
+ *
+ * The status of the job is polled like @c SFBulkIngestJob does, with a growing interval. Pages are requested with the "Sforce-Locator"
+ * header of the previous one, and the next page is requested before the current one is delivered.
+ * All requests go through @c SFRestAPI at @c SFRequestPriority::BackgroundSync.
+ *
+ * Example in C++:
+ * @code{.cpp}
+ * SFBulkQueryJob *job = new SFBulkQueryJob(this);
+ * job->setQuery("SELECT Id, Name, Industry FROM Account");
+ * connect(job, SIGNAL(rowsReady(QStringList, QVariantList)), this, SLOT(onAccountsReady(QStringList, QVariantList)));
+ * connect(job, SIGNAL(finished()), this, SLOT(onAllAccountsReady()));
+ * job->start();
+ * @endcode
+ *
+ * @see <a href="https://developer.salesforce.com/docs/atlas.en-us.api_asynch.meta/api_asynch/queries.htm">Bulk API 2.0 Query</a>
+ */
+class SFBulkQueryJob : public QObject {
+	Q_OBJECT
+	Q_ENUMS(Operation State)
+	Q_PROPERTY(QString query READ query WRITE setQuery) /*!< The SOQL query */
+	Q_PROPERTY(sf::SFBulkQueryJob::Operation operation READ operation WRITE setOperation) /*!< See @c SFBulkQueryJob::Operation. @b Default: @c SFBulkQueryJob::Query */
+	Q_PROPERTY(QString resultsFile READ resultsFile WRITE setResultsFile) /*!< Where to save the results as CSV. If empty, rows are delivered through @c rowsReady() */
+	Q_PROPERTY(int maxRecordsPerPage READ maxRecordsPerPage WRITE setMaxRecordsPerPage) /*!< The most records a page of results holds, 0 lets the server decide. @b Default: 10000 */
+	Q_PROPERTY(int pollInterval READ pollInterval WRITE setPollInterval) /*!< The time before the first poll of the job status, in milliseconds. @b Default: 1000 */
+	Q_PROPERTY(int maxPollInterval READ maxPollInterval WRITE setMaxPollInterval) /*!< The longest time between two polls, in milliseconds. @b Default: 30000 */
+	Q_PROPERTY(sf::SFBulkQueryJob::State state READ state NOTIFY stateChanged) /*!< See @c SFBulkQueryJob::State */
+	Q_PROPERTY(QString jobId READ jobId) /*!< The ID of the job, known once it is created */
+	Q_PROPERTY(QVariantMap jobInfo READ jobInfo) /*!< The last job information returned by Salesforce, e.g. "numberRecordsProcessed" */
+	Q_PROPERTY(int rowCount READ rowCount) /*!< The number of rows delivered or saved so far */
+
+public:
+	/*! The operation of the job */
+	enum Operation {
+		Query, /*!< Returns the records that aren't deleted */
+		QueryAll /*!< Also returns deleted and archived records */
+	};
+	/*! Where the job is in its lifecycle */
+	enum State {
+		Idle, /*!< Not started yet */
+		Opening, /*!< The job is being created */
+		Processing, /*!< Salesforce is running the query, its status is polled */
+		DownloadingResults, /*!< The pages of results are being downloaded */
+		Complete, /*!< All pages are delivered or saved */
+		Failed, /*!< The job failed, see @c failed() */
+		Aborted /*!< The job was aborted with @c abort() */
+	};
+
+signals:
+	/*! Emitted when the job moves to another step */
+	void stateChanged(sf::SFBulkQueryJob::State state);
+	/*! Emitted for every page of results, in order, when @c SFBulkQueryJob::resultsFile is empty.
+	 * @param columns the names of the fields
+	 * @param rows the rows of the page, each a @c QStringList with a field per column. Empty fields are null values. */
+	void rowsReady(const QStringList & columns, const QVariantList & rows);
+	/*! Emitted once all pages are delivered or saved */
+	void finished();
+	/*! Emitted when the job couldn't be run, or Salesforce failed or aborted it.
+	 * @param code the code of the error, see @c SFResult::code
+	 * @param message the message of the error */
+	void failed(int code, const QString & message);
+
+public:
+	SFBulkQueryJob(QObject *parent = 0);
+	virtual ~SFBulkQueryJob();
+
+	const QString & query() const { return this->mQuery;}; /*!< @see SFBulkQueryJob::query */
+	void setQuery(const QString & query) { this->mQuery = query;}; /*!< @see SFBulkQueryJob::query */
+	Operation operation() const { return this->mOperation;}; /*!< @see SFBulkQueryJob::operation */
+	void setOperation(Operation operation) { this->mOperation = operation;}; /*!< @see SFBulkQueryJob::operation */
+	const QString & resultsFile() const { return this->mResultsFile;}; /*!< @see SFBulkQueryJob::resultsFile */
+	void setResultsFile(const QString & fileName) { this->mResultsFile = fileName;}; /*!< @see SFBulkQueryJob::resultsFile */
+	int maxRecordsPerPage() const { return this->mMaxRecordsPerPage;}; /*!< @see SFBulkQueryJob::maxRecordsPerPage */
+	void setMaxRecordsPerPage(int count) { this->mMaxRecordsPerPage = qMax(0, count);}; /*!< @see SFBulkQueryJob::maxRecordsPerPage */
+	int pollInterval() const { return this->mPollInterval;}; /*!< @see SFBulkQueryJob::pollInterval */
+	void setPollInterval(int interval) { this->mPollInterval = qMax(100, interval);}; /*!< @see SFBulkQueryJob::pollInterval */
+	int maxPollInterval() const { return this->mMaxPollInterval;}; /*!< @see SFBulkQueryJob::maxPollInterval */
+	void setMaxPollInterval(int interval) { this->mMaxPollInterval = qMax(100, interval);}; /*!< @see SFBulkQueryJob::maxPollInterval */
+	State state() const { return this->mState;}; /*!< @see SFBulkQueryJob::state */
+	const QString & jobId() const { return this->mJobId;}; /*!< @see SFBulkQueryJob::jobId */
+	const QVariantMap & jobInfo() const { return this->mJobInfo;}; /*!< @see SFBulkQueryJob::jobInfo */
+	int rowCount() const { return this->mRowCount;}; /*!< @see SFBulkQueryJob::rowCount */
+
+public slots:
+	/*! Run the job. Does nothing if it is already running. */
+	void start();
+	/*! Stop waiting for the job and ask Salesforce to abort it if it is still running. No more rows are delivered. */
+	void abort();
+
+private slots:
+	void onJobCreated(sf::SFResult* result);
+	void onJobStatusReady(sf::SFResult* result);
+	void onPageReady(sf::SFResult* result);
+	void onAbortResultReady(sf::SFResult* result);
+	void poll();
+
+private:
+	Q_DISABLE_COPY(SFBulkQueryJob)
+
+	QString mQuery;
+	Operation mOperation;
+	QString mResultsFile;
+	int mMaxRecordsPerPage;
+	int mPollInterval;
+	int mMaxPollInterval;
+	int mNextPollInterval;
+	State mState;
+	QString mJobId;
+	QVariantMap mJobInfo;
+	int mRowCount;
+	int mPageCount; //pages requested so far
+	int mGeneration; //tags the requests of the current run, so the ones of an aborted run are ignored
+	QTimer mPollTimer;
+
+	bool isRunning() const;
+	void setState(State state);
+	void fetchPage(const QString & locator);
+	void fail(int code, const QString & message);
+	void sendAbort(const QString & jobId);
+	SFRestRequest * createRequest(const QString & path, const HTTPMethodType & method, const QVariantMap & params = QVariantMap()) const;
+	bool isCurrent(SFResult * result) const;
+};
+
+} /* namespace sf */
+Q_DECLARE_METATYPE(sf::SFBulkQueryJob*)
+#endif /* SFBULKQUERYJOB_H_ */
@@ -0,0 +1,110 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCollectionRequest.h
+*/
+
+
+#ifndef SFCOLLECTIONREQUEST_H_
+#define SFCOLLECTIONREQUEST_H_
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QVariant>
+#include "SFGlobal.h"
+
+namespace sf {
+
+class SFRestRequest;
+
+/*!
+ * @class SFCollectionRequest
+ * @headerfile SFCollectionRequest.h <rest/SFCollectionRequest.h>
+ * @brief Creates, updates or deletes a list of records with the sObject Collections resource.
+ *
+ * @details
+ * The resource takes at most 200 records per call, so the records are split into chunks that are sent concurrently, at most
+ * @c SFCollectionRequest::maxRequestsInFlight at a time. The results of the chunks are merged into one @c SFResult whose payload
+ * is a @c QVariantList with an entry per record, in the order of the records:
+ * @code
+ * {"id": "001D000000K0fXOIAZ", "success": true, "errors": []}
+ * {"id": null, "success": false, "errors": [{"statusCode": "REQUIRED_FIELD_MISSING", "message": "Required fields are missing: [Name]", "fields": ["Name"]}]}
+ * @endcode
+ * The result has an error if any of the chunks failed as a whole, e.g. because of a network error. The records of such a chunk
+ * get an entry with the error of the chunk.
+ *
+ * Requests are created by @c SFRestAPI::requestForCreateObjects(), @c SFRestAPI::requestForUpdateObjects() and
+ * @c SFRestAPI::requestForDeleteObjects(), and sent with @c SFRestAPI::sendCollectionRequest().
+ *
+ * @see <a href="https://developer.salesforce.com/docs/atlas.en-us.api_rest.meta/api_rest/resources_composite_sobjects_collections.htm">sObject Collections</a>
+ */
+class SFCollectionRequest : public QObject {
+	Q_OBJECT
+	Q_PROPERTY(bool allOrNone READ allOrNone WRITE setAllOrNone) /*!< Whether a chunk is rolled back when one of its records fails. It doesn't span chunks. @b Default: false */
+	Q_PROPERTY(int maxRequestsInFlight READ maxRequestsInFlight WRITE setMaxRequestsInFlight) /*!< How many chunks may be sent at the same time. @b Default: 3 */
+	Q_PROPERTY(int count READ count) /*!< The number of records */
+
+public:
+	static const int MaxRecordsPerRequest = 200; /*!< The limit of records per call of the sObject Collections resource */
+
+	/*! @param method @c HTTPMethod::HTTPPost to create, @c HTTPMethod::HTTPPatch to update or @c HTTPMethod::HTTPDelete to delete
+	 * @param objectType the type of the records, e.g. "Account". Not used to delete.
+	 * @param records the fields of each record as @c QVariantMap, including "Id" to update. The ids of the records to delete.
+	 * @param apiVersion the API version, e.g. "/v42.0"
+	 * @param endPoint the end point, e.g. "/services/data"
+	 * @param userAgent the user agent
+	 * @param parent the parent object */
+	SFCollectionRequest(const HTTPMethodType & method, const QString & objectType, const QVariantList & records,
+			const QString & apiVersion, const QString & endPoint, const QString & userAgent, QObject *parent = 0);
+	virtual ~SFCollectionRequest();
+
+	bool allOrNone() const { return this->mAllOrNone;}; /*!< @see SFCollectionRequest::allOrNone */
+	void setAllOrNone(bool allOrNone) { this->mAllOrNone = allOrNone;}; /*!< @see SFCollectionRequest::allOrNone */
+	int maxRequestsInFlight() const { return this->mMaxRequestsInFlight;}; /*!< @see SFCollectionRequest::maxRequestsInFlight */
+	void setMaxRequestsInFlight(int count) { this->mMaxRequestsInFlight = qMax(1, count);}; /*!< @see SFCollectionRequest::maxRequestsInFlight */
+	int count() const { return this->mRecords.size();}; /*!< @see SFCollectionRequest::count */
+	HTTPMethodType method() const { return this->mMethod;}; /*!< @return the HTTP verb of the chunks */
+	const QVariantList & records() const { return this->mRecords;}; /*!< @return the records, or the ids of the records to delete */
+
+	/*! @return the number of chunks the records are split into */
+	int chunkCount() const { return (this->mRecords.size() + MaxRecordsPerRequest - 1) / MaxRecordsPerRequest;};
+	/*! @param index the index of the chunk
+	 * @return the first record of the chunk */
+	int chunkOffset(int index) const { return index * MaxRecordsPerRequest;};
+	/*! @param index the index of the chunk
+	 * @return the number of records of the chunk */
+	int chunkSize(int index) const { return qMin(MaxRecordsPerRequest, this->mRecords.size() - this->chunkOffset(index));};
+	/*! Create the request of a chunk. The caller owns it.
+	 * @param index the index of the chunk
+	 * @return the request */
+	SFRestRequest *createChunkRequest(int index) const;
+
+private:
+	Q_DISABLE_COPY(SFCollectionRequest)
+
+	HTTPMethodType mMethod;
+	QString mObjectType;
+	QVariantList mRecords;
+	QString mApiVersion;
+	QString mEndPoint;
+	QString mUserAgent;
+	bool mAllOrNone;
+	int mMaxRequestsInFlight;
+};
+
+} /* namespace sf */
+Q_DECLARE_METATYPE(sf::SFCollectionRequest*)
+#endif /* SFCOLLECTIONREQUEST_H_ */
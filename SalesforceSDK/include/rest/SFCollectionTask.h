@@ -0,0 +1,81 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCollectionTask.h
+*/
+
+
+#ifndef SFCOLLECTIONTASK_H_
+#define SFCOLLECTIONTASK_H_
+
+#include <QObject>
+#include <QVariant>
+#include <QVector>
+
+namespace sf {
+
+class SFCollectionRequest;
+class SFResult;
+
+/*!
+ * @class SFCollectionTask
+ * @headerfile SFCollectionTask.h <rest/SFCollectionTask.h>
+ * @brief Sends the chunks of a @c SFCollectionRequest through @c SFRestAPI and merges their results.
+ *
+ * @details
+ * Each chunk is an ordinary REST request, so it is scheduled, authenticated and re-tried like any other. At most
+ * @c SFCollectionRequest::maxRequestsInFlight chunks are sent at the same time. Once all of them are done, the merged result is
+ * delivered through @c taskResultReady() and the task deletes itself, along with the request and the result.
+ *
+ * Typically, developers don't need to deal with this class directly, see @c SFRestAPI::sendCollectionRequest().
+ */
+class SFCollectionTask : public QObject {
+	Q_OBJECT
+signals:
+	/*! Emitted when all the chunks are done
+	 * @param result the merged result. @note the object is only valid within the scope of connected slot. */
+	void taskResultReady(sf::SFResult* result);
+
+public:
+	/*! @param request the request. The task takes ownership of it. */
+	SFCollectionTask(SFCollectionRequest * request);
+	virtual ~SFCollectionTask();
+
+	/*! Add an @c QVariant to the merged result and associate it with a key. @see SFResult::tags */
+	void putTag(const QString & key, const QVariant & tag) { mTags[key] = tag;};
+	/*! Send the first chunks. Must be called once, in the thread the task lives in. */
+	void start();
+
+private slots:
+	void onChunkResultReady(sf::SFResult* result);
+	void finish();
+
+private:
+	Q_DISABLE_COPY(SFCollectionTask)
+
+	SFCollectionRequest *mRequest;
+	QVariantHash mTags;
+	int mNextChunk; //the next chunk to send
+	int mRunningChunks;
+	int mFailedChunks;
+	int mErrorCode; //of the first chunk that failed
+	QString mErrorMessage;
+	QVector<QVariant> mRecordResults; //in the order of the records
+
+	void sendNextChunk();
+};
+
+} /* namespace sf */
+#endif /* SFCOLLECTIONTASK_H_ */
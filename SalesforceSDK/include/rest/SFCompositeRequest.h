@@ -0,0 +1,103 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCompositeRequest.h
+*/
+
+
+#ifndef SFCOMPOSITEREQUEST_H_
+#define SFCOMPOSITEREQUEST_H_
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+namespace sf {
+
+class SFRestRequest;
+
+/*!
+ * @class SFCompositeRequest
+ * @headerfile SFCompositeRequest.h <rest/SFCompositeRequest.h>
+ * @brief A builder for a Composite request, which runs up to 25 dependent subrequests in a single round trip.
+ *
+ * @details
+ * Each subrequest gets a reference id. Later subrequests can use the result of an earlier one in their path or fields through
+ * @c reference(), e.g. the id of a record created earlier in the same call. The subrequests run in order on the server.
+ *
+ * @code{.cpp}
+ * SFRestAPI *api = SFRestAPI::instance();
+ * SFCompositeRequest composite;
+ * composite.setAllOrNone(true);
+ * composite.add("newAccount", api->requestForCreateObject("Account", accountFields));
+ * contactFields["AccountId"] = SFCompositeRequest::reference("newAccount");
+ * composite.add("newContact", api->requestForCreateObject("Contact", contactFields));
+ * api->sendRestRequest(api->requestForComposite(&composite), this, SLOT(onCompositeResultReady(sf::SFResult*)));
+ *
+ * void MyClass::onCompositeResultReady(sf::SFResult *result) {
+ * 	QVariantMap responses = SFCompositeRequest::responsesByReference(result->payload());
+ * 	QString contactId = responses["newContact"].toMap()["body"].toMap()["id"].toString();
+ * }
+ * @endcode
+ *
+ * @see SFRestAPI::requestForComposite(), <a href="https://developer.salesforce.com/docs/atlas.en-us.api_rest.meta/api_rest/resources_composite_composite.htm">Composite</a>
+ */
+class SFCompositeRequest : public QObject {
+	Q_OBJECT
+	Q_PROPERTY(bool allOrNone READ allOrNone WRITE setAllOrNone) /*!< Whether the whole request is rolled back when a subrequest fails. @b Default: false */
+	Q_PROPERTY(int count READ count) /*!< The number of subrequests */
+
+public:
+	static const int MaxSubrequests = 25; /*!< The limit of subrequests in a Composite request */
+
+	SFCompositeRequest(QObject *parent = 0);
+	virtual ~SFCompositeRequest();
+
+	/*! Add a subrequest. This function takes ownership of the @a request and deletes it later.
+	 * @param referenceId the name of the result, unique in this composite request. Letters, digits and underscores, starting with a letter.
+	 * @param request a request created by @c SFRestAPI. It must qualify for @c SFRestRequest::canBeBatched().
+	 * @return whether the subrequest was added */
+	Q_INVOKABLE bool add(const QString & referenceId, sf::SFRestRequest * request);
+
+	/*! @param referenceId the reference id of an earlier subrequest
+	 * @param field the field of its result, "id" for the id of a created record. Use dots and brackets for nested values, e.g. "records[0].Id"
+	 * @return the expression a later subrequest uses in its path or fields, e.g. "@{newAccount.id}" */
+	Q_INVOKABLE static QString reference(const QString & referenceId, const QString & field = "id");
+
+	/*! @param payload the payload of the result of a Composite request
+	 * @return the responses of the subrequests by reference id. Each one is a map with the keys "body", "httpHeaders",
+	 * "httpStatusCode" and "referenceId" */
+	Q_INVOKABLE static QVariantMap responsesByReference(const QVariant & payload);
+
+	bool allOrNone() const { return this->mAllOrNone;}; /*!< @see SFCompositeRequest::allOrNone */
+	void setAllOrNone(bool allOrNone) { this->mAllOrNone = allOrNone;}; /*!< @see SFCompositeRequest::allOrNone */
+	int count() const { return this->mSubrequests.size();}; /*!< @see SFCompositeRequest::count */
+	QStringList referenceIds() const { return this->mReferenceIds;}; /*!< @return the reference ids, in the order the subrequests run */
+
+	/*! @return the body of the Composite request */
+	QVariantMap toRequestBody() const;
+
+private:
+	Q_DISABLE_COPY(SFCompositeRequest)
+
+	bool mAllOrNone;
+	QStringList mReferenceIds;
+	QVariantList mSubrequests;
+};
+
+} /* namespace sf */
+Q_DECLARE_METATYPE(sf::SFCompositeRequest*)
+#endif /* SFCOMPOSITEREQUEST_H_ */
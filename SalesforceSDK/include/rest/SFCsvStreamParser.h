@@ -0,0 +1,161 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCsvStreamParser.h
+*/
+
+#ifndef SFCSVSTREAMPARSER_H_
+#define SFCSVSTREAMPARSER_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include "SFResponseConsumer.h"
+
+namespace sf {
+
+/*!
+ * @class SFCsvStreamHandler
+ * @headerfile SFCsvStreamParser.h <rest/SFCsvStreamParser.h>
+ * @brief The rows reported by @c SFCsvStreamParser.
+ */
+class SFCsvStreamHandler {
+public:
+	virtual ~SFCsvStreamHandler() {};
+
+	/*! A complete row. @return false to stop the parser */
+	virtual bool row(const QStringList & fields) = 0;
+};
+
+/*!
+ * @class SFCsvStreamParser
+ * @headerfile SFCsvStreamParser.h <rest/SFCsvStreamParser.h>
+ *
+ * @brief An incremental CSV parser, as defined in RFC 4180, that can be fed a document in chunks of any size.
+ *
+ * @details
+ * Every row is reported to a @c SFCsvStreamHandler as soon as its line ends, even if it was split across chunks, quoted line breaks
+ * included. Only the row being read is kept. Rows may end with LF or CRLF, empty lines are skipped and fields are decoded as UTF-8.
+ *
+ * @code
+ * SFCsvStreamParser parser(&handler);
+ * while (!device->atEnd()) {
+ * 	if (!parser.feed(device->read(16 * 1024))) {
+ * 		break;
+ * 	}
+ * }
+ * if (!parser.finish()) {
+ * 	sfWarning() << parser.errorString();
+ * }
+ * @endcode
+ *
+ * @see SFCsvRecordsConsumer, SFCsvWriter
+ */
+class SFCsvStreamParser {
+public:
+	/*! @param handler the handler of the rows, not owned
+	 * @param delimiter the field delimiter */
+	explicit SFCsvStreamParser(SFCsvStreamHandler *handler, char delimiter = ',');
+
+	/*! Forget any partial row and error, to parse a new document */
+	void reset();
+	/*! Parse the next chunk of the document.
+	 * @return false if the document is invalid or the handler stopped the parser. Further calls do nothing. */
+	bool feed(const QByteArray & chunk);
+	/*! Signal the end of the document. A last row without a line break is reported now.
+	 * @return false if the document ends inside a quoted field */
+	bool finish();
+
+	/*! @return whether an error occurred */
+	bool hasError() const { return !mError.isNull(); };
+	/*! @return the description of the error, including its position in the document */
+	QString errorString() const { return mError; };
+	/*! @return the number of rows reported so far */
+	int rowCount() const { return mRowCount; };
+
+private:
+	enum State {
+		FieldStart,
+		Unquoted,
+		Quoted,
+		QuoteInQuoted, //a quote inside a quoted field, either escaping the next one or closing the field
+		AfterCR
+	};
+
+	SFCsvStreamHandler *mHandler;
+	char mDelimiter;
+	State mState;
+	QByteArray mField;
+	QStringList mFields;
+	int mRowCount;
+	qint64 mOffset;
+	QString mError;
+
+	void endField();
+	bool endRow();
+	bool fail(const QString & message);
+};
+
+/*!
+ * @class SFCsvRecordsConsumer
+ * @headerfile SFCsvStreamParser.h <rest/SFCsvStreamParser.h>
+ *
+ * @brief A @c SFResponseConsumer that parses a CSV response, such as the results of a bulk job, while it downloads.
+ *
+ * @details
+ * The first row names the columns, every other row is passed to @c processRow(). The default @c processRow() keeps the rows, the result
+ * is then a map with the column names under "columns" and the rows, each a @c QStringList, under "rows".
+ * Subclasses that store the rows as they arrive return without keeping them, so memory use doesn't grow with the size of the response.
+ * @note @c processRow() is called in a thread of the parsing pool.
+ */
+class SFCsvRecordsConsumer : public SFResponseConsumer, protected SFCsvStreamHandler {
+public:
+	SFCsvRecordsConsumer();
+	virtual ~SFCsvRecordsConsumer();
+
+	/*! @return the names of the columns, once the first row is parsed */
+	const QStringList & columns() const { return mColumns; };
+	/*! @return the number of rows processed so far, the header excluded */
+	int rowCount() const { return mRowCount; };
+
+	/* SFResponseConsumer */
+	bool begin(int statusCode, const QByteArray & contentType);
+	bool consume(const QByteArray & chunk);
+	bool finish();
+	QVariant result() const;
+	QString errorString() const;
+
+protected:
+	/*! Called for every row after the header, in document order.
+	 * @param index the index of the row, 0 for the first one after the header
+	 * @param fields the fields of the row, as many as there are columns
+	 * @return false to stop parsing the response */
+	virtual bool processRow(int index, const QStringList & fields);
+
+	/* SFCsvStreamHandler */
+	bool row(const QStringList & fields);
+
+private:
+	SFCsvStreamParser mParser;
+	QStringList mColumns;
+	QVariantList mRows;
+	int mRowCount;
+	QString mError;
+};
+
+} /* namespace sf */
+#endif /* SFCSVSTREAMPARSER_H_ */
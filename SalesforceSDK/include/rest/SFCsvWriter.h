@@ -0,0 +1,73 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCsvWriter.h
+*/
+
+#ifndef SFCSVWRITER_H_
+#define SFCSVWRITER_H_
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QStringList>
+#include <QVariant>
+
+namespace sf {
+
+/*!
+ * @class SFCsvWriter
+ * @headerfile SFCsvWriter.h <rest/SFCsvWriter.h>
+ *
+ * @brief Writes rows of CSV, as defined in RFC 4180 and accepted by the Bulk API, to a @c QIODevice.
+ *
+ * @details Fields that contain the delimiter, a double quote or a line break are quoted, and quotes inside them are doubled.
+ * Rows end with a single LF. Output is buffered, call @c flush() once the last row is written.
+ *
+ * Values are converted the way Salesforce expects them: booleans as "true" or "false", dates as "yyyy-MM-dd",
+ * date-times in UTC as "yyyy-MM-ddThh:mm:ss.zzzZ" and null values as empty fields.
+ */
+class SFCsvWriter {
+public:
+	/*! @param device the device to write to, already open. The writer doesn't take ownership of it.
+	 * @param delimiter the field delimiter */
+	explicit SFCsvWriter(QIODevice * device, char delimiter = ',');
+	~SFCsvWriter();
+
+	/*! Write a row of text fields. @return false if the device refused the data */
+	bool writeRow(const QStringList & fields);
+	/*! Write a row of values, converted as described above. @return false if the device refused the data */
+	bool writeRow(const QVariantList & values);
+	/*! Write out the buffered rows. @return false if the device refused the data */
+	bool flush();
+
+	int rowCount() const { return mRowCount; }; /*!< @return the number of rows written so far */
+
+	/*! @return the text of a value in a field, before quoting */
+	static QString toField(const QVariant & value);
+
+private:
+	Q_DISABLE_COPY(SFCsvWriter)
+
+	QIODevice *mDevice;
+	char mDelimiter;
+	QByteArray mBuffer;
+	int mRowCount;
+
+	void appendField(const QString & field);
+	bool endRow();
+};
+
+} /* namespace sf */
+#endif /* SFCSVWRITER_H_ */
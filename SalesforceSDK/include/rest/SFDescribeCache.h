@@ -0,0 +1,157 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFDescribeCache.h
+*/
+
+#ifndef SFDESCRIBECACHE_H_
+#define SFDESCRIBECACHE_H_
+
+#include <QAtomicPointer>
+#include <QCache>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+namespace sf {
+
+class SFOAuthInfo;
+class SFResult;
+
+/*!
+ * @class SFDescribeCache
+ * @headerfile SFDescribeCache.h <rest/SFDescribeCache.h>
+ * @brief A persistent, encrypted cache of describe documents: the global describe, the metadata and the full describe of sObjects.
+ *
+ * @details
+ * Describe documents are often hundreds of KB and rarely change, so screens that need them shouldn't wait for the network.
+ * @c describeGlobal(), @c metadata() and @c describe() return what is cached right away, from memory or from disk, and revalidate
+ * it in the background once per session. Revalidation sends the date of the cached document as "If-Modified-Since", so an unchanged
+ * document costs a 304 response without a body. When a newer document arrives, @c updated() is emitted.
+ *
+ * Documents are stored per org and API version, in files sealed with @c SFSecurityManager::encryptData(). A file is only read,
+ * decrypted and decoded when its document is requested, and it is decoded with @c QDataStream, which is much faster than parsing JSON.
+ * Revalidation only reads the date in the clear header of the file. The most recently used documents stay decoded in memory,
+ * see @c SFDescribeCache::maxDocumentsInMemory.
+ *
+ * After a login, the global describe and every document already on disk are revalidated at @c SFRequestPriority::BackgroundSync,
+ * as well as the describes of @c SFDescribeCache::warmUpObjects that aren't cached yet. All documents are removed on logout.
+ *
+ * The class is a singleton and must be used from the application's main thread.
+ *
+ * Example in QML:
+ * @code{.qml}
+ * Page {
+ * 	property variant accountDescribe: SFDescribeCache.describe("Account")
+ * 	onCreationCompleted: {
+ * 		SFDescribeCache.updated.connect(function(kind, objectType, content) {
+ * 			if (kind == SFDescribeCache.Describe && objectType == "Account") {
+ * 				accountDescribe = content;
+ * 			}
+ * 		});
+ * 	}
+ * }
+ * @endcode
+ *
+ * @see SFRestAPI::requestForDescribeGlobal(), SFRestAPI::requestForMetadata(), SFRestAPI::requestForDescribeObject()
+ */
+class SFDescribeCache : public QObject {
+	Q_OBJECT
+	Q_ENUMS(Kind)
+	Q_PROPERTY(QStringList warmUpObjects READ warmUpObjects WRITE setWarmUpObjects) /*!< The sObjects whose describe is fetched after login even if it isn't cached yet */
+	Q_PROPERTY(int maxDocumentsInMemory READ maxDocumentsInMemory WRITE setMaxDocumentsInMemory) /*!< How many of the most recently used documents are kept decoded in memory. @b Default: 32 */
+
+public:
+	/*! The kinds of describe documents */
+	enum Kind {
+		Global, /*!< The list of sObjects, see @c SFRestAPI::requestForDescribeGlobal() */
+		Metadata, /*!< The basic metadata of an sObject, see @c SFRestAPI::requestForMetadata() */
+		Describe /*!< The full describe of an sObject, see @c SFRestAPI::requestForDescribeObject() */
+	};
+
+signals:
+	/*! Emitted when a document was fetched for the first time or changed on the server.
+	 * @param kind the kind of the document
+	 * @param objectType the sObject, empty for @c SFDescribeCache::Global
+	 * @param content the new document */
+	void updated(sf::SFDescribeCache::Kind kind, const QString & objectType, const QVariantMap & content);
+	/*! Emitted when a document couldn't be fetched or revalidated. The cached document, if any, is still returned. */
+	void failed(sf::SFDescribeCache::Kind kind, const QString & objectType, int code, const QString & message);
+
+public:
+	Q_INVOKABLE static SFDescribeCache *instance(); /*!< @return The singleton instance. This function is thread-safe. */
+
+	/*! @return the cached global describe, empty if there is none yet. It is fetched or revalidated in the background. */
+	Q_INVOKABLE QVariantMap describeGlobal();
+	/*! @return the cached metadata of the sObject, empty if there is none yet. It is fetched or revalidated in the background. */
+	Q_INVOKABLE QVariantMap metadata(const QString & objectType);
+	/*! @return the cached describe of the sObject, empty if there is none yet. It is fetched or revalidated in the background. */
+	Q_INVOKABLE QVariantMap describe(const QString & objectType);
+	/*! Revalidate a document now, even if it was revalidated during this session.
+	 * @param kind the kind of the document
+	 * @param objectType the sObject, ignored for @c SFDescribeCache::Global */
+	Q_INVOKABLE void refresh(sf::SFDescribeCache::Kind kind, const QString & objectType = QString());
+	/*! Remove all documents, in memory and on disk, of all orgs */
+	Q_INVOKABLE void clear();
+
+	const QStringList & warmUpObjects() const { return this->mWarmUpObjects;}; /*!< @see SFDescribeCache::warmUpObjects */
+	void setWarmUpObjects(const QStringList & objectTypes) { this->mWarmUpObjects = objectTypes;}; /*!< @see SFDescribeCache::warmUpObjects */
+	int maxDocumentsInMemory() const { return this->mEntries.maxCost();}; /*!< @see SFDescribeCache::maxDocumentsInMemory */
+	void setMaxDocumentsInMemory(int count) { this->mEntries.setMaxCost(qMax(1, count));}; /*!< @see SFDescribeCache::maxDocumentsInMemory */
+
+public slots:
+	/*! Revalidate the global describe and every cached document of the current org, then fetch @c SFDescribeCache::warmUpObjects.
+	 * Called automatically after the first successful login of a session. */
+	void warmUp();
+
+private slots:
+	void onSFOAuthFlowSuccess(SFOAuthInfo*);
+	void onSFUserLoggedOut();
+	void onResultReady(sf::SFResult* result);
+
+private:
+	struct Entry {
+		QVariantMap content;
+		QString lastModified;
+	};
+
+	static QAtomicPointer<SFDescribeCache> sharedInstance;
+	QCache<QString, Entry> mEntries; //decoded documents by path, for the current org and version only
+	QString mScope; //the org and version the decoded documents belong to
+	QSet<QString> mValidated; //paths revalidated during this session
+	QSet<QString> mPending; //paths being fetched
+	QStringList mWarmUpObjects;
+	bool mWarmedUp;
+	int mGeneration; //tags the requests, so the ones sent before a logout are ignored
+
+	SFDescribeCache();
+	virtual ~SFDescribeCache();
+	Q_DISABLE_COPY(SFDescribeCache)
+
+	QVariantMap lookup(Kind kind, const QString & objectType);
+	void revalidate(Kind kind, const QString & objectType, bool background);
+	Entry *load(const QString & path);
+	QString currentScope() const;
+	QString scopeDirectory(const QString & scope) const;
+	QString filePath(const QString & scope, const QString & path) const;
+	static QString pathFor(Kind kind, const QString & objectType);
+	static bool kindFor(const QString & path, Kind * kind, QString * objectType);
+};
+
+} /* namespace sf */
+Q_DECLARE_METATYPE(sf::SFDescribeCache::Kind)
+#endif /* SFDESCRIBECACHE_H_ */
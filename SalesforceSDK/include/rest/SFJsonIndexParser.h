@@ -0,0 +1,111 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonIndexParser.h
+*/
+
+#ifndef SFJSONINDEXPARSER_H_
+#define SFJSONINDEXPARSER_H_
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+namespace sf {
+
+class SFStringPool;
+
+/*!
+ * @class SFJsonIndexParser
+ * @headerfile SFJsonIndexParser.h <rest/SFJsonIndexParser.h>
+ *
+ * @brief A two pass JSON parser for documents that are already complete in memory, producing the same @c QVariant tree as
+ * @c bb::data::JsonDataAccess.
+ *
+ * @details
+ * The first pass builds a structural index: the position of every bracket, colon, comma, string and scalar outside of strings,
+ * plus the position of the bracket that closes every opening one. Strings are skipped eight bytes at a time until a quote or
+ * a backslash shows up. The second pass materializes values by walking the index.
+ *
+ * Because the index tells where every element of an array ends without decoding it, the elements of a large records array
+ * in the top level object are materialized in parallel with @c QtConcurrent, then put back in order. Keys are interned, so records
+ * share their keys, and the "attributes" object of every record can be dropped with @c setStripRecordAttributes().
+ *
+ * @code
+ * SFJsonIndexParser parser(buffer);
+ * if (parser.parse()) {
+ * 	QVariantMap content = parser.result().toMap();
+ * } else {
+ * 	sfWarning() << parser.errorString();
+ * }
+ * @endcode
+ *
+ * The index alone is also the backing store of @c SFJsonView, which decodes values only when they are accessed.
+ *
+ * @see SFRestRequest::jsonParser, SFJsonView
+ */
+class SFJsonIndexParser {
+public:
+	/*! @param json the document. The parser keeps a shallow copy of it. */
+	explicit SFJsonIndexParser(const QByteArray & json);
+
+	/*! Parse the document.
+	 * @param recordsKey the key of the array in the top level object whose elements may be materialized in parallel
+	 * @return whether the document is valid */
+	bool parse(const QString & recordsKey = "records");
+	/*! @return the document, once @c parse() succeeded */
+	QVariant result() const { return mResult; };
+	/*! @return the description of the error, if @c parse() failed */
+	QString errorString() const { return mError; };
+	/*! @return whether the "attributes" members of records are dropped */
+	bool stripRecordAttributes() const { return mStripAttributes; };
+	/*! @param strip whether to drop the "attributes" members of the elements of the records array, and of the records nested
+	 * in them. @b Default: false */
+	void setStripRecordAttributes(bool strip) { mStripAttributes = strip; };
+
+private:
+	friend class SFJsonIndexRangeMaterializer;
+	friend class SFJsonView;
+	friend class SFJsonValue;
+
+	struct ValueContext {
+		SFStringPool *keys; //interns the keys of objects, may be NULL
+		bool stripAttributes;
+	};
+
+	QByteArray mJson;
+	const char *mData;
+	int mSize;
+	QVector<int> mIndex; //positions of structural characters and the first byte of strings and scalars
+	QVector<int> mMatch; //for an opening bracket, the index of its closing bracket
+	int mParallelAt; //index of the records array that is materialized in parallel, or -1
+	bool mStripAttributes;
+	QVariant mResult;
+	QString mError;
+
+	bool buildIndex();
+	bool parseRecords(int arrayIndex, QVariantList * records) const;
+	bool valueAt(int & i, QVariant * value, const ValueContext & context) const;
+	bool stringAt(int i, QString * string) const;
+	bool keyAt(int i, QString * key, SFStringPool * keys) const;
+	bool scalarAt(int i, QVariant * value) const;
+	int skip(int i) const;
+	char charAt(int i) const { return i < mIndex.size() ? mData[mIndex.at(i)] : '\0'; };
+	bool fail(const QString & message, int offset);
+};
+
+} /* namespace sf */
+#endif /* SFJSONINDEXPARSER_H_ */
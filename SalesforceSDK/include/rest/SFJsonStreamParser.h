@@ -0,0 +1,307 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonStreamParser.h
+*/
+
+#ifndef SFJSONSTREAMPARSER_H_
+#define SFJSONSTREAMPARSER_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include "SFResponseConsumer.h"
+#include "SFStringPool.h"
+
+namespace sf {
+
+/*!
+ * @class SFJsonScalar
+ * @headerfile SFJsonStreamParser.h <rest/SFJsonStreamParser.h>
+ * @brief A string, number, bool or null value, as reported by @c SFJsonStreamParser before it is converted to a @c QVariant.
+ *
+ * @details Strings are kept as the UTF-8 bytes read by the parser, so a handler that skips a value or converts it to another
+ * type never builds a @c QString. A scalar only lives for the duration of @c SFJsonStreamHandler::scalar().
+ */
+class SFJsonScalar {
+public:
+	enum Type {
+		Null,
+		Bool,
+		Integer, /*!< an integer that fits in a @c qlonglong */
+		Double, /*!< any other number */
+		String
+	};
+
+	static SFJsonScalar null() { return SFJsonScalar(Null); }; /*!< @return a null value */
+	static SFJsonScalar boolean(bool value) { SFJsonScalar s(Bool); s.mInteger = value; return s; }; /*!< @return a bool */
+	static SFJsonScalar integer(qlonglong value) { SFJsonScalar s(Integer); s.mInteger = value; return s; }; /*!< @return an integer */
+	static SFJsonScalar number(double value) { SFJsonScalar s(Double); s.mDouble = value; return s; }; /*!< @return a number that is not an integer */
+	/*! @return a string. @a utf8 is not copied and must outlive the scalar */
+	static SFJsonScalar string(const QByteArray & utf8) { SFJsonScalar s(String); s.mUtf8 = &utf8; return s; };
+
+	Type type() const { return mType; }; /*!< @return the type of the value */
+	bool isNull() const { return mType == Null; }; /*!< @return whether the value is null */
+	const QByteArray & utf8() const; /*!< @return the bytes of a string, an empty array for other types */
+
+	/*
+	 * Conversions, they follow the ones of QVariant
+	 */
+	bool toBool() const;
+	qlonglong toLongLong() const;
+	double toDouble() const;
+	QString toString() const;
+	QVariant toVariant() const; /*!< @return the value as @c SFJsonStreamHandler::value() receives it */
+
+private:
+	explicit SFJsonScalar(Type type) : mType(type), mInteger(0), mDouble(0), mUtf8(0) {};
+
+	Type mType;
+	qlonglong mInteger;
+	double mDouble;
+	const QByteArray *mUtf8;
+};
+
+/*!
+ * @class SFJsonStreamHandler
+ * @headerfile SFJsonStreamParser.h <rest/SFJsonStreamParser.h>
+ * @brief The events reported by @c SFJsonStreamParser. Every function returns false to stop the parser.
+ */
+class SFJsonStreamHandler {
+public:
+	virtual ~SFJsonStreamHandler() {};
+
+	virtual bool startObject() = 0; /*!< '{' */
+	virtual bool endObject() = 0; /*!< '}' */
+	virtual bool startArray() = 0; /*!< '[' */
+	virtual bool endArray() = 0; /*!< ']' */
+	virtual bool key(const QString & key) = 0; /*!< The key of the next value in the current object */
+	/*! A string, number (@c qlonglong if it is an integer that fits, @c double otherwise), bool or null (an invalid @c QVariant) value */
+	virtual bool value(const QVariant & value) = 0;
+	/*! The same values before they are converted. Handlers that decode values into their own types override it,
+	 * the default implementation calls @c value() */
+	virtual bool scalar(const SFJsonScalar & scalar) { return this->value(scalar.toVariant()); };
+};
+
+/*!
+ * @class SFJsonStreamParser
+ * @headerfile SFJsonStreamParser.h <rest/SFJsonStreamParser.h>
+ *
+ * @brief An incremental, event based JSON parser that can be fed a document in chunks of any size.
+ *
+ * @details
+ * Unlike @c bb::data::JsonDataAccess, the parser never builds the document. It reports every token to a @c SFJsonStreamHandler
+ * as soon as it is complete, even if it was split across chunks, and only keeps the token being read and the nesting of containers.
+ * Keys are interned for the whole document, so a key repeated in every record is reported as the same shared @c QString.
+ *
+ * @code
+ * SFJsonStreamParser parser(&handler);
+ * while (!device->atEnd()) {
+ * 	if (!parser.feed(device->read(16 * 1024))) {
+ * 		break;
+ * 	}
+ * }
+ * if (!parser.finish()) {
+ * 	sfWarning() << parser.errorString();
+ * }
+ * @endcode
+ *
+ * @see SFJsonRecordsConsumer
+ */
+class SFJsonStreamParser {
+public:
+	/*! @param handler the handler of the events, not owned */
+	explicit SFJsonStreamParser(SFJsonStreamHandler *handler);
+
+	/*! Forget any partial document and error, to parse a new document */
+	void reset();
+	/*! Parse the next chunk of the document.
+	 * @return false if the document is invalid or the handler stopped the parser. Further calls do nothing. */
+	bool feed(const QByteArray & chunk);
+	/*! Signal the end of the document.
+	 * @return false if the document is incomplete or invalid */
+	bool finish();
+
+	/*! @return whether an error occurred */
+	bool hasError() const { return !mError.isNull(); };
+	/*! @return the description of the error, including its position in the document */
+	QString errorString() const { return mError; };
+	/*! @return the number of bytes parsed so far */
+	qint64 offset() const { return mOffset; };
+
+private:
+	enum LexState {
+		LexNone,
+		LexString,
+		LexStringEscape,
+		LexStringUnicode,
+		LexNumber,
+		LexLiteral
+	};
+	enum Expect {
+		ExpectValue,
+		ExpectValueOrEnd,
+		ExpectKey,
+		ExpectKeyOrEnd,
+		ExpectColon,
+		ExpectCommaOrEnd,
+		ExpectEndOfInput
+	};
+
+	SFJsonStreamHandler *mHandler;
+	LexState mLexState;
+	Expect mExpect;
+	QVector<char> mContainers;
+	QByteArray mToken;
+	uint mUnicode;
+	int mUnicodeDigits;
+	uint mHighSurrogate;
+	qint64 mOffset;
+	QString mError;
+	SFStringPool mKeys;
+
+	bool structural(char c);
+	bool expectsValue() const { return mExpect == ExpectValue || mExpect == ExpectValueOrEnd; };
+	bool endToken(LexState kind);
+	bool emitValue(const SFJsonScalar & value);
+	bool endContainer(char open);
+	void afterValue();
+	void appendCodePoint(uint codePoint);
+	void flushHighSurrogate();
+	bool fail(const QString & message);
+	bool unexpected(char c);
+};
+
+/*!
+ * @class SFJsonVariantBuilder
+ * @headerfile SFJsonStreamParser.h <rest/SFJsonStreamParser.h>
+ * @brief A @c SFJsonStreamHandler that builds the same @c QVariant tree as @c bb::data::JsonDataAccess.
+ */
+class SFJsonVariantBuilder : public SFJsonStreamHandler {
+public:
+	SFJsonVariantBuilder();
+
+	void reset(); /*!< Discard the document built so far */
+	bool isComplete() const { return mComplete; }; /*!< @return whether a whole value has been built */
+	QVariant result() const { return mResult; }; /*!< @return the document */
+
+	bool startObject();
+	bool endObject();
+	bool startArray();
+	bool endArray();
+	bool key(const QString & key);
+	bool value(const QVariant & value);
+
+private:
+	struct Frame {
+		bool isObject;
+		QString key;
+		QVariantMap map;
+		QVariantList list;
+	};
+	QList<Frame> mStack;
+	QVariant mResult;
+	bool mComplete;
+};
+
+/*!
+ * @class SFJsonRecordsConsumer
+ * @headerfile SFJsonStreamParser.h <rest/SFJsonStreamParser.h>
+ *
+ * @brief A @c SFResponseConsumer that parses a JSON response while it downloads and hands over the elements of its records array one at a time.
+ *
+ * @details
+ * The consumer is meant for query style responses, e.g. @code {"totalSize":2000,"done":false,"nextRecordsUrl":"...","records":[{...},{...}]} @endcode
+ * Every element of the array under @c recordsKey() of the top level object is built on its own and passed to @c processRecord().
+ * The rest of the document is built as usual and is the consumer's result.
+ *
+ * The default @c processRecord() keeps the records, so that the result is the same as @c bb::data::JsonDataAccess would produce.
+ * Subclasses that store or aggregate the records as they arrive return without keeping them, so memory use doesn't grow with the size of the response:
+ * @code
+ * class ContactWriter : public SFJsonRecordsConsumer {
+ * protected:
+ * 	bool processRecord(int index, const QVariant & record) {
+ * 		return mDatabase.insert(record.toMap());
+ * 	}
+ * };
+ *
+ * SFRestRequest *request = SFRestAPI::instance()->requestForQuery("SELECT Id, Name FROM Contact");
+ * request->setResponseConsumer(new ContactWriter());
+ * @endcode
+ * The "attributes" object Salesforce adds to every record is usually not needed, @c setStripAttributes() drops it, in nested
+ * records too, before the records are built.
+ * @note @c processRecord() is called in a thread of the parsing pool.
+ */
+class SFJsonRecordsConsumer : public SFResponseConsumer, protected SFJsonStreamHandler {
+public:
+	/*! @param recordsKey the key of the array whose elements are passed to @c processRecord() */
+	explicit SFJsonRecordsConsumer(const QString & recordsKey = "records");
+	virtual ~SFJsonRecordsConsumer();
+
+	/*! @return the key of the array whose elements are passed to @c processRecord() */
+	const QString & recordsKey() const { return mRecordsKey; };
+	/*! @return the number of records processed so far */
+	int recordCount() const { return mRecordCount; };
+	/*! @return whether the "attributes" members of records are dropped */
+	bool stripAttributes() const { return mStripAttributes; };
+	/*! @param strip whether to drop the "attributes" members of records. @b Default: false */
+	void setStripAttributes(bool strip) { mStripAttributes = strip; };
+
+	/* SFResponseConsumer */
+	bool begin(int statusCode, const QByteArray & contentType);
+	bool consume(const QByteArray & chunk);
+	bool finish();
+	QVariant result() const;
+	QString errorString() const;
+
+protected:
+	/*! Called for every element of the records array, in document order.
+	 * @param index the index of the record in the array
+	 * @param record the record
+	 * @return false to stop parsing the response */
+	virtual bool processRecord(int index, const QVariant & record);
+
+	/* SFJsonStreamHandler */
+	bool startObject();
+	bool endObject();
+	bool startArray();
+	bool endArray();
+	bool key(const QString & key);
+	bool value(const QVariant & value);
+
+private:
+	QString mRecordsKey;
+	SFJsonStreamParser mParser;
+	SFJsonVariantBuilder mDocument;
+	SFJsonVariantBuilder mRecord;
+	QVariantList mRecords;
+	int mDepth;
+	int mRecordCount;
+	bool mRootIsObject;
+	bool mPendingRecordsKey;
+	bool mInRecords;
+	bool mInRecord;
+	bool mStripAttributes;
+	int mSkipDepth; //depth of the member being dropped, 0 if none
+	QString mError;
+
+	bool endContainer(bool isObject);
+	bool flushPendingKey();
+};
+
+} /* namespace sf */
+#endif /* SFJSONSTREAMPARSER_H_ */
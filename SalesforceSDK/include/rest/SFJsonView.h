@@ -0,0 +1,150 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonView.h
+*/
+
+#ifndef SFJSONVIEW_H_
+#define SFJSONVIEW_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QMetaType>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+namespace sf {
+
+class SFJsonIndexParser;
+
+/*!
+ * @class SFJsonValue
+ * @headerfile SFJsonView.h <rest/SFJsonView.h>
+ * @brief A handle to a value inside a @c SFJsonView. The value is decoded only when one of the accessors is called.
+ *
+ * @details Handles are cheap to copy and keep the whole document alive. Accessing a missing key or index, or a value
+ * of the wrong type, returns an undefined value or the given default, so lookups can be chained without checks.
+ */
+class SFJsonValue {
+public:
+	/*! The JSON type of a value */
+	enum Type {
+		Undefined, /*!< The value doesn't exist, e.g. a missing key */
+		Null,
+		Bool,
+		Number,
+		String,
+		Array,
+		Object
+	};
+
+	SFJsonValue(); /*!< Creates an undefined value */
+
+	Type type() const; /*!< @return the JSON type of the value */
+	bool isUndefined() const { return this->type() == Undefined; };
+	bool isNull() const { return this->type() == Null; };
+	bool isBool() const { return this->type() == Bool; };
+	bool isNumber() const { return this->type() == Number; };
+	bool isString() const { return this->type() == String; };
+	bool isArray() const { return this->type() == Array; };
+	bool isObject() const { return this->type() == Object; };
+
+	/*! @return the boolean, or @a defaultValue if the value is not a boolean */
+	bool toBool(bool defaultValue = false) const;
+	/*! @return the number, or @a defaultValue if the value is not a number */
+	double toDouble(double defaultValue = 0) const;
+	/*! @return the number, or @a defaultValue if the value is not an integer */
+	qlonglong toLongLong(qlonglong defaultValue = 0) const;
+	/*! @return the string, the text of a number or a boolean, or @a defaultValue for other types */
+	QString toString(const QString & defaultValue = QString()) const;
+
+	/*! @return the number of elements of an array or members of an object, 0 for other types */
+	int size() const;
+	/*! @return the element at the given index of an array. This walks the array, use @c elements() to visit all of them. */
+	SFJsonValue at(int index) const;
+	/*! @return the member of an object with the given key */
+	SFJsonValue value(const QString & key) const;
+	/*! @return the elements of an array, or the values of the members of an object */
+	QList<SFJsonValue> elements() const;
+	/*! @return the keys of an object, in document order */
+	QStringList keys() const;
+	SFJsonValue operator[](int index) const { return this->at(index); }; /*!< Same as @c at() */
+	SFJsonValue operator[](const QString & key) const { return this->value(key); }; /*!< Same as @c value() */
+
+	/*! Look up a nested value.
+	 * @param path keys separated by dots and array indexes in brackets, e.g. "records[3].Owner.Name"
+	 * @return the value, or an undefined value if any part of the path doesn't exist */
+	SFJsonValue path(const QString & path) const;
+
+	/*! @return the value as the same @c QVariant tree @c bb::data::JsonDataAccess produces. This decodes the whole value. */
+	QVariant toVariant() const;
+
+private:
+	friend class SFJsonView;
+
+	QSharedPointer<SFJsonIndexParser> mDocument;
+	int mIndex;
+
+	SFJsonValue(const QSharedPointer<SFJsonIndexParser> & document, int index);
+	bool keyEquals(int i, const QByteArray & key) const;
+};
+
+/*!
+ * @class SFJsonView
+ * @headerfile SFJsonView.h <rest/SFJsonView.h>
+ *
+ * @brief A read-only view of a JSON document that keeps the raw bytes and a structural index, and decodes values on access.
+ *
+ * @details
+ * Building the view only scans the document once to index it (see @c SFJsonIndexParser), no string or number is decoded and
+ * no @c QVariant is created. Memory use stays close to the size of the raw bytes, which is a good fit for large responses
+ * of which only a few fields are read. The view is implicitly shared and can be read from several threads.
+ *
+ * It is delivered as the payload of a REST request whose @c SFRestRequest::payloadType is @c SFRestRequest::PayloadJsonView:
+ * @code
+ * SFJsonView view = result->payload<SFJsonView>();
+ * QString owner = view.path("records[3].Owner.Name").toString();
+ * int total = view.path("totalSize").toLongLong();
+ *
+ * //converted on demand when a QVariant is asked for
+ * QVariantMap content = result->payload<QVariantMap>();
+ * @endcode
+ */
+class SFJsonView {
+public:
+	SFJsonView(); /*!< Creates an invalid view */
+
+	/*! Index the given document.
+	 * @param json the document. The view keeps a shallow copy of it.
+	 * @param errorString if not NULL, receives the description of the error if the document is malformed
+	 * @return the view, invalid if the document is malformed */
+	static SFJsonView fromJson(const QByteArray & json, QString * errorString = NULL);
+
+	bool isValid() const { return !mDocument.isNull(); }; /*!< @return whether the document was indexed successfully */
+	SFJsonValue root() const; /*!< @return the top level value */
+	SFJsonValue path(const QString & path) const { return this->root().path(path); }; /*!< Same as @c SFJsonValue::path() on the root */
+	QVariant toVariant() const { return this->root().toVariant(); }; /*!< Decode the whole document */
+	QByteArray rawData() const; /*!< @return the raw bytes of the document */
+
+private:
+	QSharedPointer<SFJsonIndexParser> mDocument;
+};
+
+} /* namespace sf */
+
+Q_DECLARE_METATYPE(sf::SFJsonView)
+#endif /* SFJSONVIEW_H_ */
@@ -0,0 +1,155 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFQueryCursor.h
+*/
+
+
+#ifndef SFQUERYCURSOR_H_
+#define SFQUERYCURSOR_H_
+
+#include <QObject>
+#include <QPointer>
+#include <QQueue>
+#include <QString>
+#include <QVariant>
+
+namespace sf {
+
+class SFGenericTask;
+class SFResult;
+
+/*!
+ * @class SFQueryCursor
+ * @headerfile SFQueryCursor.h <rest/SFQueryCursor.h>
+ * @brief Runs a SOQL query and follows "nextRecordsUrl" until all records have been delivered, one page at a time.
+ *
+ * @details
+ * The request of the next page is sent as soon as a page arrives, so the network works on it while the current page is processed.
+ * Pages that arrived but haven't been delivered are held by the cursor, at most @c SFQueryCursor::maxPagesHeld of them; the cursor
+ * doesn't fetch more until the consumer catches up.
+ *
+ * By default every page is delivered through @c pageReady() as soon as it arrives. With @c SFQueryCursor::autoFetch set to false,
+ * a page is delivered only when the consumer asks for it with @c fetchNext(), which is handy when pages are processed asynchronously.
+ *
+ * Example in C++:
+ * @code{.cpp}
+ * SFQueryCursor *cursor = new SFQueryCursor(this);
+ * cursor->setQuery("SELECT Id, Name FROM Account");
+ * cursor->setBatchSize(500);
+ * connect(cursor, SIGNAL(pageReady(QVariantList)), this, SLOT(onAccountsReady(QVariantList)));
+ * connect(cursor, SIGNAL(finished()), this, SLOT(onAllAccountsReady()));
+ * cursor->start();
+ * @endcode
+ *
+ * Example in QML:
+ * @code{.qml}
+ * attachedObjects: [
+ * 	SFQueryCursor {
+ * 		id: accounts
+ * 		query: "SELECT Id, Name FROM Account"
+ * 		onPageReady: {
+ * 			dataModel.append(records);
+ * 		}
+ * 		onFailed: {
+ * 			console.log(message);
+ * 		}
+ * 	}
+ * ]
+ * @endcode
+ *
+ * @see SFRestAPI::requestForQuery(), <a href="https://developer.salesforce.com/docs/atlas.en-us.api_rest.meta/api_rest/headers_queryoptions.htm">Query Options Header</a>
+ */
+class SFQueryCursor : public QObject {
+	Q_OBJECT
+	Q_PROPERTY(QString query READ query WRITE setQuery) /*!< The SOQL query. Changing it doesn't affect a running cursor. */
+	Q_PROPERTY(int batchSize READ batchSize WRITE setBatchSize) /*!< The number of records per page, from 200 to 2000, sent as the "Sforce-Query-Options" header. 0 lets the server decide. @b Default: 0 */
+	Q_PROPERTY(int maxPagesHeld READ maxPagesHeld WRITE setMaxPagesHeld) /*!< How many pages may arrive before they are delivered. @b Default: 2 */
+	Q_PROPERTY(bool autoFetch READ autoFetch WRITE setAutoFetch) /*!< Whether pages are delivered as soon as they arrive, rather than on @c fetchNext(). @b Default: true */
+	Q_PROPERTY(bool stripRecordAttributes READ stripRecordAttributes WRITE setStripRecordAttributes) /*!< See @c SFRestRequest::stripRecordAttributes. @b Default: false */
+	Q_PROPERTY(bool active READ isActive) /*!< Whether the cursor is started and not finished, failed or cancelled */
+	Q_PROPERTY(int totalSize READ totalSize) /*!< The number of records the query returns, known once the first page arrived */
+	Q_PROPERTY(int deliveredRecords READ deliveredRecords) /*!< The number of records delivered so far */
+
+signals:
+	/*! Emitted for every page, in order.
+	 * @param records the records of the page */
+	void pageReady(const QVariantList & records);
+	/*! Emitted after the last page was delivered */
+	void finished();
+	/*! Emitted when a page couldn't be fetched. The cursor stops.
+	 * @param code the code of the error, see @c SFResult::code
+	 * @param message the message of the error */
+	void failed(int code, const QString & message);
+	/*! Emitted when the cursor was cancelled */
+	void cancelled();
+
+public:
+	SFQueryCursor(QObject *parent = 0);
+	virtual ~SFQueryCursor();
+
+	const QString & query() const { return this->mQuery;}; /*!< @see SFQueryCursor::query */
+	void setQuery(const QString & query) { this->mQuery = query;}; /*!< @see SFQueryCursor::query */
+	int batchSize() const { return this->mBatchSize;}; /*!< @see SFQueryCursor::batchSize */
+	void setBatchSize(int batchSize); /*!< @see SFQueryCursor::batchSize */
+	int maxPagesHeld() const { return this->mMaxPagesHeld;}; /*!< @see SFQueryCursor::maxPagesHeld */
+	void setMaxPagesHeld(int count) { this->mMaxPagesHeld = qMax(1, count);}; /*!< @see SFQueryCursor::maxPagesHeld */
+	bool autoFetch() const { return this->mAutoFetch;}; /*!< @see SFQueryCursor::autoFetch */
+	void setAutoFetch(bool autoFetch) { this->mAutoFetch = autoFetch;}; /*!< @see SFQueryCursor::autoFetch */
+	bool stripRecordAttributes() const { return this->mStripRecordAttributes;}; /*!< @see SFQueryCursor::stripRecordAttributes */
+	void setStripRecordAttributes(bool strip) { this->mStripRecordAttributes = strip;}; /*!< @see SFQueryCursor::stripRecordAttributes */
+	bool isActive() const { return this->mActive;}; /*!< @see SFQueryCursor::active */
+	int totalSize() const { return this->mTotalSize;}; /*!< @see SFQueryCursor::totalSize */
+	int deliveredRecords() const { return this->mDeliveredRecords;}; /*!< @see SFQueryCursor::deliveredRecords */
+
+public slots:
+	/*! Send the query. A running cursor is cancelled first. */
+	void start();
+	/*! Ask for the next page when @c SFQueryCursor::autoFetch is false. It is delivered right away if it already arrived. */
+	void fetchNext();
+	/*! Stop delivering pages and drop the pages held. The download of the page being fetched is aborted. */
+	void cancel();
+
+private slots:
+	void onPageResultReady(sf::SFResult* result);
+
+private:
+	Q_DISABLE_COPY(SFQueryCursor)
+
+	QString mQuery;
+	int mBatchSize;
+	int mMaxPagesHeld;
+	bool mAutoFetch;
+	bool mStripRecordAttributes;
+	bool mActive;
+	bool mFetching; //a page is being fetched
+	bool mDelivering; //pageReady() is being emitted
+	int mGeneration; //tags the pages of the current run, so the ones of a cancelled run are ignored
+	int mDemand; //pages asked for with fetchNext() and not delivered yet
+	int mTotalSize;
+	int mDeliveredRecords;
+	QString mNextRecordsUrl;
+	QQueue<QVariantList> mPages;
+	QPointer<SFGenericTask> mPageTask; //the task fetching a page, cancelled with the cursor
+
+	void fetch(const QString & nextRecordsUrl);
+	void cancelPageTask();
+	void prefetch();
+	void deliverPages();
+};
+
+} /* namespace sf */
+Q_DECLARE_METATYPE(sf::SFQueryCursor*)
+#endif /* SFQUERYCURSOR_H_ */
@@ -0,0 +1,235 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordBatch.h
+*/
+
+#ifndef SFRECORDBATCH_H_
+#define SFRECORDBATCH_H_
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include "SFJsonStreamParser.h"
+
+namespace sf {
+
+class SFRecordRow;
+
+/*!
+ * @class SFRecordBatch
+ * @headerfile SFRecordBatch.h <rest/SFRecordBatch.h>
+ *
+ * @brief A columnar store for the records of a query response, with one typed column per field.
+ *
+ * @details
+ * Instead of one @c QVariantMap per record, every field is stored as a single column:
+ * - numbers, booleans, dates and date/times are unboxed in contiguous vectors. Dates and date/times are stored as milliseconds
+ * since the epoch in UTC, for comparisons and sorting, and their text as received is kept in the arena.
+ * - strings and IDs are stored as UTF-8 in one arena shared by all the string columns of the batch, and by the batches
+ * derived from it.
+ * - nested values, such as parent records and sub-queries, are kept as @c QVariant.
+ * - a bitmap per column tells which values are null or missing.
+ *
+ * Column types are inferred from the JSON values. The describe result of the sObject (see @c SFRestAPI::requestForDescribeWithObjectType())
+ * can be given to type the columns that JSON can't tell apart, i.e. IDs, dates and date/times, and the columns whose values are all null.
+ *
+ * Filtering, sorting and projecting work column by column and return a new batch that shares as much as possible with the
+ * original one. Batches are implicitly shared and cheap to copy.
+ * @code
+ * SFRecordBatch batch = result->payload<SFRecordBatch>();
+ * SFRecordBatch large = batch.filtered("Amount", SFRecordBatch::GreaterOrEqual, 10000).sorted("CloseDate").projected(QStringList() << "Id" << "Name");
+ * for (int i = 0; i < large.rowCount(); i++) {
+ * 	qDebug() << large.row(i).value("Name").toString();
+ * }
+ * @endcode
+ *
+ * A batch is delivered as the payload of a query whose @c SFRestRequest::payloadType is @c SFRestRequest::PayloadRecordBatch.
+ * The columns are then built by @c SFRecordBatchConsumer while the response downloads, one record at a time.
+ * @c SFResult::payload<QVariantMap>() still gives the usual response, rebuilt from the batch.
+ */
+class SFRecordBatch {
+public:
+	/*! The type of a column */
+	enum ColumnType {
+		ColumnString, /*!< Strings, also used for columns whose values are all null */
+		ColumnId, /*!< Record IDs */
+		ColumnBool,
+		ColumnInteger, /*!< @c qlonglong */
+		ColumnDouble,
+		ColumnDate, /*!< Compared as dates, see @c dateTimeAt() */
+		ColumnDateTime, /*!< Compared as date/times, see @c dateTimeAt() */
+		ColumnVariant /*!< Nested or mixed values, kept as they are */
+	};
+
+	/*! The comparison of a filter. Null values never match, except with @c IsNull */
+	enum Comparison {
+		Equal,
+		NotEqual,
+		Less,
+		LessOrEqual,
+		Greater,
+		GreaterOrEqual,
+		Contains, /*!< For string columns only */
+		IsNull,
+		IsNotNull
+	};
+
+	SFRecordBatch(); /*!< Creates an empty batch */
+
+	/*! Build a batch from decoded records.
+	 * @param records the records, each one a @c QVariantMap
+	 * @param describe optional describe result of the sObject, used to type the columns
+	 * @return the batch */
+	static SFRecordBatch fromRecords(const QVariantList & records, const QVariantMap & describe = QVariantMap());
+	/*! Build a batch from a decoded query response.
+	 * @param content the response, e.g. @code {"totalSize":2,"done":true,"records":[{...},{...}]} @endcode
+	 * @param describe optional describe result of the sObject, used to type the columns
+	 * @return the batch, whose @c metadata() holds the other members of the response.
+	 * The decoded response and the batch exist together until the call returns, so the peak memory is higher than with the response alone.
+	 * @c SFRecordBatchConsumer builds the batch from the JSON text without decoding all the records first. */
+	static SFRecordBatch fromQueryResult(const QVariantMap & content, const QVariantMap & describe = QVariantMap());
+
+	int rowCount() const { return mRowCount; }; /*!< @return the number of records */
+	int columnCount() const { return mColumns.size(); }; /*!< @return the number of fields */
+	QStringList columnNames() const; /*!< @return the names of the fields, in the order they first appear in the records */
+	int columnIndex(const QString & name) const { return mColumnIndex.value(name, -1); }; /*!< @return the index of a field, or -1 */
+	ColumnType columnType(int column) const { return mColumns.at(column).type; }; /*!< @return the type of a column */
+	/*! @return the members of the query response other than the records, e.g. "totalSize", "done" and "nextRecordsUrl" */
+	const QVariantMap & metadata() const { return mMetadata; };
+
+	/*! @return whether a value is null or missing */
+	bool isNull(int row, int column) const { return mColumns.at(column).nulls.testBit(row); };
+	/*! @return a value boxed the way @c bb::data::JsonDataAccess does. Dates and date/times are the strings of the response */
+	QVariant value(int row, int column) const;
+	QString stringAt(int row, int column) const; /*!< @return a value of a string or ID column, or the text of a date or date/time */
+	qlonglong integerAt(int row, int column) const; /*!< @return a value of an integer or boolean column */
+	double doubleAt(int row, int column) const; /*!< @return a value of a number column */
+	bool boolAt(int row, int column) const; /*!< @return a value of a boolean column */
+	QDateTime dateTimeAt(int row, int column) const; /*!< @return a value of a date or date/time column, in UTC */
+
+	SFRecordRow row(int row) const; /*!< @return a view of a record */
+	QVariantList toRecords() const; /*!< @return the records as @c QVariantMap, for code that expects decoded records */
+	QVariant toVariant() const; /*!< @return the query response, i.e. the metadata and the records */
+
+	/*! @return the indexes of the rows whose value in @a column matches */
+	QVector<int> where(int column, Comparison comparison, const QVariant & operand = QVariant()) const;
+	/*! @return a batch made of the given rows, in the given order */
+	SFRecordBatch selected(const QVector<int> & rows) const;
+	/*! @return a batch with the rows whose value in the named column matches */
+	SFRecordBatch filtered(const QString & column, Comparison comparison, const QVariant & operand = QVariant()) const;
+	/*! @return the indexes of the rows, ordered by the value in @a column. Null values come first in ascending order. The sort is stable. */
+	QVector<int> sortedRows(int column, Qt::SortOrder order = Qt::AscendingOrder) const;
+	/*! @return a batch with the rows ordered by the value in the named column */
+	SFRecordBatch sorted(const QString & column, Qt::SortOrder order = Qt::AscendingOrder) const;
+	/*! @return a batch with the named columns only, in the given order. Unknown names are ignored. */
+	SFRecordBatch projected(const QStringList & columns) const;
+
+private:
+	friend class SFRecordRow;
+	friend class SFRecordBatchConsumer;
+	class Builder; //builds the columns one record at a time
+	friend class Builder;
+
+	struct Column {
+		QString name;
+		ColumnType type;
+		QBitArray nulls; //set for null or missing values
+		QVector<qlonglong> integers; //integers, booleans, and dates and date/times in milliseconds
+		QVector<double> doubles;
+		QVector<int> offsets; //strings, IDs, and the text of dates and date/times, into the arena
+		QVector<int> lengths;
+		QVariantList variants;
+	};
+
+	QVector<Column> mColumns;
+	QHash<QString, int> mColumnIndex;
+	QByteArray mArena;
+	int mRowCount;
+	QVariantMap mMetadata;
+
+	void appendColumn(const Column & column);
+};
+
+/*!
+ * @class SFRecordBatchConsumer
+ * @headerfile SFRecordBatch.h <rest/SFRecordBatch.h>
+ *
+ * @brief A @c SFResponseConsumer that builds a @c SFRecordBatch from a query response while it downloads.
+ *
+ * @details
+ * Every record is appended to the columns as soon as the parser has read it, then released, so the records of the response
+ * are never all decoded at once. The result is a @c SFRecordBatch whose @c SFRecordBatch::metadata() holds the other members
+ * of the response, or the decoded response if it isn't an object.
+ *
+ * @c SFRestResourceTask uses it for the requests whose @c SFRestRequest::payloadType is @c SFRestRequest::PayloadRecordBatch.
+ */
+class SFRecordBatchConsumer : public SFJsonRecordsConsumer {
+public:
+	/*! @param describe optional describe result of the sObject, used to type the columns, see @c SFRecordBatch::fromRecords() */
+	explicit SFRecordBatchConsumer(const QVariantMap & describe = QVariantMap());
+	virtual ~SFRecordBatchConsumer();
+
+	/*! @return the batch, once the response is parsed */
+	const SFRecordBatch & batch() const { return mBatch; };
+
+	/* SFResponseConsumer */
+	bool begin(int statusCode, const QByteArray & contentType);
+	bool finish();
+	QVariant result() const;
+
+protected:
+	bool processRecord(int index, const QVariant & record);
+
+private:
+	Q_DISABLE_COPY(SFRecordBatchConsumer)
+
+	QVariantMap mDescribe;
+	SFRecordBatch::Builder *mBuilder;
+	SFRecordBatch mBatch;
+	QVariant mResult;
+};
+
+/*!
+ * @class SFRecordRow
+ * @headerfile SFRecordBatch.h <rest/SFRecordBatch.h>
+ * @brief A view of a record of a @c SFRecordBatch. It keeps the batch alive.
+ */
+class SFRecordRow {
+public:
+	SFRecordRow(const SFRecordBatch & batch, int row) : mBatch(batch), mRow(row) {}; /*!< Constructor */
+
+	int index() const { return mRow; }; /*!< @return the index of the row in the batch */
+	/*! @return the value of the named field, or an invalid @c QVariant if there is no such field */
+	QVariant value(const QString & name) const;
+	QVariant value(int column) const { return mBatch.value(mRow, column); }; /*!< @return the value of a column */
+	bool isNull(const QString & name) const; /*!< @return whether the named field is null or missing */
+	QVariantMap toMap() const; /*!< @return the record, with an invalid @c QVariant for null or missing fields */
+
+private:
+	SFRecordBatch mBatch;
+	int mRow;
+};
+
+} /* namespace sf */
+
+Q_DECLARE_METATYPE(sf::SFRecordBatch)
+#endif /* SFRECORDBATCH_H_ */
@@ -0,0 +1,449 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordDecoder.h
+*/
+
+#ifndef SFRECORDDECODER_H_
+#define SFRECORDDECODER_H_
+
+#include <QDate>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include "SFJsonStreamParser.h"
+
+namespace sf {
+
+/*!
+ * @class SFNullable
+ * @headerfile SFRecordDecoder.h <rest/SFRecordDecoder.h>
+ * @brief A value that may be null, for the fields of a typed record whose null value must be told apart from the default value.
+ */
+template<class T>
+class SFNullable {
+public:
+	SFNullable() : mIsNull(true), mValue() {}; /*!< Creates a null value */
+	SFNullable(const T & value) : mIsNull(false), mValue(value) {}; /*!< Creates a non-null value */
+
+	bool isNull() const { return mIsNull; }; /*!< @return whether the value is null */
+	const T & value() const { return mValue; }; /*!< @return the value, a default constructed one if null */
+	T valueOr(const T & defaultValue) const { return mIsNull ? defaultValue : mValue; }; /*!< @return the value, or @a defaultValue if null */
+	void setValue(const T & value) { mValue = value; mIsNull = false; }; /*!< Set the value */
+	void setNull() { mValue = T(); mIsNull = true; }; /*!< Make the value null */
+
+	SFNullable & operator=(const T & value) { this->setValue(value); return *this; };
+	bool operator==(const SFNullable & other) const { return mIsNull == other.mIsNull && (mIsNull || mValue == other.mValue); };
+	bool operator!=(const SFNullable & other) const { return !(*this == other); };
+
+private:
+	bool mIsNull;
+	T mValue;
+};
+
+/*
+ * Conversions between JSON values, as reported by SFJsonStreamParser, and the types of the members of typed records.
+ * Overload them for other member types. Dates and date/times use the format of the REST API, see sfParseIsoDateTime().
+ */
+void sfDecodeField(const SFJsonScalar & json, QString * field);
+void sfDecodeField(const SFJsonScalar & json, bool * field);
+void sfDecodeField(const SFJsonScalar & json, int * field);
+void sfDecodeField(const SFJsonScalar & json, qlonglong * field);
+void sfDecodeField(const SFJsonScalar & json, double * field);
+void sfDecodeField(const SFJsonScalar & json, QDate * field);
+void sfDecodeField(const SFJsonScalar & json, QDateTime * field);
+void sfDecodeField(const SFJsonScalar & json, QVariant * field);
+/*
+ * Any other member type is converted by QVariant, it has to be declared with Q_DECLARE_METATYPE:
+ * an undeclared type does not compile. A JSON value that does not convert leaves a default constructed member.
+ */
+template<class M>
+void sfDecodeField(const SFJsonScalar & json, M * field) {
+	*field = json.toVariant().value<M>();
+}
+template<class M>
+void sfDecodeField(const SFJsonScalar & json, SFNullable<M> * field) {
+	if (json.isNull()) {
+		field->setNull();
+	} else {
+		M value;
+		sfDecodeField(json, &value);
+		field->setValue(value);
+	}
+}
+
+QVariant sfEncodeField(const QString & field);
+QVariant sfEncodeField(bool field);
+QVariant sfEncodeField(int field);
+QVariant sfEncodeField(qlonglong field);
+QVariant sfEncodeField(double field);
+QVariant sfEncodeField(const QDate & field);
+QVariant sfEncodeField(const QDateTime & field);
+QVariant sfEncodeField(const QVariant & field);
+template<class M>
+QVariant sfEncodeField(const M & field) {
+	return QVariant::fromValue(field);
+}
+template<class M>
+QVariant sfEncodeField(const SFNullable<M> & field) {
+	return field.isNull() ? QVariant() : sfEncodeField(field.value());
+}
+
+/* inserts a value in nested maps, following a field path such as "Owner.Name" */
+void sfInsertFieldPath(QVariantMap & map, const QString & path, const QVariant & value);
+
+/* the conversions of a member of a typed record, see SF_RECORD_MEMBER() */
+template<class T>
+struct SFRecordMemberCodec {
+	void (*decode)(T & record, const SFJsonScalar & json);
+	QVariant (*encode)(const T & record);
+};
+
+/* the conversions of the member, picked at compile time from its type */
+template<class T, class M, M T::*member>
+struct SFRecordMember {
+	static void decode(T & record, const SFJsonScalar & json) { sfDecodeField(json, &(record.*member)); };
+	static QVariant encode(const T & record) { return sfEncodeField(record.*member); };
+};
+
+/* deduces the type of a member, so that SF_RECORD_MEMBER() only needs the member */
+template<class T, class M>
+struct SFRecordMemberType {
+	template<M T::*member>
+	static SFRecordMemberCodec<T> codec() {
+		SFRecordMemberCodec<T> codec = { &SFRecordMember<T, M, member>::decode, &SFRecordMember<T, M, member>::encode };
+		return codec;
+	};
+};
+
+template<class T, class M>
+SFRecordMemberType<T, M> sfRecordMemberType(M T::*) {
+	return SFRecordMemberType<T, M>();
+}
+
+/*!
+ * The conversions of a member of a typed record, for @c SFRecordFields::add(), e.g. @c SF_RECORD_MEMBER(&Opportunity::name).
+ * The member is a template argument, so decoding a field is a direct call to the conversion of its type.
+ * @note In the @c bindFields() of a class template, write @c sf::sfRecordMemberType(member).template codec<member>() instead.
+ */
+#define SF_RECORD_MEMBER(member) sf::sfRecordMemberType(member).codec<member>()
+
+/*!
+ * @class SFRecordFields
+ * @headerfile SFRecordDecoder.h <rest/SFRecordDecoder.h>
+ *
+ * @brief The list of the fields of a typed record, each one bound to a member of the C++ type.
+ *
+ * @details
+ * A typed record is a plain struct that declares its sObject type and its fields, either with static members or with a
+ * specialization of @c SFRecordTraits:
+ * @code
+ * struct Opportunity {
+ * 	QString id;
+ * 	QString name;
+ * 	SFNullable<double> amount;
+ * 	QDate closeDate;
+ * 	QString ownerName;
+ *
+ * 	static QString sObjectType() { return "Opportunity"; }
+ * 	static void bindFields(sf::SFRecordFields<Opportunity> & fields) {
+ * 		fields.add("Id", SF_RECORD_MEMBER(&Opportunity::id))
+ * 			.add("Name", SF_RECORD_MEMBER(&Opportunity::name))
+ * 			.add("Amount", SF_RECORD_MEMBER(&Opportunity::amount))
+ * 			.add("CloseDate", SF_RECORD_MEMBER(&Opportunity::closeDate))
+ * 			.add("Owner.Name", SF_RECORD_MEMBER(&Opportunity::ownerName));
+ * 	}
+ * };
+ * Q_DECLARE_METATYPE(Opportunity)
+ * @endcode
+ * The member is a template argument of its conversions, and the type of the member selects them at compile time: the list
+ * is a constant table of functions, decoding a field doesn't go through a @c QVariant or a virtual call. The field list also
+ * drives the SELECT list of @c SFRestAPI::generateSOQLQuery<T>(), so the query always matches the struct.
+ * The record type has to be declared with @c Q_DECLARE_METATYPE, its meta type identifies the records of a @c SFDecodedRecords.
+ */
+template<class T>
+class SFRecordFields {
+public:
+	SFRecordFields() {};
+
+	/*! Bind a field to a member.
+	 * @param name the name of the field. Fields of parent records are written with a dot, e.g. "Owner.Name"
+	 * @param member the conversions of the member, see @c SF_RECORD_MEMBER()
+	 * @return this list, to chain calls */
+	SFRecordFields & add(const QString & name, const SFRecordMemberCodec<T> & member) {
+		Field field = { name, member };
+		mFields.append(field);
+		return *this;
+	};
+
+	int size() const { return mFields.size(); }; /*!< @return the number of fields */
+	const QString & name(int i) const { return mFields.at(i).name; }; /*!< @return the name of a field, e.g. "Name" or "Owner.Name" */
+	/*! Set the member bound to a field from a JSON value */
+	void decode(int i, T & record, const SFJsonScalar & json) const { mFields.at(i).member.decode(record, json); };
+	/*! @return the member bound to a field as a JSON value */
+	QVariant encode(int i, const T & record) const { return mFields.at(i).member.encode(record); };
+	/*! @return the names of the fields, in the order they were added */
+	QStringList names() const {
+		QStringList names;
+		for (int i = 0; i < mFields.size(); i++) {
+			names.append(mFields.at(i).name);
+		}
+		return names;
+	};
+	/*! @return the record as a @c QVariantMap, with the same layout as the JSON of the record */
+	QVariantMap toMap(const T & record) const {
+		QVariantMap map;
+		for (int i = 0; i < mFields.size(); i++) {
+			sfInsertFieldPath(map, mFields.at(i).name, mFields.at(i).member.encode(record));
+		}
+		return map;
+	};
+
+private:
+	struct Field {
+		QString name;
+		SFRecordMemberCodec<T> member;
+	};
+	QVector<Field> mFields;
+};
+
+/*!
+ * @class SFRecordTraits
+ * @headerfile SFRecordDecoder.h <rest/SFRecordDecoder.h>
+ * @brief The sObject type and fields of a typed record. By default, they are the static members @c sObjectType() and
+ * @c bindFields() of the record type. Specialize it for types that can't have them.
+ */
+template<class T>
+struct SFRecordTraits {
+	static QString sObjectType() { return T::sObjectType(); };
+	static void bindFields(SFRecordFields<T> & fields) { T::bindFields(fields); };
+};
+
+/*! @return the names of the fields of a typed record */
+template<class T>
+QStringList sfRecordFieldNames() {
+	SFRecordFields<T> fields;
+	SFRecordTraits<T>::bindFields(fields);
+	return fields.names();
+}
+
+/* type erased storage of the records decoded by SFRecordDecoder<T>, tagged with the meta type of the records */
+class SFDecodedRecordsStore {
+public:
+	explicit SFDecodedRecordsStore(int recordType) : mRecordType(recordType) {};
+	virtual ~SFDecodedRecordsStore() {};
+	int recordType() const { return mRecordType; };
+	virtual int count() const = 0;
+	virtual QVariantList toVariantList() const = 0;
+
+private:
+	int mRecordType;
+};
+
+template<class T>
+class SFTypedRecordsStore : public SFDecodedRecordsStore {
+public:
+	SFTypedRecordsStore() : SFDecodedRecordsStore(qMetaTypeId<T>()) {};
+
+	QVector<T> records;
+
+	int count() const { return records.size(); };
+	QVariantList toVariantList() const {
+		SFRecordFields<T> fields;
+		SFRecordTraits<T>::bindFields(fields);
+		QVariantList list;
+		list.reserve(records.size());
+		for (int i = 0; i < records.size(); i++) {
+			list.append(fields.toMap(records.at(i)));
+		}
+		return list;
+	};
+};
+
+/*!
+ * @class SFDecodedRecords
+ * @headerfile SFRecordDecoder.h <rest/SFRecordDecoder.h>
+ * @brief The payload of a query decoded with a @c SFRecordDecoder: the typed records, and the other members of the response.
+ * @code
+ * QVector<Opportunity> opportunities = result->payload<SFDecodedRecords>().records<Opportunity>();
+ * @endcode
+ * @c SFResult::payload<QVariantMap>() still gives the usual response, rebuilt from the records.
+ */
+class SFDecodedRecords {
+public:
+	SFDecodedRecords() {}; /*!< Creates an empty payload */
+	SFDecodedRecords(const QVariantMap & metadata, const QSharedPointer<SFDecodedRecordsStore> & store) : mMetadata(metadata), mStore(store) {};
+
+	/*! @return the members of the query response other than the records, e.g. "totalSize", "done" and "nextRecordsUrl" */
+	const QVariantMap & metadata() const { return mMetadata; };
+	int count() const { return mStore.isNull() ? 0 : mStore->count(); }; /*!< @return the number of records */
+	/*! @return the records, or an empty vector if they are not of type T */
+	template<class T>
+	QVector<T> records() const {
+		//the meta type is registered by name, so it is the same in every library, unlike the type info dynamic_cast relies on
+		if (mStore.isNull() || mStore->recordType() != qMetaTypeId<T>()) {
+			return QVector<T>();
+		}
+		return static_cast<const SFTypedRecordsStore<T>*>(mStore.data())->records;
+	};
+	QVariant toVariant() const; /*!< @return the query response as @c bb::data::JsonDataAccess would decode it */
+
+private:
+	QVariantMap mMetadata;
+	QSharedPointer<SFDecodedRecordsStore> mStore;
+};
+
+/*!
+ * @class SFRecordDecoderBase
+ * @headerfile SFRecordDecoder.h <rest/SFRecordDecoder.h>
+ * @brief The part of @c SFRecordDecoder that doesn't depend on the record type.
+ *
+ * @details It follows the events of the JSON parser and reports the values of the bound fields of every element of the records
+ * array as @c SFJsonScalar, without building any @c QVariant. Fields that are not bound, the "attributes" of records and
+ * sub-queries are skipped. The keys of a record are matched against the keys of the previous one, position by position, so
+ * the fields are only looked up by name in the first record. The scalar members of the top level object are kept as metadata.
+ */
+class SFRecordDecoderBase : public SFResponseConsumer, protected SFJsonStreamHandler {
+public:
+	virtual ~SFRecordDecoderBase();
+
+	const QString & recordsKey() const { return mRecordsKey; }; /*!< @return the key of the records array */
+	int recordCount() const { return mRecordCount; }; /*!< @return the number of records decoded so far */
+	const QVariantMap & metadata() const { return mMetadata; }; /*!< @return the scalar members of the top level object */
+
+	/* SFResponseConsumer */
+	bool begin(int statusCode, const QByteArray & contentType);
+	bool consume(const QByteArray & chunk);
+	bool finish();
+	QString errorString() const;
+
+protected:
+	/*! @param fieldNames the names of the bound fields, see @c SFRecordFields
+	 * @param recordsKey the key of the records array in the top level object */
+	SFRecordDecoderBase(const QStringList & fieldNames, const QString & recordsKey);
+
+	virtual void clearRecords() = 0; /*!< Discard the records of a previous response */
+	virtual void beginRecord() = 0; /*!< A record starts */
+	virtual void decodeField(int field, const SFJsonScalar & json) = 0; /*!< The value of a bound field of the current record */
+	virtual bool endRecord(int index) = 0; /*!< The current record is complete. @return false to stop parsing */
+
+	/* SFJsonStreamHandler */
+	bool startObject();
+	bool endObject();
+	bool startArray();
+	bool endArray();
+	bool key(const QString & key);
+	bool value(const QVariant & value);
+	bool scalar(const SFJsonScalar & scalar);
+
+private:
+	/* what a key of a record object was bound to */
+	struct Slot {
+		QString key;
+		int field; //index of the bound field, -1 if none
+		int child; //node of the parent record, -1 if none
+	};
+	/* an object of the records, the record itself or one of its parent records, e.g. "Owner" */
+	struct Node {
+		QHash<QString, int> fields;
+		QHash<QString, int> children;
+		QVector<Slot> order; //the keys of the previous object, by position
+	};
+
+	QVector<Node> mNodes; //the record is the first node
+	QString mRecordsKey;
+	SFJsonStreamParser mParser;
+	QVariantMap mMetadata;
+	QVector<int> mOpenNodes; //nodes of the objects of the current record being parsed
+	QVector<int> mPositions; //position of the next key in each of them
+	int mField;
+	int mChild;
+	QString mKey;
+	int mDepth;
+	int mSkipDepth; //depth of the container being skipped, -1 if none
+	int mRecordCount;
+	bool mPendingRecords;
+	bool mInRecords;
+	bool mInRecord;
+	QString mError;
+
+	bool startContainer(bool isObject);
+	bool endContainer();
+	void bindKey(const QString & key);
+};
+
+/*!
+ * @class SFRecordDecoder
+ * @headerfile SFRecordDecoder.h <rest/SFRecordDecoder.h>
+ *
+ * @brief A @c SFResponseConsumer that decodes the records of a query response straight into a @c QVector of typed records.
+ *
+ * @details
+ * The response is parsed while it downloads and every record is decoded into a @c T as soon as it is complete, so neither
+ * the JSON document nor a @c QVariant tree of the records is ever built. See @c SFRecordFields for how to declare @c T, and
+ * @c SFRestAPI::requestForQuery<T>() for the simplest way to use it:
+ * @code
+ * SFRestRequest *request = SFRestAPI::instance()->requestForQuery<Opportunity>("StageName = 'Closed Won'");
+ * SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onOpportunities(sf::SFResult *)));
+ *
+ * void MyClass::onOpportunities(sf::SFResult *result) {
+ * 	QVector<Opportunity> opportunities = result->payload<SFDecodedRecords>().records<Opportunity>();
+ * }
+ * @endcode
+ * The payload is a @c SFDecodedRecords. Override @c processRecord() to handle the records as they arrive instead of keeping them.
+ */
+template<class T>
+class SFRecordDecoder : public SFRecordDecoderBase {
+public:
+	/*! @param recordsKey the key of the records array in the top level object */
+	explicit SFRecordDecoder(const QString & recordsKey = "records") : SFRecordDecoderBase(sfRecordFieldNames<T>(), recordsKey) {
+		SFRecordTraits<T>::bindFields(mFields);
+	};
+
+	/*! @return the records decoded so far */
+	QVector<T> records() const { return mStore.isNull() ? QVector<T>() : mStore->records; };
+	/*! @return a @c SFDecodedRecords */
+	QVariant result() const { return QVariant::fromValue(SFDecodedRecords(this->metadata(), mStore)); };
+
+protected:
+	/*! Called for every record, in document order, in a thread of the parsing pool. The default implementation keeps the record.
+	 * @return false to stop parsing the response */
+	virtual bool processRecord(int index, const T & record) {
+		Q_UNUSED(index);
+		mStore->records.append(record);
+		return true;
+	};
+
+	void clearRecords() { mStore = QSharedPointer<SFTypedRecordsStore<T> >(new SFTypedRecordsStore<T>()); };
+	void beginRecord() { mRecord = T(); };
+	void decodeField(int field, const SFJsonScalar & json) { mFields.decode(field, mRecord, json); };
+	bool endRecord(int index) { return this->processRecord(index, mRecord); };
+
+private:
+	SFRecordFields<T> mFields;
+	QSharedPointer<SFTypedRecordsStore<T> > mStore;
+	T mRecord;
+};
+
+} /* namespace sf */
+
+Q_DECLARE_METATYPE(sf::SFDecodedRecords)
+#endif /* SFRECORDDECODER_H_ */
@@ -0,0 +1,47 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordSource.h
+*/
+
+#ifndef SFRECORDSOURCE_H_
+#define SFRECORDSOURCE_H_
+
+#include <QVariant>
+
+namespace sf {
+
+/*!
+ * @class SFRecordSource
+ * @headerfile SFRecordSource.h <rest/SFRecordSource.h>
+ *
+ * @brief An interface for producing records one at a time, e.g. from a local database, so that they never have to be held
+ * in memory all at once.
+ *
+ * @details The values of a record are given in the order of the columns the source was registered with,
+ * see @c SFBulkIngestJob::setRecordSource().
+ */
+class SFRecordSource {
+public:
+	virtual ~SFRecordSource() {};
+
+	/*! Produce the next record.
+	 * @param[out] values receives the values of the record, one per column. A null @c QVariant is written as an empty field.
+	 * @return false when there are no more records */
+	virtual bool next(QVariantList * values) = 0;
+};
+
+} /* namespace sf */
+#endif /* SFRECORDSOURCE_H_ */
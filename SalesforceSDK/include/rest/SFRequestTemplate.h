@@ -0,0 +1,91 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRequestTemplate.h
+*/
+
+
+#ifndef SFREQUESTTEMPLATE_H_
+#define SFREQUESTTEMPLATE_H_
+
+#include <QNetworkRequest>
+#include <QString>
+#include <QUrl>
+#include "SFGlobal.h"
+
+namespace sf {
+
+class SFOAuthCredentials;
+
+/*!
+ * @class SFRequestTemplate
+ * @headerfile SFRequestTemplate.h <rest/SFRequestTemplate.h>
+ *
+ * @brief The part of a REST request that doesn't change from call to call: the base URL resolved against the instance URL,
+ * and the header block with the access token and the user agent.
+ *
+ * @details
+ * Templates are prepared once per end point, API version and user agent and shared by all the requests that use them. A template
+ * is prepared again only when the credentials of the session, its instance URL or the tokens in @c SFTokenVault change.
+ * A call only binds its path, @c SFRestRequest then adds its own parameters and headers.
+ * @code
+ * SFRequestTemplate prepared = SFRequestTemplate::prepared("/services/data", SFRestAPI::instance()->apiVersion(), userAgent);
+ * if (prepared.isValid()) {
+ * 	QNetworkRequest request = prepared.createRequest("/sobjects/Account/describe");
+ * }
+ * @endcode
+ *
+ * Templates are cheap to copy and can be used from any thread.
+ */
+class SFRequestTemplate {
+public:
+	SFRequestTemplate(); /*!< Creates an invalid template */
+
+	/*! Get the template of the current session, preparing it if needed.
+	 * @param endPoint the end point, e.g. "/services/data"
+	 * @param apiVersion the API version, e.g. "/v29.0"
+	 * @param userAgent the value of the "User-Agent" header, not sent if empty
+	 * @return the template. If it is not valid, see @c errorCode() and @c errorMessage(). */
+	static SFRequestTemplate prepared(const QString & endPoint, const QString & apiVersion, const QString & userAgent);
+	/*! Drop all prepared templates, e.g. after logout. They are prepared again on demand. */
+	static void clearCache();
+
+	bool isValid() const { return mErrorCode == SFResultCode::SFErrorNoError; }; /*!< @return whether requests can be created */
+	SFResultCodeType errorCode() const { return mErrorCode; }; /*!< @return why the template couldn't be prepared */
+	const QString & errorMessage() const { return mErrorMessage; }; /*!< @return the description of the error */
+	const QString & baseUrl() const { return mBaseUrl; }; /*!< @return the resolved end point and API version */
+
+	/*! Create a request with the header block of the template.
+	 * @param path the path relative to the API version. It may also be an absolute URL if the end point and the API version are empty.
+	 * @return the request, its URL is not valid if the path isn't */
+	QNetworkRequest createRequest(const QString & path) const;
+
+private:
+	QNetworkRequest mPrototype; //carries the header block
+	QString mBaseUrl;
+	bool mHasPrefix;
+	const SFOAuthCredentials *mCredentials;
+	QUrl mInstanceUrl;
+	int mGeneration;
+	SFResultCodeType mErrorCode;
+	QString mErrorMessage;
+
+	static SFRequestTemplate prepare(const SFOAuthCredentials * credentials, int generation, const QString & endPoint,
+			const QString & apiVersion, const QString & userAgent);
+	bool isCurrent(const SFOAuthCredentials * credentials, int generation) const;
+};
+
+} /* namespace sf */
+#endif /* SFREQUESTTEMPLATE_H_ */
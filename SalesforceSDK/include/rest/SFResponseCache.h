@@ -0,0 +1,76 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFResponseCache.h
+*/
+
+#ifndef SFRESPONSECACHE_H_
+#define SFRESPONSECACHE_H_
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+
+namespace sf {
+
+/*!
+ * @class SFResponseCache
+ * @headerfile SFResponseCache.h <rest/SFResponseCache.h>
+ *
+ * @brief The payloads of conditional requests, with the validators they were served with.
+ *
+ * @details
+ * When a request whose @c SFRestRequest::conditional property is set succeeds with an "ETag" or a "Last-Modified" header,
+ * its payload is kept here. The next identical request sends the validators as "If-None-Match" and "If-Modified-Since",
+ * and if the server answers 304 the kept payload is delivered, so an unchanged record or describe costs a response without a body.
+ *
+ * Entries are keyed by URL and payload type and evicted least recently used first, once the responses they were decoded from
+ * add up to more than @c maxCost() KB. The cache is cleared on logout and can be used from any thread.
+ *
+ * @see SFRestRequest::conditional
+ */
+class SFResponseCache {
+public:
+	/*! A kept payload */
+	struct Entry {
+		QByteArray eTag; /*!< The "ETag" header of the response, may be empty */
+		QByteArray lastModified; /*!< The "Last-Modified" header of the response, may be empty */
+		QVariant payload; /*!< The payload delivered for the response */
+	};
+
+	/*! @param key the key of the request
+	 * @param entry receives the entry, if there is one
+	 * @return whether there is an entry for the key */
+	static bool find(const QString & key, Entry * entry);
+	/*! Keep a payload, replacing the previous one.
+	 * @param key the key of the request
+	 * @param entry the payload and its validators
+	 * @param size the size in bytes of the response body it was decoded from */
+	static void insert(const QString & key, const Entry & entry, int size);
+	/*! Drop the payload of a request, e.g. because the resource no longer has validators */
+	static void remove(const QString & key);
+	/*! Drop all payloads, e.g. after logout */
+	static void clear();
+	/*! @return the maximum total size, in KB, of the response bodies the kept payloads were decoded from. @b Default: 2048 */
+	static int maxCost();
+	/*! @param kilobytes the maximum total size, see @c maxCost() */
+	static void setMaxCost(int kilobytes);
+
+private:
+	SFResponseCache();
+};
+
+} /* namespace sf */
+#endif /* SFRESPONSECACHE_H_ */
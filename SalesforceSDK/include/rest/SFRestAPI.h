@@ -26,17 +26,24 @@
 #include <QVariant>
 #include <QStringList>
 #include <QQueue>
+#include <QHash>
+#include <QList>
 #include "SFGlobal.h"
 #include "SFRestRequest.h"
 #include "SFResult.h"
+#include "SFRecordDecoder.h"
+#include "SFCompositeRequest.h"
+#include "SFCollectionRequest.h"
 
 class QScriptValue;
+class QTimer;
 
 namespace sf {
 class SFOAuthCredentials;
 class SFAccountManager;
 class SFGenericTask;
 class SFRestResourceTask;
+class SFCollectionTask;
 class SFOAuthInfo;
 
 /*!
@@ -98,6 +105,18 @@ class SFOAuthInfo;
  * 		SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onUpdateResultReady(sf::SFResult*)));
  * @endcode
  *
+ * Batching
+ * --------
+ * Screens that fire a burst of small independent requests can opt in to batching. Requests sent within the window are packed
+ * into Composite Batch requests, and every request still receives its own @c SFResult:
+ * @code{.cpp}
+ * 		SFRestAPI::instance()->setBatchWindow(10);
+ * 		for(int i = 0; i < accountIds.size(); i++) {
+ * 			SFRestRequest * request = SFRestAPI::instance()->requestForRetrieveObject("Account", accountIds.at(i), fields);
+ * 			SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onAccountReady(sf::SFResult*)));
+ * 		}
+ * @endcode
+ *
  * \sa SFAuthenticationManager, SFAbstractApplicationUI, SFRestRequest, SFResult, SFRestResourceTask
  *
  * See the [Force.com REST API Developer's Guide](http://www.salesforce.com/us/developer/docs/api_rest/index.htm) for more information regarding the Force.com REST API.
@@ -109,6 +128,7 @@ class SFRestAPI : public QObject {
 	Q_PROPERTY(QString endPoint READ endPoint WRITE setEndPoint) /*!< Force.com REST service end point. The default value is @c DefaultEndPoint */
 	Q_PROPERTY(QString apiVersion READ apiVersion WRITE setApiVersion) /*!< Force.com REST API version. Example: "/v28.0 The default value is empty string*/
 	Q_PROPERTY(QString userAgent READ userAgent WRITE setUserAgent) /*!< User agent string used for all HTTP/HTTPS requests */
+	Q_PROPERTY(int batchWindow READ batchWindow WRITE setBatchWindow) /*!< How long in milliseconds requests are held back to be sent together in a Composite Batch request. 0 disables batching. The default value is 0 */
 
 public:
 	virtual ~SFRestAPI();
@@ -131,6 +151,13 @@ public:
 	void setApiVersion(const QString & apiVersion) { this->mApiVersion = apiVersion;};
 	/*! @param userAgent String of HTTP User-Agent */
 	void setUserAgent(const QString & userAgent) { this->mUserAgent = userAgent;};
+	/*! @return the batching window in milliseconds, see @c SFRestAPI::batchWindow */
+	int batchWindow() const { return this->mBatchWindow;};
+	/*! Opt in to batching. Requests sent within @a msecs of the first queued one are packed into Composite Batch requests
+	 * of up to 25 subrequests. Each request still gets its own @c SFResult, with the same status, code, message and payload as if
+	 * it was sent on its own. Requests that can't be batched (see @c SFRestRequest::canBeBatched()) are sent immediately.
+	 * @param msecs the window, 0 sends every request immediately */
+	void setBatchWindow(int msecs) { this->mBatchWindow = qMax(0, msecs);};
 
 	/* REST APIs */
 	/*! Send REST request asynchronously. The result will be delivered to @a resultReciever as an instance of @c SFResult.
@@ -143,9 +170,11 @@ public:
 	 * @param resultReciever The result receiver QObject.
 	 * @param resultRecieverSlot The method in receiver object. You must use @c SLOT() macro. The slot should take one parameter with type of @c SFResult*.
 	 * @param tag An arbitrary value that you want to pass on to the receiver slot.
+	 * @return the task sending the request, which can be cancelled with @c SFGenericTask::cancel(). It deletes itself once the
+	 * result is delivered, keep it in a @c QPointer. NULL if @a request is NULL.
 	 * @sa SFRestRequest, SFResult, SFRestAPI::sendRestRequest(sf::SFRestRequest*,const QScriptValue&,const QScriptValue&,const QVariant&)
 	 */
-	void sendRestRequest(SFRestRequest * request, QObject * resultReciever = NULL, const char * resultRecieverSlot = NULL, const QVariant & tag = QVariant());
+	SFGenericTask * sendRestRequest(SFRestRequest * request, QObject * resultReciever = NULL, const char * resultRecieverSlot = NULL, const QVariant & tag = QVariant());
 
 	/*! This is the QML version of the same API.
 	 *
@@ -157,6 +186,27 @@ public:
 	 */
 	Q_INVOKABLE void sendRestRequest(sf::SFRestRequest * request, const QScriptValue & resultReciever, const QScriptValue & resultRecieverSlot, const QVariant & tag = QVariant());
 
+	/*! Send a collection request asynchronously. Its chunks are sent as ordinary REST requests and the merged result
+	 * will be delivered to @a resultReciever as an instance of @c SFResult. See @c SFCollectionRequest for the payload.
+	 *
+	 * @remark This function takes ownership of the @a request. The @a request will be automatically deleted after the @a resultRecieverSlot exit.
+	 * @remark This function is designed for C++. QML should call the corresponding QML version API.
+	 * @param request A pointer to a instance of @c SFCollectionRequest.
+	 * @param resultReciever The result receiver QObject.
+	 * @param resultRecieverSlot The method in receiver object. You must use @c SLOT() macro. The slot should take one parameter with type of @c SFResult*.
+	 * @param tag An arbitrary value that you want to pass on to the receiver slot.
+	 * @sa SFCollectionRequest, SFResult */
+	void sendCollectionRequest(SFCollectionRequest * request, QObject * resultReciever = NULL, const char * resultRecieverSlot = NULL, const QVariant & tag = QVariant());
+
+	/*! This is the QML version of the same API.
+	 *
+	 * @param request A pointer to a instance of @c SFCollectionRequest.
+	 * @param resultReciever A QScriptValue containing a pointer to the receiver object
+	 * @param resultRecieverSlot A QScriptValue containing a script function. The function should take one parameter.
+	 * @param tag An arbitrary value that you want to pass on to the receiver slot.
+	 * @sa SFCollectionRequest, SFResult, SFRestAPI::sendCollectionRequest(SFCollectionRequest*,QObject*,const char*,const QVariant &) */
+	Q_INVOKABLE void sendCollectionRequest(sf::SFCollectionRequest * request, const QScriptValue & resultReciever, const QScriptValue & resultRecieverSlot, const QVariant & tag = QVariant());
+
 	/*! Creates a @c SFRestRequest which lists summary information about each Salesforce.com version currently available.
 	 * @see http://www.salesforce.com/us/developer/docs/api_rest/Content/resources_versions.htm
 	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory. If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
@@ -172,22 +222,25 @@ public:
 	/*! Creates a @c SFRestRequest which lists the available objects and their metadata for your organization's data.
 	 * @see http://www.salesforce.com/us/developer/docs/api_rest/Content/resources_describeGlobal.htm
 	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory. If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
+	 * @param conditional whether to revalidate the previous response, see @c SFRestRequest::conditional. An unchanged resource then costs a 304 response without a body, but the request is never batched.
 	 * @return the pointer to the created SFRestRequest. */
-	Q_INVOKABLE sf::SFRestRequest * requestForDescribeGlobal();
+	Q_INVOKABLE sf::SFRestRequest * requestForDescribeGlobal(bool conditional = false);
 
 	/*! Creates a @c SFRestRequest which lists the summary of the individual metadata for the specified object.
 	 * @see http://www.salesforce.com/us/developer/docs/api_rest/Content/resources_sobject_basic_info.htm
 	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory. If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
 	 * @param objectType String of the object type. Example: "Account"
+	 * @param conditional whether to revalidate the previous response, see @c SFRestRequest::conditional. An unchanged resource then costs a 304 response without a body, but the request is never batched.
 	 * @return the pointer to the created SFRestRequest. */
-	Q_INVOKABLE sf::SFRestRequest * requestForMetadata(const QString & objectType);
+	Q_INVOKABLE sf::SFRestRequest * requestForMetadata(const QString & objectType, bool conditional = false);
 
 	/*! Creates a @c SFRestRequest which completely describes the individual metadata for the sepcified object.
 	 * @see http://www.salesforce.com/us/developer/docs/api_rest/Content/resources_sobject_describe.htm
 	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory. If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
 	 * @param objectType String of the object type. Example: "Account"
+	 * @param conditional whether to revalidate the previous response, see @c SFRestRequest::conditional. An unchanged resource then costs a 304 response without a body, but the request is never batched.
 	 * @return the pointer to the created SFRestRequest. */
-	Q_INVOKABLE sf::SFRestRequest * requestForDescribeObject(const QString & objectType);
+	Q_INVOKABLE sf::SFRestRequest * requestForDescribeObject(const QString & objectType, bool conditional = false);
 
 	/*! Creates a @c SFRestRequest which retrieves field values for a record of the given type.
 	 * @see http://www.salesforce.com/us/developer/docs/api_rest/Content/resources_sobject_retrieve.htm
@@ -195,8 +248,9 @@ public:
 	 * @param objectType String of the object type. Example: "Account"
 	 * @param objectId The object's object ID.
 	 * @param fieldList The list of fields for which to return values. Example: ["Name", "BillingCity", "CustomField__c"]
+	 * @param conditional whether to revalidate the previous response, see @c SFRestRequest::conditional. An unchanged resource then costs a 304 response without a body, but the request is never batched.
 	 * @return the pointer to the created SFRestRequest. */
-	Q_INVOKABLE sf::SFRestRequest * requestForRetrieveObject(const QString & objectType, const QString & objectId, const QStringList & fieldList);
+	Q_INVOKABLE sf::SFRestRequest * requestForRetrieveObject(const QString & objectType, const QString & objectId, const QStringList & fieldList, bool conditional = false);
 
 	/*! Creates a @c SFRestRequest which creates a new record of the given type.
 	 * @see http://www.salesforce.com/us/developer/docs/api_rest/Content/dome_sobject_create.htm
@@ -236,13 +290,54 @@ public:
 	 * @return the pointer to the created SFRestRequest. */
 	Q_INVOKABLE sf::SFRestRequest * requestForDeleteObject(const QString & objectType, const QString & objectId);
 
+	/*! Creates a @c SFCollectionRequest which creates several records of the given type, in chunks of up to 200 records.
+	 * @see https://developer.salesforce.com/docs/atlas.en-us.api_rest.meta/api_rest/resources_composite_sobjects_collections_create.htm
+	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory, until it is sent with @c sendCollectionRequest(). If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
+	 * @param objectType String of the object type. Example: "Account"
+	 * @param records The fields of each record as a @c QVariantMap
+	 * @param allOrNone Whether a chunk is rolled back when one of its records fails
+	 * @return the pointer to the created SFCollectionRequest. */
+	Q_INVOKABLE sf::SFCollectionRequest * requestForCreateObjects(const QString & objectType, const QVariantList & records, bool allOrNone = false);
+
+	/*! Creates a @c SFCollectionRequest which updates several records of the given type, in chunks of up to 200 records.
+	 * @see https://developer.salesforce.com/docs/atlas.en-us.api_rest.meta/api_rest/resources_composite_sobjects_collections_update.htm
+	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory, until it is sent with @c sendCollectionRequest(). If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
+	 * @param objectType String of the object type. Example: "Account"
+	 * @param records The fields to update of each record as a @c QVariantMap, including the "Id" field
+	 * @param allOrNone Whether a chunk is rolled back when one of its records fails
+	 * @return the pointer to the created SFCollectionRequest. */
+	Q_INVOKABLE sf::SFCollectionRequest * requestForUpdateObjects(const QString & objectType, const QVariantList & records, bool allOrNone = false);
+
+	/*! Creates a @c SFCollectionRequest which deletes several records, in chunks of up to 200 records.
+	 * @see https://developer.salesforce.com/docs/atlas.en-us.api_rest.meta/api_rest/resources_composite_sobjects_collections_delete.htm
+	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory, until it is sent with @c sendCollectionRequest(). If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
+	 * @param objectIds The ids of the records, of any type
+	 * @param allOrNone Whether a chunk is rolled back when one of its records fails
+	 * @return the pointer to the created SFCollectionRequest. */
+	Q_INVOKABLE sf::SFCollectionRequest * requestForDeleteObjects(const QStringList & objectIds, bool allOrNone = false);
+
 	/*! Creates a @c SFRestRequest which executes the specified SOQL query.
 	 * @see http://www.salesforce.com/us/developer/docs/api_rest/Content/resources_query.htm
 	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory. If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
 	 * @param soql A string containing the query to execute. For example, "SELECT Id,Name from Account ORDER BY Name LIMIT 20"
-	 * @return the pointer to the created SFRestRequest. */
+	 * @return the pointer to the created SFRestRequest. The result holds the first page of records, use @c SFQueryCursor to get all of them. */
 	Q_INVOKABLE sf::SFRestRequest * requestForQuery(const QString & soql);
 
+	/*! Creates a @c SFRestRequest which queries records of type T and decodes them straight into a @c QVector<T>, without
+	 * building the JSON document. The SELECT list and the sObject type come from T, see @c SFRecordFields. The payload of the
+	 * result is a @c SFDecodedRecords.
+	 * @remark The returned object has parent set to 0. It's your responsibility to manage the memory.
+	 * @param where WHERE clause, e.g. "Name='Salesforce'"
+	 * @param orderBy @c QStringList of ORDER BY fields
+	 * @param limit number for LIMIT clause. The LIMIT clause is not added if 0
+	 * @return the pointer to the created SFRestRequest. */
+	template<class T>
+	sf::SFRestRequest * requestForQuery(const QString & where, const QStringList & orderBy = QStringList(), int limit = 0) {
+		SFRestRequest *request = this->requestForQuery(this->generateSOQLQuery<T>(where, orderBy, limit));
+		request->setResponseConsumer(new SFRecordDecoder<T>());
+		return request;
+	};
+
 	/*! Creates a @c SFRestRequest which executes the specified SOSL search.
 	 * @see http://www.salesforce.com/us/developer/docs/api_rest/Content/resources_search.htm
 	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory. If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
@@ -250,6 +345,15 @@ public:
 	 * @return the pointer to the created SFRestRequest. */
 	Q_INVOKABLE sf::SFRestRequest * requestForSearch(const QString & sosl);
 
+	/*! Creates a @c SFRestRequest which runs the subrequests of @a composite in a single round trip. Subrequests can use the results
+	 * of earlier ones through @c SFCompositeRequest::reference(), so a record and its children are created in one call.
+	 * The payload of the result holds a response per subrequest, see @c SFCompositeRequest::responsesByReference().
+	 * @see https://developer.salesforce.com/docs/atlas.en-us.api_rest.meta/api_rest/resources_composite_composite.htm
+	 * @remark The returned object has parent set to 0. If the method is called in C++, it's your responsibility to manage the memory. If the method is called from QML, the ownership is automatically transfered to the JavaScript engine.
+	 * @param composite the subrequests. The function doesn't take ownership, the builder can be deleted once the request is created.
+	 * @return the pointer to the created SFRestRequest, or NULL if @a composite is NULL or empty. */
+	Q_INVOKABLE sf::SFRestRequest * requestForComposite(sf::SFCompositeRequest * composite);
+
 	/*
 	 * NOTE: Because QScriptEngine is not aware of enums, it cannot correctly interpret the signature.
 	 * 		Therefore this function should be only used in C++
@@ -264,7 +368,6 @@ public:
 	 * @param params The key-value pairs you want included in your REST request. You don't need to escape HTTP reserved characters.
 	 * @param contentType Indicate how to encode key-value pairs stored in @a params. If your HTTP verb are GET, HEAD or DELETE
 	 * This the contentType is should be @c SFRestRequest::HTTPContentTypeUrlEncoded. Please see @c SFRestRequest::HTTPContentType for more details.
-	 * @note SFRestRequest::HTTPContentTypeMultiPart is not supported in SDK version <em>1.0</em>.
 	 * @return the pointer to the created SFRestRequest.
 	 * @sa SFRestAPI::customRequest(const QString&,const QScriptValue&,const QVariantMap &,const QScriptValue&),
 	 * HTTPMethod::Type,
@@ -283,7 +386,6 @@ public:
 	 * @param method A @c QScriptValue containing an integer that matches the values of @c HTTPMethod::Type.
 	 * @param params The key-value pairs you want included in your REST request. You don't need to escape HTTP reserved characters.
 	 * @param contentType A @c QScriptValue containing an integer that matches the values of @c SFRestRequest::HTTPContentType.
-	 * @note SFRestRequest::HTTPContentTypeMultiPart is not supported in SDK version <em>1.0</em>.
 	 * @return the pointer to the created SFRestRequest.
 	 * @sa SFRestAPI::customRequest(const QString&,const HTTPMethodType&,const QVariantMap &,const sf::SFRestRequest::HTTPContentType &),
 	 * HTTPMethod::Type,
@@ -311,6 +413,16 @@ public:
 			const QStringList & orderBy = QStringList(),
 			const int & limit = 0);
 
+	/*! Generate a SOQL query whose SELECT list and sObject type come from the typed record T, see @c SFRecordFields.
+	 * @param where - WHERE clause. e.g. "Name='Salesforce'"
+	 * @param orderBy - @c QStringList of ORDER BY fields
+	 * @param limit - number for LIMIT clause. The LIMIT clause is not added if 0
+	 * @return Generated SOQL query */
+	template<class T>
+	QString generateSOQLQuery(const QString & where = "", const QStringList & orderBy = QStringList(), int limit = 0) {
+		return this->generateSOQLQuery(sfRecordFieldNames<T>(), SFRecordTraits<T>::sObjectType(), where, QStringList(), "", orderBy, limit);
+	};
+
 	/*!
 	 * Generate a SOSL search string.
 	 * @param searchTerm - the search term. e.g. "John*"
@@ -341,10 +453,17 @@ private:
 	QString mUserAgent;
 
 	QQueue<SFRestResourceTask*> mPendingTasks;
+	int mBatchWindow;
+	QTimer *mBatchTimer;
+	QList<SFRestResourceTask*> mBatchQueue; //waiting for the batching window to close
+	QHash<int, QList<SFRestResourceTask*> > mBatches; //sent in a Composite Batch request, by the tag of that request
+	int mBatchSequence;
 
 	SFRestResourceTask* createRestTask(SFRestRequest * request, const QVariant & tag = QVariant());
+	SFCollectionTask* createCollectionTask(SFCollectionRequest * request, const QVariant & tag = QVariant());
 	void startRestTask(SFRestResourceTask * task);
 	void resendAllPendingTasks();
+	bool enqueueBatchedTask(SFRestResourceTask * task);
 
 	QString findWebKitUserAgent();
 	QString constructUserAgent();
@@ -355,6 +474,8 @@ private slots:
 	void onSFOAuthFlowCanceled(SFOAuthInfo*);
 
 	void onTaskShouldRetry(sf::SFGenericTask*, sf::SFResult*);
+	void onBatchWindowClosed();
+	void onBatchResultReady(sf::SFResult*);
 };
 
 } /* namespace sf */
@@ -24,12 +24,15 @@
 
 #include <QObject>
 #include <QVariant>
+#include <QStringList>
 #include "SFGlobal.h"
 
 class QNetworkRequest;
 
 namespace sf {
 
+class SFResponseConsumer;
+
 extern const QString DefaultEndpoint; //!< Default Force.com REST API end point: "/services/data"
 
 /*!
@@ -43,6 +46,10 @@ extern const QString DefaultEndpoint; //!< Default Force.com REST API end point:
  * to construct the object by yourself. @c SFRestAPI provide with convenient functions for you to create various SFRestRequest objects.
  * This class also support customized request body if built-in parameter encoding is not sufficient.
  *
+ * For large responses, such as big query results, a @c SFResponseConsumer can be set with @c setResponseConsumer(). The response body is then
+ * processed chunk by chunk while it is downloaded, and the payload of the result is whatever the consumer produces.
+ * Likewise, a large request body can be sent straight from a file with @c setRequestBodyFile(), it is read as it is uploaded.
+ *
  * For security reason, this class do not hold information about current Salesforce session. It retrieves access token and instance URL at runtime.
  * This means if you logout after you create a request, the class cannot inject valid access token into generated @c QNetworkRequest.
  *
@@ -53,6 +60,8 @@ extern const QString DefaultEndpoint; //!< Default Force.com REST API end point:
 class SFRestRequest : public QObject {
 	Q_OBJECT
 	Q_ENUMS(HTTPContentType)
+	Q_ENUMS(JsonParser)
+	Q_ENUMS(PayloadType)
 	Q_PROPERTY(QString endPoint READ endPoint WRITE setEndPoint) /*!< The end point of this request, relative to the session's instance URL. @b Default: "/services/data" */
 	Q_PROPERTY(QString apiVersion READ apiVersion WRITE setApiVersion) /*!< The Force.com REST API version of this request. e.g. "/29.0" */
 
@@ -71,14 +80,35 @@ class SFRestRequest : public QObject {
 	 * used if HTTP verb is set to GET, HEAD, DELETE. For supported format, see @c SFRestRequest::HTTPContentType */
 	Q_PROPERTY(sf::SFRestRequest::HTTPContentType paramsContentType READ paramsContentType WRITE setParamsContentType)
 	Q_PROPERTY(QByteArray requestRawData READ requestRawData WRITE setRequestRawData) /*!< The raw data of the request body. @note Assigning this property automatically clear the parameters assigned via @c setRequestParams() */
+	Q_PROPERTY(QString requestBodyFile READ requestBodyFile) /*!< The file the request body is streamed from, if any. See @c setRequestBodyFile() */
+	Q_PROPERTY(QStringList capturedResponseHeaders READ capturedResponseHeaders WRITE setCapturedResponseHeaders) /*!< The names of the response headers to copy into the result's tags under @c kSFResponseHeadersTag, e.g. "Sforce-Locator" */
 	Q_PROPERTY(QVariantMap requestRawHeaders READ requestRawHeaders WRITE setRequestRawHeaders) /*!< Key-value pairs that will be added to the request header. @note entries added will overwrite default values. */
+	Q_PROPERTY(sf::SFRestRequest::JsonParser jsonParser READ jsonParser WRITE setJsonParser) /*!< The parser of the JSON response. See @c SFRestRequest::JsonParser. @b Default: @c SFRestRequest::JsonParserDefault */
+	Q_PROPERTY(bool stripRecordAttributes READ stripRecordAttributes WRITE setStripRecordAttributes) /*!< Whether to drop the "attributes" object Salesforce adds to every record of the "records" array of the response. Not applied to a @c SFRestRequest::PayloadJsonView payload nor to a response consumer, see @c SFJsonRecordsConsumer::setStripAttributes(). @b Default: false */
+	Q_PROPERTY(sf::SFRestRequest::PayloadType payloadType READ payloadType WRITE setPayloadType) /*!< The type of the payload of a successful response. See @c SFRestRequest::PayloadType. @b Default: @c SFRestRequest::PayloadVariant */
+	Q_PROPERTY(QVariantMap recordDescribe READ recordDescribe WRITE setRecordDescribe) /*!< The describe result of the queried sObject, used to type the columns of a @c SFRestRequest::PayloadRecordBatch payload. Optional. */
+	Q_PROPERTY(bool conditional READ isConditional WRITE setConditional) /*!< Whether a GET request is revalidated with the "ETag" and "Last-Modified" of its previous response, see @c SFResponseCache. A 304 response is then a success whose payload is the previous one. Validators set in @c SFRestRequest::requestRawHeaders take precedence, the payload of a 304 response is then empty. Not applied to a response consumer. A conditional request is never sent in a batch nor accepted in a composite request, see @c SFRestRequest::canBeBatched(). @b Default: false, see the @a conditional parameter of @c SFRestAPI::requestForRetrieveObject() and of the describe requests */
+	Q_PROPERTY(sf::SFRequestPriority::Type priority READ priority WRITE setPriority) /*!< The scheduling priority of this request. See @c SFRequestScheduler. @b Default: @c SFRequestPriority::Interactive */
 public:
 	/*! The encoding type of parameters. Typically with Force.com APIs, use @c SFRestRequest::HTTPContentTypeUrlEncoded for GET, HEAD and DELETE
 	 * and use @c SFRestRequest::HTTPContentTypeJSON for other HTTP verbs. */
 	enum HTTPContentType {
 		HTTPContentTypeUrlEncoded, /*!< parameters are encoded into the URL as key-value pair. e.g. "?firstname=John&lastname=Smith" */
 		HTTPContentTypeJSON, /*!< parameters are encoded into request body using JSON format. */
-		HTTPContentTypeMultiPart, /*!< use HTTP "multipart/form-data" encoding. @warning currently not implemented. */
+		HTTPContentTypeMultiPart, /*!< use HTTP "multipart/form-data" encoding. Byte arrays are sent as files, maps and lists as JSON parts. */
+	};
+
+	/*! The parser of the JSON response. Both produce the same payload. Ignored if a response consumer is set. */
+	enum JsonParser {
+		JsonParserDefault, /*!< @c bb::data::JsonDataAccess. */
+		JsonParserIndexed, /*!< @c SFJsonIndexParser, faster for large responses such as big query pages, whose records are materialized in parallel. */
+	};
+
+	/*! The type of the payload of a successful response. Error responses are always decoded to a @c QVariant. Ignored if a response consumer is set. */
+	enum PayloadType {
+		PayloadVariant, /*!< The decoded @c QVariant tree. */
+		PayloadJsonView, /*!< A @c SFJsonView that decodes values on access. @c SFResult::payload<T>() still decodes it to any other type on demand. */
+		PayloadRecordBatch, /*!< For queries, a @c SFRecordBatch that stores the records column by column. See @c SFRestRequest::recordDescribe. @c SFResult::payload<T>() still gives the usual response for any other type. */
 	};
 
 	/*! Explicit constructor.
@@ -113,6 +143,19 @@ public:
 	 * @return standard @c SFResultCode indicating the result of this operation. See @c SFResultCode::Type for possible values. */
 	SFResultCodeType prepareNetworkRequest(QNetworkRequest *pOutRequest, QByteArray *pOutData, QString *pOutErrorMsg);
 
+	/*! @return whether the request can be sent as a subrequest of a Composite Batch request. Only requests to the "sobjects", "query", "queryAll"
+	 * and "search" resources whose response is delivered as a plain @c QVariant, that are not conditional, without raw data, a body file, raw headers,
+	 * captured response headers or a response consumer, and whose body, if any, is JSON qualify.
+	 * @see SFRestAPI::batchWindow */
+	bool canBeBatched() const;
+	/*! @return the description of the request inside the "batchRequests" array of a Composite Batch request. The URL is
+	 * relative to the end point, e.g. "v29.0/sobjects/Account/001D000000K0fXOIAZ?fields=Name" */
+	QVariantMap toBatchSubrequest() const;
+	/*! @param referenceId the name later subrequests use to refer to the result, e.g. "@{referenceId.id}"
+	 * @return the description of the request inside the "compositeRequest" array of a Composite request. The URL includes
+	 * the end point, e.g. "/services/data/v29.0/sobjects/Account" @see SFCompositeRequest */
+	QVariantMap toCompositeSubrequest(const QString & referenceId) const;
+
 	/* accessors */
 	/*! See @c SFRestRequest::endPoint */
 	const QString & endPoint() const {return this->mEndPoint;};
@@ -146,10 +189,56 @@ public:
 	const QByteArray & requestRawData() const {return this->mRequestRawData;};
 	/*! See @c SFRestRequest::requestRawData */
 	void setRequestRawData(const QByteArray &rawData) {this->mRequestRawData = rawData;};
+	/*! See @c SFRestRequest::requestBodyFile */
+	const QString & requestBodyFile() const {return this->mRequestBodyFile;};
+	/*! @return the Content-Type of the body sent from @c SFRestRequest::requestBodyFile */
+	const QString & requestBodyContentType() const {return this->mRequestBodyContentType;};
+	/*! Send the content of a file as the request body. The file is read while it is uploaded, never loaded in memory as a whole.
+	 * When set, parameters and @c SFRestRequest::requestRawData are not sent in the body.
+	 * @param fileName the file to send, or an empty string to stop sending a file
+	 * @param contentType the value of the Content-Type header, e.g. "text/csv" */
+	Q_INVOKABLE void setRequestBodyFile(const QString & fileName, const QString & contentType = "application/octet-stream") {
+		this->mRequestBodyFile = fileName;
+		this->mRequestBodyContentType = contentType;
+	};
 	/*! See @c SFRestRequest::requestRawHeaders */
 	const QVariantMap & requestRawHeaders() const {return this->mRequestRawHeaders;};
 	/*! See @c SFRestRequest::requestRawHeaders */
 	void setRequestRawHeaders(const QVariantMap & rawHeaders ) {this->mRequestRawHeaders = rawHeaders;};
+	/*! See @c SFRestRequest::capturedResponseHeaders */
+	const QStringList & capturedResponseHeaders() const {return this->mCapturedResponseHeaders;};
+	/*! See @c SFRestRequest::capturedResponseHeaders */
+	void setCapturedResponseHeaders(const QStringList & names) {this->mCapturedResponseHeaders = names;};
+	/*! See @c SFRestRequest::jsonParser */
+	const JsonParser & jsonParser() const {return this->mJsonParser;};
+	/*! See @c SFRestRequest::jsonParser */
+	void setJsonParser(const JsonParser & parser) {this->mJsonParser = parser;};
+	/*! See @c SFRestRequest::stripRecordAttributes */
+	bool stripRecordAttributes() const {return this->mStripRecordAttributes;};
+	/*! See @c SFRestRequest::stripRecordAttributes */
+	void setStripRecordAttributes(bool strip) {this->mStripRecordAttributes = strip;};
+	/*! See @c SFRestRequest::payloadType */
+	const PayloadType & payloadType() const {return this->mPayloadType;};
+	/*! See @c SFRestRequest::payloadType */
+	void setPayloadType(const PayloadType & type) {this->mPayloadType = type;};
+	/*! See @c SFRestRequest::recordDescribe */
+	const QVariantMap & recordDescribe() const {return this->mRecordDescribe;};
+	/*! See @c SFRestRequest::recordDescribe */
+	void setRecordDescribe(const QVariantMap & describe) {this->mRecordDescribe = describe;};
+	/*! See @c SFRestRequest::conditional */
+	bool isConditional() const {return this->mConditional;};
+	/*! See @c SFRestRequest::conditional */
+	void setConditional(bool conditional) {this->mConditional = conditional;};
+	/*! See @c SFRestRequest::priority */
+	const SFRequestPriorityType & priority() const {return this->mPriority;};
+	/*! See @c SFRestRequest::priority */
+	void setPriority(const SFRequestPriorityType & priority) {this->mPriority = priority;};
+	/*! @return the consumer the response body is streamed to, or NULL if the response is parsed as a whole. */
+	SFResponseConsumer * responseConsumer() const {return this->mResponseConsumer;};
+	/*! Stream the body of a successful response to the given consumer instead of parsing it as a whole JSON document.
+	 * The request takes ownership of the consumer and deletes the previous one.
+	 * @param consumer the consumer, or NULL to parse the response as JSON */
+	void setResponseConsumer(SFResponseConsumer * consumer);
 
 	/*! Get the value of the parameter associated with given key
 	 * @param key the key of the parameter to get
@@ -174,12 +263,22 @@ private:
 	QVariantMap mRequestParams;
 	HTTPContentType mParamsContentType;
 	QByteArray mRequestRawData;
+	QString mRequestBodyFile;
+	QString mRequestBodyContentType;
 	QVariantMap mRequestRawHeaders;
+	QStringList mCapturedResponseHeaders;
+	JsonParser mJsonParser;
+	PayloadType mPayloadType;
+	bool mStripRecordAttributes;
+	QVariantMap mRecordDescribe;
+	bool mConditional;
+	SFRequestPriorityType mPriority;
+	SFResponseConsumer *mResponseConsumer;
 
 	SFResultCodeType createNetworkRequest(QNetworkRequest *pOutRequest, QString * pOutErrorMsg);
+	QVariantMap toSubrequest(const QString & base, const QString & bodyKey) const;
 	bool encodeParamsToURL(QUrl & url);
 	bool encodeParamsToData(QByteArray * pOutBytes, QString * pOutContentType);
-	void createUrlEncodedContent(QByteArray *pOutBytes);
 
 	//for debug
 	QString composeRequestSummary(const QNetworkRequest & request, QByteArray & data);
@@ -32,6 +32,8 @@
 
 namespace sf {
 
+class SFRecordBatchConsumer;
+
 /*!
  * @class SFRestResourceTask
  * @headerfile SFRestResourceTask.h <rest/SFRestResourceTask.h>
@@ -195,6 +197,16 @@ public:
 	/*! destructor */
 	virtual ~SFRestResourceTask();
 
+	/*! @return the request of the task */
+	SFRestRequest *restRequest() { return this->mRestRequest;};
+
+	/*! Finish the task with one of the responses of a Composite Batch request instead of sending its own request. The result is built
+	 * and delivered the same way as if the response was received on its own, including a re-try on 401.
+	 * Must be called in the thread the task lives in, on a task that is not started.
+	 * @param statusCode the HTTP status code of the subrequest
+	 * @param content the body of the subresponse, already decoded */
+	void finishWithSubresponse(int statusCode, const QVariant & content);
+
 protected:
 	/*! Prepare and validate @c SFNetworkAccessTask::mRequest. Called immediately before the request is sent
 	 * @return the state of the task */
@@ -217,6 +229,10 @@ protected:
 	SFRestRequest *mRestRequest; /*! The pointer to a @c SFRestRequest instance */
 
 private:
+	QString mCacheKey; //the key in SFResponseCache of a conditional request, empty otherwise
+	QVariant mCachedPayload; //the payload the validators were sent for
+	SFRecordBatchConsumer *mRecordBatchConsumer; //builds the payload of a PayloadRecordBatch request while it downloads
+
 	NetworkTaskState processStatusCode(const int & statusCode, const QString & reason, QNetworkReply * reply);
 	NetworkTaskState processNetworkErrorCode(const int & errorCode, const QString & reason);
 };
@@ -26,6 +26,7 @@
 #include "SFAuthenticationManager.h"
 #include "SFRestAPI.h"
 #include "SFAccountManager.h"
+#include "SFDescribeCache.h"
 
 namespace sf {
 /* Constants */
@@ -50,6 +51,8 @@ SFAbstractApplicationUI::SFAbstractApplicationUI(bb::cascades::Application *app)
 
 	//setup API objects
 	SFRestAPI::instance()->setApiVersion(SFDefaultRestApiVersion);
+	//created before the first login so that it warms up after it
+	SFDescribeCache::instance();
 
 	//Expose API objects to QML
 	QDeclarativeEngine *engine = QmlDocument::defaultDeclarativeEngine();
@@ -58,6 +61,7 @@ SFAbstractApplicationUI::SFAbstractApplicationUI(bb::cascades::Application *app)
 		context->setContextProperty("SFAccountManager", SFAccountManager::instance());
 		context->setContextProperty("SFAuthenticationManager", SFAuthenticationManager::instance());
 		context->setContextProperty("SFRestAPI", SFRestAPI::instance());
+		context->setContextProperty("SFDescribeCache", SFDescribeCache::instance());
 	} else {
 		sfWarning() << "[SFAbstractApplicationUI] Failed to grab shared QML declarative engine. SF APIs may not be accessible in QML.";
 	}
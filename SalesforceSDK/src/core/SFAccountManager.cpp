@@ -20,11 +20,16 @@
 */
 
 #include "SFAccountManager.h"
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QSettings>
+#include <QThread>
 #include "SFOAuthCoordinator.h"
 #include "SFOAuthCredentials.h"
 #include "SFIdentityData.h"
 #include "SFIdentityCoordinator.h"
+#include "SFTokenVault.h"
 #include "SFGlobal.h"
 
 namespace sf {
@@ -51,8 +56,10 @@ static const QString kLoginHostKey = "login_host_pref";
 static const QString kAppSettingsLoginHostIsCustom = "CUSTOM";
 
 
-SFAccountManager * SFAccountManager::sharedInstance = NULL;
+QAtomicPointer<SFAccountManager> SFAccountManager::sharedInstance;
 QString CurrentAccountIdentifier;
+//instance() calls instanceForAccount() with the lock held
+static QMutex sInstanceLock(QMutex::Recursive);
 
 SFAccountManager::SFAccountManager() {
 	mCoordinator = NULL;
@@ -70,18 +77,34 @@ SFAccountManager::~SFAccountManager() {
 }
 
 SFAccountManager* SFAccountManager::instance() {
-	if (!SFAccountManager::sharedInstance) {
-		SFAccountManager::setCurrentAccountIdentifier(SFDefaultAccountIdentifier);
-		SFAccountManager::sharedInstance = instanceForAccount(CurrentAccountIdentifier);
+	//the lock is only taken until the instance exists
+	SFAccountManager *instance = sharedInstance.fetchAndAddAcquire(0);
+	if (!instance) {
+		QMutexLocker locker(&sInstanceLock);
+		if (!sharedInstance.fetchAndAddAcquire(0)) {
+			SFAccountManager::setCurrentAccountIdentifier(SFDefaultAccountIdentifier);
+		}
+		instance = instanceForAccount(CurrentAccountIdentifier);
 	}
-	return sharedInstance;
+	return instance;
 }
 
 SFAccountManager* SFAccountManager::instanceForAccount(QString accountIdentifier) {
-	if (!SFAccountManager::sharedInstance) {
-		SFAccountManager::sharedInstance = new SFAccountManager(accountIdentifier);
+	SFAccountManager *instance = sharedInstance.fetchAndAddAcquire(0);
+	if (!instance) {
+		QMutexLocker locker(&sInstanceLock);
+		instance = sharedInstance.fetchAndAddAcquire(0);
+		if (!instance) {
+			instance = new SFAccountManager(accountIdentifier);
+			QCoreApplication *app = QCoreApplication::instance();
+			if (app && instance->thread() != app->thread()) {
+				//its coordinators and signals belong to the application thread, whichever thread created it
+				instance->moveToThread(app->thread());
+			}
+			sharedInstance.fetchAndStoreRelease(instance);
+		}
 	}
-	return sharedInstance;
+	return instance;
 }
 
 void SFAccountManager::ensureAccountDefaultsExist(){
@@ -289,6 +312,8 @@ void SFAccountManager::updateLoginHost(){
 	setting.setValue(kLoginHostKey, currentLoginHost);
 	if (previousLoginHost!=currentLoginHost){
 		sfWarning()<<"[SFAccountManager] update login host from "<<previousLoginHost<<" to "<<currentLoginHost;
+		//tokens are keyed by login host, make sure nothing of the previous host is served from memory
+		SFTokenVault::instance()->invalidate();
 		//this signal should be handled by authentication manager, which should cancel authentication, and clear account state (keep data)
 		emit loginHostChanged();
 	}
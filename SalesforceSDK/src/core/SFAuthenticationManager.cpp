@@ -33,6 +33,8 @@
 #include "SFOAuthInfo.h"
 #include "SFOAuthCoordinator.h"
 #include "SFIdentityCoordinator.h"
+#include "SFRequestTemplate.h"
+#include "SFResponseCache.h"
 #include "SFIdentityData.h"
 #include <bb/system/SystemToast>
 #include <bb/cascades/WebLoadStatus>
@@ -79,6 +81,8 @@ void SFAuthenticationManager::login(){
 void SFAuthenticationManager::logout(){
 	SFAccountManager::instance()->getCoordinator()->stopAuthentication();
 	SFAccountManager::instance()->clearAccountState(true);
+	SFRequestTemplate::clearCache();
+	SFResponseCache::clear();
 	SFSecurityLockout::instance()->reset();
 	emit SFUserLoggedOut();
 }
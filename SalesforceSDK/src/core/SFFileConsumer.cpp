@@ -0,0 +1,79 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFFileConsumer.cpp
+*/
+
+
+#include "SFFileConsumer.h"
+
+namespace sf {
+
+SFFileConsumer::SFFileConsumer(const QString & fileName) : mFile(fileName), mSize(0), mStartOffset(-1), mAppend(false),
+		mSkipFirstLine(false), mInFirstLine(false) {
+}
+
+SFFileConsumer::~SFFileConsumer() {
+	mFile.close();
+}
+
+bool SFFileConsumer::begin(int, const QByteArray &) {
+	mFile.close();
+	mSize = 0;
+	mError.clear();
+	mInFirstLine = mSkipFirstLine;
+	if (!mAppend) {
+		return mFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || this->fail();
+	}
+	if (mStartOffset < 0) {
+		mStartOffset = mFile.exists() ? mFile.size() : 0;
+	}
+	//drop whatever a previous attempt wrote
+	if (!mFile.open(QIODevice::ReadWrite) || !mFile.resize(mStartOffset) || !mFile.seek(mStartOffset)) {
+		return this->fail();
+	}
+	return true;
+}
+
+bool SFFileConsumer::consume(const QByteArray & chunk) {
+	int skipped = 0;
+	if (mInFirstLine) {
+		int lineEnd = chunk.indexOf('\n');
+		mInFirstLine = lineEnd < 0;
+		skipped = mInFirstLine ? chunk.size() : lineEnd + 1;
+	}
+	qint64 length = chunk.size() - skipped;
+	if (length > 0 && mFile.write(chunk.constData() + skipped, length) != length) {
+		return this->fail();
+	}
+	mSize += length;
+	return true;
+}
+
+bool SFFileConsumer::finish() {
+	if (!mFile.flush()) {
+		return this->fail();
+	}
+	mFile.close();
+	return true;
+}
+
+bool SFFileConsumer::fail() {
+	mError = QString("Cannot write %1: %2").arg(mFile.fileName(), mFile.errorString());
+	mFile.close();
+	return false;
+}
+
+} /* namespace sf */
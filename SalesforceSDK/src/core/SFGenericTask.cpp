@@ -180,13 +180,17 @@ void SFGenericTask::cleanup() {
 
 	if (mStatus != TaskStatusWillRetry ||  !this->retry()) {
 		//no need to retry or can't retry, finish up
-		emit taskResultReady(mResult);
-
-		emit taskFinished(this);
-		this->deleteLater();
+		this->finish();
 	}
 }
 
+void SFGenericTask::finish() {
+	emit taskResultReady(mResult);
+
+	emit taskFinished(this);
+	this->deleteLater();
+}
+
 bool SFGenericTask::retry() {
 
 	if (mRetryCount-- <= 0) {
@@ -22,7 +22,17 @@
 #include "SFGlobal.h"
 #include <QtDeclarative>
 #include <QtNetwork/QNetworkAccessManager>
+#include <QThread>
+#include <QThreadPool>
+#include <QDateTime>
+#include "SFNetworkThread.h"
 #include "SFRestRequest.h"
+#include "SFBulkIngestJob.h"
+#include "SFBulkQueryJob.h"
+#include "SFCompositeRequest.h"
+#include "SFDescribeCache.h"
+#include "SFCollectionRequest.h"
+#include "SFQueryCursor.h"
 #include "SFResult.h"
 
 namespace sf {
@@ -32,8 +42,11 @@ const QString SFMobileSDKNativeDesignator = "Native";
 const QString kSFRestRequestTag = "SFRestRequestTag";
 const QString kSFOAuthError = "error";
 const QString kSFOAuthErrorDescription = "error_description";
+const QString kSFTaskEventLoopHopsTag = "SFTaskEventLoopHops";
+const QString kSFTaskThreadSwitchesTag = "SFTaskThreadSwitches";
+const QString kSFResponseHeadersTag = "SFResponseHeaders";
 
-QNetworkAccessManager* sharedNetworkAccessManager = NULL;
+QThreadPool* sharedParsingThreadPool = NULL;
 
 /*
  * Global Function
@@ -43,18 +56,115 @@ void sfRegisterMetaTypes() {
 	//register enum
 	qmlRegisterUncreatableType<HTTPMethod>("sf", 1, 0, "HTTPMethod", "Enum wrapper class");
 	qmlRegisterUncreatableType<SFResultCode>("sf", 1, 0, "SFResultCode", "Enum wrapper class");
+	qmlRegisterUncreatableType<SFRequestPriority>("sf", 1, 0, "SFRequestPriority", "Enum wrapper class");
 
 	//register classes
 	qmlRegisterType<SFRestRequest>("sf", 1, 0, "SFRestRequest");
+	qmlRegisterType<SFCompositeRequest>("sf", 1, 0, "SFCompositeRequest");
+	qmlRegisterUncreatableType<SFCollectionRequest>("sf", 1, 0, "SFCollectionRequest", "Created by SFRestAPI");
+	qmlRegisterType<SFQueryCursor>("sf", 1, 0, "SFQueryCursor");
+	qmlRegisterType<SFBulkIngestJob>("sf", 1, 0, "SFBulkIngestJob");
+	qmlRegisterType<SFBulkQueryJob>("sf", 1, 0, "SFBulkQueryJob");
 	qmlRegisterType<SFResult>("sf", 1, 0, "SFResult");
+	qmlRegisterUncreatableType<SFDescribeCache>("sf", 1, 0, "SFDescribeCache", "Use the SFDescribeCache context property");
+	qRegisterMetaType<SFDescribeCache::Kind>("sf::SFDescribeCache::Kind");
 }
 
 QNetworkAccessManager* getSharedNetworkAccessManager(){
-	if (sharedNetworkAccessManager==NULL){
-		sharedNetworkAccessManager = new QNetworkAccessManager();
-		//TODO: do additional set up here.
+	return SFNetworkThread::instance()->networkAccessManager();
+}
+
+QThreadPool* getSharedParsingThreadPool(){
+	if (sharedParsingThreadPool==NULL){
+		sharedParsingThreadPool = new QThreadPool();
+		sharedParsingThreadPool->setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+	}
+	return sharedParsingThreadPool;
+}
+
+/* the digits at the given position of the text as a number, or -1 */
+static int digitsAt(const QString & text, int position, int count) {
+	if (position + count > text.length()) {
+		return -1;
+	}
+	int number = 0;
+	for (int i = position; i < position + count; i++) {
+		ushort c = text.at(i).unicode();
+		if (c < '0' || c > '9') {
+			return -1;
+		}
+		number = number * 10 + (c - '0');
+	}
+	return number;
+}
+
+bool sfParseIsoDateTime(const QString & text, bool dateOnly, qint64 * msecs) {
+	int length = text.length();
+	if (length < 10 || text.at(4) != '-' || text.at(7) != '-') {
+		return false;
+	}
+	QDate date(digitsAt(text, 0, 4), digitsAt(text, 5, 2), digitsAt(text, 8, 2));
+	if (!date.isValid()) {
+		return false;
+	}
+	if (dateOnly) {
+		*msecs = QDateTime(date, QTime(0, 0), Qt::UTC).toMSecsSinceEpoch();
+		return length == 10;
+	}
+
+	if (length < 19 || (text.at(10) != 'T' && text.at(10) != ' ') || text.at(13) != ':' || text.at(16) != ':') {
+		return false;
+	}
+	int hour = digitsAt(text, 11, 2);
+	int minute = digitsAt(text, 14, 2);
+	int second = digitsAt(text, 17, 2);
+	int millisecond = 0;
+	int position = 19;
+	if (position < length && text.at(position) == '.') {
+		position++;
+		int scale = 0;
+		while (position < length && text.at(position).isDigit()) {
+			if (scale < 3) {
+				millisecond = millisecond * 10 + text.at(position).digitValue();
+				scale++;
+			}
+			position++;
+		}
+		if (scale == 0) {
+			return false;
+		}
+		for (; scale < 3; scale++) {
+			millisecond *= 10;
+		}
+	}
+	QTime time(hour, minute, second, millisecond);
+	if (hour < 0 || minute < 0 || second < 0 || !time.isValid()) {
+		return false;
+	}
+
+	//no offset means UTC
+	int offsetMinutes = 0;
+	if (position < length && text.at(position) == 'Z') {
+		position++;
+	} else if (position < length && (text.at(position) == '+' || text.at(position) == '-')) {
+		int sign = text.at(position) == '-' ? -1 : 1;
+		int offsetHours = digitsAt(text, position + 1, 2);
+		position += 3;
+		if (position < length && text.at(position) == ':') {
+			position++;
+		}
+		int offsetRest = digitsAt(text, position, 2);
+		position += 2;
+		if (offsetHours < 0 || offsetRest < 0) {
+			return false;
+		}
+		offsetMinutes = sign * (offsetHours * 60 + offsetRest);
+	}
+	if (position != length) {
+		return false;
 	}
-	return sharedNetworkAccessManager;
+	*msecs = QDateTime(date, time, Qt::UTC).toMSecsSinceEpoch() - offsetMinutes * 60000LL;
+	return true;
 }
 
 } /* namespace sf */
@@ -29,6 +29,7 @@
 #include "SFIdentityData.h"
 #include "SFResult.h"
 #include "SFRestResourceTask.h"
+#include "SFRequestScheduler.h"
 
 namespace sf {
 
@@ -49,7 +50,10 @@ void SFIdentityCoordinator::initiateIdentityDataRetrieval(SFOAuthCredentials* cr
 	SFRestResourceTask *task = new SFRestResourceTask(getSharedNetworkAccessManager(), request);
 	task->setCancellable(true);
 	connect(this, SIGNAL(cancelIdTask()), task, SLOT(cancel()));
-	task->startTaskAsync(this, SLOT(onIdReplyReady(sf::SFResult*)));
+	//part of the login flow, don't queue it behind application traffic
+	task->setPriority(SFRequestPriority::AuthCritical);
+	connect(task, SIGNAL(taskResultReady(sf::SFResult*)), this, SLOT(onIdReplyReady(sf::SFResult*)));
+	SFRequestScheduler::instance()->submit(task);
 }
 
 void SFIdentityCoordinator::cancelRetrieval(){
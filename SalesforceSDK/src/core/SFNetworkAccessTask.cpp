@@ -22,20 +22,139 @@
 #include "SFNetworkAccessTask.h"
 #include <bb/data/JsonDataAccess>
 #include <QThreadPool>
+#include <QThread>
 #include <QBuffer>
 #include <QTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QRunnable>
+#include <QWaitCondition>
 #include "SFResult.h"
+#include "SFResponseConsumer.h"
 
 using namespace bb::data;
 
 namespace sf {
 
 static unsigned long int DefaultNetworkTimeout = 60000; // 1 minutes
+static const qint64 kSFStreamReadBufferSize = 64 * 1024; //how much of a streamed body QNetworkReply may buffer
+static const int kSFStreamHighWater = 1024 * 1024; //queued bytes above which the reply is no longer read
+static const int kSFStreamLowWater = 256 * 1024; //queued bytes below which reading resumes
+
+/*
+ * Hands the chunks read in the network thread over to the consumer in the parsing pool, one drainer at a time.
+ * It is shared with the queued drain runnables, so it stays valid after the task is gone. Once closed, the consumer is never touched again.
+ * When the consumer falls behind, the queue is capped: the task stops reading the reply, whose bounded read buffer then holds back
+ * the sender, and the drainer asks the task to resume once the queue is short again.
+ */
+class SFResponseStream {
+public:
+	SFResponseStream(SFResponseConsumer *consumer, QObject *reader)
+	: mConsumer(consumer), mReader(reader), mQueuedBytes(0), mDraining(false), mScheduled(false), mClosed(false), mFailed(false), mPaused(false) {}
+
+	/* @return true if a drain has to be scheduled */
+	bool push(const QByteArray & chunk) {
+		QMutexLocker locker(&mLock);
+		if (mClosed || mFailed) {
+			return false;
+		}
+		mChunks.enqueue(chunk);
+		mQueuedBytes += chunk.size();
+		if (mScheduled) {
+			return false;
+		}
+		mScheduled = true;
+		return true;
+	}
+
+	/* @return true if the queue is full, the reader then waits for resumeReading() */
+	bool pauseIfFull() {
+		QMutexLocker locker(&mLock);
+		mPaused = mQueuedBytes >= kSFStreamHighWater;
+		return mPaused;
+	}
+
+	void drain() {
+		QMutexLocker locker(&mLock);
+		mScheduled = false;
+		while (mDraining) {
+			mIdle.wait(&mLock);
+		}
+		mDraining = true;
+		while (!mClosed && !mFailed && !mChunks.isEmpty()) {
+			QByteArray chunk = mChunks.dequeue();
+			mQueuedBytes -= chunk.size();
+			if (mPaused && mQueuedBytes < kSFStreamLowWater) {
+				//the reader can't be gone, close() waits for the drainer and a deleted receiver drops its queued calls
+				mPaused = false;
+				QMetaObject::invokeMethod(mReader, "resumeReading", Qt::QueuedConnection);
+			}
+			locker.unlock();
+			bool consumed = mConsumer->consume(chunk);
+			locker.relock();
+			mFailed = !consumed;
+		}
+		mDraining = false;
+		mIdle.wakeAll();
+	}
+
+	bool finish(const QByteArray & tail) {
+		this->push(tail);
+		this->drain();
+		bool failed = this->close();
+		return !failed && mConsumer->finish();
+	}
+
+	/* @return whether the consumer failed */
+	bool close() {
+		QMutexLocker locker(&mLock);
+		while (mDraining) {
+			mIdle.wait(&mLock);
+		}
+		mClosed = true;
+		mChunks.clear();
+		mQueuedBytes = 0;
+		return mFailed;
+	}
+
+	void fail() {
+		QMutexLocker locker(&mLock);
+		mFailed = true;
+	}
+
+	bool isFailed() {
+		QMutexLocker locker(&mLock);
+		return mFailed;
+	}
+
+private:
+	SFResponseConsumer *mConsumer;
+	QObject *mReader;
+	QMutex mLock;
+	QWaitCondition mIdle;
+	QQueue<QByteArray> mChunks;
+	int mQueuedBytes;
+	bool mDraining;
+	bool mScheduled;
+	bool mClosed;
+	bool mFailed;
+	bool mPaused;
+};
+
+class SFResponseStreamDrain : public QRunnable {
+public:
+	SFResponseStreamDrain(const QSharedPointer<SFResponseStream> & stream) : mStream(stream) {}
+	void run() { mStream->drain(); }
+private:
+	QSharedPointer<SFResponseStream> mStream;
+};
 
 SFNetworkAccessTask::SFNetworkAccessTask(QNetworkAccessManager *networkAccessManager)
 : SFGenericTask(), mNetworkAccessManager(networkAccessManager), mRequest(QNetworkRequest(QUrl())), mMethod(HTTPMethod::HTTPGet),
   mRequestBytesArray(QByteArray()), mRequestData(NULL), mState(StateNotStarted), mCurrentReply(NULL),
-  mUseCache(false), mNetworkTimeout(DefaultNetworkTimeout), mNetworkTimer(NULL) {
+  mUseCache(false), mNetworkTimeout(DefaultNetworkTimeout), mNetworkTimer(NULL), mOwnerThread(NULL),
+  mPriority(SFRequestPriority::Interactive), mResponseConsumer(NULL), mEventLoopHops(0), mThreadSwitches(0) {
 
 	this->setUseCache(false);
 }
@@ -43,7 +162,8 @@ SFNetworkAccessTask::SFNetworkAccessTask(QNetworkAccessManager *networkAccessMan
 SFNetworkAccessTask::SFNetworkAccessTask(QNetworkAccessManager * const networkAccessManager, const QNetworkRequest & request, const HTTPMethodType & method)
 : SFGenericTask(), mNetworkAccessManager(networkAccessManager), mRequest(request), mMethod(method),
   mRequestBytesArray(QByteArray()), mRequestData(NULL), mState(StateNotStarted), mCurrentReply(NULL),
-  mUseCache(false), mNetworkTimeout(DefaultNetworkTimeout), mNetworkTimer(NULL) {
+  mUseCache(false), mNetworkTimeout(DefaultNetworkTimeout), mNetworkTimer(NULL), mOwnerThread(NULL),
+  mPriority(SFRequestPriority::Interactive), mResponseConsumer(NULL), mEventLoopHops(0), mThreadSwitches(0) {
 
 	this->setUseCache(false);
 }
@@ -51,7 +171,8 @@ SFNetworkAccessTask::SFNetworkAccessTask(QNetworkAccessManager * const networkAc
 SFNetworkAccessTask::SFNetworkAccessTask(QNetworkAccessManager * const networkAccessManager, const QUrl & url, const HTTPMethodType & method)
 : SFGenericTask(), mNetworkAccessManager(networkAccessManager), mRequest(QNetworkRequest(url)), mMethod(method),
   mRequestBytesArray(QByteArray()), mRequestData(NULL), mState(StateNotStarted), mCurrentReply(NULL),
-  mUseCache(false), mNetworkTimeout(DefaultNetworkTimeout), mNetworkTimer(NULL) {
+  mUseCache(false), mNetworkTimeout(DefaultNetworkTimeout), mNetworkTimer(NULL), mOwnerThread(NULL),
+  mPriority(SFRequestPriority::Interactive), mResponseConsumer(NULL), mEventLoopHops(0), mThreadSwitches(0) {
 
 	this->setUseCache(false);
 }
@@ -59,13 +180,14 @@ SFNetworkAccessTask::SFNetworkAccessTask(QNetworkAccessManager * const networkAc
 SFNetworkAccessTask::SFNetworkAccessTask(QNetworkAccessManager * const networkAccessManager, const QString & path, const HTTPMethodType & method)
 : SFGenericTask(), mNetworkAccessManager(networkAccessManager), mRequest(QNetworkRequest(QUrl(path))), mMethod(method),
   mRequestBytesArray(QByteArray()), mRequestData(NULL), mState(StateNotStarted), mCurrentReply(NULL),
-  mUseCache(false), mNetworkTimeout(DefaultNetworkTimeout), mNetworkTimer(NULL) {
+  mUseCache(false), mNetworkTimeout(DefaultNetworkTimeout), mNetworkTimer(NULL), mOwnerThread(NULL),
+  mPriority(SFRequestPriority::Interactive), mResponseConsumer(NULL), mEventLoopHops(0), mThreadSwitches(0) {
 
 	this->setUseCache(false);
 }
 
 SFNetworkAccessTask::~SFNetworkAccessTask() {
-
+	this->closeResponseStream();
 }
 
 /*********************
@@ -89,25 +211,52 @@ void SFNetworkAccessTask::setRequestData(QIODevice * data) {
 
 /* Overrides */
 void SFNetworkAccessTask::startTaskAsync(QObject* resultReceiver, const char * resultReceiverSlot) {
+	if (QThread::currentThread() != this->thread()) {
+		//only the thread the task lives in can move it, so connect the receiver now and start from there
+		if (resultReceiver && resultReceiverSlot) {
+			connect(this, SIGNAL(taskResultReady(sf::SFResult*)), resultReceiver, resultReceiverSlot);
+		}
+		this->queueInvocation("startTaskAsync");
+		return;
+	}
 	SFGenericTask::prepareToStart(resultReceiver, resultReceiverSlot);
 	if (this->mCurrentReply) {
 		this->mCurrentReply->deleteLater();
 		this->mCurrentReply = NULL;
 	}
+	if (!mOwnerThread) {
+		//a re-started task is already in the network thread, keep the thread of the first start
+		mOwnerThread = this->thread();
+		mEventLoopHops = 0;
+		mThreadSwitches = 0;
+	}
 	mState = StateNotStarted;
+
+	QThread *networkThread = mNetworkAccessManager ? mNetworkAccessManager->thread() : NULL;
+	if (networkThread && networkThread != this->thread()) {
+		//the request reads the session, which only the thread that started the task may touch, so it is built here.
+		//The rest of the FSM runs in the network thread, finish() brings the task back
+		mStatus = TaskStatusRunning;
+		this->prepare();
+		mState = this->ensureRequest();
+		this->moveQObjectsToThread(networkThread);
+		this->queueInvocation("fsmDispatcher");
+		return;
+	}
 	this->fsmDispatcher();
 }
 
 void SFNetworkAccessTask::run() {
 	try {
-		//call the function in creator's thread and block
-		bool ret = this->metaObject()->invokeMethod(this, "moveQObjectsToThread", Qt::BlockingQueuedConnection, Q_ARG(QThread*, QThread::currentThread()));
-		if (!ret || !mCurrentReply) {
+		//the network thread left the task, reply and result without thread affinity, pull them into this thread
+		this->moveQObjectsToThread(QThread::currentThread());
+		if (!mCurrentReply) {
 			mResult = mResult ? mResult : SFResult::createErrorResult(SFResultCode::SFErrorNetwork, "No reply to process.");
 			mState = StateError;
 		} else {
 			mState = this->processReply(mCurrentReply);
 		}
+		this->closeResponseStream();
 
 		mStatus = TaskStatusFinished;
 	} catch(std::exception &e) {
@@ -132,6 +281,8 @@ void SFNetworkAccessTask::prepare() {
 }
 
 void SFNetworkAccessTask::cleanup() {
+	//a cancelled or failed task may leave chunks behind, the consumer must not see them once the task is done
+	this->closeResponseStream();
 	if (mResult && mCurrentReply && mCurrentReply->thread() == mResult->thread()) {
 		mCurrentReply->setParent(mResult); //the reply will be deleted when result is deleted
 	} else if (mCurrentReply && mCurrentReply->thread() == this->thread()) {
@@ -142,6 +293,36 @@ void SFNetworkAccessTask::cleanup() {
 	SFGenericTask::cleanup();
 }
 
+void SFNetworkAccessTask::finish() {
+	if (QThread::currentThread() != this->thread()) {
+		//only the thread the task lives in can move it
+		this->queueInvocation("finish");
+		return;
+	}
+	if (mOwnerThread && mOwnerThread != this->thread()) {
+		//the result, and the reply it owns, move along with the task. Usually this is the pool thread that processed the reply,
+		//so the result reaches the owner thread in a single hop
+		this->moveQObjectsToThread(mOwnerThread);
+		this->queueInvocation("finish");
+		return;
+	}
+	if (mResult) {
+		mResult->mTags.insert(kSFTaskEventLoopHopsTag, mEventLoopHops);
+		mResult->mTags.insert(kSFTaskThreadSwitchesTag, mThreadSwitches);
+	}
+	if (mResult && mCurrentReply && !mCapturedResponseHeaders.isEmpty()) {
+		QVariantMap headers;
+		for (int i = 0; i < mCapturedResponseHeaders.size(); i++) {
+			QByteArray name = mCapturedResponseHeaders.at(i).toLatin1();
+			if (mCurrentReply->hasRawHeader(name)) {
+				headers.insert(mCapturedResponseHeaders.at(i), QString::fromLatin1(mCurrentReply->rawHeader(name)));
+			}
+		}
+		mResult->mTags.insert(kSFResponseHeadersTag, headers);
+	}
+	SFGenericTask::finish();
+}
+
 bool SFNetworkAccessTask::retry() {
 	//close current data buffer
 	if (this->mRequestData && !this->mRequestBytesArray.isNull()) {
@@ -149,86 +330,119 @@ bool SFNetworkAccessTask::retry() {
 		this->mRequestData->deleteLater();
 		this->mRequestData = NULL;
 	}
+	//the task is re-started from the thread that started it, so that the request is built there again
+	if (mOwnerThread && this->thread() != mOwnerThread && this->thread() == QThread::currentThread()) {
+		this->moveQObjectsToThread(mOwnerThread);
+	}
 	return SFGenericTask::retry();
 }
 
 /* to be run in any thread */
 void SFNetworkAccessTask::fsmDispatcher() {
-	if (this->isCancelled()) {
-		this->cleanup();
-		return;
-	}
-	NetworkTaskState oldState = this->mState;
-	switch(this->mState) {
-	//following state may happen only in creator's thread
-	case StateNotStarted:
-		//start the task
-		mStatus = TaskStatusRunning;
-		this->prepare();
-		mState = this->ensureRequest();
-		break;
-
-	case StateReadyToSend:
-		mState = this->initiateNetworkAccess();
-		break;
-
-	case StateHasResponse:
-		mState = this->preprocessReply(mCurrentReply);
-		break;
-
-	case StateNeedToRedirect:
-		if (mCurrentReply) {
-			mCurrentReply->deleteLater();
-			mCurrentReply = NULL;
+	//consecutive synchronous states run inline, the loop only exits when the task has to wait for something
+	forever {
+		if (this->isCancelled()) {
+			this->cleanup();
+			return;
+		}
+		NetworkTaskState oldState = this->mState;
+		switch(this->mState) {
+		//following state may happen only in network thread
+		case StateNotStarted:
+			//start the task
+			mStatus = TaskStatusRunning;
+			this->prepare();
+			mState = this->ensureRequest();
+			break;
+
+		case StateReadyToSend:
+			mState = this->initiateNetworkAccess();
+			break;
+
+		case StateHasResponse:
+			mState = this->preprocessReply(mCurrentReply);
+			break;
+
+		case StateNeedToRedirect:
+			if (mCurrentReply) {
+				mCurrentReply->deleteLater();
+				mCurrentReply = NULL;
+			}
+			if (mRequestData && !mRequestData->isSequential()) {
+				//the body was already sent once, send it again from the start
+				mRequestData->seek(0);
+			}
+			mState = this->initiateNetworkAccess();
+			break;
+
+		case StateReadyToProcess:
+			//hand the task over to the pool without waiting for anyone, run() picks the objects up
+			mState = StateProcessing;
+			this->moveQObjectsToThread(NULL);
+			//QThreadPool runs higher numbers first, SFRequestPriority runs lower numbers first
+			getSharedParsingThreadPool()->start(this, SFRequestPriority::BackgroundSync - mPriority);
+			return;
+
+		//following state may happen in any thread
+		case StateFinished:
+			mStatus = TaskStatusFinished;
+			this->cleanup();
+			return;
+		case StateError:
+			mStatus = TaskStatusError;
+			this->cleanup();
+			return;
+		case StateNeedToRetry:
+			//cleanup will finish up the task if no retry is permitted
+			mStatus = TaskStatusWillRetry;
+			this->cleanup();
+			return;
+		default:
+			return;
 		}
-		mState = this->initiateNetworkAccess();
-		break;
-
-	case StateReadyToProcess:
-		QThreadPool::globalInstance()->start(this);
-		break;
-
-	//following state may happen in any thread
-	case StateFinished:
-		mStatus = TaskStatusFinished;
-		this->cleanup();
-		break;
-	case StateError:
-		mStatus = TaskStatusError;
-		this->cleanup();
-		break;
-	case StateNeedToRetry:
-		//cleanup will finish up the task if no retry is permitted
-		mStatus = TaskStatusWillRetry;
-		this->cleanup();
-		break;
-	default:
-		return;
-	}
 
-	//if reach here, mState is changed and require immediate attention
-	if (oldState != this->mState) {
+		if (oldState == this->mState) {
+			return;
+		}
 		//for debug
 //		sfDebug() << "[DEBUG] NetworkAccessTask: " << this->stateDescription(oldState)
 //				<< " --> " << this->stateDescription(this->mState);
+	}
+}
 
-		//try to move to next state
-		this->metaObject()->invokeMethod(this, "fsmDispatcher"); //call the function in creator's thread
+void SFNetworkAccessTask::cancel() {
+	//the reply lives in the thread of the task
+	if (QThread::currentThread() != this->thread()) {
+		QMetaObject::invokeMethod(this, "cancel");
+		return;
+	}
+	SFGenericTask::cancel();
+	if (this->isCancelled() && mState == StateWaiting && mCurrentReply) {
+		//this will trigger onReplyFinished, which finds the task cancelled
+		mCurrentReply->abort();
 	}
 }
 
-/* to be run in creator's thread */
+/* to be run in the thread the task lives in, or in any thread when the task has no thread affinity */
 void SFNetworkAccessTask::moveQObjectsToThread(QThread *thread) {
-	if (thread == NULL) {
+	if (this->thread() == thread) {
 		return;
 	}
-	if (mCurrentReply != NULL) {
+	//a NULL thread leaves the objects without thread affinity, so that the thread that runs next can pull them in
+	if (mCurrentReply != NULL && mCurrentReply->parent() != this && mCurrentReply->parent() != mResult) {
 		mCurrentReply->setParent(0);
 		mCurrentReply->moveToThread(thread);
 	}
-	if (mResult != NULL) {
+	if (mResult != NULL && mResult->parent() != this) {
 		mResult->moveToThread(thread);
 	}
+	this->moveToThread(thread);
+	mThreadSwitches++;
+}
+
+void SFNetworkAccessTask::queueInvocation(const char * method) {
+	mEventLoopHops++;
+	QMetaObject::invokeMethod(this, method, Qt::QueuedConnection);
 }
 
 
@@ -262,6 +476,7 @@ SFNetworkAccessTask::NetworkTaskState SFNetworkAccessTask::ensureRequest() {
 
 SFNetworkAccessTask::NetworkTaskState SFNetworkAccessTask::initiateNetworkAccess() {
 	//ensure network
+	this->closeResponseStream();
 	mCurrentReply = this->createReplyAndExit();
 	if (!mCurrentReply) {
 		mResult ? mResult : SFResult::createErrorResult(SFResultCode::SFErrorNetwork, "Network resource is not available.");
@@ -269,6 +484,16 @@ SFNetworkAccessTask::NetworkTaskState SFNetworkAccessTask::initiateNetworkAccess
 	} else {
 		sfWarning() << "[SFNetworkAccessTask] Request Sent. ";
 		connect(mCurrentReply, SIGNAL(finished()), this, SLOT(onReplyFinished()));
+		if (mResponseConsumer) {
+			//keep only a bounded part of the body in the reply, the rest goes to the consumer as it arrives
+			mCurrentReply->setReadBufferSize(kSFStreamReadBufferSize);
+			connect(mCurrentReply, SIGNAL(readyRead()), this, SLOT(onReplyReadyRead()));
+		}
+		if (mResponseConsumer || (mRequestData && mRequestBytesArray.isNull())) {
+			//a streamed transfer may take longer than the timeout, it only times out when no data moves for that long
+			connect(mCurrentReply, SIGNAL(uploadProgress(qint64, qint64)), this, SLOT(onReplyProgress(qint64, qint64)));
+			connect(mCurrentReply, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(onReplyProgress(qint64, qint64)));
+		}
 		//restart timer
 		if (!mNetworkTimer) {
 			mNetworkTimer = new QTimer(this);
@@ -288,6 +513,12 @@ void SFNetworkAccessTask::onReplyFinished() {
 	this->fsmDispatcher();
 }
 
+void SFNetworkAccessTask::onReplyProgress(qint64, qint64) {
+	if (mNetworkTimer && mNetworkTimer->isActive()) {
+		mNetworkTimer->start(mNetworkTimeout);
+	}
+}
+
 void SFNetworkAccessTask::onNetworkTimeout() {
 	if (mCurrentReply) {
 		//this will trigger onReplyFinished
@@ -295,6 +526,79 @@ void SFNetworkAccessTask::onNetworkTimeout() {
 	}
 }
 
+/* to be run in network thread */
+void SFNetworkAccessTask::onReplyReadyRead() {
+	if (!mCurrentReply || sender() != mCurrentReply) {
+		return;
+	}
+	if (mResponseStream.isNull()) {
+		//first data of this reply, only the body of a successful response is streamed
+		bool hasStatusCode = false;
+		int statusCode = mCurrentReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(&hasStatusCode);
+		bool isRedirect = mCurrentReply->attribute(QNetworkRequest::RedirectionTargetAttribute).isValid();
+		if (!hasStatusCode || statusCode < 200 || statusCode >= 300 || isRedirect) {
+			mCurrentReply->setReadBufferSize(0);
+			disconnect(mCurrentReply, SIGNAL(readyRead()), this, SLOT(onReplyReadyRead()));
+			return;
+		}
+		mResponseStream = QSharedPointer<SFResponseStream>(new SFResponseStream(mResponseConsumer, this));
+		if (!mResponseConsumer->begin(statusCode, mCurrentReply->rawHeader("Content-Type"))) {
+			mResponseStream->fail();
+		}
+	}
+	this->readResponseStream();
+}
+
+/* to be run in network thread, queued by the drainer once the consumer has caught up */
+void SFNetworkAccessTask::resumeReading() {
+	if (mCurrentReply && !mResponseStream.isNull()) {
+		this->readResponseStream();
+	}
+}
+
+void SFNetworkAccessTask::readResponseStream() {
+	if (mResponseStream->isFailed()) {
+		//no point in downloading the rest, processReply() reports the consumer's error
+		disconnect(mCurrentReply, SIGNAL(readyRead()), this, SLOT(onReplyReadyRead()));
+		mCurrentReply->abort();
+		return;
+	}
+	if (mResponseStream->pauseIfFull()) {
+		//what is left stays in the reply, whose full read buffer holds back the sender until resumeReading()
+		return;
+	}
+	if (mResponseStream->push(mCurrentReply->readAll())) {
+		getSharedParsingThreadPool()->start(new SFResponseStreamDrain(mResponseStream), SFRequestPriority::BackgroundSync - mPriority);
+	}
+}
+
+SFNetworkAccessTask::NetworkTaskState SFNetworkAccessTask::finishResponseStream(QNetworkReply * reply) {
+	if (mResponseStream.isNull()) {
+		mResult = mResult ? mResult : SFResult::createErrorResult(SFResultCode::SFErrorGeneric, "Internal Error: the response was not streamed.");
+		return StateError;
+	}
+	QSharedPointer<SFResponseStream> stream = mResponseStream;
+	if (reply->error() != QNetworkReply::NoError && !stream->isFailed()) {
+		//the download broke off, the consumer only saw part of the body
+		stream->close();
+		mResult = mResult ? mResult : SFResult::createErrorResult(reply->error(), reply->errorString());
+		return StateError;
+	}
+	//a drain runnable that is still queued finds the stream closed and returns
+	if (!stream->finish(reply->readAll())) {
+		mResult = mResult ? mResult : SFResult::createErrorResult(SFResultCode::SFErrorGeneric, mResponseConsumer->errorString());
+		return StateError;
+	}
+	return StateFinished;
+}
+
+void SFNetworkAccessTask::closeResponseStream() {
+	if (!mResponseStream.isNull()) {
+		mResponseStream->close();
+		mResponseStream.clear();
+	}
+}
+
 QNetworkReply * SFNetworkAccessTask::createReplyAndExit() {
 	QNetworkReply *reply = NULL;
 
@@ -357,6 +661,17 @@ SFNetworkAccessTask::NetworkTaskState SFNetworkAccessTask::preprocessReply(QNetw
 }
 
 SFNetworkAccessTask::NetworkTaskState SFNetworkAccessTask::processReply(QNetworkReply * reply) {
+	if (this->isResponseStreamed()) {
+		NetworkTaskState state = this->finishResponseStream(reply);
+		if (state != StateFinished) {
+			return state;
+		}
+		mResult = SFResult::create();
+		mResult->mPayload = mResponseConsumer->result();
+		mResult->mStatus = SFResult::TaskResultSuccess;
+		return StateFinished;
+	}
+
 	if (reply->error() != QNetworkReply::NoError) {
 		//try to use status code
 		bool hasStatusCode = false;
@@ -0,0 +1,66 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFNetworkThread.cpp
+*/
+
+#include "SFNetworkThread.h"
+#include <QCoreApplication>
+#include <QtNetwork/QNetworkAccessManager>
+
+namespace sf {
+
+SFNetworkThread* SFNetworkThread::sharedInstance = NULL;
+
+SFNetworkThread* SFNetworkThread::instance() {
+	if (!sharedInstance) {
+		sharedInstance = new SFNetworkThread();
+		sharedInstance->setObjectName("SFNetworkThread");
+		if (QCoreApplication::instance()) {
+			connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), sharedInstance, SLOT(stop()));
+		}
+		sharedInstance->start();
+		//wait for the network access manager to be created in the new thread
+		sharedInstance->mReady.acquire();
+	}
+	return sharedInstance;
+}
+
+SFNetworkThread::SFNetworkThread() : QThread(0), mNetworkAccessManager(NULL) {
+}
+
+SFNetworkThread::~SFNetworkThread() {
+	this->stop();
+}
+
+void SFNetworkThread::stop() {
+	if (this->isRunning()) {
+		this->quit();
+		this->wait();
+	}
+}
+
+void SFNetworkThread::run() {
+	//created here so that the manager and everything it creates internally belong to this thread
+	QNetworkAccessManager manager;
+	mNetworkAccessManager = &manager;
+	mReady.release();
+
+	this->exec();
+
+	mNetworkAccessManager = NULL;
+}
+
+} /* namespace sf */
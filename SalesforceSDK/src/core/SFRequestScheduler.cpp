@@ -0,0 +1,161 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRequestScheduler.cpp
+*/
+
+#include "SFRequestScheduler.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include "SFNetworkAccessTask.h"
+
+namespace sf {
+
+static const int kSFDefaultMaxRequestsPerHost = 6;
+static const int kSFDefaultReservedInteractiveSlots = 2;
+//out of every kSFBulkRoundLength bulk slots, the last one goes to background sync, the others to prefetch
+static const int kSFBulkRoundLength = 3;
+
+QAtomicPointer<SFRequestScheduler> SFRequestScheduler::sharedInstance;
+static QMutex sInstanceLock;
+
+SFRequestScheduler* SFRequestScheduler::instance() {
+	SFRequestScheduler *instance = sharedInstance.fetchAndAddAcquire(0);
+	if (!instance) {
+		QMutexLocker locker(&sInstanceLock);
+		instance = sharedInstance.fetchAndAddAcquire(0);
+		if (!instance) {
+			instance = new SFRequestScheduler();
+			sharedInstance.fetchAndStoreRelease(instance);
+		}
+	}
+	return instance;
+}
+
+SFRequestScheduler::SFRequestScheduler() : QObject(0), mMaxRequestsPerHost(kSFDefaultMaxRequestsPerHost),
+		mReservedInteractiveSlots(kSFDefaultReservedInteractiveSlots), mBulkTurn(0) {
+}
+
+SFRequestScheduler::~SFRequestScheduler() {
+}
+
+/*
+ * Public
+ */
+void SFRequestScheduler::submit(SFNetworkAccessTask *task, const QString & host) {
+	if (!task || mRunning.contains(task)) {
+		return;
+	}
+	Entry entry;
+	entry.task = task;
+	entry.host = host.isEmpty() ? task->request().url().host() : host;
+	connect(task, SIGNAL(taskFinished(sf::SFGenericTask*)), this, SLOT(onTaskFinished(sf::SFGenericTask*)), Qt::UniqueConnection);
+	connect(task, SIGNAL(destroyed(QObject*)), this, SLOT(onTaskDestroyed(QObject*)), Qt::UniqueConnection);
+
+	SFRequestPriorityType priority = task->priority();
+	if (priority == SFRequestPriority::AuthCritical) {
+		//a token refresh unblocks everything else, it never waits
+		this->start(entry);
+		return;
+	}
+	mQueues[priority].append(entry);
+	this->schedule();
+}
+
+bool SFRequestScheduler::isRunning(SFNetworkAccessTask *task) const {
+	return mRunning.contains(task);
+}
+
+void SFRequestScheduler::setMaxRequestsPerHost(int count) {
+	mMaxRequestsPerHost = qMax(1, count);
+	this->schedule();
+}
+
+void SFRequestScheduler::setReservedInteractiveSlots(int count) {
+	mReservedInteractiveSlots = qMax(0, count);
+	this->schedule();
+}
+
+/*
+ * Private Slots
+ */
+void SFRequestScheduler::onTaskFinished(SFGenericTask *task) {
+	this->release(task);
+}
+
+void SFRequestScheduler::onTaskDestroyed(QObject *task) {
+	//the task is being destroyed, only compare the pointer
+	for (int priority = 0; priority <= SFRequestPriority::BackgroundSync; priority++) {
+		QList<Entry> & queue = mQueues[priority];
+		for (int i = queue.size() - 1; i >= 0; i--) {
+			if (queue.at(i).task == task) {
+				queue.removeAt(i);
+			}
+		}
+	}
+	this->release(task);
+}
+
+/*
+ * Private
+ */
+void SFRequestScheduler::schedule() {
+	//interactive tasks may use every slot of their host
+	while (this->startNext(SFRequestPriority::Interactive, mMaxRequestsPerHost));
+
+	//bulk tasks leave the reserved slots to interactive ones
+	int bulkLimit = qMax(1, mMaxRequestsPerHost - mReservedInteractiveSlots);
+	forever {
+		bool backgroundTurn = (mBulkTurn % kSFBulkRoundLength) == kSFBulkRoundLength - 1;
+		SFRequestPriorityType first = backgroundTurn ? SFRequestPriority::BackgroundSync : SFRequestPriority::Prefetch;
+		SFRequestPriorityType second = backgroundTurn ? SFRequestPriority::Prefetch : SFRequestPriority::BackgroundSync;
+		//if the class whose turn it is has nothing to start, the other one takes the slot
+		if (!this->startNext(first, bulkLimit) && !this->startNext(second, bulkLimit)) {
+			break;
+		}
+		mBulkTurn++;
+	}
+}
+
+bool SFRequestScheduler::startNext(SFRequestPriorityType priority, int limit) {
+	QList<Entry> & queue = mQueues[priority];
+	//skip tasks whose host is busy, so that they don't block tasks to other hosts
+	for (int i = 0; i < queue.size(); i++) {
+		if (mInFlight.value(queue.at(i).host) < limit) {
+			this->start(queue.takeAt(i));
+			return true;
+		}
+	}
+	return false;
+}
+
+void SFRequestScheduler::start(const Entry & entry) {
+	mRunning.insert(entry.task, entry.host);
+	mInFlight[entry.host]++;
+	entry.task->startTaskAsync();
+}
+
+void SFRequestScheduler::release(QObject *task) {
+	if (!mRunning.contains(task)) {
+		return;
+	}
+	QString host = mRunning.take(task);
+	if (--mInFlight[host] <= 0) {
+		mInFlight.remove(host);
+	}
+	this->schedule();
+}
+
+} /* namespace sf */
@@ -21,6 +21,9 @@
 
 #include "SFResult.h"
 #include <QtScript/QtScript>
+#include "SFJsonView.h"
+#include "SFRecordBatch.h"
+#include "SFRecordDecoder.h"
 
 namespace sf {
 
@@ -68,6 +71,19 @@ SFResult * SFResult::createCancelResult(const int & code, const QString & messag
 	return result;
 }
 
+QVariant SFResult::materialize(const QVariant & payload) {
+	if (payload.userType() == qMetaTypeId<SFJsonView>()) {
+		return payload.value<SFJsonView>().toVariant();
+	}
+	if (payload.userType() == qMetaTypeId<SFRecordBatch>()) {
+		return payload.value<SFRecordBatch>().toVariant();
+	}
+	if (payload.userType() == qMetaTypeId<SFDecodedRecords>()) {
+		return payload.value<SFDecodedRecords>().toVariant();
+	}
+	return payload;
+}
+
 /* Conversion function for QScriptEngine */
 QScriptValue SFResult::toScriptValue(QScriptEngine *engine, SFResult* const &inResult) {
   return engine->newQObject(inResult, QScriptEngine::QtOwnership);
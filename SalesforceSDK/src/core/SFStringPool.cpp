@@ -0,0 +1,49 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFStringPool.cpp
+*/
+
+
+#include "SFStringPool.h"
+
+namespace sf {
+
+static const int kSFMaxInternedLength = 64; //longer strings are rarely repeated, and would make the pool costly to hash
+
+SFStringPool::SFStringPool(int maxSize) : mMaxSize(maxSize) {
+}
+
+QString SFStringPool::intern(const char *utf8, int size) {
+	if (size > kSFMaxInternedLength) {
+		return QString::fromUtf8(utf8, size);
+	}
+	//look up without copying the bytes
+	QHash<QByteArray, QString>::const_iterator found = mStrings.constFind(QByteArray::fromRawData(utf8, size));
+	if (found != mStrings.constEnd()) {
+		return found.value();
+	}
+	QString string = QString::fromUtf8(utf8, size);
+	if (mStrings.size() < mMaxSize) {
+		mStrings.insert(QByteArray(utf8, size), string);
+	}
+	return string;
+}
+
+void SFStringPool::clear() {
+	mStrings.clear();
+}
+
+} /* namespace sf */
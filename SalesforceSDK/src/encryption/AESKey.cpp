@@ -14,6 +14,9 @@
 * limitations under the License.
 */
 
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+
 #include <sbreturn.h>
 
 #include "AESKey.hpp"
@@ -38,3 +41,4 @@ AESKey::~AESKey() {
 }
 
 }
+#endif /* SF_CRYPTO_HUSB */
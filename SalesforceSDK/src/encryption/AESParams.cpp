@@ -14,6 +14,9 @@
 * limitations under the License.
 */
 
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+
 #include "AESParams.hpp"
 
 namespace sf{
@@ -34,3 +37,4 @@ AESParams::~AESParams() {
 	}
 }
 }
+#endif /* SF_CRYPTO_HUSB */
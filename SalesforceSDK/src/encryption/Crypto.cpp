@@ -14,6 +14,9 @@
 * limitations under the License.
 */
 
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+
 #include "Crypto.hpp"
 #include <sbreturn.h>
 #include "SBError.hpp"
@@ -38,3 +41,4 @@ void Crypto::invalid() {
 }
 
 }
+#endif /* SF_CRYPTO_HUSB */
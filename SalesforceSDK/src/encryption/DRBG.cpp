@@ -14,6 +14,9 @@
 * limitations under the License.
 */
 
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+
 #include "DRBG.hpp"
 
 namespace sf{
@@ -44,3 +47,4 @@ int DRBG::getBytes(QByteArray & buffer) {
 }
 
 }
+#endif /* SF_CRYPTO_HUSB */
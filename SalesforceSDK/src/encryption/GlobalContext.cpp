@@ -14,6 +14,9 @@
 * limitations under the License.
 */
 
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+
 #include <sbreturn.h>
 #include <hugse56.h>
 #include <huseed.h>
@@ -43,3 +46,4 @@ GlobalContext::~GlobalContext() {
 }
 
 }
+#endif /* SF_CRYPTO_HUSB */
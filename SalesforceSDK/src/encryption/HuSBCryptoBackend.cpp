@@ -0,0 +1,128 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+
+#include <sbreturn.h>
+#include <QMutexLocker>
+
+#include "HuSBCryptoBackend.hpp"
+#include "CipherContext.hpp"
+#include "AESParams.hpp"
+#include "AESKey.hpp"
+#include "DRBG.hpp"
+#include "SHA.h"
+
+namespace sf{
+
+/*
+ * Owns its own global context, params and key schedule so that contexts can be used from different threads.
+ */
+class HuSBCipherContext : public CipherContext, public Crypto {
+public:
+	HuSBCipherContext(const QByteArray & key) :
+			Crypto("HuSBCipherContext"), _globalContext(), _params(_globalContext), _key(_params, key) {
+	}
+
+	virtual bool isValid() {
+		return _globalContext.isValid() && _params.isValid() && _key.isValid();
+	}
+
+	virtual bool crypt(bool isEncrypt, const QByteArray & iv, const QByteArray & in, QByteArray & out) {
+		if (!isValid()) {
+			invalid();
+			return false;
+		}
+		int rc;
+		if (isEncrypt) {
+			rc = hu_AESEncryptMsg(_params.aesParams(), _key.aesKey(), iv.length(),
+					(const unsigned char*) iv.constData(), in.length(),
+					(const unsigned char *) in.constData(),
+					(unsigned char *) out.data(), _globalContext.ctx());
+		} else {
+			rc = hu_AESDecryptMsg(_params.aesParams(), _key.aesKey(), iv.length(),
+					(const unsigned char*) iv.constData(), in.length(),
+					(const unsigned char *) in.constData(),
+					(unsigned char *) out.data(), _globalContext.ctx());
+		}
+		return maybeLog(isEncrypt ? "AESEncryptMsg" : "AESDecryptMsg", rc);
+	}
+
+private:
+	//declaration order matters, params and key keep references to the members above them
+	GlobalContext _globalContext;
+	AESParams _params;
+	AESKey _key;
+};
+
+QAtomicPointer<HuSBCryptoBackend> HuSBCryptoBackend::sharedInstance;
+static QMutex sInstanceLock;
+
+HuSBCryptoBackend* HuSBCryptoBackend::instance() {
+	//the first encryption can come from any thread, the lock is only taken until the instance exists
+	HuSBCryptoBackend *instance = sharedInstance.fetchAndAddAcquire(0);
+	if (!instance) {
+		QMutexLocker locker(&sInstanceLock);
+		instance = sharedInstance.fetchAndAddAcquire(0);
+		if (!instance) {
+			instance = new HuSBCryptoBackend();
+			sharedInstance.fetchAndStoreRelease(instance);
+		}
+	}
+	return instance;
+}
+
+HuSBCryptoBackend::HuSBCryptoBackend() : mDrbg(NULL) {
+}
+
+HuSBCryptoBackend::~HuSBCryptoBackend() {
+	delete mDrbg;
+}
+
+QString HuSBCryptoBackend::name() const {
+	return "huSB";
+}
+
+CipherContext* HuSBCryptoBackend::createCipherContext(const QByteArray & key) {
+	HuSBCipherContext *context = new HuSBCipherContext(key);
+	if (!context->isValid()) {
+		delete context;
+		return NULL;
+	}
+	return context;
+}
+
+bool HuSBCryptoBackend::randomBytes(QByteArray & buffer) {
+	QMutexLocker locker(&mLock);
+	if (!mDrbg) {
+		mDrbg = new DRBG(mGlobalContext);
+	}
+	return mDrbg->getBytes(buffer) == SB_SUCCESS;
+}
+
+QByteArray HuSBCryptoBackend::sha256(const QByteArray & data) {
+	QMutexLocker locker(&mLock);
+	unsigned char messageDigest[SB_SHA256_DIGEST_LEN];
+	SHA sha(mGlobalContext, messageDigest);
+	if (sha.updateDigest(data) != SB_SUCCESS || sha.completeDigest() != SB_SUCCESS) {
+		return QByteArray();
+	}
+	return QByteArray(reinterpret_cast<const char *>(messageDigest), SB_SHA256_DIGEST_LEN);
+}
+
+}
+#endif /* SF_CRYPTO_HUSB */
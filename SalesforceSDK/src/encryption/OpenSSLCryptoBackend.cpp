@@ -0,0 +1,136 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_OPENSSL
+
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "OpenSSLCryptoBackend.hpp"
+#include "CipherContext.hpp"
+#include "SFGlobal.h"
+
+namespace sf{
+
+/*
+ * The key schedules for encryption and decryption differ, so one EVP context is kept for each direction.
+ * Only the IV is reset per message.
+ */
+class OpenSSLCipherContext : public CipherContext {
+public:
+	OpenSSLCipherContext(const QByteArray & key) : _encryptCtx(EVP_CIPHER_CTX_new()), _decryptCtx(EVP_CIPHER_CTX_new()), _valid(false) {
+		_valid = key.length() == 16 && _encryptCtx && _decryptCtx
+				&& init(_encryptCtx, key, 1)
+				&& init(_decryptCtx, key, 0);
+		if (!_valid) {
+			sfWarning() << "[OpenSSLCipherContext] FAILED to set up the AES key";
+		}
+	}
+
+	virtual ~OpenSSLCipherContext() {
+		EVP_CIPHER_CTX_free(_encryptCtx);
+		EVP_CIPHER_CTX_free(_decryptCtx);
+	}
+
+	virtual bool isValid() {
+		return _valid;
+	}
+
+	virtual bool crypt(bool isEncrypt, const QByteArray & iv, const QByteArray & in, QByteArray & out) {
+		if (!_valid || iv.length() != 16 || out.length() < in.length()) {
+			return false;
+		}
+		EVP_CIPHER_CTX *ctx = isEncrypt ? _encryptCtx : _decryptCtx;
+		int written = 0;
+		int finalWritten = 0;
+		//-1 keeps the direction, the key schedule set up in the constructor is reused
+		bool success = EVP_CipherInit_ex(ctx, NULL, NULL, NULL, (const unsigned char *) iv.constData(), -1) == 1
+				&& EVP_CipherUpdate(ctx, (unsigned char *) out.data(), &written, (const unsigned char *) in.constData(), in.length()) == 1
+				&& EVP_CipherFinal_ex(ctx, (unsigned char *) out.data() + written, &finalWritten) == 1;
+		if (!success) {
+			sfWarning() << "[OpenSSLCipherContext] FAILED" << (isEncrypt ? "encrypt" : "decrypt");
+		}
+		return success && written + finalWritten == in.length();
+	}
+
+private:
+	EVP_CIPHER_CTX *_encryptCtx;
+	EVP_CIPHER_CTX *_decryptCtx;
+	bool _valid;
+
+	static bool init(EVP_CIPHER_CTX *ctx, const QByteArray & key, int isEncrypt) {
+		if (EVP_CipherInit_ex(ctx, EVP_aes_128_cbc(), NULL, (const unsigned char *) key.constData(), NULL, isEncrypt) != 1) {
+			return false;
+		}
+		//SFSecurityManager pads the data itself, same as the huSB backend
+		return EVP_CIPHER_CTX_set_padding(ctx, 0) == 1;
+	}
+};
+
+QAtomicPointer<OpenSSLCryptoBackend> OpenSSLCryptoBackend::sharedInstance;
+static QMutex sInstanceLock;
+
+OpenSSLCryptoBackend* OpenSSLCryptoBackend::instance() {
+	//the first encryption can come from any thread, the lock is only taken until the instance exists
+	OpenSSLCryptoBackend *instance = sharedInstance.fetchAndAddAcquire(0);
+	if (!instance) {
+		QMutexLocker locker(&sInstanceLock);
+		instance = sharedInstance.fetchAndAddAcquire(0);
+		if (!instance) {
+			instance = new OpenSSLCryptoBackend();
+			sharedInstance.fetchAndStoreRelease(instance);
+		}
+	}
+	return instance;
+}
+
+OpenSSLCryptoBackend::OpenSSLCryptoBackend() {
+}
+
+OpenSSLCryptoBackend::~OpenSSLCryptoBackend() {
+}
+
+QString OpenSSLCryptoBackend::name() const {
+	return "OpenSSL";
+}
+
+CipherContext* OpenSSLCryptoBackend::createCipherContext(const QByteArray & key) {
+	OpenSSLCipherContext *context = new OpenSSLCipherContext(key);
+	if (!context->isValid()) {
+		delete context;
+		return NULL;
+	}
+	return context;
+}
+
+bool OpenSSLCryptoBackend::randomBytes(QByteArray & buffer) {
+	return RAND_bytes((unsigned char *) buffer.data(), buffer.length()) == 1;
+}
+
+QByteArray OpenSSLCryptoBackend::sha256(const QByteArray & data) {
+	unsigned char messageDigest[EVP_MAX_MD_SIZE];
+	unsigned int length = 0;
+	if (EVP_Digest(data.constData(), data.length(), messageDigest, &length, EVP_sha256(), NULL) != 1) {
+		return QByteArray();
+	}
+	return QByteArray(reinterpret_cast<const char *>(messageDigest), length);
+}
+
+}
+#endif /* SF_CRYPTO_OPENSSL */
@@ -14,6 +14,9 @@
 * limitations under the License.
 */
 
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+
 #include "SBError.hpp"
 
 namespace sf{
@@ -319,3 +322,4 @@ void SBError::buildErrors() {
 	map[0x3D00] = "SB_ERR_ES_BASE";
 };
 }
+#endif /* SF_CRYPTO_HUSB */
@@ -0,0 +1,174 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SFCodec.h"
+#include <string.h>
+
+namespace sf {
+
+static const char kSFHexDigits[] = "0123456789abcdef";
+static const char kSFBase64Digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+//decode tables: value of the digit, kSFSkip for separators, kSFInvalid for anything else
+static const signed char kSFInvalid = -1;
+static const signed char kSFSkip = -2;
+
+struct SFCodecTables {
+	//two hex digits per byte value
+	char hexPairs[256][2];
+	signed char hexValues[256];
+	signed char base64Values[256];
+
+	SFCodecTables() {
+		memset(hexValues, kSFInvalid, sizeof(hexValues));
+		memset(base64Values, kSFInvalid, sizeof(base64Values));
+		for (int i = 0; i < 256; ++i) {
+			hexPairs[i][0] = kSFHexDigits[i >> 4];
+			hexPairs[i][1] = kSFHexDigits[i & 0xf];
+		}
+		for (int i = 0; i < 16; ++i) {
+			hexValues[(uchar) kSFHexDigits[i]] = i;
+		}
+		for (int i = 10; i < 16; ++i) {
+			hexValues['A' + i - 10] = i;
+		}
+		hexValues[' '] = hexValues[':'] = hexValues['.'] = kSFSkip;
+		for (int i = 0; i < 64; ++i) {
+			base64Values[(uchar) kSFBase64Digits[i]] = i;
+		}
+		base64Values[' '] = base64Values['\n'] = base64Values['\r'] = base64Values['\t'] = kSFSkip;
+	}
+};
+
+static const SFCodecTables & tables() {
+	static const SFCodecTables sTables;
+	return sTables;
+}
+
+QByteArray SFCodec::toHex(const QByteArray & in) {
+	const SFCodecTables & t = tables();
+	QByteArray out;
+	out.resize(in.length() * 2);
+	const uchar *src = reinterpret_cast<const uchar*>(in.constData());
+	char *dst = out.data();
+	for (int i = 0; i < in.length(); ++i, dst += 2) {
+		memcpy(dst, t.hexPairs[src[i]], 2);
+	}
+	return out;
+}
+
+bool SFCodec::fromHex(const QByteArray & in, QByteArray & out) {
+	const SFCodecTables & t = tables();
+	out.resize(in.length() / 2);
+	const uchar *src = reinterpret_cast<const uchar*>(in.constData());
+	char *dst = out.data();
+	int written = 0;
+	int i = 0;
+	while (i < in.length()) {
+		signed char high = t.hexValues[src[i]];
+		if (high == kSFSkip) {
+			i++;
+			continue;
+		}
+		if (high < 0 || i + 1 >= in.length()) {
+			out.clear();
+			return false;
+		}
+		signed char low = t.hexValues[src[i + 1]];
+		if (low < 0) {
+			out.clear();
+			return false;
+		}
+		dst[written++] = (char) ((high << 4) | low);
+		i += 2;
+	}
+	if (written == 0) {
+		out.clear();
+		return false;
+	}
+	out.resize(written);
+	return true;
+}
+
+QByteArray SFCodec::toBase64(const QByteArray & in) {
+	QByteArray out;
+	out.resize(((in.length() + 2) / 3) * 4);
+	const uchar *src = reinterpret_cast<const uchar*>(in.constData());
+	char *dst = out.data();
+	int i = 0;
+	for (; i + 3 <= in.length(); i += 3, dst += 4) {
+		quint32 triple = (src[i] << 16) | (src[i + 1] << 8) | src[i + 2];
+		dst[0] = kSFBase64Digits[(triple >> 18) & 0x3f];
+		dst[1] = kSFBase64Digits[(triple >> 12) & 0x3f];
+		dst[2] = kSFBase64Digits[(triple >> 6) & 0x3f];
+		dst[3] = kSFBase64Digits[triple & 0x3f];
+	}
+	int remaining = in.length() - i;
+	if (remaining > 0) {
+		quint32 triple = (src[i] << 16) | (remaining == 2 ? (src[i + 1] << 8) : 0);
+		dst[0] = kSFBase64Digits[(triple >> 18) & 0x3f];
+		dst[1] = kSFBase64Digits[(triple >> 12) & 0x3f];
+		dst[2] = remaining == 2 ? kSFBase64Digits[(triple >> 6) & 0x3f] : '=';
+		dst[3] = '=';
+	}
+	return out;
+}
+
+bool SFCodec::fromBase64(const QByteArray & in, QByteArray & out) {
+	const SFCodecTables & t = tables();
+	out.resize((in.length() / 4) * 3 + 3);
+	const uchar *src = reinterpret_cast<const uchar*>(in.constData());
+	char *dst = out.data();
+	int written = 0;
+	quint32 quad = 0;
+	int count = 0;
+	int length = in.length();
+	//padding may only appear at the end
+	while (length > 0 && (src[length - 1] == '=' || t.base64Values[src[length - 1]] == kSFSkip)) {
+		length--;
+	}
+	for (int i = 0; i < length; ++i) {
+		signed char value = t.base64Values[src[i]];
+		if (value == kSFSkip) {
+			continue;
+		}
+		if (value < 0) {
+			out.clear();
+			return false;
+		}
+		quad = (quad << 6) | value;
+		if (++count == 4) {
+			dst[written++] = (char) (quad >> 16);
+			dst[written++] = (char) (quad >> 8);
+			dst[written++] = (char) quad;
+			quad = 0;
+			count = 0;
+		}
+	}
+	if (count == 1) {
+		out.clear();
+		return false;
+	}
+	if (count == 2) {
+		dst[written++] = (char) (quad >> 4);
+	} else if (count == 3) {
+		dst[written++] = (char) (quad >> 10);
+		dst[written++] = (char) (quad >> 2);
+	}
+	out.resize(written);
+	return true;
+}
+
+} /* namespace sf */
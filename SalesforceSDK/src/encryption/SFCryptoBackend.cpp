@@ -0,0 +1,90 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+#include "HuSBCryptoBackend.hpp"
+#endif
+#ifdef SF_CRYPTO_OPENSSL
+#include "OpenSSLCryptoBackend.hpp"
+#endif
+
+namespace sf {
+
+static const int kSFHmacBlockSize = 64;
+
+SFCryptoBackend* SFCryptoBackend::instance() {
+#ifdef SF_CRYPTO_HUSB
+	return HuSBCryptoBackend::instance();
+#else
+	return OpenSSLCryptoBackend::instance();
+#endif
+}
+
+SFCryptoBackend* SFCryptoBackend::backend(const QString & name) {
+#ifdef SF_CRYPTO_HUSB
+	if (name == HuSBCryptoBackend::instance()->name()) {
+		return HuSBCryptoBackend::instance();
+	}
+#endif
+#ifdef SF_CRYPTO_OPENSSL
+	if (name == OpenSSLCryptoBackend::instance()->name()) {
+		return OpenSSLCryptoBackend::instance();
+	}
+#endif
+	return NULL;
+}
+
+QStringList SFCryptoBackend::availableBackends() {
+	QStringList names;
+#ifdef SF_CRYPTO_HUSB
+	names << HuSBCryptoBackend::instance()->name();
+#endif
+#ifdef SF_CRYPTO_OPENSSL
+	names << OpenSSLCryptoBackend::instance()->name();
+#endif
+	return names;
+}
+
+bool SFCryptoBackend::constantTimeEquals(const QByteArray & a, const QByteArray & b) {
+	if (a.length() != b.length() || a.isEmpty()) {
+		return false;
+	}
+	char diff = 0;
+	for (int i = 0; i < a.length(); ++i) {
+		diff |= a.at(i) ^ b.at(i);
+	}
+	return diff == 0;
+}
+
+QByteArray SFCryptoBackend::hmacSha256(const QByteArray & key, const QByteArray & data) {
+	QByteArray blockKey = key.length() > kSFHmacBlockSize ? sha256(key) : key;
+	blockKey = blockKey.leftJustified(kSFHmacBlockSize, 0, true);
+
+	QByteArray innerPad(kSFHmacBlockSize, 0x36);
+	QByteArray outerPad(kSFHmacBlockSize, 0x5c);
+	for (int i = 0; i < kSFHmacBlockSize; ++i) {
+		innerPad[i] = innerPad[i] ^ blockKey[i];
+		outerPad[i] = outerPad[i] ^ blockKey[i];
+	}
+	QByteArray inner = sha256(innerPad + data);
+	if (inner.isEmpty()) {
+		return QByteArray();
+	}
+	return sha256(outerPad + inner);
+}
+
+} /* namespace sf */
@@ -20,49 +20,74 @@
 */
 
 #include "SFSecurityManager.h"
-#include <sbreturn.h>
-#include "AESParams.hpp"
-#include "AESKey.hpp"
-#include "DRBG.hpp"
-#include "SBError.hpp"
+#include "SFCryptoBackend.h"
+#include "CipherContext.hpp"
+#include "SFCodec.h"
 #include <QSettings>
-#include "SHA.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrentMap>
 #include "SFGlobal.h"
-#include "GlobalContext.hpp"
 
 namespace sf {
 
 static const QString kAESKey = "aes_key";
 static const QString kAESIV = "aes_iv";
+//batches smaller than this are processed on the calling thread, the hand off to the thread pool would cost more than it saves
+static const int kSFParallelBatchThreshold = 32;
+static const int kSFRandomBufferSize = 512;
+//envelope layout: version | key id | iv | ciphertext | mac
+static const char kSFEnvelopeVersion = 1;
+static const int kSFEnvelopeKeyIdLength = 4;
+static const int kSFEnvelopeIVLength = 16;
+static const int kSFEnvelopeMacLength = 32;
+static const int kSFEnvelopeHeaderLength = 1 + kSFEnvelopeKeyIdLength + kSFEnvelopeIVLength;
+static const int kSFEnvelopeMinLength = kSFEnvelopeHeaderLength + 16 + kSFEnvelopeMacLength;
 
-SFSecurityManager* SFSecurityManager::sharedInstance = NULL;
+static QString encryptOne(const QString & clearText) {
+	return SFSecurityManager::instance()->encrypt(clearText);
+}
+
+static QString decryptOne(const QString & cipherTextHex) {
+	return SFSecurityManager::instance()->decrypt(cipherTextHex);
+}
+
+QAtomicPointer<SFSecurityManager> SFSecurityManager::sharedInstance;
+static QMutex sInstanceLock;
 
 SFSecurityManager* SFSecurityManager::instance(){
-	if (!sharedInstance){
-		sharedInstance = new SFSecurityManager();
+	//used from pool threads as well, the lock is only taken until the instance exists
+	SFSecurityManager *instance = sharedInstance.fetchAndAddAcquire(0);
+	if (!instance) {
+		QMutexLocker locker(&sInstanceLock);
+		instance = sharedInstance.fetchAndAddAcquire(0);
+		if (!instance) {
+			instance = new SFSecurityManager();
+			sharedInstance.fetchAndStoreRelease(instance);
+		}
 	}
-	return sharedInstance;
+	return instance;
 }
 
 QString SFSecurityManager::encrypt(QString clearText){
 	QByteArray in(clearText.toUtf8());
 	pad(in);
 	QByteArray out(in.length(), 0);
-	if (crypt(true, in, out)) {
-		return toHex(out);
+	if (crypt(true, mIvBytes, in, out)) {
+		return QString::fromLatin1(SFCodec::toHex(out));
 	}
 	//return null string
 	return QString();
 }
 QString SFSecurityManager::decrypt(QString cipherTextHex){
 	QByteArray in;
-	if (!fromHex(cipherTextHex, in)) {
+	if (!SFCodec::fromHex(cipherTextHex.toLatin1(), in)) {
 		//return null string
 		return QString();
 	}
 	QByteArray out(in.length(), 0);
 
-	if (crypt(false, in, out)) {
+	if (crypt(false, mIvBytes, in, out)) {
 		if (removePadding(out)) {
 			return QString (QString::fromUtf8(out.constData(), out.length()));
 		}
@@ -71,27 +96,128 @@ QString SFSecurityManager::decrypt(QString cipherTextHex){
 	return QString();
 }
 
-QString SFSecurityManager::hash(QString clearText){
-	unsigned char message_digest[SB_SHA256_DIGEST_LEN];
-	SHA sha = SHA(mGlobalContext, message_digest);
-	int rc = sha.updateDigest(clearText);
-	if (!rc==SB_SUCCESS){
-		return QString(); //returns null string
+QByteArray SFSecurityManager::encryptData(const QByteArray & clearData) {
+	QByteArray iv = randomBytes(kSFEnvelopeIVLength);
+	if (iv.isEmpty() || mKeyId.isEmpty()) {
+		return QByteArray();
+	}
+	QByteArray in(clearData);
+	pad(in);
+
+	QByteArray envelope;
+	envelope.reserve(kSFEnvelopeHeaderLength + in.length() + kSFEnvelopeMacLength);
+	envelope.append(kSFEnvelopeVersion);
+	envelope.append(mKeyId);
+	envelope.append(iv);
+	QByteArray out(in.length(), 0);
+	if (!crypt(true, iv, in, out)) {
+		return QByteArray();
+	}
+	envelope.append(out);
+	QByteArray mac = mBackend->hmacSha256(mEnvelopeMacKey, envelope);
+	if (mac.length() != kSFEnvelopeMacLength) {
+		return QByteArray();
 	}
-	rc = sha.completeDigest();
-	if (!rc==SB_SUCCESS){
+	envelope.append(mac);
+	return envelope;
+}
+
+QByteArray SFSecurityManager::decryptData(const QByteArray & envelope) {
+	if (!isEnvelope(envelope)) {
+		return QByteArray();
+	}
+	if (envelope.mid(1, kSFEnvelopeKeyIdLength) != mKeyId) {
+		sfWarning() << "[SFSecurityManager] envelope was sealed with another key";
+		return QByteArray();
+	}
+	int signedLength = envelope.length() - kSFEnvelopeMacLength;
+	QByteArray mac = mBackend->hmacSha256(mEnvelopeMacKey, QByteArray::fromRawData(envelope.constData(), signedLength));
+	if (!SFCryptoBackend::constantTimeEquals(mac, envelope.right(kSFEnvelopeMacLength))) {
+		sfWarning() << "[SFSecurityManager] envelope failed verification";
+		return QByteArray();
+	}
+	QByteArray iv = envelope.mid(1 + kSFEnvelopeKeyIdLength, kSFEnvelopeIVLength);
+	QByteArray in = QByteArray::fromRawData(envelope.constData() + kSFEnvelopeHeaderLength, signedLength - kSFEnvelopeHeaderLength);
+	QByteArray out(in.length(), 0);
+	if (crypt(false, iv, in, out) && removePadding(out)) {
+		return out;
+	}
+	return QByteArray();
+}
+
+bool SFSecurityManager::isEnvelope(const QByteArray & data) {
+	//legacy data is hex text, it never starts with the version byte
+	return data.length() >= kSFEnvelopeMinLength && data.at(0) == kSFEnvelopeVersion
+			&& (data.length() - kSFEnvelopeHeaderLength - kSFEnvelopeMacLength) % 16 == 0;
+}
+
+QStringList SFSecurityManager::encryptMany(const QStringList & clearTexts) {
+	if (clearTexts.size() < kSFParallelBatchThreshold) {
+		QStringList results;
+		results.reserve(clearTexts.size());
+		for (QStringList::const_iterator i = clearTexts.constBegin(); i != clearTexts.constEnd(); i++) {
+			results.append(encrypt(*i));
+		}
+		return results;
+	}
+	return QtConcurrent::blockingMapped<QStringList>(clearTexts, encryptOne);
+}
+
+QStringList SFSecurityManager::decryptMany(const QStringList & cipherTextsHex) {
+	if (cipherTextsHex.size() < kSFParallelBatchThreshold) {
+		QStringList results;
+		results.reserve(cipherTextsHex.size());
+		for (QStringList::const_iterator i = cipherTextsHex.constBegin(); i != cipherTextsHex.constEnd(); i++) {
+			results.append(decrypt(*i));
+		}
+		return results;
+	}
+	return QtConcurrent::blockingMapped<QStringList>(cipherTextsHex, decryptOne);
+}
+
+QByteArray SFSecurityManager::randomBytes(int length) {
+	QMutexLocker locker(&mRandomLock);
+	QByteArray bytes;
+	bytes.reserve(length);
+	while (bytes.length() < length) {
+		if (mRandomOffset >= mRandomBuffer.length()) {
+			mRandomBuffer.fill(0, kSFRandomBufferSize);
+			if (!mBackend->randomBytes(mRandomBuffer)) {
+				mRandomBuffer.clear();
+				mRandomOffset = 0;
+				return QByteArray();
+			}
+			mRandomOffset = 0;
+		}
+		int count = qMin(length - bytes.length(), mRandomBuffer.length() - mRandomOffset);
+		bytes.append(mRandomBuffer.constData() + mRandomOffset, count);
+		//never hand out the same bytes twice
+		memset(mRandomBuffer.data() + mRandomOffset, 0, count);
+		mRandomOffset += count;
+	}
+	return bytes;
+}
+
+QByteArray SFSecurityManager::deriveKey(const QByteArray & label) {
+	if (mKeyBytes.isEmpty()) {
+		return QByteArray();
+	}
+	return mBackend->hmacSha256(mKeyBytes, label);
+}
+
+QString SFSecurityManager::hash(QString clearText){
+	QByteArray digest = mBackend->sha256(clearText.toUtf8());
+	if (digest.isEmpty()){
 		return QString(); //returns null string
 	}
-	QByteArray hash_data = QByteArray::fromRawData(reinterpret_cast<const char *>(message_digest), SB_SHA256_DIGEST_LEN);
-	QString hash_as_hex = QString::fromAscii(hash_data.toHex());
-	return hash_as_hex;
+	return QString::fromLatin1(SFCodec::toHex(digest));
 }
 
 
 /*
  * private
  */
-SFSecurityManager::SFSecurityManager() {
+SFSecurityManager::SFSecurityManager() : mBackend(SFCryptoBackend::instance()), mMaxIdleContexts(qMax(2, QThread::idealThreadCount())), mRandomOffset(0) {
 	QSettings setting;
 	mKey = setting.value(kAESKey).toString();
 	mIv = setting.value(kAESIV).toString();
@@ -102,71 +228,28 @@ SFSecurityManager::SFSecurityManager() {
 		setting.setValue(kAESKey, mKey);
 		setting.setValue(kAESIV, mIv);
 	}
+	//parse the key and iv once, every crypt() call reuses them
+	if (!SFCodec::fromHex(mKey.toLatin1(), mKeyBytes)) {
+		sfWarning() << "[SFSecurityManager] Key is not valid hex.";
+	}
+	if (!SFCodec::fromHex(mIv.toLatin1(), mIvBytes)) {
+		sfWarning() << "[SFSecurityManager] IV is not valid hex.";
+	}
+	//identifies the key in envelopes without revealing anything about it
+	mKeyId = deriveKey("sf-envelope-key-id").left(kSFEnvelopeKeyIdLength);
+	mEnvelopeMacKey = deriveKey("sf-envelope-mac");
 }
 
 SFSecurityManager::~SFSecurityManager() {
-	//when this instance is destroyed, the global context will be destroyed and will clean up everything in the destructor
+	qDeleteAll(mIdleContexts);
 }
 
 QString SFSecurityManager::generateRandomString(){
-	DRBG drbg(mGlobalContext);
-	QByteArray buffer(16, 0);
-	int rc = drbg.getBytes(buffer);
-	if (rc != SB_SUCCESS) {
+	QByteArray buffer = randomBytes(16);
+	if (buffer.isEmpty()) {
 		return "";
 	}
-	return toHex(buffer);
-}
-
-bool SFSecurityManager::fromHex(const QString in, QByteArray & toReturn) {
-	QString temp(in);
-	temp.replace(" ","");
-	temp.replace(":","");
-	temp.replace(".","");
-	QByteArray content(temp.toLocal8Bit());
-
-	const char * c(content.constData());
-
-	if (content.length() == 0 || ((content.length() % 2) != 0)) {
-		return false;
-	}
-
-	for (int i = 0; i < content.length(); i += 2) {
-		char a = c[i];
-		char b = c[i + 1];
-		a = nibble(a);
-		b = nibble(b);
-		if (a < 0 || b < 0) {
-			toReturn.clear();
-			return false;
-		}
-		toReturn.append((a << 4) | b);
-	}
-	return true;
-}
-
-QString SFSecurityManager::toHex(const QByteArray & in){
-	static char hexChars[] = "0123456789abcdef";
-
-	const char * c = in.constData();
-	QString toReturn;
-	for (int i = 0; i < in.length(); ++i) {
-		toReturn += hexChars[(c[i] >> 4) & 0xf];
-		toReturn += hexChars[(c[i]) & 0xf];
-	}
-
-	return toReturn;
-}
-
-char SFSecurityManager::nibble(char c) {
-	if (c >= '0' && c <= '9') {
-		return c - '0';
-	} else if (c >= 'a' && c <= 'f') {
-		return c - 'a' + 10;
-	} else if (c >= 'A' && c <= 'F') {
-		return c - 'A' + 10;
-	}
-	return -1;
+	return QString::fromLatin1(SFCodec::toHex(buffer));
 }
 
 void SFSecurityManager::pad(QByteArray & in){
@@ -197,46 +280,38 @@ bool SFSecurityManager::removePadding(QByteArray & out) {
 	return true;
 }
 
-bool SFSecurityManager::crypt(bool isEncrypt, const QByteArray & in, QByteArray & out){
-	QByteArray key, iv;
-	QString fail;
-
-	if (!fromHex(mKey, key)) {
-		fail += "Key is not valid hex. ";
-	}
-	if (!fromHex(mIv, iv)) {
-		fail += "IV is not valid hex. ";
-	}
-
-	if (!fail.isEmpty()) {
+bool SFSecurityManager::crypt(bool isEncrypt, const QByteArray & iv, const QByteArray & in, QByteArray & out){
+	if (mKeyBytes.isEmpty() || mIvBytes.isEmpty()) {
 		return false;
 	}
 
-	AESParams params(mGlobalContext);
-	if (!params.isValid()) {
+	CipherContext *context = acquireContext();
+	if (!context) {
 		return false;
 	}
+	bool success = context->crypt(isEncrypt, iv, in, out);
+	releaseContext(context);
+	return success;
+}
 
-	AESKey aesKey(params, key);
-	if (!aesKey.isValid()) {
-		return false;
+CipherContext* SFSecurityManager::acquireContext() {
+	{
+		QMutexLocker locker(&mContextLock);
+		if (!mIdleContexts.isEmpty()) {
+			return mIdleContexts.takeLast();
+		}
 	}
+	//setting up a context is the expensive part, do it outside of the lock
+	return mBackend->createCipherContext(mKeyBytes);
+}
 
-	int rc;
-	if (isEncrypt) {
-		rc = hu_AESEncryptMsg(params.aesParams(), aesKey.aesKey(), iv.length(),
-				(const unsigned char*) iv.constData(), in.length(),
-				(const unsigned char *) in.constData(),
-				(unsigned char *) out.data(), mGlobalContext.ctx());
-	} else {
-		rc = hu_AESDecryptMsg(params.aesParams(), aesKey.aesKey(), iv.length(),
-				(const unsigned char*) iv.constData(), in.length(),
-				(const unsigned char *) in.constData(),
-				(unsigned char *) out.data(), mGlobalContext.ctx());
-	}
-	if (rc == SB_SUCCESS) {
-		return true;
+void SFSecurityManager::releaseContext(CipherContext* context) {
+	QMutexLocker locker(&mContextLock);
+	if (mIdleContexts.size() < mMaxIdleContexts) {
+		mIdleContexts.append(context);
+		return;
 	}
-	return false;
+	locker.unlock();
+	delete context;
 }
 } /* namespace sf */
@@ -0,0 +1,324 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "SFStreamCipher.h"
+#include <QIODevice>
+#include <QtEndian>
+#include "SFSecurityManager.h"
+#include "SFCryptoBackend.h"
+#include "CipherContext.hpp"
+
+namespace sf {
+
+static const char kSFStreamMagic[] = "SFSC";
+static const char kSFStreamVersion = 1;
+static const int kSFStreamHeaderLength = 28;
+static const int kSFStreamNonceLength = 16;
+static const int kSFStreamBlockLength = 16;
+static const int kSFStreamMacLength = 32;
+static const int kSFStreamMaxChunkSize = 16 * 1024 * 1024;
+static const char kSFStreamEncryptionLabel[] = "sf-stream-enc";
+static const char kSFStreamMacLabel[] = "sf-stream-mac";
+
+static void deriveStreamKeys(const QByteArray & nonce, QByteArray & encryptionKey, QByteArray & macKey) {
+	encryptionKey = SFSecurityManager::instance()->deriveKey(QByteArray(kSFStreamEncryptionLabel) + nonce).left(16);
+	macKey = SFSecurityManager::instance()->deriveKey(QByteArray(kSFStreamMacLabel) + nonce);
+}
+
+static QByteArray chunkMac(SFCryptoBackend* backend, const QByteArray & macKey, const QByteArray & header,
+		qint64 index, bool final, const QByteArray & iv, const QByteArray & cipherText) {
+	uchar indexBytes[8];
+	qToBigEndian<quint64>(index, indexBytes);
+	QByteArray message;
+	message.reserve(header.length() + 9 + iv.length() + cipherText.length());
+	message.append(header);
+	message.append(reinterpret_cast<const char*>(indexBytes), 8);
+	message.append(final ? (char) 1 : (char) 0);
+	message.append(iv);
+	message.append(cipherText);
+	return backend->hmacSha256(macKey, message);
+}
+
+/*
+ * SFStreamEncryptor
+ */
+SFStreamEncryptor::SFStreamEncryptor() : mDevice(NULL), mBackend(SFCryptoBackend::instance()), mCipher(NULL), mChunkSize(0), mChunkIndex(0) {
+}
+
+SFStreamEncryptor::~SFStreamEncryptor() {
+	delete mCipher;
+}
+
+bool SFStreamEncryptor::begin(QIODevice* device, int chunkSize) {
+	if (!device || !device->isWritable()) {
+		return fail("device is not writable");
+	}
+	if (chunkSize <= 0 || chunkSize > kSFStreamMaxChunkSize) {
+		return fail("invalid chunk size");
+	}
+	QByteArray nonce = SFSecurityManager::instance()->randomBytes(kSFStreamNonceLength);
+	if (nonce.isEmpty()) {
+		return fail("unable to generate nonce");
+	}
+	mChunkSize = (chunkSize + kSFStreamBlockLength - 1) / kSFStreamBlockLength * kSFStreamBlockLength;
+	mChunkIndex = 0;
+	mBuffer.clear();
+
+	uchar chunkSizeBytes[4];
+	qToBigEndian<quint32>(mChunkSize, chunkSizeBytes);
+	mHeader.clear();
+	mHeader.append(kSFStreamMagic, 4);
+	mHeader.append(kSFStreamVersion);
+	mHeader.append(QByteArray(3, 0));
+	mHeader.append(reinterpret_cast<const char*>(chunkSizeBytes), 4);
+	mHeader.append(nonce);
+
+	QByteArray encryptionKey;
+	deriveStreamKeys(nonce, encryptionKey, mMacKey);
+	delete mCipher;
+	mCipher = encryptionKey.isEmpty() ? NULL : mBackend->createCipherContext(encryptionKey);
+	if (!mCipher || mMacKey.isEmpty()) {
+		return fail("unable to set up the keys");
+	}
+	if (device->write(mHeader) != mHeader.length()) {
+		return fail(device->errorString());
+	}
+	mDevice = device;
+	mErrorString.clear();
+	return true;
+}
+
+bool SFStreamEncryptor::write(const QByteArray & data) {
+	if (!mDevice) {
+		return fail("stream is not started");
+	}
+	int offset = 0;
+	//top up a partial chunk left by the previous call first
+	if (!mBuffer.isEmpty()) {
+		offset = qMin(mChunkSize - mBuffer.length(), data.length());
+		mBuffer.append(data.constData(), offset);
+		if (mBuffer.length() < mChunkSize) {
+			return true;
+		}
+		if (!writeChunk(mBuffer, false)) {
+			return false;
+		}
+		mBuffer.clear();
+	}
+	//full chunks are encrypted straight from the caller's data, without copying
+	while (data.length() - offset >= mChunkSize) {
+		if (!writeChunk(QByteArray::fromRawData(data.constData() + offset, mChunkSize), false)) {
+			return false;
+		}
+		offset += mChunkSize;
+	}
+	mBuffer.append(data.constData() + offset, data.length() - offset);
+	return true;
+}
+
+bool SFStreamEncryptor::finish() {
+	if (!mDevice) {
+		return fail("stream is not started");
+	}
+	//the final chunk is always shorter than a full one, possibly empty
+	bool success = writeChunk(mBuffer, true);
+	mBuffer.clear();
+	mDevice = NULL;
+	return success;
+}
+
+bool SFStreamEncryptor::encrypt(QIODevice* source, QIODevice* destination, int chunkSize) {
+	SFStreamEncryptor encryptor;
+	if (!source || !encryptor.begin(destination, chunkSize)) {
+		return false;
+	}
+	while (!source->atEnd()) {
+		QByteArray data = source->read(encryptor.mChunkSize);
+		if (data.isEmpty()) {
+			break;
+		}
+		if (!encryptor.write(data)) {
+			return false;
+		}
+	}
+	return encryptor.finish();
+}
+
+bool SFStreamEncryptor::writeChunk(const QByteArray & clearText, bool final) {
+	QByteArray in(clearText);
+	if (final) {
+		int padLength = kSFStreamBlockLength - (in.length() % kSFStreamBlockLength);
+		in.append(QByteArray(padLength, (char) padLength));
+	}
+	QByteArray iv = SFSecurityManager::instance()->randomBytes(kSFStreamBlockLength);
+	QByteArray out(in.length(), 0);
+	if (iv.isEmpty() || !mCipher->crypt(true, iv, in, out)) {
+		return fail("encryption failed");
+	}
+	QByteArray mac = chunkMac(mBackend, mMacKey, mHeader, mChunkIndex, final, iv, out);
+	if (mac.length() != kSFStreamMacLength) {
+		return fail("MAC failed");
+	}
+	if (mDevice->write(iv) != iv.length() || mDevice->write(out) != out.length() || mDevice->write(mac) != mac.length()) {
+		return fail(mDevice->errorString());
+	}
+	mChunkIndex++;
+	return true;
+}
+
+bool SFStreamEncryptor::fail(const QString & error) {
+	mErrorString = error;
+	return false;
+}
+
+/*
+ * SFStreamDecryptor
+ */
+SFStreamDecryptor::SFStreamDecryptor() : mDevice(NULL), mBackend(SFCryptoBackend::instance()), mCipher(NULL), mChunkSize(0), mNextIndex(0) {
+}
+
+SFStreamDecryptor::~SFStreamDecryptor() {
+	delete mCipher;
+}
+
+bool SFStreamDecryptor::open(QIODevice* device) {
+	mDevice = NULL;
+	if (!device || !device->isReadable()) {
+		return fail("device is not readable");
+	}
+	if (!device->isSequential() && !device->seek(0)) {
+		return fail(device->errorString());
+	}
+	QByteArray header = device->read(kSFStreamHeaderLength);
+	if (header.length() != kSFStreamHeaderLength || !header.startsWith(kSFStreamMagic)) {
+		return fail("not an encrypted stream");
+	}
+	if (header.at(4) != kSFStreamVersion) {
+		return fail("unsupported stream version");
+	}
+	quint32 chunkSize = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(header.constData() + 8));
+	if (chunkSize == 0 || chunkSize > (quint32) kSFStreamMaxChunkSize || chunkSize % kSFStreamBlockLength != 0) {
+		return fail("invalid chunk size");
+	}
+	QByteArray encryptionKey;
+	deriveStreamKeys(header.right(kSFStreamNonceLength), encryptionKey, mMacKey);
+	delete mCipher;
+	mCipher = encryptionKey.isEmpty() ? NULL : mBackend->createCipherContext(encryptionKey);
+	if (!mCipher || mMacKey.isEmpty()) {
+		return fail("unable to set up the keys");
+	}
+	mHeader = header;
+	mChunkSize = chunkSize;
+	mNextIndex = 0;
+	mDevice = device;
+	mErrorString.clear();
+	return true;
+}
+
+qint64 SFStreamDecryptor::chunkCount() const {
+	if (!mDevice || mDevice->isSequential()) {
+		return -1;
+	}
+	qint64 length = mDevice->size() - kSFStreamHeaderLength;
+	return length <= 0 ? 0 : (length + recordSize() - 1) / recordSize();
+}
+
+bool SFStreamDecryptor::readChunk(qint64 index, QByteArray & clearText) {
+	qint64 count = chunkCount();
+	if (count < 0) {
+		return fail("random access needs an open, seekable device");
+	}
+	if (index < 0 || index >= count) {
+		return fail("chunk index out of range");
+	}
+	if (!mDevice->seek(kSFStreamHeaderLength + index * recordSize())) {
+		return fail(mDevice->errorString());
+	}
+	return decryptRecord(index, index == count - 1, mDevice->read(recordSize()), clearText);
+}
+
+bool SFStreamDecryptor::readNext(QByteArray & clearText, bool & final) {
+	if (!mDevice) {
+		return fail("stream is not open");
+	}
+	QByteArray record = mDevice->read(recordSize());
+	if (record.isEmpty()) {
+		return fail("stream is truncated");
+	}
+	//only the final record can be shorter than a full one
+	final = record.length() < recordSize() || mDevice->atEnd();
+	if (!decryptRecord(mNextIndex, final, record, clearText)) {
+		return false;
+	}
+	mNextIndex++;
+	return true;
+}
+
+bool SFStreamDecryptor::decrypt(QIODevice* source, QIODevice* destination) {
+	SFStreamDecryptor decryptor;
+	if (!destination || !decryptor.open(source)) {
+		return false;
+	}
+	bool final = false;
+	while (!final) {
+		QByteArray clearText;
+		if (!decryptor.readNext(clearText, final)) {
+			return false;
+		}
+		if (destination->write(clearText) != clearText.length()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int SFStreamDecryptor::recordSize() const {
+	return kSFStreamBlockLength + mChunkSize + kSFStreamMacLength;
+}
+
+bool SFStreamDecryptor::decryptRecord(qint64 index, bool final, const QByteArray & record, QByteArray & clearText) {
+	int cipherLength = record.length() - kSFStreamBlockLength - kSFStreamMacLength;
+	if (cipherLength <= 0 || cipherLength % kSFStreamBlockLength != 0 || (!final && record.length() != recordSize())) {
+		return fail("chunk is truncated");
+	}
+	QByteArray iv = record.left(kSFStreamBlockLength);
+	QByteArray cipherText = record.mid(kSFStreamBlockLength, cipherLength);
+	//verify before decrypting anything
+	if (!SFCryptoBackend::constantTimeEquals(record.right(kSFStreamMacLength), chunkMac(mBackend, mMacKey, mHeader, index, final, iv, cipherText))) {
+		return fail("chunk failed verification");
+	}
+	clearText.fill(0, cipherLength);
+	if (!mCipher->crypt(false, iv, cipherText, clearText)) {
+		clearText.clear();
+		return fail("decryption failed");
+	}
+	if (final) {
+		int padLength = (uchar) clearText.at(clearText.length() - 1);
+		if (padLength < 1 || padLength > kSFStreamBlockLength) {
+			clearText.clear();
+			return fail("invalid padding");
+		}
+		clearText.chop(padLength);
+	}
+	return true;
+}
+
+bool SFStreamDecryptor::fail(const QString & error) {
+	mErrorString = error;
+	return false;
+}
+
+} /* namespace sf */
@@ -19,6 +19,9 @@
 *      Author: timshi
 */
 
+#include "SFCryptoBackend.h"
+#ifdef SF_CRYPTO_HUSB
+
 #include "SHA.h"
 #include "husha2.h"
 #include "sbreturn.h"
@@ -33,8 +36,11 @@ SHA::SHA(GlobalContext & gc, unsigned char* messageDigest):
 }
 
 int SHA::updateDigest(const QString input_data){
-	QByteArray input_bytes = input_data.toUtf8();
-	unsigned char* hash_input = reinterpret_cast<unsigned char*>(input_bytes.data());
+	return updateDigest(input_data.toUtf8());
+}
+
+int SHA::updateDigest(const QByteArray & input_bytes){
+	const unsigned char* hash_input = reinterpret_cast<const unsigned char*>(input_bytes.constData());
 
 	int rc = hu_SHA256Hash(sha256Context, (size_t) input_bytes.length(), hash_input, context.ctx());
 	maybeLog("SHA creating hash", rc);
@@ -61,3 +67,4 @@ SHA::~SHA() {
 	}
 }
 } /* namespace sf */
+#endif /* SF_CRYPTO_HUSB */
@@ -33,6 +33,7 @@
 #include "SFResult.h"
 #include "SFGlobal.h"
 #include "SFNetworkAccessTask.h"
+#include "SFRequestScheduler.h"
 
 namespace sf {
 
@@ -218,7 +219,10 @@ void SFOAuthCoordinator::beginTokenRefreshFlow(){
 	task->setRequestBytesArray(params.toUtf8());
 	task->setCancellable(true);
 	connect(this, SIGNAL(cancelRefreshTask()), task, SLOT(cancel()));
-	task->startTaskAsync(this, SLOT(onRefreshReplyReady(sf::SFResult*)));
+	//every pending REST request waits for the new token, the refresh jumps the queue
+	task->setPriority(SFRequestPriority::AuthCritical);
+	connect(task, SIGNAL(taskResultReady(sf::SFResult*)), this, SLOT(onRefreshReplyReady(sf::SFResult*)));
+	SFRequestScheduler::instance()->submit(task);
 }
 
 void SFOAuthCoordinator::handleRefreshResponse(QByteArray responseData){
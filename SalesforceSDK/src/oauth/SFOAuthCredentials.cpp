@@ -20,10 +20,9 @@
 */
 
 #include "SFOAuthCredentials.h"
-#include <QDir>
-#include <QFile>
-#include <QTextIStream>
-#include "SFSecurityManager.h"
+#include <QStringList>
+#include "SFTokenVault.h"
+#include "SFGlobal.h"
 
 namespace sf {
 
@@ -31,7 +30,6 @@ static QString const kSFOAuthProtocolHttps = "https";
 static QString const kSFOAuthDefaultDomain = "login.salesforce.com";
 static QString const kSFOAuthServiceAccess = "com.salesforce.oauth.access";
 static QString const kSFOAuthServiceRefresh = "com.salesforce.oauth.refresh";
-static QString const kSFTokenFileDir = "sf_token_store";
 static QString const kSFCredentialFileDir = "sf_credential_store";
 
 SFOAuthCredentials::SFOAuthCredentials(){
@@ -131,8 +129,15 @@ void SFOAuthCredentials::setIdentifier(const QString& identifier) {
 }
 
 void SFOAuthCredentials::revoke(){
-	revokeAccessToken();
-	revokeRefreshToken();
+	//remove both tokens with a single write to the vault
+	QStringList keys;
+	keys << keyForToken(kSFOAuthServiceAccess) << keyForToken(kSFOAuthServiceRefresh);
+	if (!SFTokenVault::instance()->removeTokens(keys)) {
+		sfWarning() << "[SFOAuthCredentials] unable to remove tokens";
+	}
+	mInstanceUrl.clear();
+	mIdentityUrl.clear();
+	mIssuedAt=QString();
 }
 void SFOAuthCredentials::revokeAccessToken(){
 	setAccessToken(NULL);
@@ -144,58 +149,17 @@ void SFOAuthCredentials::revokeRefreshToken(){
 	mIssuedAt=QString();
 }
 
-void SFOAuthCredentials::saveToken(QString token, QString key) const{
-	//qDebug()<<"setting token to "<< token;
-	QString encryptedToken = SFSecurityManager::instance()->encrypt(token);
-	//qDebug()<<"token encrypted to "<< encryptedToken;
-
-	QDir home = QDir::home();
-	QString absoluteDirPath = home.absoluteFilePath(kSFTokenFileDir);
-	QDir dir = QDir(absoluteDirPath);
-	if (!dir.exists()){
-		home.mkdir(kSFTokenFileDir);
+bool SFOAuthCredentials::saveToken(QString token, QString key) const{
+	//the vault writes the token through to the encrypted vault file and keeps it in memory
+	if (!SFTokenVault::instance()->setToken(key, token)) {
+		sfWarning() << "[SFOAuthCredentials] unable to save token" << key;
+		return false;
 	}
-
-	QString path = QString("%1/%2").arg(kSFTokenFileDir, key);
-	QString absolutePath = home.absoluteFilePath(path);
-
-	//qDebug()<<"token file path is "<<absolutePath;
-
-	QFile tokenFile(absolutePath);
-	tokenFile.open(QIODevice::WriteOnly | QIODevice::Text);
-	QTextStream out(&tokenFile);
-	out<<encryptedToken;
-	tokenFile.close();
+	return true;
 }
 
 QString SFOAuthCredentials::retreiveToken(QString key) const {
-	QDir home = QDir::home();
-
-	QString absoluteDirPath = home.absoluteFilePath(kSFTokenFileDir);
-	QDir dir = QDir(absoluteDirPath);
-	if (!dir.exists()){
-		//return null
-		return QString();
-	}
-
-	QString path = QString("%1/%2").arg(kSFTokenFileDir, key);
-	QString absolutePath = home.absoluteFilePath(path);
-
-	//qDebug()<<"token file path is "<<absolutePath;
-
-	QFile tokenFile(absolutePath);
-	tokenFile.open(QIODevice::ReadOnly | QIODevice::Text);
-	QTextStream out(&tokenFile);
-	QString encryptedToken = out.readAll();
-	tokenFile.close();
-
-	//qDebug()<<"encrypted token string is "<<encryptedToken;
-
-	QString tokenString = SFSecurityManager::instance()->decrypt(encryptedToken);
-
-	//qDebug()<<"token string is "<<tokenString;
-
-	return tokenString;
+	return SFTokenVault::instance()->token(key);
 }
 
 
@@ -0,0 +1,281 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFTokenVault.cpp
+*/
+
+#include "SFTokenVault.h"
+#include <bb/data/JsonDataAccess>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QVariant>
+#include "SFSecurityManager.h"
+#include "SFGlobal.h"
+
+namespace sf {
+
+static QString const kSFTokenFileDir = "sf_token_store";
+static QString const kSFTokenVaultFile = "sf_token_vault";
+static QString const kSFTempSuffix = ".tmp";
+static QString const kSFBackupSuffix = ".bak";
+
+QAtomicPointer<SFTokenVault> SFTokenVault::sharedInstance;
+static QMutex sInstanceLock;
+
+SFTokenVault* SFTokenVault::instance() {
+	//REST requests read tokens from any thread, the lock is only taken until the instance exists
+	SFTokenVault *instance = sharedInstance.fetchAndAddAcquire(0);
+	if (!instance) {
+		QMutexLocker locker(&sInstanceLock);
+		instance = sharedInstance.fetchAndAddAcquire(0);
+		if (!instance) {
+			instance = new SFTokenVault();
+			sharedInstance.fetchAndStoreRelease(instance);
+		}
+	}
+	return instance;
+}
+
+SFTokenVault::SFTokenVault() : QObject(0), mSnapshot(), mGeneration(0) {
+}
+
+SFTokenVault::~SFTokenVault() {
+}
+
+/*
+ * Public
+ */
+QString SFTokenVault::token(const QString & key) {
+	return currentSnapshot()->tokens.value(key);
+}
+
+bool SFTokenVault::setToken(const QString & key, const QString & token) {
+	QMutexLocker locker(&mWriteLock);
+	SnapshotPointer snapshot(new Snapshot(*lockedSnapshot()));
+	if (token.isNull()) {
+		snapshot->tokens.remove(key);
+	} else {
+		snapshot->tokens.insert(key, token);
+	}
+	if (!persist(snapshot->tokens)) {
+		return false;
+	}
+	publish(snapshot);
+	return true;
+}
+
+bool SFTokenVault::removeTokens(const QStringList & keys) {
+	QMutexLocker locker(&mWriteLock);
+	SnapshotPointer snapshot(new Snapshot(*lockedSnapshot()));
+	for (QStringList::const_iterator i = keys.constBegin(); i != keys.constEnd(); i++) {
+		snapshot->tokens.remove(*i);
+	}
+	if (!persist(snapshot->tokens)) {
+		return false;
+	}
+	publish(snapshot);
+	return true;
+}
+
+void SFTokenVault::invalidate() {
+	QMutexLocker locker(&mWriteLock);
+	publish(SnapshotPointer());
+}
+
+/*
+ * Private
+ */
+SFTokenVault::SnapshotPointer SFTokenVault::currentSnapshot() {
+	//common path: the vault is loaded, the reader keeps a reference for as long as it uses the snapshot
+	{
+		QMutexLocker locker(&mSnapshotLock);
+		if (mSnapshot) {
+			return mSnapshot;
+		}
+	}
+	//first read or after invalidate(), load from disk
+	QMutexLocker locker(&mWriteLock);
+	return lockedSnapshot();
+}
+
+/* caller must hold mWriteLock */
+SFTokenVault::SnapshotPointer SFTokenVault::lockedSnapshot() {
+	SnapshotPointer snapshot;
+	{
+		QMutexLocker locker(&mSnapshotLock);
+		snapshot = mSnapshot;
+	}
+	if (!snapshot) {
+		snapshot = load();
+		publish(snapshot);
+	}
+	return snapshot;
+}
+
+/* caller must hold mWriteLock */
+void SFTokenVault::publish(const SnapshotPointer & snapshot) {
+	SnapshotPointer old;
+	{
+		QMutexLocker locker(&mSnapshotLock);
+		old = mSnapshot;
+		mSnapshot = snapshot;
+	}
+	//the replaced snapshot is freed here, or by the last reader still holding it
+	old.reset();
+	mGeneration.ref();
+}
+
+SFTokenVault::SnapshotPointer SFTokenVault::load() {
+	SnapshotPointer snapshot(new Snapshot());
+	bool needsPersist = false;
+	QString path = vaultFilePath();
+	if (!QFile::exists(path) && QFile::exists(path + kSFBackupSuffix)) {
+		//the last write was interrupted between its two renames, the backup is the last complete vault
+		QFile::rename(path + kSFBackupSuffix, path);
+	}
+	QFile vaultFile(path);
+	if (vaultFile.exists() && vaultFile.open(QIODevice::ReadOnly)) {
+		QByteArray content = vaultFile.readAll();
+		vaultFile.close();
+
+		SFSecurityManager *securityManager = SFSecurityManager::instance();
+		QByteArray json;
+		if (SFSecurityManager::isEnvelope(content)) {
+			json = securityManager->decryptData(content);
+		} else {
+			//vaults written before the binary envelope are hex text, rewrite them in the new format
+			json = securityManager->decrypt(QString::fromLatin1(content)).toUtf8();
+			needsPersist = !json.isEmpty();
+		}
+
+		bb::data::JsonDataAccess jda;
+		QVariantMap data = jda.loadFromBuffer(json).toMap();
+		for (QVariantMap::const_iterator i = data.constBegin(); i != data.constEnd(); i++) {
+			snapshot->tokens.insert(i.key(), i.value().toString());
+		}
+	}
+
+	int count = snapshot->tokens.size();
+	QStringList migratedFiles = migrateLegacyTokens(snapshot->tokens);
+	if (needsPersist || snapshot->tokens.size() != count) {
+		if (!persist(snapshot->tokens)) {
+			//the tokens are served from memory, the legacy files are imported again next time
+			return snapshot;
+		}
+	}
+	//the vault on disk now holds every token of these files
+	for (QStringList::const_iterator i = migratedFiles.constBegin(); i != migratedFiles.constEnd(); i++) {
+		QFile::remove(*i);
+	}
+	return snapshot;
+}
+
+bool SFTokenVault::persist(const QHash<QString, QString> & tokens) {
+	QDir home = QDir::home();
+	if (!home.exists(kSFTokenFileDir)) {
+		home.mkdir(kSFTokenFileDir);
+	}
+
+	QVariantMap data;
+	for (QHash<QString, QString>::const_iterator i = tokens.constBegin(); i != tokens.constEnd(); i++) {
+		data.insert(i.key(), i.value());
+	}
+	QByteArray buffer;
+	bb::data::JsonDataAccess jda;
+	jda.saveToBuffer(data, &buffer);
+	QByteArray encrypted = SFSecurityManager::instance()->encryptData(buffer);
+	if (encrypted.isEmpty()) {
+		sfWarning() << "[SFTokenVault] unable to encrypt token vault";
+		return false;
+	}
+
+	//write to a temporary file first so that a crash never leaves a half-written vault behind
+	QString path = vaultFilePath();
+	QString tempPath = path + kSFTempSuffix;
+	QString backupPath = path + kSFBackupSuffix;
+	QFile tempFile(tempPath);
+	if (!tempFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		sfWarning() << "[SFTokenVault] unable to write token vault" << tempPath;
+		return false;
+	}
+	bool written = tempFile.write(encrypted) == encrypted.length();
+	tempFile.close();
+	if (!written) {
+		sfWarning() << "[SFTokenVault] unable to write token vault" << tempPath;
+		tempFile.remove();
+		return false;
+	}
+
+	//QFile::rename() doesn't replace a file, move the current vault aside and keep it until the new one is in place
+	bool hasVault = QFile::exists(path);
+	QFile::remove(backupPath);
+	if (hasVault && !QFile::rename(path, backupPath)) {
+		sfWarning() << "[SFTokenVault] unable to back up token vault" << path;
+		QFile::remove(tempPath);
+		return false;
+	}
+	if (!QFile::rename(tempPath, path)) {
+		sfWarning() << "[SFTokenVault] unable to replace token vault" << path;
+		if (hasVault) {
+			QFile::rename(backupPath, path);
+		}
+		QFile::remove(tempPath);
+		return false;
+	}
+	QFile::remove(backupPath);
+	return true;
+}
+
+/* @return the files whose token is now in the table, they can be removed once the table is persisted */
+QStringList SFTokenVault::migrateLegacyTokens(QHash<QString, QString> & tokens) {
+	//earlier versions stored each token in its own file named after the token key
+	QStringList migratedFiles;
+	QDir dir(QDir::home().absoluteFilePath(kSFTokenFileDir));
+	if (!dir.exists()) {
+		return migratedFiles;
+	}
+	QStringList legacyFiles = dir.entryList(QDir::Files);
+	for (QStringList::const_iterator i = legacyFiles.constBegin(); i != legacyFiles.constEnd(); i++) {
+		if (i->startsWith(kSFTokenVaultFile)) {
+			continue;
+		}
+		QFile tokenFile(dir.absoluteFilePath(*i));
+		if (!tokenFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+			continue;
+		}
+		QTextStream in(&tokenFile);
+		QString token = SFSecurityManager::instance()->decrypt(in.readAll());
+		tokenFile.close();
+		if (token.isEmpty()) {
+			//keep the file, it may be readable once the key is available
+			sfWarning() << "[SFTokenVault] unable to decrypt legacy token" << *i;
+			continue;
+		}
+		if (!tokens.contains(*i)) {
+			sfDebug() << "[SFTokenVault] migrating token" << *i;
+			tokens.insert(*i, token);
+		}
+		migratedFiles.append(tokenFile.fileName());
+	}
+	return migratedFiles;
+}
+
+QString SFTokenVault::vaultFilePath() const {
+	return QDir::home().absoluteFilePath(QString("%1/%2").arg(kSFTokenFileDir, kSFTokenVaultFile));
+}
+
+} /* namespace sf */
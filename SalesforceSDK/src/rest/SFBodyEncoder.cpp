@@ -0,0 +1,398 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBodyEncoder.cpp
+*/
+
+
+#include "SFBodyEncoder.h"
+#include <QDateTime>
+#include <QIODevice>
+#include <cstring>
+#include "SFGlobal.h"
+
+namespace sf {
+
+static const char kSFHexDigits[] = "0123456789ABCDEF";
+
+/* RFC 3986 unreserved characters, which are not percent-encoded */
+static inline bool isUnreserved(uchar c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~';
+}
+
+SFBodyEncoder::SFBodyEncoder() : mBuffer(NULL), mDevice(NULL), mChunkUsed(0), mSize(0), mError(false) {
+}
+
+SFBodyEncoder::SFBodyEncoder(QByteArray * buffer) : mBuffer(buffer), mDevice(NULL), mChunkUsed(0), mSize(0), mError(false) {
+}
+
+SFBodyEncoder::SFBodyEncoder(QIODevice * device) : mBuffer(NULL), mDevice(device), mChunkUsed(0), mSize(0), mError(false) {
+}
+
+SFBodyEncoder::~SFBodyEncoder() {
+	this->flush();
+}
+
+bool SFBodyEncoder::flush() {
+	if (mDevice && mChunkUsed > 0) {
+		if (mDevice->write(mChunk, mChunkUsed) != mChunkUsed) {
+			mError = true;
+		}
+		mChunkUsed = 0;
+	}
+	return !mError;
+}
+
+inline void SFBodyEncoder::put(char c) {
+	mSize++;
+	if (mBuffer) {
+		mBuffer->append(c);
+	} else if (mDevice) {
+		if (mChunkUsed == kChunkSize) {
+			this->flush();
+		}
+		mChunk[mChunkUsed++] = c;
+	}
+}
+
+void SFBodyEncoder::writeRaw(const char * data, int size) {
+	if (size <= 0) {
+		return;
+	}
+	mSize += size;
+	if (mBuffer) {
+		mBuffer->append(data, size);
+	} else if (mDevice) {
+		if (mChunkUsed + size > kChunkSize) {
+			this->flush();
+		}
+		if (size >= kChunkSize) {
+			if (mDevice->write(data, size) != size) {
+				mError = true;
+			}
+		} else {
+			memcpy(mChunk + mChunkUsed, data, size);
+			mChunkUsed += size;
+		}
+	}
+}
+
+void SFBodyEncoder::writeLiteral(const char * text) {
+	this->writeRaw(text, strlen(text));
+}
+
+inline void SFBodyEncoder::putEscaped(uchar c, Escape escape) {
+	switch (escape) {
+	case EscapePercent:
+		if (isUnreserved(c)) {
+			this->put(c);
+		} else {
+			this->put('%');
+			this->put(kSFHexDigits[c >> 4]);
+			this->put(kSFHexDigits[c & 0xF]);
+		}
+		break;
+	case EscapeJson:
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			this->put(c);
+			break;
+		}
+		this->put('\\');
+		switch (c) {
+		case '"': this->put('"'); break;
+		case '\\': this->put('\\'); break;
+		case '\b': this->put('b'); break;
+		case '\f': this->put('f'); break;
+		case '\n': this->put('n'); break;
+		case '\r': this->put('r'); break;
+		case '\t': this->put('t'); break;
+		default:
+			this->writeLiteral("u00");
+			this->put(kSFHexDigits[c >> 4]);
+			this->put(kSFHexDigits[c & 0xF]);
+			break;
+		}
+		break;
+	default:
+		this->put(c);
+		break;
+	}
+}
+
+void SFBodyEncoder::writeUtf8(const QString & text, Escape escape) {
+	const ushort *data = text.utf16();
+	int length = text.length();
+	for (int i = 0; i < length; i++) {
+		uint c = data[i];
+		if (c < 0x80) {
+			this->putEscaped(c, escape);
+			continue;
+		}
+		if (c >= 0xD800 && c < 0xDC00 && i + 1 < length && data[i + 1] >= 0xDC00 && data[i + 1] < 0xE000) {
+			c = 0x10000 + ((c - 0xD800) << 10) + (data[++i] - 0xDC00);
+		} else if (c >= 0xD800 && c < 0xE000) {
+			c = 0xFFFD; //lone surrogate
+		}
+		if (c < 0x800) {
+			this->putEscaped(0xC0 | (c >> 6), escape);
+		} else if (c < 0x10000) {
+			this->putEscaped(0xE0 | (c >> 12), escape);
+			this->putEscaped(0x80 | ((c >> 6) & 0x3F), escape);
+		} else {
+			this->putEscaped(0xF0 | (c >> 18), escape);
+			this->putEscaped(0x80 | ((c >> 12) & 0x3F), escape);
+			this->putEscaped(0x80 | ((c >> 6) & 0x3F), escape);
+		}
+		this->putEscaped(0x80 | (c & 0x3F), escape);
+	}
+}
+
+void SFBodyEncoder::writePercentEncoded(const QString & text) {
+	this->writeUtf8(text, EscapePercent);
+}
+
+void SFBodyEncoder::writeJsonString(const QString & text) {
+	this->put('"');
+	this->writeUtf8(text, EscapeJson);
+	this->put('"');
+}
+
+void SFBodyEncoder::writeNumber(qlonglong number) {
+	char digits[32];
+	int size = qsnprintf(digits, sizeof(digits), "%lld", number);
+	this->writeRaw(digits, size);
+}
+
+void SFBodyEncoder::writeNumber(qulonglong number) {
+	char digits[32];
+	int size = qsnprintf(digits, sizeof(digits), "%llu", number);
+	this->writeRaw(digits, size);
+}
+
+void SFBodyEncoder::writeNumber(double number) {
+	if (number != number || number - number != 0) {
+		//NaN and infinities are not valid JSON
+		this->writeLiteral("null");
+		return;
+	}
+	//the shortest text that reads back as the same number. QByteArray formats and parses
+	//in the C locale, printf and strtod would use a decimal comma in some locales
+	QByteArray digits = QByteArray::number(number, 'g', 15);
+	if (digits.toDouble() != number) {
+		digits = QByteArray::number(number, 'g', 17);
+	}
+	this->writeRaw(digits);
+}
+
+void SFBodyEncoder::writeNumber(float number) {
+	if (number != number || number - number != 0) {
+		this->writeLiteral("null");
+		return;
+	}
+	//written with the float's own precision, 0.1f is sent as 0.1 rather than 0.100000001490116
+	QByteArray digits = QByteArray::number(number, 'g', 7);
+	if (digits.toFloat() != number) {
+		digits = QByteArray::number(number, 'g', 9);
+	}
+	this->writeRaw(digits);
+}
+
+bool SFBodyEncoder::paramValue(const QVariant & value, QString * pOutText) const {
+	if (value.type() != QVariant::ByteArray && value.canConvert<QString>()) {
+		*pOutText = value.toString();
+		return true;
+	} else if (!value.isNull() && value.canConvert<QByteArray>()) {
+		*pOutText = value.toByteArray().toBase64();
+		return true;
+	}
+	return false;
+}
+
+void SFBodyEncoder::writeUrlEncoded(const QVariantMap & params) {
+	bool first = true;
+	for (QVariantMap::const_iterator i = params.constBegin(); i != params.constEnd(); i++) {
+		QString value;
+		if (i.key().isEmpty() || !this->paramValue(i.value(), &value)) {
+			//only warn once, when the bytes are actually written
+			if (!this->isCounting()) {
+				sfWarning() << "[SFBodyEncoder] Invalid parameter:" << i.key() << i.value();
+			}
+			continue;
+		}
+		if (!first) {
+			this->put('&');
+		}
+		first = false;
+		this->writeUtf8(i.key(), EscapePercent);
+		this->put('=');
+		this->writeUtf8(value, EscapePercent);
+	}
+}
+
+bool SFBodyEncoder::writeJson(const QVariant & value) {
+	//userType() rather than type(), floats only have a QMetaType id
+	switch (value.userType()) {
+	case QVariant::Invalid:
+		this->writeLiteral("null");
+		return true;
+	case QVariant::Bool:
+		this->writeLiteral(value.toBool() ? "true" : "false");
+		return true;
+	case QVariant::Int:
+	case QVariant::LongLong:
+		this->writeNumber(value.toLongLong());
+		return true;
+	case QVariant::UInt:
+	case QVariant::ULongLong:
+		this->writeNumber(value.toULongLong());
+		return true;
+	case QVariant::Double:
+		this->writeNumber(value.toDouble());
+		return true;
+	case QMetaType::Float:
+		this->writeNumber(value.value<float>());
+		return true;
+	case QVariant::String:
+		this->writeJsonString(value.toString());
+		return true;
+	case QVariant::ByteArray:
+		this->writeJsonString(QString::fromUtf8(value.toByteArray()));
+		return true;
+	case QVariant::Date:
+		this->writeJsonString(value.toDate().toString("yyyy-MM-dd"));
+		return true;
+	case QVariant::DateTime:
+		this->writeJsonString(value.toDateTime().toUTC().toString("yyyy-MM-ddThh:mm:ss.zzz") + "+0000");
+		return true;
+	case QVariant::Map: {
+		const QVariantMap map = value.toMap();
+		bool ok = true;
+		this->put('{');
+		for (QVariantMap::const_iterator i = map.constBegin(); i != map.constEnd() && ok; i++) {
+			if (i != map.constBegin()) {
+				this->put(',');
+			}
+			this->writeJsonString(i.key());
+			this->put(':');
+			ok = this->writeJson(i.value());
+		}
+		this->put('}');
+		return ok;
+	}
+	case QVariant::Hash: {
+		const QVariantHash hash = value.toHash();
+		bool ok = true;
+		this->put('{');
+		for (QVariantHash::const_iterator i = hash.constBegin(); i != hash.constEnd() && ok; i++) {
+			if (i != hash.constBegin()) {
+				this->put(',');
+			}
+			this->writeJsonString(i.key());
+			this->put(':');
+			ok = this->writeJson(i.value());
+		}
+		this->put('}');
+		return ok;
+	}
+	case QVariant::List:
+	case QVariant::StringList: {
+		const QVariantList list = value.toList();
+		bool ok = true;
+		this->put('[');
+		for (int i = 0; i < list.size() && ok; i++) {
+			if (i > 0) {
+				this->put(',');
+			}
+			ok = this->writeJson(list.at(i));
+		}
+		this->put(']');
+		return ok;
+	}
+	default:
+		if (value.canConvert<QString>()) {
+			this->writeJsonString(value.toString());
+			return true;
+		}
+		mError = true;
+		return false;
+	}
+}
+
+void SFBodyEncoder::writeMultipart(const QVariantMap & params, const QByteArray & boundary) {
+	for (QVariantMap::const_iterator i = params.constBegin(); i != params.constEnd(); i++) {
+		this->writeLiteral("--");
+		this->writeRaw(boundary);
+		this->writeLiteral("\r\nContent-Disposition: form-data; name=\"");
+		this->writeUtf8(i.key(), EscapeJson);
+		this->put('"');
+		const QVariant & value = i.value();
+		switch (value.type()) {
+		case QVariant::ByteArray:
+			this->writeLiteral("; filename=\"");
+			this->writeUtf8(i.key(), EscapeJson);
+			this->writeLiteral("\"\r\nContent-Type: application/octet-stream\r\n\r\n");
+			this->writeRaw(value.toByteArray());
+			break;
+		case QVariant::Map:
+		case QVariant::Hash:
+		case QVariant::List:
+		case QVariant::StringList:
+			this->writeLiteral("\r\nContent-Type: application/json; charset=utf-8\r\n\r\n");
+			this->writeJson(value);
+			break;
+		default:
+			this->writeLiteral("\r\nContent-Type: text/plain; charset=utf-8\r\n\r\n");
+			this->writeUtf8(value.toString(), EscapeNone);
+			break;
+		}
+		this->writeLiteral("\r\n");
+	}
+	this->writeLiteral("--");
+	this->writeRaw(boundary);
+	this->writeLiteral("--\r\n");
+}
+
+QByteArray SFBodyEncoder::encodeUrlEncoded(const QVariantMap & params) {
+	SFBodyEncoder counter;
+	counter.writeUrlEncoded(params);
+	QByteArray bytes;
+	bytes.reserve(counter.size());
+	SFBodyEncoder encoder(&bytes);
+	encoder.writeUrlEncoded(params);
+	return bytes;
+}
+
+bool SFBodyEncoder::encodeJson(const QVariant & value, QByteArray * pOutBytes) {
+	SFBodyEncoder counter;
+	if (!counter.writeJson(value)) {
+		return false;
+	}
+	pOutBytes->clear();
+	pOutBytes->reserve(counter.size());
+	SFBodyEncoder encoder(pOutBytes);
+	return encoder.writeJson(value);
+}
+
+QByteArray SFBodyEncoder::encodeMultipart(const QVariantMap & params, const QByteArray & boundary) {
+	SFBodyEncoder counter;
+	counter.writeMultipart(params, boundary);
+	QByteArray bytes;
+	bytes.reserve(counter.size());
+	SFBodyEncoder encoder(&bytes);
+	encoder.writeMultipart(params, boundary);
+	return bytes;
+}
+
+} /* namespace sf */
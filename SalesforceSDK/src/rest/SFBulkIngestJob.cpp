@@ -0,0 +1,361 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBulkIngestJob.cpp
+*/
+
+#include "SFBulkIngestJob.h"
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QtConcurrentRun>
+#include "SFCsvWriter.h"
+#include "SFFileConsumer.h"
+#include "SFRecordSource.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFResult.h"
+
+namespace sf {
+
+static const QString kSFIngestJobsPath = "/jobs/ingest";
+static const QString kSFIngestBatchesPath = "/batches";
+static const QString kSFSuccessfulResultsPath = "/successfulResults/";
+static const QString kSFFailedResultsPath = "/failedResults/";
+static const QString kSFCsvContentType = "text/csv";
+static const QString kSFJobIdKey = "id";
+static const QString kSFJobStateKey = "state";
+static const QString kSFJobErrorMessageKey = "errorMessage";
+static const QString kSFJobStateUploadComplete = "UploadComplete";
+static const QString kSFJobStateComplete = "JobComplete";
+static const QString kSFJobStateFailed = "Failed";
+static const QString kSFJobStateAborted = "Aborted";
+
+/* runs in a worker thread, @return an error message, empty on success */
+static QString spillRecords(SFRecordSource *source, const QStringList & columns, const QString & fileName) {
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return QString("Cannot write %1: %2").arg(fileName, file.errorString());
+	}
+	SFCsvWriter writer(&file);
+	bool written = writer.writeRow(columns);
+	QVariantList values;
+	while (written && source->next(&values)) {
+		written = writer.writeRow(values);
+		values.clear();
+	}
+	written = written && writer.flush();
+	return written ? QString() : QString("Cannot write %1: %2").arg(fileName, file.errorString());
+}
+
+static QString operationName(SFBulkIngestJob::Operation operation) {
+	switch (operation) {
+	case SFBulkIngestJob::Update:
+		return "update";
+	case SFBulkIngestJob::Upsert:
+		return "upsert";
+	case SFBulkIngestJob::Delete:
+		return "delete";
+	case SFBulkIngestJob::HardDelete:
+		return "hardDelete";
+	default:
+		return "insert";
+	}
+}
+
+SFBulkIngestJob::SFBulkIngestJob(QObject *parent)
+: QObject(parent), mObjectType(), mOperation(Insert), mExternalIdFieldName(), mCsvFile(), mSuccessfulResultsFile(), mFailedResultsFile(),
+  mPollInterval(1000), mMaxPollInterval(30000), mNextPollInterval(1000), mState(Idle), mJobId(), mJobInfo(), mGeneration(0),
+  mPendingDownloads(0), mRecordSource(NULL), mColumns(), mSpillFile(NULL), mSpillWatcher(), mPollTimer() {
+	mPollTimer.setSingleShot(true);
+	connect(&mPollTimer, SIGNAL(timeout()), this, SLOT(poll()));
+	connect(&mSpillWatcher, SIGNAL(finished()), this, SLOT(onRecordsSpilled()));
+}
+
+SFBulkIngestJob::~SFBulkIngestJob() {
+	//the worker still reads the source and writes the file
+	mSpillWatcher.waitForFinished();
+	delete mRecordSource;
+}
+
+void SFBulkIngestJob::setRecordSource(SFRecordSource * source, const QStringList & columns) {
+	if (mState == Preparing) {
+		sfWarning() << "[SFBulkIngestJob] The record source can't be replaced while it is read.";
+		return;
+	}
+	if (mRecordSource != source) {
+		delete mRecordSource;
+	}
+	mRecordSource = source;
+	mColumns = columns;
+}
+
+void SFBulkIngestJob::start() {
+	if (this->isRunning() || mSpillWatcher.isRunning()) {
+		return;
+	}
+	mGeneration++;
+	mJobId.clear();
+	mJobInfo.clear();
+	if (mObjectType.isEmpty()) {
+		this->fail(SFResultCode::SFErrorGeneric, "The object type is empty.");
+		return;
+	}
+	if (mOperation == Upsert && mExternalIdFieldName.isEmpty()) {
+		this->fail(SFResultCode::SFErrorGeneric, "An upsert needs an external ID field.");
+		return;
+	}
+	if (!mRecordSource) {
+		if (!QFile::exists(mCsvFile)) {
+			this->fail(SFResultCode::SFErrorGeneric, QString("The CSV file %1 doesn't exist.").arg(mCsvFile));
+			return;
+		}
+		this->openJob();
+		return;
+	}
+
+	//the size of the upload has to be known up front, so the records go to a file first
+	delete mSpillFile;
+	mSpillFile = new QTemporaryFile(QDir::tempPath() + "/sfbulk_XXXXXX.csv", this);
+	if (!mSpillFile->open()) {
+		this->fail(SFResultCode::SFErrorGeneric, QString("Cannot create a temporary file: %1").arg(mSpillFile->errorString()));
+		return;
+	}
+	mSpillFile->close(); //the file stays until the object is deleted
+	this->setState(Preparing);
+	mSpillWatcher.setFuture(QtConcurrent::run(spillRecords, mRecordSource, mColumns, mSpillFile->fileName()));
+}
+
+void SFBulkIngestJob::abort() {
+	if (!this->isRunning()) {
+		return;
+	}
+	//responses of the aborted run are ignored from now on
+	mGeneration++;
+	mPollTimer.stop();
+	if (!mJobId.isEmpty() && mState != DownloadingResults) {
+		this->sendAbort(mJobId);
+	}
+	this->setState(Aborted);
+}
+
+void SFBulkIngestJob::onRecordsSpilled() {
+	QString error = mSpillWatcher.result();
+	delete mRecordSource;
+	mRecordSource = NULL;
+	if (mState != Preparing) {
+		//aborted while the records were written
+		return;
+	}
+	if (!error.isEmpty()) {
+		this->fail(SFResultCode::SFErrorGeneric, error);
+		return;
+	}
+	this->openJob();
+}
+
+void SFBulkIngestJob::onJobCreated(SFResult* result) {
+	if (!this->isCurrent(result)) {
+		//the job was aborted before Salesforce told its ID, don't leave it open
+		QString staleJobId = result->hasError() ? QString() : result->payload<QVariantMap>().value(kSFJobIdKey).toString();
+		if (!staleJobId.isEmpty()) {
+			this->sendAbort(staleJobId);
+		}
+		return;
+	}
+	if (result->hasError()) {
+		this->fail(result->code(), result->message());
+		return;
+	}
+	mJobInfo = result->payload<QVariantMap>();
+	mJobId = mJobInfo.value(kSFJobIdKey).toString();
+	if (mJobId.isEmpty()) {
+		this->fail(SFResultCode::SFErrorGeneric, "Salesforce didn't return the ID of the job.");
+		return;
+	}
+
+	this->setState(Uploading);
+	SFRestRequest *request = this->createRequest(kSFIngestJobsPath + "/" + mJobId + kSFIngestBatchesPath, HTTPMethod::HTTPPut);
+	request->setRequestBodyFile(mSpillFile ? mSpillFile->fileName() : mCsvFile, kSFCsvContentType);
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onDataUploaded(sf::SFResult*)), mGeneration);
+}
+
+void SFBulkIngestJob::onDataUploaded(SFResult* result) {
+	if (!this->isCurrent(result)) {
+		return;
+	}
+	if (result->hasError()) {
+		this->fail(result->code(), result->message());
+		return;
+	}
+	//the data is with Salesforce now
+	delete mSpillFile;
+	mSpillFile = NULL;
+
+	this->setState(Closing);
+	QVariantMap body;
+	body[kSFJobStateKey] = kSFJobStateUploadComplete;
+	SFRestRequest *request = this->createRequest(kSFIngestJobsPath + "/" + mJobId, HTTPMethod::HTTPPatch, body);
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onJobClosed(sf::SFResult*)), mGeneration);
+}
+
+void SFBulkIngestJob::onJobClosed(SFResult* result) {
+	if (!this->isCurrent(result)) {
+		return;
+	}
+	if (result->hasError()) {
+		this->fail(result->code(), result->message());
+		return;
+	}
+	mJobInfo = result->payload<QVariantMap>();
+	this->setState(Processing);
+	mNextPollInterval = mPollInterval;
+	mPollTimer.start(mNextPollInterval);
+}
+
+void SFBulkIngestJob::poll() {
+	if (mState != Processing) {
+		return;
+	}
+	SFRestRequest *request = this->createRequest(kSFIngestJobsPath + "/" + mJobId, HTTPMethod::HTTPGet);
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onJobStatusReady(sf::SFResult*)), mGeneration);
+}
+
+void SFBulkIngestJob::onJobStatusReady(SFResult* result) {
+	if (!this->isCurrent(result)) {
+		return;
+	}
+	if (result->hasError()) {
+		this->fail(result->code(), result->message());
+		return;
+	}
+	mJobInfo = result->payload<QVariantMap>();
+	QString jobState = mJobInfo.value(kSFJobStateKey).toString();
+	if (jobState == kSFJobStateFailed) {
+		this->fail(SFResultCode::SFErrorGeneric, mJobInfo.value(kSFJobErrorMessageKey, "Salesforce failed the job.").toString());
+		return;
+	}
+	if (jobState == kSFJobStateAborted) {
+		this->fail(SFResultCode::SFErrorGeneric, "The job was aborted.");
+		return;
+	}
+	if (jobState != kSFJobStateComplete) {
+		//back off, large jobs take minutes and every poll counts against the API limits
+		mNextPollInterval = qMin(mNextPollInterval + mNextPollInterval / 2, mMaxPollInterval);
+		mPollTimer.start(mNextPollInterval);
+		return;
+	}
+
+	this->setState(DownloadingResults);
+	mPendingDownloads = 0;
+	this->download(kSFSuccessfulResultsPath, mSuccessfulResultsFile);
+	this->download(kSFFailedResultsPath, mFailedResultsFile);
+	if (mPendingDownloads == 0) {
+		this->setState(Complete);
+		emit finished();
+	}
+}
+
+void SFBulkIngestJob::onResultsDownloaded(SFResult* result) {
+	if (!this->isCurrent(result)) {
+		return;
+	}
+	if (result->hasError()) {
+		this->fail(result->code(), result->message());
+		return;
+	}
+	if (--mPendingDownloads == 0) {
+		this->setState(Complete);
+		emit finished();
+	}
+}
+
+void SFBulkIngestJob::onAbortResultReady(SFResult* result) {
+	if (result->hasError()) {
+		sfWarning() << "[SFBulkIngestJob] The job couldn't be aborted:" << result->code() << result->message();
+	}
+}
+
+bool SFBulkIngestJob::isRunning() const {
+	return mState != Idle && mState != Complete && mState != Failed && mState != Aborted;
+}
+
+void SFBulkIngestJob::setState(State state) {
+	if (mState == state) {
+		return;
+	}
+	mState = state;
+	emit stateChanged(state);
+}
+
+void SFBulkIngestJob::openJob() {
+	this->setState(Opening);
+	QVariantMap body;
+	body["object"] = mObjectType;
+	body["operation"] = operationName(mOperation);
+	body["contentType"] = "CSV";
+	body["lineEnding"] = "LF";
+	if (mOperation == Upsert) {
+		body["externalIdFieldName"] = mExternalIdFieldName;
+	}
+	SFRestRequest *request = this->createRequest(kSFIngestJobsPath, HTTPMethod::HTTPPost, body);
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onJobCreated(sf::SFResult*)), mGeneration);
+}
+
+void SFBulkIngestJob::download(const QString & resultsPath, const QString & fileName) {
+	if (fileName.isEmpty()) {
+		return;
+	}
+	SFRestRequest *request = this->createRequest(kSFIngestJobsPath + "/" + mJobId + resultsPath, HTTPMethod::HTTPGet);
+	//the results can be as large as the upload, they go straight to the file
+	request->setResponseConsumer(new SFFileConsumer(fileName));
+	mPendingDownloads++;
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onResultsDownloaded(sf::SFResult*)), mGeneration);
+}
+
+void SFBulkIngestJob::fail(int code, const QString & message) {
+	mGeneration++;
+	mPollTimer.stop();
+	//a job that never got to processing would stay open on the server until it times out
+	if (!mJobId.isEmpty() && (mState == Uploading || mState == Closing)) {
+		this->sendAbort(mJobId);
+	}
+	delete mSpillFile;
+	mSpillFile = NULL;
+	this->setState(Failed);
+	emit failed(code, message);
+}
+
+void SFBulkIngestJob::sendAbort(const QString & jobId) {
+	QVariantMap body;
+	body[kSFJobStateKey] = kSFJobStateAborted;
+	SFRestRequest *request = this->createRequest(kSFIngestJobsPath + "/" + jobId, HTTPMethod::HTTPPatch, body);
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onAbortResultReady(sf::SFResult*)));
+}
+
+SFRestRequest * SFBulkIngestJob::createRequest(const QString & path, const HTTPMethodType & method, const QVariantMap & body) const {
+	SFRestAPI *api = SFRestAPI::instance();
+	SFRestRequest *request = new SFRestRequest(0, path, method, api->apiVersion(), api->endPoint(), api->userAgent());
+	request->setRequestParams(body);
+	request->setParamsContentType(body.isEmpty() ? SFRestRequest::HTTPContentTypeUrlEncoded : SFRestRequest::HTTPContentTypeJSON);
+	request->setPriority(SFRequestPriority::BackgroundSync);
+	return request;
+}
+
+bool SFBulkIngestJob::isCurrent(SFResult * result) const {
+	return result->getTag<int>(kSFRestRequestTag) == mGeneration && this->isRunning();
+}
+
+} /* namespace sf */
@@ -0,0 +1,252 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBulkQueryJob.cpp
+*/
+
+#include "SFBulkQueryJob.h"
+#include "SFCsvStreamParser.h"
+#include "SFFileConsumer.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFResult.h"
+
+namespace sf {
+
+static const QString kSFQueryJobsPath = "/jobs/query";
+static const QString kSFQueryResultsPath = "/results";
+static const QString kSFLocatorHeader = "Sforce-Locator";
+static const QString kSFNumberOfRecordsHeader = "Sforce-NumberOfRecords";
+static const QString kSFLastLocator = "null"; //the locator of the last page
+static const QString kSFLocatorParam = "locator";
+static const QString kSFMaxRecordsParam = "maxRecords";
+static const QString kSFJobIdKey = "id";
+static const QString kSFJobStateKey = "state";
+static const QString kSFJobErrorMessageKey = "errorMessage";
+static const QString kSFJobStateComplete = "JobComplete";
+static const QString kSFJobStateFailed = "Failed";
+static const QString kSFJobStateAborted = "Aborted";
+static const QString kSFColumnsKey = "columns";
+static const QString kSFRowsKey = "rows";
+
+SFBulkQueryJob::SFBulkQueryJob(QObject *parent)
+: QObject(parent), mQuery(), mOperation(Query), mResultsFile(), mMaxRecordsPerPage(10000), mPollInterval(1000), mMaxPollInterval(30000),
+  mNextPollInterval(1000), mState(Idle), mJobId(), mJobInfo(), mRowCount(0), mPageCount(0), mGeneration(0), mPollTimer() {
+	mPollTimer.setSingleShot(true);
+	connect(&mPollTimer, SIGNAL(timeout()), this, SLOT(poll()));
+}
+
+SFBulkQueryJob::~SFBulkQueryJob() {
+}
+
+void SFBulkQueryJob::start() {
+	if (this->isRunning()) {
+		return;
+	}
+	mGeneration++;
+	mJobId.clear();
+	mJobInfo.clear();
+	mRowCount = 0;
+	mPageCount = 0;
+	if (mQuery.trimmed().isEmpty()) {
+		this->fail(SFResultCode::SFErrorGeneric, "The query is empty.");
+		return;
+	}
+
+	this->setState(Opening);
+	QVariantMap body;
+	body["operation"] = mOperation == QueryAll ? "queryAll" : "query";
+	body["query"] = mQuery;
+	body["contentType"] = "CSV";
+	body["lineEnding"] = "LF";
+	SFRestRequest *request = this->createRequest(kSFQueryJobsPath, HTTPMethod::HTTPPost, body);
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onJobCreated(sf::SFResult*)), mGeneration);
+}
+
+void SFBulkQueryJob::abort() {
+	if (!this->isRunning()) {
+		return;
+	}
+	//responses of the aborted run are ignored from now on
+	mGeneration++;
+	mPollTimer.stop();
+	if (!mJobId.isEmpty() && mState == Processing) {
+		this->sendAbort(mJobId);
+	}
+	this->setState(Aborted);
+}
+
+void SFBulkQueryJob::onJobCreated(SFResult* result) {
+	if (!this->isCurrent(result)) {
+		//the job was aborted before Salesforce told its ID, don't let it run for nothing
+		QString staleJobId = result->hasError() ? QString() : result->payload<QVariantMap>().value(kSFJobIdKey).toString();
+		if (!staleJobId.isEmpty()) {
+			this->sendAbort(staleJobId);
+		}
+		return;
+	}
+	if (result->hasError()) {
+		this->fail(result->code(), result->message());
+		return;
+	}
+	mJobInfo = result->payload<QVariantMap>();
+	mJobId = mJobInfo.value(kSFJobIdKey).toString();
+	if (mJobId.isEmpty()) {
+		this->fail(SFResultCode::SFErrorGeneric, "Salesforce didn't return the ID of the job.");
+		return;
+	}
+	this->setState(Processing);
+	mNextPollInterval = mPollInterval;
+	mPollTimer.start(mNextPollInterval);
+}
+
+void SFBulkQueryJob::poll() {
+	if (mState != Processing) {
+		return;
+	}
+	SFRestRequest *request = this->createRequest(kSFQueryJobsPath + "/" + mJobId, HTTPMethod::HTTPGet);
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onJobStatusReady(sf::SFResult*)), mGeneration);
+}
+
+void SFBulkQueryJob::onJobStatusReady(SFResult* result) {
+	if (!this->isCurrent(result)) {
+		return;
+	}
+	if (result->hasError()) {
+		this->fail(result->code(), result->message());
+		return;
+	}
+	mJobInfo = result->payload<QVariantMap>();
+	QString jobState = mJobInfo.value(kSFJobStateKey).toString();
+	if (jobState == kSFJobStateFailed) {
+		this->fail(SFResultCode::SFErrorGeneric, mJobInfo.value(kSFJobErrorMessageKey, "Salesforce failed the job.").toString());
+		return;
+	}
+	if (jobState == kSFJobStateAborted) {
+		this->fail(SFResultCode::SFErrorGeneric, "The job was aborted.");
+		return;
+	}
+	if (jobState != kSFJobStateComplete) {
+		//back off, large queries take minutes and every poll counts against the API limits
+		mNextPollInterval = qMin(mNextPollInterval + mNextPollInterval / 2, mMaxPollInterval);
+		mPollTimer.start(mNextPollInterval);
+		return;
+	}
+	this->setState(DownloadingResults);
+	this->fetchPage(QString());
+}
+
+void SFBulkQueryJob::onPageReady(SFResult* result) {
+	if (!this->isCurrent(result)) {
+		return;
+	}
+	if (result->hasError()) {
+		this->fail(result->code(), result->message());
+		return;
+	}
+	QVariantMap headers = result->getTag<QVariantMap>(kSFResponseHeadersTag);
+	QString locator = headers.value(kSFLocatorHeader).toString();
+	bool lastPage = locator.isEmpty() || locator == kSFLastLocator;
+	//look ahead before the rows are delivered, so the network works while they are processed
+	if (!lastPage) {
+		this->fetchPage(locator);
+	}
+
+	if (mResultsFile.isEmpty()) {
+		QVariantMap page = result->payload<QVariantMap>();
+		QVariantList rows = page.value(kSFRowsKey).toList();
+		mRowCount += rows.size();
+		emit rowsReady(page.value(kSFColumnsKey).toStringList(), rows);
+	} else {
+		mRowCount += headers.value(kSFNumberOfRecordsHeader).toInt();
+	}
+
+	//a slot connected to rowsReady() may have aborted the job
+	if (lastPage && mState == DownloadingResults) {
+		this->setState(Complete);
+		emit finished();
+	}
+}
+
+void SFBulkQueryJob::onAbortResultReady(SFResult* result) {
+	if (result->hasError()) {
+		sfWarning() << "[SFBulkQueryJob] The job couldn't be aborted:" << result->code() << result->message();
+	}
+}
+
+bool SFBulkQueryJob::isRunning() const {
+	return mState == Opening || mState == Processing || mState == DownloadingResults;
+}
+
+void SFBulkQueryJob::setState(State state) {
+	if (mState == state) {
+		return;
+	}
+	mState = state;
+	emit stateChanged(state);
+}
+
+void SFBulkQueryJob::fetchPage(const QString & locator) {
+	QVariantMap params;
+	if (mMaxRecordsPerPage > 0) {
+		params[kSFMaxRecordsParam] = QString::number(mMaxRecordsPerPage);
+	}
+	if (!locator.isEmpty()) {
+		params[kSFLocatorParam] = locator;
+	}
+	SFRestRequest *request = this->createRequest(kSFQueryJobsPath + "/" + mJobId + kSFQueryResultsPath, HTTPMethod::HTTPGet, params);
+	request->setCapturedResponseHeaders(QStringList() << kSFLocatorHeader << kSFNumberOfRecordsHeader);
+	if (mResultsFile.isEmpty()) {
+		request->setResponseConsumer(new SFCsvRecordsConsumer());
+	} else {
+		//pages are requested one after the other, so each is appended once the previous one is written
+		SFFileConsumer *consumer = new SFFileConsumer(mResultsFile);
+		consumer->setAppend(mPageCount > 0);
+		consumer->setSkipFirstLine(mPageCount > 0);
+		request->setResponseConsumer(consumer);
+	}
+	mPageCount++;
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onPageReady(sf::SFResult*)), mGeneration);
+}
+
+void SFBulkQueryJob::fail(int code, const QString & message) {
+	mGeneration++;
+	mPollTimer.stop();
+	this->setState(Failed);
+	emit failed(code, message);
+}
+
+void SFBulkQueryJob::sendAbort(const QString & jobId) {
+	QVariantMap body;
+	body[kSFJobStateKey] = kSFJobStateAborted;
+	SFRestRequest *request = this->createRequest(kSFQueryJobsPath + "/" + jobId, HTTPMethod::HTTPPatch, body);
+	SFRestAPI::instance()->sendRestRequest(request, this, SLOT(onAbortResultReady(sf::SFResult*)));
+}
+
+SFRestRequest * SFBulkQueryJob::createRequest(const QString & path, const HTTPMethodType & method, const QVariantMap & params) const {
+	SFRestAPI *api = SFRestAPI::instance();
+	SFRestRequest *request = new SFRestRequest(0, path, method, api->apiVersion(), api->endPoint(), api->userAgent());
+	request->setRequestParams(params);
+	//parameters of a GET go in the URL
+	request->setParamsContentType(method == HTTPMethod::HTTPGet ? SFRestRequest::HTTPContentTypeUrlEncoded : SFRestRequest::HTTPContentTypeJSON);
+	request->setPriority(SFRequestPriority::BackgroundSync);
+	return request;
+}
+
+bool SFBulkQueryJob::isCurrent(SFResult * result) const {
+	return result->getTag<int>(kSFRestRequestTag) == mGeneration && this->isRunning();
+}
+
+} /* namespace sf */
@@ -0,0 +1,78 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCollectionRequest.cpp
+*/
+
+
+#include "SFCollectionRequest.h"
+#include <QStringList>
+#include "SFRestRequest.h"
+
+namespace sf {
+
+static const QString kSFCollectionPath = "/composite/sobjects";
+static const QString kSFAllOrNoneKey = "allOrNone";
+static const QString kSFRecordsKey = "records";
+static const QString kSFIdsKey = "ids";
+static const QString kSFRecordAttributesKey = "attributes";
+static const QString kSFRecordTypeKey = "type";
+
+const int SFCollectionRequest::MaxRecordsPerRequest;
+
+SFCollectionRequest::SFCollectionRequest(const HTTPMethodType & method, const QString & objectType, const QVariantList & records,
+		const QString & apiVersion, const QString & endPoint, const QString & userAgent, QObject *parent)
+: QObject(parent), mMethod(method), mObjectType(objectType), mRecords(records), mApiVersion(apiVersion), mEndPoint(endPoint),
+  mUserAgent(userAgent), mAllOrNone(false), mMaxRequestsInFlight(3) {
+}
+
+SFCollectionRequest::~SFCollectionRequest() {
+}
+
+SFRestRequest *SFCollectionRequest::createChunkRequest(int index) const {
+	QVariantList chunk = mRecords.mid(this->chunkOffset(index), this->chunkSize(index));
+	SFRestRequest *request = new SFRestRequest(0, kSFCollectionPath, mMethod, mApiVersion, mEndPoint, mUserAgent);
+	QVariantMap params;
+
+	if (mMethod == HTTPMethod::HTTPDelete) {
+		QStringList ids;
+		for(QVariantList::const_iterator i = chunk.constBegin(); i != chunk.constEnd(); i++) {
+			ids.append(i->toString());
+		}
+		params[kSFIdsKey] = ids.join(",");
+		params[kSFAllOrNoneKey] = mAllOrNone ? "true" : "false";
+		request->setRequestParams(params);
+		request->setParamsContentType(SFRestRequest::HTTPContentTypeUrlEncoded);
+		return request;
+	}
+
+	//every record names its type
+	QVariantMap attributes;
+	attributes[kSFRecordTypeKey] = mObjectType;
+	for(QVariantList::iterator i = chunk.begin(); i != chunk.end(); i++) {
+		QVariantMap record = i->toMap();
+		if (!record.contains(kSFRecordAttributesKey)) {
+			record[kSFRecordAttributesKey] = attributes;
+		}
+		*i = record;
+	}
+	params[kSFAllOrNoneKey] = mAllOrNone;
+	params[kSFRecordsKey] = chunk;
+	request->setRequestParams(params);
+	request->setParamsContentType(SFRestRequest::HTTPContentTypeJSON);
+	return request;
+}
+
+} /* namespace sf */
@@ -0,0 +1,128 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCollectionTask.cpp
+*/
+
+
+#include "SFCollectionTask.h"
+#include <QMetaObject>
+#include "SFGlobal.h"
+#include "SFCollectionRequest.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFResult.h"
+
+namespace sf {
+
+static const QString kSFRecordIdKey = "Id";
+static const QString kSFResultIdKey = "id";
+static const QString kSFResultSuccessKey = "success";
+static const QString kSFResultErrorsKey = "errors";
+static const QString kSFErrorStatusCodeKey = "statusCode";
+static const QString kSFErrorMessageKey = "message";
+
+SFCollectionTask::SFCollectionTask(SFCollectionRequest * request)
+: QObject(0), mRequest(request), mTags(), mNextChunk(0), mRunningChunks(0), mFailedChunks(0), mErrorCode(SFResultCode::SFErrorNoError),
+  mErrorMessage(), mRecordResults(request ? request->count() : 0) {
+	if (request) {
+		request->setParent(this);
+	}
+}
+
+SFCollectionTask::~SFCollectionTask() {
+}
+
+void SFCollectionTask::start() {
+	int chunkCount = mRequest ? mRequest->chunkCount() : 0;
+	if (chunkCount == 0) {
+		//nothing to send, still deliver asynchronously like any other request
+		QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+		return;
+	}
+	int inFlight = qMin(chunkCount, mRequest->maxRequestsInFlight());
+	for(int i = 0; i < inFlight; i++) {
+		this->sendNextChunk();
+	}
+}
+
+void SFCollectionTask::onChunkResultReady(SFResult* result) {
+	int index = result->getTag<int>(kSFRestRequestTag);
+	int offset = mRequest->chunkOffset(index);
+	int size = mRequest->chunkSize(index);
+	QVariantList responses = result->hasError() ? QVariantList() : result->payload().toList();
+
+	if (responses.size() == size) {
+		for(int i = 0; i < size; i++) {
+			mRecordResults[offset + i] = responses.at(i);
+		}
+	} else {
+		//the chunk failed as a whole, every record of it gets the error of the chunk
+		if (mFailedChunks++ == 0) {
+			mErrorCode = result->hasError() ? result->code() : SFResultCode::SFErrorGeneric;
+			mErrorMessage = result->hasError() ? result->message() : QString("Unexpected response.");
+		}
+		QVariantMap error;
+		error[kSFErrorStatusCodeKey] = result->hasError() ? result->code() : SFResultCode::SFErrorGeneric;
+		error[kSFErrorMessageKey] = result->hasError() ? result->message() : QString("Unexpected response.");
+		QVariantMap response;
+		response[kSFResultSuccessKey] = false;
+		response[kSFResultErrorsKey] = QVariantList() << error;
+		for(int i = 0; i < size; i++) {
+			const QVariant & record = mRequest->records().at(offset + i);
+			response[kSFResultIdKey] = record.type() == QVariant::Map ? record.toMap().value(kSFRecordIdKey) : record;
+			mRecordResults[offset + i] = response;
+		}
+	}
+
+	mRunningChunks--;
+	if (mNextChunk < mRequest->chunkCount()) {
+		this->sendNextChunk();
+	} else if (mRunningChunks == 0) {
+		this->finish();
+	}
+}
+
+void SFCollectionTask::sendNextChunk() {
+	int index = mNextChunk++;
+	mRunningChunks++;
+	SFRestAPI::instance()->sendRestRequest(mRequest->createChunkRequest(index), this, SLOT(onChunkResultReady(sf::SFResult*)), index);
+}
+
+void SFCollectionTask::finish() {
+	int succeeded = 0;
+	for(QVector<QVariant>::const_iterator i = mRecordResults.constBegin(); i != mRecordResults.constEnd(); i++) {
+		if (i->toMap().value(kSFResultSuccessKey).toBool()) {
+			succeeded++;
+		}
+	}
+	QString summary = QString("%1 of %2 records succeeded.").arg(succeeded).arg(mRecordResults.size());
+
+	SFResult *result = NULL;
+	if (mFailedChunks == 0) {
+		result = SFResult::create();
+		result->mMessage = summary;
+	} else {
+		result = SFResult::createErrorResult(mErrorCode, QString("%1\n%2").arg(mErrorMessage, summary));
+	}
+	result->mPayload = QVariantList(mRecordResults.toList());
+	result->mTags = mTags;
+	result->setParent(this);
+
+	emit taskResultReady(result);
+	this->deleteLater();
+}
+
+} /* namespace sf */
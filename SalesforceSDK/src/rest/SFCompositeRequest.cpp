@@ -0,0 +1,83 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCompositeRequest.cpp
+*/
+
+
+#include "SFCompositeRequest.h"
+#include <QRegExp>
+#include "SFGlobal.h"
+#include "SFRestRequest.h"
+
+namespace sf {
+
+static const QString kSFAllOrNoneKey = "allOrNone";
+static const QString kSFCompositeRequestKey = "compositeRequest";
+static const QString kSFCompositeResponseKey = "compositeResponse";
+static const QString kSFReferenceIdKey = "referenceId";
+
+SFCompositeRequest::SFCompositeRequest(QObject *parent) : QObject(parent), mAllOrNone(false), mReferenceIds(), mSubrequests() {
+}
+
+SFCompositeRequest::~SFCompositeRequest() {
+}
+
+bool SFCompositeRequest::add(const QString & referenceId, SFRestRequest * request) {
+	if (!request) {
+		return false;
+	}
+	//we own the request from now on, whether it is added or not
+	request->deleteLater();
+
+	QRegExp validReferenceId("[A-Za-z][A-Za-z0-9_]*");
+	if (mSubrequests.size() >= MaxSubrequests) {
+		sfWarning() << "[SFCompositeRequest] A composite request holds at most" << MaxSubrequests << "subrequests.";
+		return false;
+	} else if (!validReferenceId.exactMatch(referenceId) || mReferenceIds.contains(referenceId)) {
+		sfWarning() << "[SFCompositeRequest] Invalid or duplicate reference id:" << referenceId;
+		return false;
+	} else if (!request->canBeBatched()) {
+		sfWarning() << "[SFCompositeRequest] The request can't be a subrequest:" << request->path();
+		return false;
+	}
+
+	mReferenceIds.append(referenceId);
+	mSubrequests.append(request->toCompositeSubrequest(referenceId));
+	return true;
+}
+
+QString SFCompositeRequest::reference(const QString & referenceId, const QString & field) {
+	return QString("@{%1.%2}").arg(referenceId, field);
+}
+
+QVariantMap SFCompositeRequest::responsesByReference(const QVariant & payload) {
+	QVariantMap responses;
+	QVariantList compositeResponse = payload.toMap().value(kSFCompositeResponseKey).toList();
+	for(QVariantList::const_iterator i = compositeResponse.constBegin(); i != compositeResponse.constEnd(); i++) {
+		QVariantMap response = i->toMap();
+		responses.insert(response.value(kSFReferenceIdKey).toString(), response);
+	}
+	return responses;
+}
+
+QVariantMap SFCompositeRequest::toRequestBody() const {
+	QVariantMap body;
+	body[kSFAllOrNoneKey] = mAllOrNone;
+	body[kSFCompositeRequestKey] = mSubrequests;
+	return body;
+}
+
+} /* namespace sf */
@@ -0,0 +1,243 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCsvStreamParser.cpp
+*/
+
+#include "SFCsvStreamParser.h"
+
+namespace sf {
+
+static const QString kSFColumnsKey = "columns";
+static const QString kSFRowsKey = "rows";
+
+/*
+ * SFCsvStreamParser
+ */
+SFCsvStreamParser::SFCsvStreamParser(SFCsvStreamHandler *handler, char delimiter) : mHandler(handler), mDelimiter(delimiter) {
+	this->reset();
+}
+
+void SFCsvStreamParser::reset() {
+	mState = FieldStart;
+	mField.clear();
+	mFields.clear();
+	mRowCount = 0;
+	mOffset = 0;
+	mError = QString();
+}
+
+bool SFCsvStreamParser::feed(const QByteArray & chunk) {
+	if (this->hasError()) {
+		return false;
+	}
+	const char *data = chunk.constData();
+	int size = chunk.size();
+	int i = 0;
+	while (i < size) {
+		char c = data[i];
+		switch (mState) {
+		case AfterCR:
+			//CRLF ends a single row
+			mState = FieldStart;
+			if (c == '\n') {
+				i++;
+			}
+			break;
+		case FieldStart:
+			if (c == '"') {
+				mState = Quoted;
+				i++;
+				break;
+			}
+			mState = Unquoted;
+			//fall through
+		case Unquoted: {
+			//copy the run of plain bytes at once
+			int begin = i;
+			while (i < size && data[i] != mDelimiter && data[i] != '\n' && data[i] != '\r' && data[i] != '"') {
+				i++;
+			}
+			mField.append(data + begin, i - begin);
+			if (i == size) {
+				break;
+			}
+			c = data[i++];
+			if (c == '"') {
+				mOffset += i;
+				return this->fail("Unexpected quote in an unquoted field");
+			}
+			this->endField();
+			if (c == mDelimiter) {
+				mState = FieldStart;
+			} else if (!this->endRow()) {
+				return false;
+			} else {
+				mState = c == '\r' ? AfterCR : FieldStart;
+			}
+			break;
+		}
+		case Quoted: {
+			int begin = i;
+			while (i < size && data[i] != '"') {
+				i++;
+			}
+			mField.append(data + begin, i - begin);
+			if (i < size) {
+				mState = QuoteInQuoted;
+				i++;
+			}
+			break;
+		}
+		case QuoteInQuoted:
+			if (c == '"') {
+				//an escaped quote
+				mField.append('"');
+				mState = Quoted;
+				i++;
+				break;
+			}
+			i++;
+			this->endField();
+			if (c == mDelimiter) {
+				mState = FieldStart;
+			} else if (c == '\n' || c == '\r') {
+				if (!this->endRow()) {
+					return false;
+				}
+				mState = c == '\r' ? AfterCR : FieldStart;
+			} else {
+				mOffset += i;
+				return this->fail("Unexpected character after a quoted field");
+			}
+			break;
+		}
+	}
+	mOffset += size;
+	return true;
+}
+
+bool SFCsvStreamParser::finish() {
+	if (this->hasError()) {
+		return false;
+	}
+	switch (mState) {
+	case Quoted:
+		return this->fail("Unterminated quoted field");
+	case Unquoted:
+	case QuoteInQuoted:
+		this->endField();
+		return this->endRow();
+	default:
+		//a delimiter right before the end leaves an empty last field
+		if (!mFields.isEmpty()) {
+			this->endField();
+			return this->endRow();
+		}
+		return true;
+	}
+}
+
+void SFCsvStreamParser::endField() {
+	mFields.append(QString::fromUtf8(mField.constData(), mField.size()));
+	mField.clear();
+}
+
+bool SFCsvStreamParser::endRow() {
+	//an empty line holds a single empty unquoted field
+	if (mFields.size() == 1 && mFields.at(0).isEmpty() && mState != QuoteInQuoted) {
+		mFields.clear();
+		return true;
+	}
+	QStringList fields = mFields;
+	mFields.clear();
+	mRowCount++;
+	if (!mHandler->row(fields)) {
+		return this->fail("Stopped by the handler");
+	}
+	return true;
+}
+
+bool SFCsvStreamParser::fail(const QString & message) {
+	mError = QString("%1 at offset %2, row %3").arg(message).arg(mOffset).arg(mRowCount + 1);
+	return false;
+}
+
+/*
+ * SFCsvRecordsConsumer
+ */
+SFCsvRecordsConsumer::SFCsvRecordsConsumer() : mParser(this), mRowCount(0) {
+}
+
+SFCsvRecordsConsumer::~SFCsvRecordsConsumer() {
+}
+
+bool SFCsvRecordsConsumer::begin(int statusCode, const QByteArray & contentType) {
+	Q_UNUSED(statusCode);
+	Q_UNUSED(contentType);
+	mParser.reset();
+	mColumns.clear();
+	mRows.clear();
+	mRowCount = 0;
+	mError = QString();
+	return true;
+}
+
+bool SFCsvRecordsConsumer::consume(const QByteArray & chunk) {
+	if (!mParser.feed(chunk)) {
+		mError = mError.isNull() ? mParser.errorString() : mError;
+		return false;
+	}
+	return true;
+}
+
+bool SFCsvRecordsConsumer::finish() {
+	if (!mParser.finish()) {
+		mError = mError.isNull() ? mParser.errorString() : mError;
+		return false;
+	}
+	return true;
+}
+
+QVariant SFCsvRecordsConsumer::result() const {
+	QVariantMap result;
+	result[kSFColumnsKey] = mColumns;
+	result[kSFRowsKey] = mRows;
+	return result;
+}
+
+QString SFCsvRecordsConsumer::errorString() const {
+	return mError;
+}
+
+bool SFCsvRecordsConsumer::processRow(int index, const QStringList & fields) {
+	Q_UNUSED(index);
+	mRows.append(fields);
+	return true;
+}
+
+bool SFCsvRecordsConsumer::row(const QStringList & fields) {
+	if (mColumns.isEmpty()) {
+		mColumns = fields;
+		return true;
+	}
+	if (fields.size() != mColumns.size()) {
+		mError = QString("Row %1 has %2 fields, expected %3").arg(mRowCount + 1).arg(fields.size()).arg(mColumns.size());
+		return false;
+	}
+	return this->processRow(mRowCount++, fields);
+}
+
+} /* namespace sf */
@@ -0,0 +1,106 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCsvWriter.cpp
+*/
+
+#include "SFCsvWriter.h"
+#include <QDateTime>
+
+namespace sf {
+
+static const int kSFCsvFlushThreshold = 64 * 1024; //rows are handed to the device in chunks of about this size
+
+SFCsvWriter::SFCsvWriter(QIODevice * device, char delimiter) : mDevice(device), mDelimiter(delimiter), mBuffer(), mRowCount(0) {
+	mBuffer.reserve(kSFCsvFlushThreshold + 1024);
+}
+
+SFCsvWriter::~SFCsvWriter() {
+}
+
+bool SFCsvWriter::writeRow(const QStringList & fields) {
+	for (int i = 0; i < fields.size(); i++) {
+		if (i > 0) {
+			mBuffer.append(mDelimiter);
+		}
+		this->appendField(fields.at(i));
+	}
+	return this->endRow();
+}
+
+bool SFCsvWriter::writeRow(const QVariantList & values) {
+	for (int i = 0; i < values.size(); i++) {
+		if (i > 0) {
+			mBuffer.append(mDelimiter);
+		}
+		this->appendField(toField(values.at(i)));
+	}
+	return this->endRow();
+}
+
+bool SFCsvWriter::flush() {
+	if (mBuffer.isEmpty()) {
+		return true;
+	}
+	bool written = mDevice && mDevice->write(mBuffer) == mBuffer.size();
+	mBuffer.clear();
+	return written;
+}
+
+QString SFCsvWriter::toField(const QVariant & value) {
+	if (value.isNull()) {
+		return QString();
+	}
+	switch (value.type()) {
+	case QVariant::Bool:
+		return value.toBool() ? "true" : "false";
+	case QVariant::Date:
+		return value.toDate().toString("yyyy-MM-dd");
+	case QVariant::DateTime:
+		return value.toDateTime().toUTC().toString("yyyy-MM-ddThh:mm:ss.zzzZ");
+	case QVariant::Double: {
+		//the shortest text that reads the same number back, 17 digits are always enough
+		double number = value.toDouble();
+		QString text = QString::number(number, 'g', 15);
+		return text.toDouble() == number ? text : QString::number(number, 'g', 17);
+	}
+	default:
+		return value.toString();
+	}
+}
+
+void SFCsvWriter::appendField(const QString & field) {
+	QByteArray utf8 = field.toUtf8();
+	bool quote = false;
+	for (int i = 0; i < utf8.size() && !quote; i++) {
+		char c = utf8.at(i);
+		quote = c == mDelimiter || c == '"' || c == '\n' || c == '\r';
+	}
+	if (!quote) {
+		mBuffer.append(utf8);
+		return;
+	}
+	mBuffer.append('"');
+	mBuffer.append(utf8.replace('"', "\"\""));
+	mBuffer.append('"');
+}
+
+bool SFCsvWriter::endRow() {
+	mBuffer.append('\n');
+	mRowCount++;
+	return mBuffer.size() < kSFCsvFlushThreshold || this->flush();
+}
+
+} /* namespace sf */
@@ -0,0 +1,408 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFDescribeCache.cpp
+*/
+
+#include "SFDescribeCache.h"
+#include <cstring>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QUrl>
+#include <QtConcurrentRun>
+#include "SFAuthenticationManager.h"
+#include "SFGlobal.h"
+#include "SFOAuthCredentials.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFResult.h"
+#include "SFSecurityManager.h"
+
+namespace sf {
+
+QAtomicPointer<SFDescribeCache> SFDescribeCache::sharedInstance;
+static QMutex sInstanceLock;
+
+static const QString kSFDescribeCacheDir = "sf_describe_cache";
+static const QByteArray kSFDescribeFileMagic = "SFDC";
+static const char kSFDescribeFileVersion = 1;
+static const int kSFDescribeHeaderSize = 7; //magic, version and the length of the date
+static const QString kSFGlobalPath = "/sobjects";
+static const QString kSFMetadataPath = "/sobjects/%1";
+static const QString kSFDescribePath = "/sobjects/%1/describe";
+static const QString kSFDescribeSuffix = "/describe";
+static const QString kSFIfModifiedSinceHeader = "If-Modified-Since";
+static const QString kSFLastModifiedHeader = "Last-Modified";
+static const QString kSFDateHeader = "Date";
+static const QString kSFGenerationKey = "generation";
+static const QString kSFPathKey = "path";
+
+//writes run in the global thread pool, they are serialized, and the ones queued before a clear() are dropped
+static QMutex sWriteLock;
+static int sWriteGeneration = 0;
+
+/* runs in a pool thread */
+static void writeDocument(const QString & fileName, const QString & lastModified, const QVariantMap & content, int generation) {
+	QByteArray clearData;
+	QDataStream out(&clearData, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_4_8);
+	out << content;
+	QByteArray envelope = SFSecurityManager::instance()->encryptData(clearData);
+	if (envelope.isEmpty()) {
+		sfWarning() << "[SFDescribeCache] unable to encrypt" << fileName;
+		return;
+	}
+
+	QByteArray date = lastModified.toLatin1();
+	QByteArray header = kSFDescribeFileMagic;
+	header.append(kSFDescribeFileVersion);
+	header.append(char((date.size() >> 8) & 0xFF));
+	header.append(char(date.size() & 0xFF));
+	header.append(date);
+
+	QMutexLocker locker(&sWriteLock);
+	if (generation != sWriteGeneration) {
+		return;
+	}
+	QDir().mkpath(QFileInfo(fileName).absolutePath());
+	//write to a temporary file first so that a crash never leaves a half-written document behind
+	QString tempName = fileName + ".tmp";
+	QFile file(tempName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		sfWarning() << "[SFDescribeCache] unable to write" << tempName;
+		return;
+	}
+	bool written = file.write(header) == header.size() && file.write(envelope) == envelope.size();
+	file.close();
+	if (!written) {
+		sfWarning() << "[SFDescribeCache] unable to write" << tempName;
+		file.remove();
+		return;
+	}
+	QFile::remove(fileName);
+	QFile::rename(tempName, fileName);
+}
+
+/* @return the size of the header, or 0 if the data isn't a document of this version */
+static int readHeader(const uchar * data, qint64 size, QString * lastModified) {
+	if (size < kSFDescribeHeaderSize || memcmp(data, kSFDescribeFileMagic.constData(), 4) != 0 || data[4] != kSFDescribeFileVersion) {
+		return 0;
+	}
+	int length = (data[5] << 8) | data[6];
+	if (size < kSFDescribeHeaderSize + length) {
+		return 0;
+	}
+	*lastModified = QString::fromLatin1(reinterpret_cast<const char*>(data) + kSFDescribeHeaderSize, length);
+	return kSFDescribeHeaderSize + length;
+}
+
+SFDescribeCache* SFDescribeCache::instance() {
+	SFDescribeCache *instance = sharedInstance.fetchAndAddAcquire(0);
+	if (!instance) {
+		QMutexLocker locker(&sInstanceLock);
+		instance = sharedInstance.fetchAndAddAcquire(0);
+		if (!instance) {
+			instance = new SFDescribeCache();
+			sharedInstance.fetchAndStoreRelease(instance);
+		}
+	}
+	return instance;
+}
+
+SFDescribeCache::SFDescribeCache() : QObject(0), mEntries(32), mScope(), mValidated(), mPending(), mWarmUpObjects(),
+		mWarmedUp(false), mGeneration(0) {
+	connect(SFAuthenticationManager::instance(), SIGNAL(SFOAuthFlowSuccess(SFOAuthInfo*)), this, SLOT(onSFOAuthFlowSuccess(SFOAuthInfo*)));
+	connect(SFAuthenticationManager::instance(), SIGNAL(SFUserLoggedOut()), this, SLOT(onSFUserLoggedOut()));
+}
+
+SFDescribeCache::~SFDescribeCache() {
+}
+
+/*
+ * Public
+ */
+QVariantMap SFDescribeCache::describeGlobal() {
+	return this->lookup(Global, QString());
+}
+
+QVariantMap SFDescribeCache::metadata(const QString & objectType) {
+	return this->lookup(Metadata, objectType);
+}
+
+QVariantMap SFDescribeCache::describe(const QString & objectType) {
+	return this->lookup(Describe, objectType);
+}
+
+void SFDescribeCache::refresh(Kind kind, const QString & objectType) {
+	mValidated.remove(pathFor(kind, objectType));
+	this->revalidate(kind, objectType, false);
+}
+
+void SFDescribeCache::clear() {
+	mGeneration++;
+	mEntries.clear();
+	mValidated.clear();
+	mPending.clear();
+	mScope.clear();
+
+	QMutexLocker locker(&sWriteLock);
+	sWriteGeneration++;
+	QDir root(QDir::home().absoluteFilePath(kSFDescribeCacheDir));
+	QStringList scopes = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	for (int i = 0; i < scopes.size(); i++) {
+		QDir scope(root.absoluteFilePath(scopes.at(i)));
+		QStringList files = scope.entryList(QDir::Files);
+		for (int j = 0; j < files.size(); j++) {
+			scope.remove(files.at(j));
+		}
+		root.rmdir(scopes.at(i));
+	}
+}
+
+void SFDescribeCache::warmUp() {
+	QString scope = this->currentScope();
+	if (scope.isEmpty()) {
+		return;
+	}
+	this->revalidate(Global, QString(), true);
+	//the dates are in the clear headers of the files, the documents stay on disk until they are used
+	QStringList files = QDir(this->scopeDirectory(scope)).entryList(QDir::Files);
+	for (int i = 0; i < files.size(); i++) {
+		Kind kind;
+		QString objectType;
+		if (kindFor(QUrl::fromPercentEncoding(files.at(i).toLatin1()), &kind, &objectType) && kind != Global) {
+			this->revalidate(kind, objectType, true);
+		}
+	}
+	for (int i = 0; i < mWarmUpObjects.size(); i++) {
+		this->revalidate(Describe, mWarmUpObjects.at(i), true);
+	}
+}
+
+/*
+ * Private slots
+ */
+void SFDescribeCache::onSFOAuthFlowSuccess(SFOAuthInfo*) {
+	//the flow also succeeds when the token is refreshed, only the first login of a session warms the cache up
+	if (!mWarmedUp) {
+		mWarmedUp = true;
+		this->warmUp();
+	}
+}
+
+void SFDescribeCache::onSFUserLoggedOut() {
+	mWarmedUp = false;
+	this->clear();
+}
+
+void SFDescribeCache::onResultReady(SFResult* result) {
+	QVariantMap tag = result->getTag<QVariantMap>(kSFRestRequestTag);
+	if (tag.value(kSFGenerationKey).toInt() != mGeneration) {
+		return;
+	}
+	QString path = tag.value(kSFPathKey).toString();
+	mPending.remove(path);
+	Kind kind;
+	QString objectType;
+	kindFor(path, &kind, &objectType);
+	if (result->code() == SFResultCode::SFRestStatusNoChanges) {
+		mValidated.insert(path);
+		return;
+	}
+	if (result->hasError()) {
+		emit failed(kind, objectType, result->code(), result->message());
+		return;
+	}
+
+	QVariantMap headers = result->getTag<QVariantMap>(kSFResponseHeadersTag);
+	QString lastModified = headers.value(kSFLastModifiedHeader, headers.value(kSFDateHeader)).toString();
+	QString scope = this->currentScope();
+	Entry *entry = new Entry();
+	entry->content = result->payload<QVariantMap>();
+	entry->lastModified = lastModified;
+	mValidated.insert(path);
+	if (scope != mScope) {
+		//another org or version, the decoded documents are of no use anymore
+		mEntries.clear();
+		mScope = scope;
+	}
+	QVariantMap content = entry->content;
+	mEntries.insert(path, entry);
+	if (!scope.isEmpty()) {
+		QtConcurrent::run(writeDocument, this->filePath(scope, path), lastModified, content, sWriteGeneration);
+	}
+	emit updated(kind, objectType, content);
+}
+
+/*
+ * Private
+ */
+QVariantMap SFDescribeCache::lookup(Kind kind, const QString & objectType) {
+	if (kind != Global && objectType.isEmpty()) {
+		return QVariantMap();
+	}
+	QString path = pathFor(kind, objectType);
+	Entry *entry = this->load(path);
+	this->revalidate(kind, objectType, false);
+	return entry ? entry->content : QVariantMap();
+}
+
+void SFDescribeCache::revalidate(Kind kind, const QString & objectType, bool background) {
+	QString path = pathFor(kind, objectType);
+	if (mValidated.contains(path) || mPending.contains(path)) {
+		return;
+	}
+	SFRestAPI *api = SFRestAPI::instance();
+	SFRestRequest *request = NULL;
+	switch (kind) {
+	case Global:
+		request = api->requestForDescribeGlobal();
+		break;
+	case Metadata:
+		request = api->requestForMetadata(objectType);
+		break;
+	default:
+		request = api->requestForDescribeObject(objectType);
+		break;
+	}
+
+	//only the date is needed, a document that isn't decoded yet stays on disk
+	QString lastModified;
+	Entry *entry = this->currentScope() == mScope ? mEntries.object(path) : NULL;
+	if (entry) {
+		lastModified = entry->lastModified;
+	} else {
+		QString scope = this->currentScope();
+		QFile file(scope.isEmpty() ? QString() : this->filePath(scope, path));
+		if (file.open(QIODevice::ReadOnly)) {
+			QByteArray header = file.read(kSFDescribeHeaderSize + 0xFFFF);
+			readHeader(reinterpret_cast<const uchar*>(header.constData()), header.size(), &lastModified);
+		}
+	}
+	if (!lastModified.isEmpty()) {
+		QVariantMap headers;
+		headers[kSFIfModifiedSinceHeader] = lastModified;
+		request->setRequestRawHeaders(headers);
+	}
+	request->setCapturedResponseHeaders(QStringList() << kSFLastModifiedHeader << kSFDateHeader);
+	request->setJsonParser(SFRestRequest::JsonParserIndexed);
+	request->setPriority(background ? SFRequestPriority::BackgroundSync : SFRequestPriority::Prefetch);
+
+	mPending.insert(path);
+	QVariantMap tag;
+	tag[kSFGenerationKey] = mGeneration;
+	tag[kSFPathKey] = path;
+	api->sendRestRequest(request, this, SLOT(onResultReady(sf::SFResult*)), tag);
+}
+
+SFDescribeCache::Entry * SFDescribeCache::load(const QString & path) {
+	QString scope = this->currentScope();
+	if (scope != mScope) {
+		//another org or version, the decoded documents are of no use anymore
+		mEntries.clear();
+		mScope = scope;
+	}
+	Entry *entry = mEntries.object(path);
+	if (entry || scope.isEmpty()) {
+		return entry;
+	}
+
+	QFile file(this->filePath(scope, path));
+	if (!file.open(QIODevice::ReadOnly)) {
+		return NULL;
+	}
+	//the whole envelope is decrypted anyway, so the file is read in one go
+	QByteArray data = file.readAll();
+	file.close();
+	QString lastModified;
+	int headerSize = readHeader(reinterpret_cast<const uchar*>(data.constData()), data.size(), &lastModified);
+	QByteArray clearData;
+	if (headerSize > 0) {
+		clearData = SFSecurityManager::instance()->decryptData(QByteArray::fromRawData(data.constData() + headerSize, data.size() - headerSize));
+	}
+	data.clear();
+
+	QVariantMap content;
+	QDataStream in(clearData);
+	in.setVersion(QDataStream::Qt_4_8);
+	in >> content;
+	if (clearData.isNull() || in.status() != QDataStream::Ok) {
+		//written by another version, with another key, or damaged
+		sfWarning() << "[SFDescribeCache] dropping unreadable document" << path;
+		file.remove();
+		return NULL;
+	}
+	entry = new Entry();
+	entry->content = content;
+	entry->lastModified = lastModified;
+	mEntries.insert(path, entry);
+	return entry;
+}
+
+QString SFDescribeCache::currentScope() const {
+	const SFOAuthCredentials *credentials = SFRestAPI::instance()->currentCredentials();
+	if (!credentials) {
+		return QString();
+	}
+	//the identity URL is https://login.salesforce.com/id/<org id>/<user id>
+	QStringList segments = credentials->getIdentityUrl().path().split('/', QString::SkipEmptyParts);
+	QString org = segments.size() >= 3 ? segments.at(1) : credentials->getInstanceUrl().host();
+	if (org.isEmpty()) {
+		return QString();
+	}
+	return org + "\n" + SFRestAPI::instance()->apiVersion();
+}
+
+QString SFDescribeCache::scopeDirectory(const QString & scope) const {
+	QByteArray name = QCryptographicHash::hash(scope.toUtf8(), QCryptographicHash::Sha1).toHex();
+	return QDir::home().absoluteFilePath(QString("%1/%2").arg(kSFDescribeCacheDir, QString::fromLatin1(name)));
+}
+
+QString SFDescribeCache::filePath(const QString & scope, const QString & path) const {
+	return QDir(this->scopeDirectory(scope)).absoluteFilePath(QString::fromLatin1(QUrl::toPercentEncoding(path)));
+}
+
+QString SFDescribeCache::pathFor(Kind kind, const QString & objectType) {
+	switch (kind) {
+	case Global:
+		return kSFGlobalPath;
+	case Metadata:
+		return kSFMetadataPath.arg(objectType);
+	default:
+		return kSFDescribePath.arg(objectType);
+	}
+}
+
+bool SFDescribeCache::kindFor(const QString & path, Kind * kind, QString * objectType) {
+	if (path == kSFGlobalPath) {
+		*kind = Global;
+		objectType->clear();
+		return true;
+	}
+	if (!path.startsWith(kSFGlobalPath + "/")) {
+		return false;
+	}
+	QString rest = path.mid(kSFGlobalPath.size() + 1);
+	*kind = rest.endsWith(kSFDescribeSuffix) ? Describe : Metadata;
+	*objectType = *kind == Describe ? rest.left(rest.size() - kSFDescribeSuffix.size()) : rest;
+	return !objectType->isEmpty() && !objectType->contains('/');
+}
+
+} /* namespace sf */
@@ -0,0 +1,553 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonIndexParser.cpp
+*/
+
+#include "SFJsonIndexParser.h"
+#include <QtConcurrentMap>
+#include <QThread>
+#include <QPair>
+#include <cstring>
+#include "SFStringPool.h"
+
+namespace sf {
+
+static const int kSFParallelRecordThreshold = 256; //below that, spreading the records over threads costs more than it saves
+static const int kSFMinRecordsPerRange = 64;
+static const char kSFRecordAttributesKey[] = "attributes";
+static const quint64 kSFOnes = Q_UINT64_C(0x0101010101010101);
+static const quint64 kSFHighBits = Q_UINT64_C(0x8080808080808080);
+
+/* whether any of the eight bytes of the word is c */
+static inline bool hasByte(quint64 word, char c) {
+	quint64 x = word ^ (kSFOnes * static_cast<uchar>(c));
+	return ((x - kSFOnes) & ~x & kSFHighBits) != 0;
+}
+
+static inline bool isDelimiter(char c) {
+	switch (c) {
+	case ' ': case '\t': case '\n': case '\r':
+	case ',': case ':': case '[': case ']': case '{': case '}': case '"':
+		return true;
+	default:
+		return false;
+	}
+}
+
+static inline int hexDigit(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+static void appendUtf8(QByteArray & bytes, uint codePoint) {
+	if (codePoint < 0x80) {
+		bytes.append(static_cast<char>(codePoint));
+	} else if (codePoint < 0x800) {
+		bytes.append(static_cast<char>(0xC0 | (codePoint >> 6)));
+		bytes.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	} else if (codePoint < 0x10000) {
+		bytes.append(static_cast<char>(0xE0 | (codePoint >> 12)));
+		bytes.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		bytes.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	} else {
+		bytes.append(static_cast<char>(0xF0 | (codePoint >> 18)));
+		bytes.append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+		bytes.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		bytes.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+}
+
+/* materializes a range of the records array in a QtConcurrent worker */
+struct SFJsonIndexRange {
+	bool valid;
+	QVariantList records;
+};
+
+class SFJsonIndexRangeMaterializer {
+public:
+	typedef SFJsonIndexRange result_type;
+
+	SFJsonIndexRangeMaterializer(const SFJsonIndexParser *parser, const QVector<int> *starts, const SFStringPool *seed)
+	: mParser(parser), mStarts(starts), mSeed(seed) {}
+
+	SFJsonIndexRange operator()(const QPair<int, int> & range) const {
+		//pools aren't thread safe, so each range has its own copy of the seed, which holds the keys of the first record
+		//and is only read while the ranges are materialized. The keys of all ranges then share the same strings.
+		SFStringPool keys(*mSeed);
+		SFJsonIndexParser::ValueContext context = {&keys, mParser->mStripAttributes};
+		SFJsonIndexRange result;
+		result.valid = true;
+		for (int k = range.first; k < range.second && result.valid; k++) {
+			int i = mStarts->at(k);
+			QVariant record;
+			result.valid = mParser->valueAt(i, &record, context);
+			result.records.append(record);
+		}
+		return result;
+	}
+
+private:
+	const SFJsonIndexParser *mParser;
+	const QVector<int> *mStarts;
+	const SFStringPool *mSeed;
+};
+
+SFJsonIndexParser::SFJsonIndexParser(const QByteArray & json) : mJson(json), mData(mJson.constData()), mSize(mJson.size()), mParallelAt(-1), mStripAttributes(false) {
+}
+
+bool SFJsonIndexParser::parse(const QString & recordsKey) {
+	mResult = QVariant();
+	mError = QString();
+	if (!this->buildIndex()) {
+		return false;
+	}
+	if (mIndex.isEmpty()) {
+		return this->fail("Empty document", mSize);
+	}
+
+	//look for the records array among the keys of the top level object
+	mParallelAt = -1;
+	if (this->charAt(0) == '{') {
+		int i = 1;
+		while (this->charAt(i) == '"' && this->charAt(i + 1) == ':') {
+			QString key;
+			if (this->stringAt(i, &key) && key == recordsKey && this->charAt(i + 2) == '[') {
+				mParallelAt = i + 2;
+				break;
+			}
+			i = this->skip(i + 2);
+			if (this->charAt(i) != ',') {
+				break;
+			}
+			i++;
+		}
+	}
+
+	SFStringPool keys;
+	ValueContext context = {&keys, false};
+	int i = 0;
+	QVariant document;
+	if (!this->valueAt(i, &document, context)) {
+		return this->fail("Malformed document", i < mIndex.size() ? mIndex.at(i) : mSize);
+	}
+	if (i != mIndex.size()) {
+		return this->fail("Unexpected data after the document", mIndex.at(i));
+	}
+	mResult = document;
+	return true;
+}
+
+/*
+ * Private
+ */
+bool SFJsonIndexParser::buildIndex() {
+	mIndex.clear();
+	mMatch.clear();
+	mIndex.reserve(mSize / 8);
+	mMatch.reserve(mSize / 8);
+	QVector<int> open;
+
+	int i = 0;
+	while (i < mSize) {
+		char c = mData[i];
+		switch (c) {
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+			i++;
+			continue;
+
+		case '"':
+			mIndex.append(i);
+			mMatch.append(-1);
+			i++;
+			//skip the string, eight bytes at a time while there is no quote or backslash
+			forever {
+				while (i + 8 <= mSize) {
+					quint64 word;
+					memcpy(&word, mData + i, sizeof(word));
+					if (hasByte(word, '"') || hasByte(word, '\\')) {
+						break;
+					}
+					i += 8;
+				}
+				while (i < mSize && mData[i] != '"' && mData[i] != '\\') {
+					i++;
+				}
+				if (i >= mSize) {
+					return this->fail("Unterminated string", mIndex.last());
+				}
+				if (mData[i] == '\\') {
+					i += 2;
+					continue;
+				}
+				i++;
+				break;
+			}
+			continue;
+
+		case '{':
+		case '[':
+			open.append(mIndex.size());
+			mIndex.append(i);
+			mMatch.append(-1);
+			break;
+
+		case '}':
+		case ']':
+			if (open.isEmpty() || mData[mIndex.at(open.last())] != (c == '}' ? '{' : '[')) {
+				return this->fail("Mismatched brackets", i);
+			}
+			mMatch[open.last()] = mIndex.size();
+			open.remove(open.size() - 1);
+			mIndex.append(i);
+			mMatch.append(-1);
+			break;
+
+		case ',':
+		case ':':
+			mIndex.append(i);
+			mMatch.append(-1);
+			break;
+
+		default:
+			//number or literal, only its first byte is indexed
+			mIndex.append(i);
+			mMatch.append(-1);
+			while (i < mSize && !isDelimiter(mData[i])) {
+				i++;
+			}
+			continue;
+		}
+		i++;
+	}
+
+	if (!open.isEmpty()) {
+		return this->fail("Unterminated container", mIndex.at(open.last()));
+	}
+	return true;
+}
+
+bool SFJsonIndexParser::parseRecords(int arrayIndex, QVariantList * records) const {
+	//the index tells where every element ends, so the elements can be found without decoding them
+	QVector<int> starts;
+	int i = arrayIndex + 1;
+	if (this->charAt(i) != ']') {
+		forever {
+			starts.append(i);
+			i = this->skip(i);
+			if (this->charAt(i) == ']') {
+				break;
+			}
+			if (this->charAt(i) != ',') {
+				return false;
+			}
+			i++;
+		}
+	}
+
+	int count = starts.size();
+	if (count < kSFParallelRecordThreshold) {
+		SFStringPool keys;
+		ValueContext context = {&keys, mStripAttributes};
+		for (int k = 0; k < count; k++) {
+			int j = starts.at(k);
+			QVariant record;
+			if (!this->valueAt(j, &record, context)) {
+				return false;
+			}
+			records->append(record);
+		}
+		return true;
+	}
+
+	//the first record seeds the keys shared by all ranges
+	SFStringPool seed;
+	ValueContext context = {&seed, mStripAttributes};
+	int j = starts.first();
+	QVariant firstRecord;
+	if (!this->valueAt(j, &firstRecord, context)) {
+		return false;
+	}
+	records->reserve(count);
+	records->append(firstRecord);
+
+	int perRange = qMax(kSFMinRecordsPerRange, count / (qMax(1, QThread::idealThreadCount()) * 4));
+	QList<QPair<int, int> > ranges;
+	for (int first = 1; first < count; first += perRange) {
+		ranges.append(qMakePair(first, qMin(count, first + perRange)));
+	}
+	QList<SFJsonIndexRange> results = QtConcurrent::blockingMapped<QList<SFJsonIndexRange> >(ranges, SFJsonIndexRangeMaterializer(this, &starts, &seed));
+	for (QList<SFJsonIndexRange>::const_iterator r = results.constBegin(); r != results.constEnd(); r++) {
+		if (!r->valid) {
+			return false;
+		}
+		records->append(r->records);
+	}
+	return true;
+}
+
+bool SFJsonIndexParser::valueAt(int & i, QVariant * value, const ValueContext & context) const {
+	switch (this->charAt(i)) {
+	case '{': {
+		QVariantMap map;
+		i++;
+		if (this->charAt(i) == '}') {
+			i++;
+			*value = map;
+			return true;
+		}
+		forever {
+			QString key;
+			if (this->charAt(i) != '"' || !this->keyAt(i, &key, context.keys) || this->charAt(i + 1) != ':') {
+				return false;
+			}
+			i += 2;
+			if (context.stripAttributes && key == kSFRecordAttributesKey) {
+				i = this->skip(i);
+			} else {
+				QVariant member;
+				if (!this->valueAt(i, &member, context)) {
+					return false;
+				}
+				map.insert(key, member);
+			}
+			char next = this->charAt(i++);
+			if (next == '}') {
+				break;
+			} else if (next != ',') {
+				return false;
+			}
+		}
+		*value = map;
+		return true;
+	}
+
+	case '[': {
+		QVariantList list;
+		if (i == mParallelAt) {
+			if (!this->parseRecords(i, &list)) {
+				return false;
+			}
+			i = this->skip(i);
+			*value = list;
+			return true;
+		}
+		i++;
+		if (this->charAt(i) == ']') {
+			i++;
+			*value = list;
+			return true;
+		}
+		forever {
+			QVariant element;
+			if (!this->valueAt(i, &element, context)) {
+				return false;
+			}
+			list.append(element);
+			char next = this->charAt(i++);
+			if (next == ']') {
+				break;
+			} else if (next != ',') {
+				return false;
+			}
+		}
+		*value = list;
+		return true;
+	}
+
+	case '"': {
+		QString string;
+		if (!this->stringAt(i, &string)) {
+			return false;
+		}
+		i++;
+		*value = string;
+		return true;
+	}
+
+	case '}':
+	case ']':
+	case ',':
+	case ':':
+	case '\0':
+		return false;
+
+	default:
+		if (!this->scalarAt(i, value)) {
+			return false;
+		}
+		i++;
+		return true;
+	}
+}
+
+bool SFJsonIndexParser::stringAt(int i, QString * string) const {
+	const char *p = mData + mIndex.at(i) + 1;
+	const char *end = mData + mSize;
+	const char *run = p;
+	while (p < end && *p != '"' && *p != '\\') {
+		p++;
+	}
+	if (p >= end) {
+		return false;
+	}
+	if (*p == '"') {
+		//common case, nothing to unescape
+		*string = QString::fromUtf8(run, p - run);
+		return true;
+	}
+
+	QByteArray bytes(run, p - run);
+	uint highSurrogate = 0;
+	while (p < end) {
+		char c = *p++;
+		if (c == '"') {
+			if (highSurrogate) {
+				appendUtf8(bytes, 0xFFFD);
+			}
+			*string = QString::fromUtf8(bytes.constData(), bytes.size());
+			return true;
+		}
+		uint codePoint = static_cast<uchar>(c);
+		bool isMultiByte = false;
+		if (c == '\\') {
+			if (p >= end) {
+				return false;
+			}
+			switch (*p++) {
+			case '"': codePoint = '"'; break;
+			case '\\': codePoint = '\\'; break;
+			case '/': codePoint = '/'; break;
+			case 'b': codePoint = '\b'; break;
+			case 'f': codePoint = '\f'; break;
+			case 'n': codePoint = '\n'; break;
+			case 'r': codePoint = '\r'; break;
+			case 't': codePoint = '\t'; break;
+			case 'u': {
+				if (end - p < 4) {
+					return false;
+				}
+				codePoint = 0;
+				for (int k = 0; k < 4; k++) {
+					int digit = hexDigit(*p++);
+					if (digit < 0) {
+						return false;
+					}
+					codePoint = codePoint * 16 + digit;
+				}
+				isMultiByte = true;
+				break;
+			}
+			default:
+				return false;
+			}
+		}
+
+		if (isMultiByte && codePoint >= 0xD800 && codePoint < 0xDC00) {
+			if (highSurrogate) {
+				appendUtf8(bytes, 0xFFFD);
+			}
+			highSurrogate = codePoint;
+			continue;
+		}
+		if (isMultiByte && codePoint >= 0xDC00 && codePoint < 0xE000) {
+			codePoint = highSurrogate ? 0x10000 + ((highSurrogate - 0xD800) << 10) + (codePoint - 0xDC00) : 0xFFFD;
+		} else if (highSurrogate) {
+			appendUtf8(bytes, 0xFFFD);
+		}
+		highSurrogate = 0;
+		if (isMultiByte) {
+			appendUtf8(bytes, codePoint);
+		} else {
+			//plain bytes of a UTF-8 sequence are copied as they are
+			bytes.append(static_cast<char>(codePoint));
+		}
+	}
+	return false;
+}
+
+bool SFJsonIndexParser::keyAt(int i, QString * key, SFStringPool * keys) const {
+	if (keys) {
+		const char *begin = mData + mIndex.at(i) + 1;
+		const char *end = mData + mSize;
+		const char *p = begin;
+		while (p < end && *p != '"' && *p != '\\') {
+			p++;
+		}
+		if (p < end && *p == '"') {
+			*key = keys->intern(begin, p - begin);
+			return true;
+		}
+	}
+	//keys with escape sequences are rare enough not to intern them
+	return this->stringAt(i, key);
+}
+
+bool SFJsonIndexParser::scalarAt(int i, QVariant * value) const {
+	int begin = mIndex.at(i);
+	int end = begin;
+	while (end < mSize && !isDelimiter(mData[end])) {
+		end++;
+	}
+	QByteArray token = QByteArray::fromRawData(mData + begin, end - begin);
+
+	char first = token.at(0);
+	if (first == '-' || (first >= '0' && first <= '9')) {
+		bool ok = false;
+		if (token.indexOf('.') < 0 && token.indexOf('e') < 0 && token.indexOf('E') < 0) {
+			qlonglong integer = token.toLongLong(&ok);
+			if (ok) {
+				*value = integer;
+				return true;
+			}
+		}
+		double number = token.toDouble(&ok);
+		if (ok) {
+			*value = number;
+		}
+		return ok;
+	}
+	if (token == "true") {
+		*value = true;
+	} else if (token == "false") {
+		*value = false;
+	} else if (token == "null") {
+		*value = QVariant();
+	} else {
+		return false;
+	}
+	return true;
+}
+
+int SFJsonIndexParser::skip(int i) const {
+	char c = this->charAt(i);
+	return (c == '{' || c == '[') ? mMatch.at(i) + 1 : i + 1;
+}
+
+bool SFJsonIndexParser::fail(const QString & message, int offset) {
+	mError = QString("%1 at offset %2").arg(message).arg(offset);
+	return false;
+}
+
+} /* namespace sf */
@@ -0,0 +1,723 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonStreamParser.cpp
+*/
+
+#include "SFJsonStreamParser.h"
+
+namespace sf {
+
+static const uint kSFReplacementCharacter = 0xFFFD;
+
+static inline int hexDigit(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+static const QString kSFRecordAttributesKey = "attributes";
+
+static inline bool isNumberChar(char c) {
+	return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+/*
+ * SFJsonScalar
+ */
+const QByteArray & SFJsonScalar::utf8() const {
+	static const QByteArray kSFEmpty;
+	return mType == String ? *mUtf8 : kSFEmpty;
+}
+
+bool SFJsonScalar::toBool() const {
+	switch (mType) {
+	case Bool:
+	case Integer:
+		return mInteger != 0;
+	case Double:
+		return mDouble != 0;
+	case String:
+		return !mUtf8->isEmpty() && *mUtf8 != "0" && *mUtf8 != "false";
+	default:
+		return false;
+	}
+}
+
+qlonglong SFJsonScalar::toLongLong() const {
+	switch (mType) {
+	case Bool:
+	case Integer:
+		return mInteger;
+	case Double:
+		return qRound64(mDouble);
+	case String:
+		return mUtf8->toLongLong();
+	default:
+		return 0;
+	}
+}
+
+double SFJsonScalar::toDouble() const {
+	switch (mType) {
+	case Bool:
+	case Integer:
+		return mInteger;
+	case Double:
+		return mDouble;
+	case String:
+		return mUtf8->toDouble();
+	default:
+		return 0;
+	}
+}
+
+QString SFJsonScalar::toString() const {
+	switch (mType) {
+	case Bool:
+		return mInteger ? "true" : "false";
+	case Integer:
+		return QString::number(mInteger);
+	case Double:
+		return QString::number(mDouble, 'g', 15);
+	case String:
+		return QString::fromUtf8(mUtf8->constData(), mUtf8->size());
+	default:
+		return QString();
+	}
+}
+
+QVariant SFJsonScalar::toVariant() const {
+	switch (mType) {
+	case Bool:
+		return QVariant(mInteger != 0);
+	case Integer:
+		return QVariant(mInteger);
+	case Double:
+		return QVariant(mDouble);
+	case String:
+		return QVariant(this->toString());
+	default:
+		return QVariant();
+	}
+}
+
+/*
+ * SFJsonStreamParser
+ */
+SFJsonStreamParser::SFJsonStreamParser(SFJsonStreamHandler *handler) : mHandler(handler) {
+	this->reset();
+}
+
+void SFJsonStreamParser::reset() {
+	mLexState = LexNone;
+	mExpect = ExpectValue;
+	mContainers.clear();
+	mToken.clear();
+	mUnicode = 0;
+	mUnicodeDigits = 0;
+	mHighSurrogate = 0;
+	mOffset = 0;
+	mError = QString();
+	mKeys.clear();
+}
+
+bool SFJsonStreamParser::feed(const QByteArray & chunk) {
+	if (this->hasError()) {
+		return false;
+	}
+	const char *data = chunk.constData();
+	int size = chunk.size();
+	qint64 base = mOffset;
+	int i = 0;
+	while (i < size) {
+		char c = data[i];
+		switch (mLexState) {
+		case LexNone:
+			mOffset = base + i;
+			if (!this->structural(c)) {
+				return false;
+			}
+			i++;
+			break;
+
+		case LexString: {
+			//copy the run of plain characters at once
+			int run = i;
+			while (i < size && data[i] != '"' && data[i] != '\\') {
+				if (static_cast<uchar>(data[i]) < 0x20) {
+					mOffset = base + i;
+					return this->fail("Control character in string");
+				}
+				i++;
+			}
+			if (i > run) {
+				this->flushHighSurrogate();
+				mToken.append(data + run, i - run);
+			}
+			if (i < size) {
+				mOffset = base + i;
+				i++;
+				if (data[i - 1] == '"') {
+					mLexState = LexNone;
+					if (!this->endToken(LexString)) {
+						return false;
+					}
+				} else {
+					mLexState = LexStringEscape;
+				}
+			}
+			break;
+		}
+
+		case LexStringEscape:
+			mLexState = LexString;
+			switch (c) {
+			case '"':
+			case '\\':
+			case '/':
+				this->flushHighSurrogate();
+				mToken.append(c);
+				break;
+			case 'b':
+				this->flushHighSurrogate();
+				mToken.append('\b');
+				break;
+			case 'f':
+				this->flushHighSurrogate();
+				mToken.append('\f');
+				break;
+			case 'n':
+				this->flushHighSurrogate();
+				mToken.append('\n');
+				break;
+			case 'r':
+				this->flushHighSurrogate();
+				mToken.append('\r');
+				break;
+			case 't':
+				this->flushHighSurrogate();
+				mToken.append('\t');
+				break;
+			case 'u':
+				mLexState = LexStringUnicode;
+				mUnicode = 0;
+				mUnicodeDigits = 0;
+				break;
+			default:
+				mOffset = base + i;
+				return this->fail("Invalid escape sequence");
+			}
+			i++;
+			break;
+
+		case LexStringUnicode: {
+			int digit = hexDigit(c);
+			if (digit < 0) {
+				mOffset = base + i;
+				return this->fail("Invalid unicode escape sequence");
+			}
+			mUnicode = mUnicode * 16 + digit;
+			if (++mUnicodeDigits == 4) {
+				mLexState = LexString;
+				this->appendCodePoint(mUnicode);
+			}
+			i++;
+			break;
+		}
+
+		case LexNumber:
+		case LexLiteral: {
+			int run = i;
+			if (mLexState == LexNumber) {
+				while (i < size && isNumberChar(data[i])) {
+					i++;
+				}
+			} else {
+				while (i < size && data[i] >= 'a' && data[i] <= 'z') {
+					i++;
+				}
+			}
+			mToken.append(data + run, i - run);
+			if (i < size) {
+				//the delimiter is handled by the next iteration
+				mOffset = base + i;
+				LexState kind = mLexState;
+				mLexState = LexNone;
+				if (!this->endToken(kind)) {
+					return false;
+				}
+			}
+			break;
+		}
+		}
+	}
+	mOffset = base + size;
+	return true;
+}
+
+bool SFJsonStreamParser::finish() {
+	if (this->hasError()) {
+		return false;
+	}
+	if (mLexState == LexNumber || mLexState == LexLiteral) {
+		LexState kind = mLexState;
+		mLexState = LexNone;
+		if (!this->endToken(kind)) {
+			return false;
+		}
+	} else if (mLexState != LexNone) {
+		return this->fail("Unterminated string");
+	}
+	if (mExpect != ExpectEndOfInput) {
+		return this->fail("Unexpected end of document");
+	}
+	return true;
+}
+
+/*
+ * Private
+ */
+bool SFJsonStreamParser::structural(char c) {
+	switch (c) {
+	case ' ':
+	case '\t':
+	case '\n':
+	case '\r':
+		return true;
+	case '{':
+		if (!this->expectsValue()) {
+			return this->unexpected(c);
+		}
+		mContainers.append('{');
+		mExpect = ExpectKeyOrEnd;
+		return mHandler->startObject() || this->fail("Stopped by the handler");
+	case '[':
+		if (!this->expectsValue()) {
+			return this->unexpected(c);
+		}
+		mContainers.append('[');
+		mExpect = ExpectValueOrEnd;
+		return mHandler->startArray() || this->fail("Stopped by the handler");
+	case '}':
+		if (mExpect != ExpectKeyOrEnd && mExpect != ExpectCommaOrEnd) {
+			return this->unexpected(c);
+		}
+		return this->endContainer('{');
+	case ']':
+		if (mExpect != ExpectValueOrEnd && mExpect != ExpectCommaOrEnd) {
+			return this->unexpected(c);
+		}
+		return this->endContainer('[');
+	case ':':
+		if (mExpect != ExpectColon) {
+			return this->unexpected(c);
+		}
+		mExpect = ExpectValue;
+		return true;
+	case ',':
+		if (mExpect != ExpectCommaOrEnd) {
+			return this->unexpected(c);
+		}
+		mExpect = mContainers.last() == '{' ? ExpectKey : ExpectValue;
+		return true;
+	case '"':
+		if (!this->expectsValue() && mExpect != ExpectKey && mExpect != ExpectKeyOrEnd) {
+			return this->unexpected(c);
+		}
+		mLexState = LexString;
+		mToken.clear();
+		return true;
+	default:
+		if (!this->expectsValue()) {
+			return this->unexpected(c);
+		}
+		if (c == '-' || (c >= '0' && c <= '9')) {
+			mLexState = LexNumber;
+		} else if (c == 't' || c == 'f' || c == 'n') {
+			mLexState = LexLiteral;
+		} else {
+			return this->unexpected(c);
+		}
+		mToken.clear();
+		mToken.append(c);
+		return true;
+	}
+}
+
+bool SFJsonStreamParser::endToken(LexState kind) {
+	if (kind == LexString) {
+		this->flushHighSurrogate();
+		if (mExpect == ExpectKey || mExpect == ExpectKeyOrEnd) {
+			mExpect = ExpectColon;
+			return mHandler->key(mKeys.intern(mToken)) || this->fail("Stopped by the handler");
+		}
+		return this->emitValue(SFJsonScalar::string(mToken));
+	}
+
+	if (kind == LexNumber) {
+		bool ok = false;
+		if (mToken.indexOf('.') < 0 && mToken.indexOf('e') < 0 && mToken.indexOf('E') < 0) {
+			qlonglong integer = mToken.toLongLong(&ok);
+			if (ok) {
+				return this->emitValue(SFJsonScalar::integer(integer));
+			}
+		}
+		//fractions, exponents and integers that don't fit in 64 bits
+		double number = mToken.toDouble(&ok);
+		if (!ok) {
+			return this->fail("Invalid number");
+		}
+		return this->emitValue(SFJsonScalar::number(number));
+	}
+
+	if (mToken == "true") {
+		return this->emitValue(SFJsonScalar::boolean(true));
+	} else if (mToken == "false") {
+		return this->emitValue(SFJsonScalar::boolean(false));
+	} else if (mToken == "null") {
+		return this->emitValue(SFJsonScalar::null());
+	}
+	return this->fail("Invalid literal");
+}
+
+bool SFJsonStreamParser::emitValue(const SFJsonScalar & value) {
+	bool ok = mHandler->scalar(value);
+	this->afterValue();
+	return ok || this->fail("Stopped by the handler");
+}
+
+bool SFJsonStreamParser::endContainer(char open) {
+	if (mContainers.isEmpty() || mContainers.last() != open) {
+		return this->fail("Mismatched brackets");
+	}
+	mContainers.remove(mContainers.size() - 1);
+	bool ok = open == '{' ? mHandler->endObject() : mHandler->endArray();
+	this->afterValue();
+	return ok || this->fail("Stopped by the handler");
+}
+
+void SFJsonStreamParser::afterValue() {
+	mExpect = mContainers.isEmpty() ? ExpectEndOfInput : ExpectCommaOrEnd;
+}
+
+void SFJsonStreamParser::appendCodePoint(uint codePoint) {
+	if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+		//wait for the low surrogate in the next escape sequence
+		this->flushHighSurrogate();
+		mHighSurrogate = codePoint;
+		return;
+	}
+	if (codePoint >= 0xDC00 && codePoint < 0xE000) {
+		codePoint = mHighSurrogate ? 0x10000 + ((mHighSurrogate - 0xD800) << 10) + (codePoint - 0xDC00) : kSFReplacementCharacter;
+		mHighSurrogate = 0;
+	} else {
+		this->flushHighSurrogate();
+	}
+
+	if (codePoint < 0x80) {
+		mToken.append(static_cast<char>(codePoint));
+	} else if (codePoint < 0x800) {
+		mToken.append(static_cast<char>(0xC0 | (codePoint >> 6)));
+		mToken.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	} else if (codePoint < 0x10000) {
+		mToken.append(static_cast<char>(0xE0 | (codePoint >> 12)));
+		mToken.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		mToken.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	} else {
+		mToken.append(static_cast<char>(0xF0 | (codePoint >> 18)));
+		mToken.append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+		mToken.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		mToken.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+}
+
+void SFJsonStreamParser::flushHighSurrogate() {
+	if (mHighSurrogate) {
+		//a high surrogate that is not followed by a low one
+		mHighSurrogate = 0;
+		this->appendCodePoint(kSFReplacementCharacter);
+	}
+}
+
+bool SFJsonStreamParser::fail(const QString & message) {
+	if (mError.isNull()) {
+		mError = QString("%1 at offset %2").arg(message).arg(mOffset);
+	}
+	return false;
+}
+
+bool SFJsonStreamParser::unexpected(char c) {
+	return this->fail(QString("Unexpected character '%1'").arg(QChar::fromLatin1(c)));
+}
+
+/*
+ * SFJsonVariantBuilder
+ */
+SFJsonVariantBuilder::SFJsonVariantBuilder() : mComplete(false) {
+}
+
+void SFJsonVariantBuilder::reset() {
+	mStack.clear();
+	mResult = QVariant();
+	mComplete = false;
+}
+
+bool SFJsonVariantBuilder::startObject() {
+	Frame frame;
+	frame.isObject = true;
+	mStack.append(frame);
+	return true;
+}
+
+bool SFJsonVariantBuilder::endObject() {
+	if (mStack.isEmpty() || !mStack.last().isObject) {
+		return false;
+	}
+	Frame frame = mStack.takeLast();
+	return this->value(frame.map);
+}
+
+bool SFJsonVariantBuilder::startArray() {
+	Frame frame;
+	frame.isObject = false;
+	mStack.append(frame);
+	return true;
+}
+
+bool SFJsonVariantBuilder::endArray() {
+	if (mStack.isEmpty() || mStack.last().isObject) {
+		return false;
+	}
+	Frame frame = mStack.takeLast();
+	return this->value(frame.list);
+}
+
+bool SFJsonVariantBuilder::key(const QString & key) {
+	if (mStack.isEmpty() || !mStack.last().isObject) {
+		return false;
+	}
+	mStack.last().key = key;
+	return true;
+}
+
+bool SFJsonVariantBuilder::value(const QVariant & value) {
+	if (mStack.isEmpty()) {
+		mResult = value;
+		mComplete = true;
+		return true;
+	}
+	Frame & top = mStack.last();
+	if (top.isObject) {
+		top.map.insert(top.key, value);
+	} else {
+		top.list.append(value);
+	}
+	return true;
+}
+
+/*
+ * SFJsonRecordsConsumer
+ */
+SFJsonRecordsConsumer::SFJsonRecordsConsumer(const QString & recordsKey) : mRecordsKey(recordsKey), mParser(this),
+		mDepth(0), mRecordCount(0), mRootIsObject(false), mPendingRecordsKey(false), mInRecords(false), mInRecord(false),
+		mStripAttributes(false), mSkipDepth(0) {
+}
+
+SFJsonRecordsConsumer::~SFJsonRecordsConsumer() {
+}
+
+bool SFJsonRecordsConsumer::begin(int statusCode, const QByteArray & contentType) {
+	Q_UNUSED(statusCode);
+	Q_UNUSED(contentType);
+	mParser.reset();
+	mDocument.reset();
+	mRecord.reset();
+	mRecords.clear();
+	mDepth = 0;
+	mRecordCount = 0;
+	mRootIsObject = false;
+	mPendingRecordsKey = false;
+	mInRecords = false;
+	mInRecord = false;
+	mSkipDepth = 0;
+	mError = QString();
+	return true;
+}
+
+bool SFJsonRecordsConsumer::consume(const QByteArray & chunk) {
+	if (!mParser.feed(chunk)) {
+		mError = mParser.errorString();
+		return false;
+	}
+	return true;
+}
+
+bool SFJsonRecordsConsumer::finish() {
+	if (!mParser.finish()) {
+		mError = mParser.errorString();
+		return false;
+	}
+	return true;
+}
+
+QVariant SFJsonRecordsConsumer::result() const {
+	return mDocument.result();
+}
+
+QString SFJsonRecordsConsumer::errorString() const {
+	return mError;
+}
+
+bool SFJsonRecordsConsumer::processRecord(int index, const QVariant & record) {
+	Q_UNUSED(index);
+	mRecords.append(record);
+	return true;
+}
+
+/* depth 1 is the top level object, depth 2 the records array, records themselves start at depth 3 */
+bool SFJsonRecordsConsumer::startObject() {
+	if (mSkipDepth) {
+		mDepth++;
+		return true;
+	}
+	if (mInRecord) {
+		mDepth++;
+		return mRecord.startObject();
+	}
+	if (mInRecords && mDepth == 2) {
+		mInRecord = true;
+		mRecord.reset();
+		mDepth++;
+		return mRecord.startObject();
+	}
+	if (mDepth == 0) {
+		mRootIsObject = true;
+	}
+	if (!this->flushPendingKey()) {
+		return false;
+	}
+	mDepth++;
+	return mDocument.startObject();
+}
+
+bool SFJsonRecordsConsumer::endObject() {
+	return this->endContainer(true);
+}
+
+bool SFJsonRecordsConsumer::startArray() {
+	if (mSkipDepth) {
+		mDepth++;
+		return true;
+	}
+	if (mInRecord) {
+		mDepth++;
+		return mRecord.startArray();
+	}
+	if (mInRecords && mDepth == 2) {
+		mInRecord = true;
+		mRecord.reset();
+		mDepth++;
+		return mRecord.startArray();
+	}
+	if (mPendingRecordsKey) {
+		//the records array itself is not built, its elements are handed over one by one
+		mPendingRecordsKey = false;
+		mInRecords = true;
+		mDepth++;
+		return true;
+	}
+	mDepth++;
+	return mDocument.startArray();
+}
+
+bool SFJsonRecordsConsumer::endArray() {
+	return this->endContainer(false);
+}
+
+bool SFJsonRecordsConsumer::key(const QString & key) {
+	if (mInRecord) {
+		if (mStripAttributes && key == kSFRecordAttributesKey) {
+			//drop the key and its value
+			mSkipDepth = mDepth;
+			return true;
+		}
+		return mRecord.key(key);
+	}
+	if (mDepth == 1 && mRootIsObject && key == mRecordsKey) {
+		//hold it back until we know whether it's an array
+		mPendingRecordsKey = true;
+		return true;
+	}
+	return mDocument.key(key);
+}
+
+bool SFJsonRecordsConsumer::value(const QVariant & value) {
+	if (mSkipDepth) {
+		if (mDepth == mSkipDepth) {
+			mSkipDepth = 0;
+		}
+		return true;
+	}
+	if (mInRecord) {
+		return mRecord.value(value);
+	}
+	if (mInRecords && mDepth == 2) {
+		return this->processRecord(mRecordCount++, value);
+	}
+	if (!this->flushPendingKey()) {
+		return false;
+	}
+	return mDocument.value(value);
+}
+
+bool SFJsonRecordsConsumer::endContainer(bool isObject) {
+	mDepth--;
+	if (mSkipDepth) {
+		if (mDepth == mSkipDepth) {
+			mSkipDepth = 0;
+		}
+		return true;
+	}
+	if (mInRecord) {
+		bool ok = isObject ? mRecord.endObject() : mRecord.endArray();
+		if (ok && mDepth == 2) {
+			mInRecord = false;
+			ok = this->processRecord(mRecordCount++, mRecord.result());
+			mRecord.reset();
+		}
+		return ok;
+	}
+	if (mInRecords && mDepth == 1) {
+		mInRecords = false;
+		return mDocument.key(mRecordsKey) && mDocument.value(mRecords);
+	}
+	return isObject ? mDocument.endObject() : mDocument.endArray();
+}
+
+bool SFJsonRecordsConsumer::flushPendingKey() {
+	if (!mPendingRecordsKey) {
+		return true;
+	}
+	mPendingRecordsKey = false;
+	return mDocument.key(mRecordsKey);
+}
+
+} /* namespace sf */
@@ -0,0 +1,289 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonView.cpp
+*/
+
+#include "SFJsonView.h"
+#include <cstring>
+#include "SFJsonIndexParser.h"
+#include "SFStringPool.h"
+
+namespace sf {
+
+/*
+ * SFJsonValue
+ */
+SFJsonValue::SFJsonValue() : mIndex(-1) {
+}
+
+SFJsonValue::SFJsonValue(const QSharedPointer<SFJsonIndexParser> & document, int index) : mDocument(document), mIndex(index) {
+}
+
+SFJsonValue::Type SFJsonValue::type() const {
+	if (mDocument.isNull() || mIndex < 0 || mIndex >= mDocument->mIndex.size()) {
+		return Undefined;
+	}
+	switch (mDocument->charAt(mIndex)) {
+	case '{':
+		return Object;
+	case '[':
+		return Array;
+	case '"':
+		return String;
+	case 't':
+	case 'f':
+		return Bool;
+	case 'n':
+		return Null;
+	case '}':
+	case ']':
+	case ',':
+	case ':':
+		return Undefined;
+	default:
+		return Number;
+	}
+}
+
+bool SFJsonValue::toBool(bool defaultValue) const {
+	if (this->type() != Bool) {
+		return defaultValue;
+	}
+	return mDocument->charAt(mIndex) == 't';
+}
+
+double SFJsonValue::toDouble(double defaultValue) const {
+	QVariant number;
+	if (this->type() != Number || !mDocument->scalarAt(mIndex, &number)) {
+		return defaultValue;
+	}
+	return number.toDouble();
+}
+
+qlonglong SFJsonValue::toLongLong(qlonglong defaultValue) const {
+	QVariant number;
+	if (this->type() != Number || !mDocument->scalarAt(mIndex, &number) || number.type() != QVariant::LongLong) {
+		return defaultValue;
+	}
+	return number.toLongLong();
+}
+
+QString SFJsonValue::toString(const QString & defaultValue) const {
+	QString string;
+	QVariant scalar;
+	switch (this->type()) {
+	case String:
+		return mDocument->stringAt(mIndex, &string) ? string : defaultValue;
+	case Number:
+	case Bool:
+		return mDocument->scalarAt(mIndex, &scalar) ? scalar.toString() : defaultValue;
+	default:
+		return defaultValue;
+	}
+}
+
+int SFJsonValue::size() const {
+	Type type = this->type();
+	if (type != Array && type != Object) {
+		return 0;
+	}
+	//every element but the last is followed by a comma at the top level of the container
+	const SFJsonIndexParser *document = mDocument.data();
+	int count = 0;
+	int i = mIndex + 1;
+	char close = type == Array ? ']' : '}';
+	while (i < document->mIndex.size() && document->charAt(i) != close) {
+		count++;
+		i = type == Array ? document->skip(i) : document->skip(i + 2);
+		if (document->charAt(i) == ',') {
+			i++;
+		}
+	}
+	return count;
+}
+
+SFJsonValue SFJsonValue::at(int index) const {
+	if (this->type() != Array || index < 0) {
+		return SFJsonValue();
+	}
+	const SFJsonIndexParser *document = mDocument.data();
+	int i = mIndex + 1;
+	while (i < document->mIndex.size() && document->charAt(i) != ']') {
+		if (index-- == 0) {
+			return SFJsonValue(mDocument, i);
+		}
+		i = document->skip(i);
+		if (document->charAt(i) == ',') {
+			i++;
+		}
+	}
+	return SFJsonValue();
+}
+
+SFJsonValue SFJsonValue::value(const QString & key) const {
+	if (this->type() != Object) {
+		return SFJsonValue();
+	}
+	const SFJsonIndexParser *document = mDocument.data();
+	QByteArray utf8Key = key.toUtf8();
+	int i = mIndex + 1;
+	while (document->charAt(i) == '"' && document->charAt(i + 1) == ':') {
+		if (this->keyEquals(i, utf8Key)) {
+			return SFJsonValue(mDocument, i + 2);
+		}
+		i = document->skip(i + 2);
+		if (document->charAt(i) != ',') {
+			break;
+		}
+		i++;
+	}
+	return SFJsonValue();
+}
+
+QList<SFJsonValue> SFJsonValue::elements() const {
+	QList<SFJsonValue> elements;
+	Type type = this->type();
+	if (type != Array && type != Object) {
+		return elements;
+	}
+	const SFJsonIndexParser *document = mDocument.data();
+	int i = mIndex + 1;
+	char close = type == Array ? ']' : '}';
+	while (i < document->mIndex.size() && document->charAt(i) != close) {
+		int valueIndex = type == Array ? i : i + 2;
+		elements.append(SFJsonValue(mDocument, valueIndex));
+		i = document->skip(valueIndex);
+		if (document->charAt(i) == ',') {
+			i++;
+		}
+	}
+	return elements;
+}
+
+QStringList SFJsonValue::keys() const {
+	QStringList keys;
+	if (this->type() != Object) {
+		return keys;
+	}
+	const SFJsonIndexParser *document = mDocument.data();
+	int i = mIndex + 1;
+	while (document->charAt(i) == '"' && document->charAt(i + 1) == ':') {
+		QString key;
+		document->stringAt(i, &key);
+		keys.append(key);
+		i = document->skip(i + 2);
+		if (document->charAt(i) != ',') {
+			break;
+		}
+		i++;
+	}
+	return keys;
+}
+
+SFJsonValue SFJsonValue::path(const QString & path) const {
+	SFJsonValue current = *this;
+	int p = 0;
+	int length = path.length();
+	while (p < length && !current.isUndefined()) {
+		QChar c = path.at(p);
+		if (c == '.') {
+			p++;
+		} else if (c == '[') {
+			int close = path.indexOf(']', p);
+			bool ok = false;
+			int index = close < 0 ? -1 : path.mid(p + 1, close - p - 1).toInt(&ok);
+			if (!ok) {
+				return SFJsonValue();
+			}
+			current = current.at(index);
+			p = close + 1;
+		} else {
+			int end = p;
+			while (end < length && path.at(end) != '.' && path.at(end) != '[') {
+				end++;
+			}
+			current = current.value(path.mid(p, end - p));
+			p = end;
+		}
+	}
+	return current;
+}
+
+QVariant SFJsonValue::toVariant() const {
+	if (this->isUndefined()) {
+		return QVariant();
+	}
+	SFStringPool keys;
+	SFJsonIndexParser::ValueContext context = {&keys, false};
+	int i = mIndex;
+	QVariant value;
+	return mDocument->valueAt(i, &value, context) ? value : QVariant();
+}
+
+bool SFJsonValue::keyEquals(int i, const QByteArray & key) const {
+	const SFJsonIndexParser *document = mDocument.data();
+	int begin = document->mIndex.at(i) + 1;
+	int length = key.size();
+	//common case, the raw bytes of the key are the key
+	if (begin + length < document->mSize && memcmp(document->mData + begin, key.constData(), length) == 0
+			&& document->mData[begin + length] == '"') {
+		return true;
+	}
+	//the key might be written with escape sequences
+	const char *p = document->mData + begin;
+	const char *end = document->mData + document->mSize;
+	while (p < end && *p != '"' && *p != '\\') {
+		p++;
+	}
+	if (p >= end || *p == '"') {
+		return false;
+	}
+	QString decoded;
+	return document->stringAt(i, &decoded) && decoded.toUtf8() == key;
+}
+
+/*
+ * SFJsonView
+ */
+SFJsonView::SFJsonView() {
+}
+
+SFJsonView SFJsonView::fromJson(const QByteArray & json, QString * errorString) {
+	QSharedPointer<SFJsonIndexParser> document(new SFJsonIndexParser(json));
+	SFJsonView view;
+	if (!document->buildIndex()) {
+		if (errorString) {
+			*errorString = document->errorString();
+		}
+	} else if (document->mIndex.isEmpty()) {
+		if (errorString) {
+			*errorString = "Empty document";
+		}
+	} else {
+		view.mDocument = document;
+	}
+	return view;
+}
+
+SFJsonValue SFJsonView::root() const {
+	return this->isValid() ? SFJsonValue(mDocument, 0) : SFJsonValue();
+}
+
+QByteArray SFJsonView::rawData() const {
+	return this->isValid() ? mDocument->mJson : QByteArray();
+}
+
+} /* namespace sf */
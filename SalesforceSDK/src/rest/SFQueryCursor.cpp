@@ -0,0 +1,172 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFQueryCursor.cpp
+*/
+
+
+#include "SFQueryCursor.h"
+#include "SFGenericTask.h"
+#include "SFGlobal.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFResult.h"
+
+namespace sf {
+
+static const QString kSFQueryOptionsHeader = "Sforce-Query-Options";
+static const QString kSFQueryBatchSizeOption = "batchSize=%1";
+static const int kSFMinQueryBatchSize = 200;
+static const int kSFMaxQueryBatchSize = 2000;
+static const QString kSFRecordsKey = "records";
+static const QString kSFTotalSizeKey = "totalSize";
+static const QString kSFDoneKey = "done";
+static const QString kSFNextRecordsUrlKey = "nextRecordsUrl";
+
+SFQueryCursor::SFQueryCursor(QObject *parent)
+: QObject(parent), mQuery(), mBatchSize(0), mMaxPagesHeld(2), mAutoFetch(true), mStripRecordAttributes(false), mActive(false),
+  mFetching(false), mDelivering(false), mGeneration(0), mDemand(0), mTotalSize(0), mDeliveredRecords(0), mNextRecordsUrl(), mPages(), mPageTask() {
+}
+
+SFQueryCursor::~SFQueryCursor() {
+	this->cancelPageTask();
+}
+
+void SFQueryCursor::setBatchSize(int batchSize) {
+	this->mBatchSize = batchSize <= 0 ? 0 : qBound(kSFMinQueryBatchSize, batchSize, kSFMaxQueryBatchSize);
+}
+
+void SFQueryCursor::start() {
+	if (mActive) {
+		this->cancel();
+	}
+	if (mQuery.trimmed().isEmpty()) {
+		emit failed(SFResultCode::SFErrorGeneric, "The query is empty.");
+		return;
+	}
+	mActive = true;
+	mDemand = 0;
+	mTotalSize = 0;
+	mDeliveredRecords = 0;
+	mNextRecordsUrl.clear();
+	this->fetch(QString());
+}
+
+void SFQueryCursor::fetchNext() {
+	if (!mActive) {
+		return;
+	}
+	mDemand++;
+	this->deliverPages();
+}
+
+void SFQueryCursor::cancel() {
+	if (!mActive) {
+		return;
+	}
+	//a result already on its way doesn't belong to any run anymore
+	mGeneration++;
+	this->cancelPageTask();
+	mActive = false;
+	mFetching = false;
+	mPages.clear();
+	emit cancelled();
+}
+
+void SFQueryCursor::onPageResultReady(SFResult* result) {
+	if (result->getTag<int>(kSFRestRequestTag) != mGeneration || !mActive) {
+		return;
+	}
+	mFetching = false;
+	mPageTask = NULL;
+	if (result->hasError()) {
+		mActive = false;
+		mPages.clear();
+		emit failed(result->code(), result->message());
+		return;
+	}
+
+	QVariantMap page = result->payload<QVariantMap>();
+	mTotalSize = page.value(kSFTotalSizeKey).toInt();
+	mNextRecordsUrl = page.value(kSFDoneKey).toBool() ? QString() : page.value(kSFNextRecordsUrlKey).toString();
+	mPages.enqueue(page.value(kSFRecordsKey).toList());
+
+	//look ahead before the consumer gets the page, so the network works while the page is processed
+	this->prefetch();
+	this->deliverPages();
+}
+
+void SFQueryCursor::fetch(const QString & nextRecordsUrl) {
+	SFRestAPI *api = SFRestAPI::instance();
+	SFRestRequest *request = NULL;
+	if (nextRecordsUrl.isEmpty()) {
+		request = api->requestForQuery(mQuery);
+	} else {
+		//the URL already holds the end point and the version
+		request = api->customRequest(nextRecordsUrl, HTTPMethod::HTTPGet, QVariantMap(), SFRestRequest::HTTPContentTypeUrlEncoded);
+		//only the consumer waiting for this page makes it urgent
+		request->setPriority(mPages.isEmpty() && (mAutoFetch || mDemand > 0) ? SFRequestPriority::Interactive : SFRequestPriority::Prefetch);
+	}
+	if (mBatchSize > 0) {
+		QVariantMap headers;
+		headers[kSFQueryOptionsHeader] = kSFQueryBatchSizeOption.arg(mBatchSize);
+		request->setRequestRawHeaders(headers);
+	}
+	request->setJsonParser(SFRestRequest::JsonParserIndexed);
+	request->setStripRecordAttributes(mStripRecordAttributes);
+
+	mFetching = true;
+	mPageTask = api->sendRestRequest(request, this, SLOT(onPageResultReady(sf::SFResult*)), mGeneration);
+}
+
+void SFQueryCursor::cancelPageTask() {
+	if (mPageTask) {
+		mPageTask->cancel();
+	}
+	mPageTask = NULL;
+}
+
+void SFQueryCursor::prefetch() {
+	if (!mActive || mFetching || mNextRecordsUrl.isEmpty() || mPages.size() >= mMaxPagesHeld) {
+		return;
+	}
+	this->fetch(mNextRecordsUrl);
+}
+
+void SFQueryCursor::deliverPages() {
+	if (mDelivering) {
+		//fetchNext() called from a slot connected to pageReady(), the loop below picks it up
+		return;
+	}
+	mDelivering = true;
+	while (mActive && !mPages.isEmpty() && (mAutoFetch || mDemand > 0)) {
+		QVariantList records = mPages.dequeue();
+		if (!mAutoFetch) {
+			mDemand--;
+		}
+		mDeliveredRecords += records.size();
+		//a page left the cursor, there is room for the next one
+		this->prefetch();
+		emit pageReady(records);
+	}
+	mDelivering = false;
+
+	if (mActive && mPages.isEmpty() && !mFetching && mNextRecordsUrl.isEmpty()) {
+		mActive = false;
+		emit finished();
+	}
+}
+
+} /* namespace sf */
@@ -0,0 +1,853 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordBatch.cpp
+*/
+
+
+#include "SFRecordBatch.h"
+#include <QtAlgorithms>
+#include <cstring>
+#include <functional>
+#include "SFGlobal.h"
+
+namespace sf {
+
+static const QString kSFRecordsKey = "records";
+static const QString kSFIdFieldName = "Id";
+
+/* the kinds of JSON values, to pick the type of a column */
+enum SFValueKind {
+	SFValueBool,
+	SFValueInteger,
+	SFValueDouble,
+	SFValueString,
+	SFValueOther
+};
+
+static SFValueKind valueKind(const QVariant & value) {
+	switch (value.type()) {
+	case QVariant::Bool:
+		return SFValueBool;
+	case QVariant::Int:
+	case QVariant::UInt:
+	case QVariant::LongLong:
+	case QVariant::ULongLong:
+		return SFValueInteger;
+	case QVariant::Double:
+		return SFValueDouble;
+	case QVariant::String:
+		return SFValueString;
+	default:
+		return SFValueOther;
+	}
+}
+
+static qint64 operandToMSecs(const QVariant & operand, bool * ok) {
+	qint64 msecs = 0;
+	*ok = true;
+	switch (operand.type()) {
+	case QVariant::DateTime:
+		return operand.toDateTime().toMSecsSinceEpoch();
+	case QVariant::Date:
+		return QDateTime(operand.toDate(), QTime(0, 0), Qt::UTC).toMSecsSinceEpoch();
+	case QVariant::String:
+		*ok = sfParseIsoDateTime(operand.toString(), operand.toString().length() == 10, &msecs);
+		return msecs;
+	default:
+		*ok = false;
+		return 0;
+	}
+}
+
+static inline int compareBytes(const char *a, int aLength, const char *b, int bLength) {
+	int result = memcmp(a, b, qMin(aLength, bLength));
+	return result ? result : aLength - bLength;
+}
+
+static inline bool matches(int order, SFRecordBatch::Comparison comparison) {
+	switch (comparison) {
+	case SFRecordBatch::Equal: return order == 0;
+	case SFRecordBatch::NotEqual: return order != 0;
+	case SFRecordBatch::Less: return order < 0;
+	case SFRecordBatch::LessOrEqual: return order <= 0;
+	case SFRecordBatch::Greater: return order > 0;
+	case SFRecordBatch::GreaterOrEqual: return order >= 0;
+	default: return false;
+	}
+}
+
+template<class T, class Predicate>
+static void scanMatching(const QVector<T> & values, const QBitArray & nulls, Predicate predicate, QVector<int> * rows) {
+	const T *data = values.constData();
+	int count = values.size();
+	for (int i = 0; i < count; i++) {
+		if (!nulls.testBit(i) && predicate(data[i])) {
+			rows->append(i);
+		}
+	}
+}
+
+/* compares the values of a column to the operand, as U */
+template<class U, class T>
+static void scanComparison(const QVector<T> & values, const QBitArray & nulls, SFRecordBatch::Comparison comparison, U operand, QVector<int> * rows) {
+	switch (comparison) {
+	case SFRecordBatch::Equal:
+		scanMatching(values, nulls, std::bind2nd(std::equal_to<U>(), operand), rows);
+		break;
+	case SFRecordBatch::NotEqual:
+		scanMatching(values, nulls, std::bind2nd(std::not_equal_to<U>(), operand), rows);
+		break;
+	case SFRecordBatch::Less:
+		scanMatching(values, nulls, std::bind2nd(std::less<U>(), operand), rows);
+		break;
+	case SFRecordBatch::LessOrEqual:
+		scanMatching(values, nulls, std::bind2nd(std::less_equal<U>(), operand), rows);
+		break;
+	case SFRecordBatch::Greater:
+		scanMatching(values, nulls, std::bind2nd(std::greater<U>(), operand), rows);
+		break;
+	case SFRecordBatch::GreaterOrEqual:
+		scanMatching(values, nulls, std::bind2nd(std::greater_equal<U>(), operand), rows);
+		break;
+	default:
+		break;
+	}
+}
+
+/* orders rows by the values of a column, nulls first */
+class SFRecordRowLess {
+public:
+	SFRecordRowLess(SFRecordBatch::ColumnType type, const QBitArray & nulls, const qlonglong *integers, const double *doubles,
+			const int *offsets, const int *lengths, const char *arena, const QVariantList & variants, bool descending)
+	: mType(type), mNulls(nulls), mIntegers(integers), mDoubles(doubles), mOffsets(offsets), mLengths(lengths), mArena(arena),
+	  mVariants(variants), mDescending(descending) {}
+
+	bool operator()(int a, int b) const {
+		return mDescending ? this->less(b, a) : this->less(a, b);
+	}
+
+private:
+	SFRecordBatch::ColumnType mType;
+	const QBitArray & mNulls;
+	const qlonglong *mIntegers;
+	const double *mDoubles;
+	const int *mOffsets;
+	const int *mLengths;
+	const char *mArena;
+	const QVariantList & mVariants;
+	bool mDescending;
+
+	bool less(int a, int b) const {
+		bool aIsNull = mNulls.testBit(a);
+		bool bIsNull = mNulls.testBit(b);
+		if (aIsNull || bIsNull) {
+			return aIsNull && !bIsNull;
+		}
+		switch (mType) {
+		case SFRecordBatch::ColumnString:
+		case SFRecordBatch::ColumnId:
+			return compareBytes(mArena + mOffsets[a], mLengths[a], mArena + mOffsets[b], mLengths[b]) < 0;
+		case SFRecordBatch::ColumnDouble:
+			return mDoubles[a] < mDoubles[b];
+		case SFRecordBatch::ColumnVariant:
+			return mVariants.at(a).toString() < mVariants.at(b).toString();
+		default:
+			return mIntegers[a] < mIntegers[b];
+		}
+	}
+};
+
+/*
+ * SFRecordBatch::Builder
+ *
+ * A column is typed by its first value, or by the describe result while it only has nulls. It is widened when a later value
+ * doesn't fit: integers to doubles, dates that don't parse to strings, and mixed kinds to variants. The columns end up with
+ * the types they would get from looking at all the records first, without keeping the records.
+ */
+class SFRecordBatch::Builder {
+public:
+	explicit Builder(const QVariantMap & describe);
+
+	void append(const QVariantMap & record);
+	SFRecordBatch batch();
+
+private:
+	QHash<QString, QString> mDescribedTypes;
+	QVector<Column> mColumns;
+	QVector<bool> mTyped; //whether a value has typed the column, rather than the describe result
+	QHash<QString, int> mIndex;
+	QByteArray mArena;
+	int mRowCount;
+
+	int column(const QString & name);
+	ColumnType describedType(const QString & name) const;
+	ColumnType valueType(const QString & name, SFValueKind kind) const;
+	void reset(Column & column, ColumnType type, int size);
+	void appendNull(Column & column);
+	void set(int c, int row, const QVariant & value);
+	void setText(Column & column, int row, const QString & text);
+	QVariant valueAt(const Column & column, int row) const;
+	void toDoubles(Column & column);
+	void toVariants(Column & column);
+};
+
+SFRecordBatch::Builder::Builder(const QVariantMap & describe) : mRowCount(0) {
+	QVariantList fields = describe.value("fields").toList();
+	for (QVariantList::const_iterator i = fields.constBegin(); i != fields.constEnd(); i++) {
+		QVariantMap field = i->toMap();
+		mDescribedTypes.insert(field.value("name").toString(), field.value("type").toString().toLower());
+	}
+}
+
+void SFRecordBatch::Builder::append(const QVariantMap & record) {
+	int row = mRowCount++;
+	for (int c = 0; c < mColumns.size(); c++) {
+		this->appendNull(mColumns[c]);
+	}
+	for (QVariantMap::const_iterator i = record.constBegin(); i != record.constEnd(); i++) {
+		int c = this->column(i.key());
+		if (i.value().isValid()) {
+			this->set(c, row, i.value());
+		}
+	}
+}
+
+SFRecordBatch SFRecordBatch::Builder::batch() {
+	SFRecordBatch batch;
+	batch.mRowCount = mRowCount;
+	mArena.squeeze();
+	batch.mArena = mArena;
+	for (int c = 0; c < mColumns.size(); c++) {
+		//the vectors grew a row at a time
+		Column & column = mColumns[c];
+		column.integers.squeeze();
+		column.doubles.squeeze();
+		column.offsets.squeeze();
+		column.lengths.squeeze();
+		batch.appendColumn(column);
+	}
+	return batch;
+}
+
+/* @return the index of the named column, added with a null value for every row so far if it is new */
+int SFRecordBatch::Builder::column(const QString & name) {
+	int c = mIndex.value(name, -1);
+	if (c < 0) {
+		c = mColumns.size();
+		mIndex.insert(name, c);
+		Column column;
+		column.name = name;
+		this->reset(column, this->describedType(name), mRowCount);
+		mColumns.append(column);
+		mTyped.append(false);
+	}
+	return c;
+}
+
+/* the type of a column whose values are all null */
+SFRecordBatch::ColumnType SFRecordBatch::Builder::describedType(const QString & name) const {
+	QString described = mDescribedTypes.value(name);
+	if (described == "boolean") {
+		return ColumnBool;
+	} else if (described == "double" || described == "currency" || described == "percent") {
+		return ColumnDouble;
+	} else if (described == "int") {
+		return ColumnInteger;
+	} else if (described == "id" || described == "reference" || (described.isEmpty() && name == kSFIdFieldName)) {
+		return ColumnId;
+	} else if (described == "date") {
+		return ColumnDate;
+	} else if (described == "datetime") {
+		return ColumnDateTime;
+	}
+	return ColumnString;
+}
+
+/* the type of a column given by its first value */
+SFRecordBatch::ColumnType SFRecordBatch::Builder::valueType(const QString & name, SFValueKind kind) const {
+	ColumnType described = this->describedType(name);
+	switch (kind) {
+	case SFValueBool:
+		return ColumnBool;
+	case SFValueInteger:
+		return described == ColumnDouble ? ColumnDouble : ColumnInteger;
+	case SFValueDouble:
+		return ColumnDouble;
+	case SFValueString:
+		return (described == ColumnId || described == ColumnDate || described == ColumnDateTime) ? described : ColumnString;
+	default:
+		return ColumnVariant;
+	}
+}
+
+/* make an all null column of the given type */
+void SFRecordBatch::Builder::reset(Column & column, ColumnType type, int size) {
+	column.type = type;
+	column.nulls = QBitArray(size, true);
+	column.integers.clear();
+	column.doubles.clear();
+	column.offsets.clear();
+	column.lengths.clear();
+	column.variants.clear();
+	switch (type) {
+	case ColumnString:
+	case ColumnId:
+		column.offsets.resize(size);
+		column.lengths.resize(size);
+		break;
+	case ColumnDouble:
+		column.doubles.resize(size);
+		break;
+	case ColumnVariant:
+		column.variants.reserve(size);
+		for (int row = 0; row < size; row++) {
+			column.variants.append(QVariant());
+		}
+		break;
+	case ColumnDate:
+	case ColumnDateTime:
+		column.offsets.resize(size);
+		column.lengths.resize(size);
+		column.integers.resize(size);
+		break;
+	default:
+		column.integers.resize(size);
+		break;
+	}
+}
+
+void SFRecordBatch::Builder::appendNull(Column & column) {
+	int row = column.nulls.size();
+	column.nulls.resize(row + 1);
+	column.nulls.setBit(row);
+	switch (column.type) {
+	case ColumnString:
+	case ColumnId:
+		column.offsets.append(0);
+		column.lengths.append(0);
+		break;
+	case ColumnDouble:
+		column.doubles.append(0);
+		break;
+	case ColumnVariant:
+		column.variants.append(QVariant());
+		break;
+	case ColumnDate:
+	case ColumnDateTime:
+		column.offsets.append(0);
+		column.lengths.append(0);
+		column.integers.append(0);
+		break;
+	default:
+		column.integers.append(0);
+		break;
+	}
+}
+
+void SFRecordBatch::Builder::set(int c, int row, const QVariant & value) {
+	Column & column = mColumns[c];
+	SFValueKind kind = valueKind(value);
+	if (!mTyped.at(c)) {
+		mTyped[c] = true;
+		ColumnType type = this->valueType(column.name, kind);
+		if (type != column.type) {
+			this->reset(column, type, mRowCount);
+		}
+	} else {
+		switch (column.type) {
+		case ColumnBool:
+			if (kind != SFValueBool) {
+				this->toVariants(column);
+			}
+			break;
+		case ColumnInteger:
+			if (kind == SFValueDouble) {
+				this->toDoubles(column);
+			} else if (kind != SFValueInteger) {
+				this->toVariants(column);
+			}
+			break;
+		case ColumnDouble:
+			if (kind != SFValueInteger && kind != SFValueDouble) {
+				this->toVariants(column);
+			}
+			break;
+		case ColumnVariant:
+			break;
+		default:
+			if (kind != SFValueString) {
+				this->toVariants(column);
+			}
+			break;
+		}
+	}
+
+	column.nulls.clearBit(row);
+	switch (column.type) {
+	case ColumnString:
+	case ColumnId:
+		this->setText(column, row, value.toString());
+		break;
+	case ColumnBool:
+		column.integers[row] = value.toBool() ? 1 : 0;
+		break;
+	case ColumnInteger:
+		column.integers[row] = value.toLongLong();
+		break;
+	case ColumnDouble:
+		column.doubles[row] = value.toDouble();
+		break;
+	case ColumnDate:
+	case ColumnDateTime: {
+		//the text is kept so that the records read back exactly as they were received
+		QString text = value.toString();
+		if (!sfParseIsoDateTime(text, column.type == ColumnDate, &column.integers[row])) {
+			//only if every value is in the expected format
+			column.type = ColumnString;
+			column.integers.clear();
+		}
+		this->setText(column, row, text);
+		break;
+	}
+	case ColumnVariant:
+		column.variants[row] = value;
+		break;
+	}
+}
+
+void SFRecordBatch::Builder::setText(Column & column, int row, const QString & text) {
+	QByteArray utf8 = text.toUtf8();
+	column.offsets[row] = mArena.size();
+	column.lengths[row] = utf8.size();
+	mArena.append(utf8);
+}
+
+QVariant SFRecordBatch::Builder::valueAt(const Column & column, int row) const {
+	if (column.nulls.testBit(row)) {
+		return QVariant();
+	}
+	switch (column.type) {
+	case ColumnString:
+	case ColumnId:
+	case ColumnDate:
+	case ColumnDateTime:
+		return QString::fromUtf8(mArena.constData() + column.offsets.at(row), column.lengths.at(row));
+	case ColumnBool:
+		return column.integers.at(row) != 0;
+	case ColumnInteger:
+		return column.integers.at(row);
+	case ColumnDouble:
+		return column.doubles.at(row);
+	default:
+		return column.variants.at(row);
+	}
+}
+
+void SFRecordBatch::Builder::toDoubles(Column & column) {
+	int size = column.nulls.size();
+	column.doubles.resize(size);
+	for (int row = 0; row < size; row++) {
+		column.doubles[row] = column.integers.at(row);
+	}
+	column.integers.clear();
+	column.type = ColumnDouble;
+}
+
+/* the text of the values stays in the arena, mixed columns are rare */
+void SFRecordBatch::Builder::toVariants(Column & column) {
+	int size = column.nulls.size();
+	QVariantList variants;
+	variants.reserve(size);
+	for (int row = 0; row < size; row++) {
+		variants.append(this->valueAt(column, row));
+	}
+	column.integers.clear();
+	column.doubles.clear();
+	column.offsets.clear();
+	column.lengths.clear();
+	column.variants = variants;
+	column.type = ColumnVariant;
+}
+
+/*
+ * SFRecordBatch
+ */
+SFRecordBatch::SFRecordBatch() : mRowCount(0) {
+}
+
+SFRecordBatch SFRecordBatch::fromRecords(const QVariantList & records, const QVariantMap & describe) {
+	Builder builder(describe);
+	for (QVariantList::const_iterator r = records.constBegin(); r != records.constEnd(); r++) {
+		builder.append(r->toMap());
+	}
+	return builder.batch();
+}
+
+SFRecordBatch SFRecordBatch::fromQueryResult(const QVariantMap & content, const QVariantMap & describe) {
+	SFRecordBatch batch = fromRecords(content.value(kSFRecordsKey).toList(), describe);
+	batch.mMetadata = content;
+	batch.mMetadata.remove(kSFRecordsKey);
+	return batch;
+}
+
+QStringList SFRecordBatch::columnNames() const {
+	QStringList names;
+	for (int c = 0; c < mColumns.size(); c++) {
+		names.append(mColumns.at(c).name);
+	}
+	return names;
+}
+
+QVariant SFRecordBatch::value(int row, int column) const {
+	const Column & c = mColumns.at(column);
+	if (c.nulls.testBit(row)) {
+		return QVariant();
+	}
+	switch (c.type) {
+	case ColumnString:
+	case ColumnId:
+	case ColumnDate:
+	case ColumnDateTime:
+		return this->stringAt(row, column);
+	case ColumnBool:
+		return c.integers.at(row) != 0;
+	case ColumnInteger:
+		return c.integers.at(row);
+	case ColumnDouble:
+		return c.doubles.at(row);
+	default:
+		return c.variants.at(row);
+	}
+}
+
+QString SFRecordBatch::stringAt(int row, int column) const {
+	const Column & c = mColumns.at(column);
+	if (c.type == ColumnBool || c.type == ColumnInteger || c.type == ColumnDouble || c.type == ColumnVariant || c.nulls.testBit(row)) {
+		return QString();
+	}
+	return QString::fromUtf8(mArena.constData() + c.offsets.at(row), c.lengths.at(row));
+}
+
+qlonglong SFRecordBatch::integerAt(int row, int column) const {
+	const Column & c = mColumns.at(column);
+	if (c.nulls.testBit(row)) {
+		return 0;
+	}
+	switch (c.type) {
+	case ColumnBool:
+	case ColumnInteger:
+		return c.integers.at(row);
+	case ColumnDouble:
+		return static_cast<qlonglong>(c.doubles.at(row));
+	default:
+		return 0;
+	}
+}
+
+double SFRecordBatch::doubleAt(int row, int column) const {
+	const Column & c = mColumns.at(column);
+	if (c.nulls.testBit(row)) {
+		return 0;
+	}
+	switch (c.type) {
+	case ColumnInteger:
+		return c.integers.at(row);
+	case ColumnDouble:
+		return c.doubles.at(row);
+	default:
+		return 0;
+	}
+}
+
+bool SFRecordBatch::boolAt(int row, int column) const {
+	const Column & c = mColumns.at(column);
+	return c.type == ColumnBool && !c.nulls.testBit(row) && c.integers.at(row) != 0;
+}
+
+QDateTime SFRecordBatch::dateTimeAt(int row, int column) const {
+	const Column & c = mColumns.at(column);
+	if ((c.type != ColumnDate && c.type != ColumnDateTime) || c.nulls.testBit(row)) {
+		return QDateTime();
+	}
+	return QDateTime::fromMSecsSinceEpoch(c.integers.at(row)).toUTC();
+}
+
+SFRecordRow SFRecordBatch::row(int row) const {
+	return SFRecordRow(*this, row);
+}
+
+QVariantList SFRecordBatch::toRecords() const {
+	QVariantList records;
+	records.reserve(mRowCount);
+	for (int row = 0; row < mRowCount; row++) {
+		records.append(SFRecordRow(*this, row).toMap());
+	}
+	return records;
+}
+
+QVariant SFRecordBatch::toVariant() const {
+	QVariantMap content = mMetadata;
+	content.insert(kSFRecordsKey, this->toRecords());
+	return content;
+}
+
+QVector<int> SFRecordBatch::where(int column, Comparison comparison, const QVariant & operand) const {
+	QVector<int> rows;
+	const Column & c = mColumns.at(column);
+	if (comparison == IsNull || comparison == IsNotNull) {
+		bool wanted = comparison == IsNull;
+		for (int i = 0; i < mRowCount; i++) {
+			if (c.nulls.testBit(i) == wanted) {
+				rows.append(i);
+			}
+		}
+		return rows;
+	}
+
+	bool ok = true;
+	switch (c.type) {
+	case ColumnString:
+	case ColumnId: {
+		QByteArray utf8 = operand.toString().toUtf8();
+		const char *arena = mArena.constData();
+		for (int i = 0; i < mRowCount; i++) {
+			if (c.nulls.testBit(i)) {
+				continue;
+			}
+			const char *value = arena + c.offsets.at(i);
+			int length = c.lengths.at(i);
+			bool match = comparison == Contains ? QByteArray::fromRawData(value, length).indexOf(utf8) >= 0
+					: matches(compareBytes(value, length, utf8.constData(), utf8.size()), comparison);
+			if (match) {
+				rows.append(i);
+			}
+		}
+		break;
+	}
+	case ColumnBool:
+		scanComparison<qlonglong>(c.integers, c.nulls, comparison, operand.toBool() ? 1 : 0, &rows);
+		break;
+	case ColumnInteger: {
+		double number = operand.toDouble(&ok);
+		if (ok && number == static_cast<double>(static_cast<qlonglong>(number))) {
+			scanComparison<qlonglong>(c.integers, c.nulls, comparison, operand.toLongLong(), &rows);
+		} else if (ok) {
+			scanComparison<double>(c.integers, c.nulls, comparison, number, &rows);
+		}
+		break;
+	}
+	case ColumnDouble: {
+		double number = operand.toDouble(&ok);
+		if (ok) {
+			scanComparison<double>(c.doubles, c.nulls, comparison, number, &rows);
+		}
+		break;
+	}
+	case ColumnDate:
+	case ColumnDateTime: {
+		qint64 msecs = operandToMSecs(operand, &ok);
+		if (ok) {
+			scanComparison<qlonglong>(c.integers, c.nulls, comparison, msecs, &rows);
+		}
+		break;
+	}
+	case ColumnVariant:
+		if (comparison == Equal || comparison == NotEqual) {
+			for (int i = 0; i < mRowCount; i++) {
+				if (!c.nulls.testBit(i) && (c.variants.at(i) == operand) == (comparison == Equal)) {
+					rows.append(i);
+				}
+			}
+		}
+		break;
+	}
+	return rows;
+}
+
+SFRecordBatch SFRecordBatch::selected(const QVector<int> & rows) const {
+	SFRecordBatch batch;
+	batch.mArena = mArena;
+	batch.mMetadata = mMetadata;
+	batch.mRowCount = rows.size();
+	int count = rows.size();
+	const int *selection = rows.constData();
+	for (int c = 0; c < mColumns.size(); c++) {
+		const Column & source = mColumns.at(c);
+		Column column;
+		column.name = source.name;
+		column.type = source.type;
+		column.nulls = QBitArray(count);
+		for (int k = 0; k < count; k++) {
+			column.nulls.setBit(k, source.nulls.testBit(selection[k]));
+		}
+		switch (source.type) {
+		case ColumnString:
+		case ColumnId:
+			column.offsets.resize(count);
+			column.lengths.resize(count);
+			for (int k = 0; k < count; k++) {
+				column.offsets[k] = source.offsets.at(selection[k]);
+				column.lengths[k] = source.lengths.at(selection[k]);
+			}
+			break;
+		case ColumnDouble:
+			column.doubles.resize(count);
+			for (int k = 0; k < count; k++) {
+				column.doubles[k] = source.doubles.at(selection[k]);
+			}
+			break;
+		case ColumnVariant:
+			column.variants.reserve(count);
+			for (int k = 0; k < count; k++) {
+				column.variants.append(source.variants.at(selection[k]));
+			}
+			break;
+		case ColumnDate:
+		case ColumnDateTime:
+			column.offsets.resize(count);
+			column.lengths.resize(count);
+			for (int k = 0; k < count; k++) {
+				column.offsets[k] = source.offsets.at(selection[k]);
+				column.lengths[k] = source.lengths.at(selection[k]);
+			}
+			column.integers.resize(count);
+			for (int k = 0; k < count; k++) {
+				column.integers[k] = source.integers.at(selection[k]);
+			}
+			break;
+		default:
+			column.integers.resize(count);
+			for (int k = 0; k < count; k++) {
+				column.integers[k] = source.integers.at(selection[k]);
+			}
+			break;
+		}
+		batch.appendColumn(column);
+	}
+	return batch;
+}
+
+SFRecordBatch SFRecordBatch::filtered(const QString & column, Comparison comparison, const QVariant & operand) const {
+	int c = this->columnIndex(column);
+	return this->selected(c < 0 ? QVector<int>() : this->where(c, comparison, operand));
+}
+
+QVector<int> SFRecordBatch::sortedRows(int column, Qt::SortOrder order) const {
+	QVector<int> rows(mRowCount);
+	for (int i = 0; i < mRowCount; i++) {
+		rows[i] = i;
+	}
+	const Column & c = mColumns.at(column);
+	SFRecordRowLess less(c.type, c.nulls, c.integers.constData(), c.doubles.constData(), c.offsets.constData(), c.lengths.constData(),
+			mArena.constData(), c.variants, order == Qt::DescendingOrder);
+	qStableSort(rows.begin(), rows.end(), less);
+	return rows;
+}
+
+SFRecordBatch SFRecordBatch::sorted(const QString & column, Qt::SortOrder order) const {
+	int c = this->columnIndex(column);
+	return c < 0 ? *this : this->selected(this->sortedRows(c, order));
+}
+
+SFRecordBatch SFRecordBatch::projected(const QStringList & columns) const {
+	SFRecordBatch batch;
+	batch.mArena = mArena;
+	batch.mMetadata = mMetadata;
+	batch.mRowCount = mRowCount;
+	for (QStringList::const_iterator i = columns.constBegin(); i != columns.constEnd(); i++) {
+		int c = this->columnIndex(*i);
+		if (c >= 0 && batch.columnIndex(*i) < 0) {
+			batch.appendColumn(mColumns.at(c));
+		}
+	}
+	return batch;
+}
+
+void SFRecordBatch::appendColumn(const Column & column) {
+	mColumnIndex.insert(column.name, mColumns.size());
+	mColumns.append(column);
+}
+
+/*
+ * SFRecordBatchConsumer
+ */
+SFRecordBatchConsumer::SFRecordBatchConsumer(const QVariantMap & describe)
+: SFJsonRecordsConsumer(kSFRecordsKey), mDescribe(describe), mBuilder(NULL), mBatch(), mResult() {
+}
+
+SFRecordBatchConsumer::~SFRecordBatchConsumer() {
+	delete mBuilder;
+}
+
+bool SFRecordBatchConsumer::begin(int statusCode, const QByteArray & contentType) {
+	delete mBuilder;
+	mBuilder = new SFRecordBatch::Builder(mDescribe);
+	mBatch = SFRecordBatch();
+	mResult = QVariant();
+	return SFJsonRecordsConsumer::begin(statusCode, contentType);
+}
+
+bool SFRecordBatchConsumer::finish() {
+	if (!SFJsonRecordsConsumer::finish()) {
+		return false;
+	}
+	QVariant document = SFJsonRecordsConsumer::result();
+	if (document.type() == QVariant::Map) {
+		//the records array of the document is empty, they are in the builder
+		mBatch = mBuilder->batch();
+		mBatch.mMetadata = document.toMap();
+		mBatch.mMetadata.remove(kSFRecordsKey);
+		mResult = QVariant::fromValue(mBatch);
+	} else {
+		mResult = document;
+	}
+	delete mBuilder;
+	mBuilder = NULL;
+	return true;
+}
+
+QVariant SFRecordBatchConsumer::result() const {
+	return mResult;
+}
+
+bool SFRecordBatchConsumer::processRecord(int index, const QVariant & record) {
+	Q_UNUSED(index);
+	mBuilder->append(record.toMap());
+	return true;
+}
+
+/*
+ * SFRecordRow
+ */
+QVariant SFRecordRow::value(const QString & name) const {
+	int c = mBatch.columnIndex(name);
+	return c < 0 ? QVariant() : mBatch.value(mRow, c);
+}
+
+bool SFRecordRow::isNull(const QString & name) const {
+	int c = mBatch.columnIndex(name);
+	return c < 0 || mBatch.isNull(mRow, c);
+}
+
+QVariantMap SFRecordRow::toMap() const {
+	QVariantMap map;
+	for (int c = 0; c < mBatch.columnCount(); c++) {
+		map.insert(mBatch.mColumns.at(c).name, mBatch.value(mRow, c));
+	}
+	return map;
+}
+
+} /* namespace sf */
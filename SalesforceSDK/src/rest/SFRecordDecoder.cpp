@@ -0,0 +1,326 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordDecoder.cpp
+*/
+
+
+#include "SFRecordDecoder.h"
+#include "SFGlobal.h"
+
+namespace sf {
+
+/*
+ * Field conversions
+ */
+void sfDecodeField(const SFJsonScalar & json, QString * field) {
+	*field = json.toString();
+}
+
+void sfDecodeField(const SFJsonScalar & json, bool * field) {
+	*field = json.toBool();
+}
+
+void sfDecodeField(const SFJsonScalar & json, int * field) {
+	*field = (int) json.toLongLong();
+}
+
+void sfDecodeField(const SFJsonScalar & json, qlonglong * field) {
+	*field = json.toLongLong();
+}
+
+void sfDecodeField(const SFJsonScalar & json, double * field) {
+	*field = json.toDouble();
+}
+
+void sfDecodeField(const SFJsonScalar & json, QDate * field) {
+	qint64 msecs;
+	if (json.type() == SFJsonScalar::String && sfParseIsoDateTime(json.toString(), true, &msecs)) {
+		*field = QDateTime::fromMSecsSinceEpoch(msecs).toUTC().date();
+	} else {
+		*field = QDate();
+	}
+}
+
+void sfDecodeField(const SFJsonScalar & json, QDateTime * field) {
+	qint64 msecs;
+	if (json.type() == SFJsonScalar::String && sfParseIsoDateTime(json.toString(), false, &msecs)) {
+		*field = QDateTime::fromMSecsSinceEpoch(msecs).toUTC();
+	} else {
+		*field = QDateTime();
+	}
+}
+
+void sfDecodeField(const SFJsonScalar & json, QVariant * field) {
+	*field = json.toVariant();
+}
+
+QVariant sfEncodeField(const QString & field) {
+	return field;
+}
+
+QVariant sfEncodeField(bool field) {
+	return field;
+}
+
+QVariant sfEncodeField(int field) {
+	return field;
+}
+
+QVariant sfEncodeField(qlonglong field) {
+	return field;
+}
+
+QVariant sfEncodeField(double field) {
+	return field;
+}
+
+QVariant sfEncodeField(const QDate & field) {
+	return field.isValid() ? QVariant(field.toString("yyyy-MM-dd")) : QVariant();
+}
+
+QVariant sfEncodeField(const QDateTime & field) {
+	return field.isValid() ? QVariant(field.toUTC().toString("yyyy-MM-ddThh:mm:ss.zzz") + "+0000") : QVariant();
+}
+
+QVariant sfEncodeField(const QVariant & field) {
+	return field;
+}
+
+void sfInsertFieldPath(QVariantMap & map, const QString & path, const QVariant & value) {
+	int dot = path.indexOf('.');
+	if (dot < 0) {
+		map.insert(path, value);
+		return;
+	}
+	QString head = path.left(dot);
+	QVariantMap child = map.value(head).toMap();
+	sfInsertFieldPath(child, path.mid(dot + 1), value);
+	map.insert(head, child);
+}
+
+/*
+ * SFDecodedRecords
+ */
+QVariant SFDecodedRecords::toVariant() const {
+	QVariantMap content = mMetadata;
+	content.insert("records", mStore.isNull() ? QVariantList() : mStore->toVariantList());
+	return content;
+}
+
+/*
+ * SFRecordDecoderBase
+ */
+SFRecordDecoderBase::SFRecordDecoderBase(const QStringList & fieldNames, const QString & recordsKey) : mRecordsKey(recordsKey), mParser(this),
+		mField(-1), mChild(-1), mDepth(0), mSkipDepth(-1), mRecordCount(0), mPendingRecords(false), mInRecords(false), mInRecord(false) {
+	//a tree of the field paths, "Owner.Name" is the field "Name" of the child "Owner" of the record
+	mNodes.append(Node());
+	for (int i = 0; i < fieldNames.size(); i++) {
+		QStringList path = fieldNames.at(i).split('.');
+		int node = 0;
+		for (int j = 0; j < path.size() - 1; j++) {
+			int child = mNodes.at(node).children.value(path.at(j), -1);
+			if (child < 0) {
+				child = mNodes.size();
+				mNodes.append(Node());
+				mNodes[node].children.insert(path.at(j), child);
+			}
+			node = child;
+		}
+		mNodes[node].fields.insert(path.last(), i);
+	}
+}
+
+SFRecordDecoderBase::~SFRecordDecoderBase() {
+}
+
+bool SFRecordDecoderBase::begin(int statusCode, const QByteArray & contentType) {
+	Q_UNUSED(statusCode);
+	Q_UNUSED(contentType);
+	mParser.reset();
+	mMetadata.clear();
+	mOpenNodes.clear();
+	mPositions.clear();
+	mField = -1;
+	mChild = -1;
+	mKey = QString();
+	mDepth = 0;
+	mSkipDepth = -1;
+	mRecordCount = 0;
+	mPendingRecords = false;
+	mInRecords = false;
+	mInRecord = false;
+	mError = QString();
+	this->clearRecords();
+	return true;
+}
+
+bool SFRecordDecoderBase::consume(const QByteArray & chunk) {
+	if (!mParser.feed(chunk)) {
+		mError = mError.isNull() ? mParser.errorString() : mError;
+		return false;
+	}
+	return true;
+}
+
+bool SFRecordDecoderBase::finish() {
+	if (!mParser.finish()) {
+		mError = mError.isNull() ? mParser.errorString() : mError;
+		return false;
+	}
+	return true;
+}
+
+QString SFRecordDecoderBase::errorString() const {
+	return mError;
+}
+
+bool SFRecordDecoderBase::startObject() {
+	return this->startContainer(true);
+}
+
+bool SFRecordDecoderBase::endObject() {
+	return this->endContainer();
+}
+
+bool SFRecordDecoderBase::startArray() {
+	return this->startContainer(false);
+}
+
+bool SFRecordDecoderBase::endArray() {
+	return this->endContainer();
+}
+
+/* depth 1 is the top level object, depth 2 the records array, the members of records are at depth 3 */
+bool SFRecordDecoderBase::startContainer(bool isObject) {
+	if (mSkipDepth >= 0) {
+		mDepth++;
+		return true;
+	}
+	if (mDepth == 0) {
+		if (!isObject) {
+			mError = "The response is not an object";
+			return false;
+		}
+	} else if (mInRecord) {
+		if (isObject && mChild >= 0) {
+			//a parent record with bound fields, e.g. "Owner" for "Owner.Name"
+			mOpenNodes.append(mChild);
+			mPositions.append(0);
+		} else {
+			//sub-queries, "attributes" and parent records without bound fields
+			mSkipDepth = mDepth;
+		}
+	} else if (mInRecords) {
+		if (isObject) {
+			mInRecord = true;
+			mOpenNodes.resize(1);
+			mOpenNodes[0] = 0;
+			mPositions.resize(1);
+			mPositions[0] = 0;
+			this->beginRecord();
+		} else {
+			mSkipDepth = mDepth;
+		}
+	} else if (mPendingRecords && !isObject) {
+		mInRecords = true;
+	} else {
+		mSkipDepth = mDepth;
+	}
+	mPendingRecords = false;
+	mDepth++;
+	return true;
+}
+
+bool SFRecordDecoderBase::endContainer() {
+	mDepth--;
+	if (mSkipDepth >= 0) {
+		if (mDepth == mSkipDepth) {
+			mSkipDepth = -1;
+		}
+		return true;
+	}
+	if (mInRecord) {
+		if (mDepth == 2) {
+			mInRecord = false;
+			return this->endRecord(mRecordCount++);
+		}
+		mOpenNodes.remove(mOpenNodes.size() - 1);
+		mPositions.remove(mPositions.size() - 1);
+	} else if (mInRecords && mDepth == 1) {
+		mInRecords = false;
+	}
+	return true;
+}
+
+bool SFRecordDecoderBase::key(const QString & key) {
+	if (mSkipDepth >= 0) {
+		return true;
+	}
+	if (mInRecord) {
+		this->bindKey(key);
+	} else {
+		mKey = key;
+		mPendingRecords = mDepth == 1 && key == mRecordsKey;
+	}
+	return true;
+}
+
+/* the records of a response have their keys in the same order, and the parser reports a key as the same shared string every time */
+void SFRecordDecoderBase::bindKey(const QString & key) {
+	Node & node = mNodes[mOpenNodes.last()];
+	int & position = mPositions.last();
+	if (position < node.order.size() && node.order.at(position).key.constData() == key.constData()) {
+		const Slot & slot = node.order.at(position);
+		mField = slot.field;
+		mChild = slot.child;
+	} else {
+		Slot slot;
+		slot.key = key;
+		slot.field = node.fields.value(key, -1);
+		slot.child = node.children.value(key, -1);
+		if (position < node.order.size()) {
+			node.order[position] = slot;
+		} else {
+			node.order.append(slot);
+		}
+		mField = slot.field;
+		mChild = slot.child;
+	}
+	position++;
+}
+
+bool SFRecordDecoderBase::value(const QVariant & value) {
+	//the parser reports the values with scalar()
+	Q_UNUSED(value);
+	return true;
+}
+
+bool SFRecordDecoderBase::scalar(const SFJsonScalar & scalar) {
+	if (mSkipDepth >= 0) {
+		return true;
+	}
+	if (mInRecord) {
+		if (mField >= 0) {
+			this->decodeField(mField, scalar);
+		}
+	} else if (!mInRecords && mDepth == 1) {
+		mMetadata.insert(mKey, scalar.toVariant());
+	}
+	mPendingRecords = false;
+	return true;
+}
+
+} /* namespace sf */
@@ -0,0 +1,130 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRequestTemplate.cpp
+*/
+
+
+#include "SFRequestTemplate.h"
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include "SFOAuthCredentials.h"
+#include "SFRestAPI.h"
+#include "SFTokenVault.h"
+
+namespace sf {
+
+static const QByteArray kSFAuthorizationHeader = "Authorization";
+static const QByteArray kSFBearerPrefix = "Bearer ";
+static const QByteArray kSFUserAgentHeader = "User-Agent";
+
+//prepared templates, keyed by end point, API version and user agent
+static QHash<QString, SFRequestTemplate> sTemplates;
+static QMutex sTemplatesLock;
+
+SFRequestTemplate::SFRequestTemplate() : mHasPrefix(false), mCredentials(NULL), mGeneration(-1), mErrorCode(SFResultCode::SFErrorGeneric) {
+}
+
+SFRequestTemplate SFRequestTemplate::prepared(const QString & endPoint, const QString & apiVersion, const QString & userAgent) {
+	const SFOAuthCredentials *credentials = SFRestAPI::instance()->currentCredentials();
+	int generation = SFTokenVault::instance()->generation();
+	QString key = endPoint + '\n' + apiVersion + '\n' + userAgent;
+	{
+		QMutexLocker locker(&sTemplatesLock);
+		QHash<QString, SFRequestTemplate>::const_iterator i = sTemplates.constFind(key);
+		if (i != sTemplates.constEnd() && i.value().isCurrent(credentials, generation)) {
+			return i.value();
+		}
+	}
+
+	SFRequestTemplate prepared = prepare(credentials, generation, endPoint, apiVersion, userAgent);
+	if (prepared.isValid()) {
+		QMutexLocker locker(&sTemplatesLock);
+		sTemplates.insert(key, prepared);
+	}
+	return prepared;
+}
+
+void SFRequestTemplate::clearCache() {
+	QMutexLocker locker(&sTemplatesLock);
+	sTemplates.clear();
+}
+
+QNetworkRequest SFRequestTemplate::createRequest(const QString & path) const {
+	QNetworkRequest request(mPrototype);
+	if (!mHasPrefix) {
+		request.setUrl(mInstanceUrl.resolved(QUrl(path)));
+	} else {
+		request.setUrl(QUrl(mBaseUrl + path));
+	}
+	return request;
+}
+
+/***********************
+ * Privates
+ ***********************/
+SFRequestTemplate SFRequestTemplate::prepare(const SFOAuthCredentials * credentials, int generation, const QString & endPoint,
+		const QString & apiVersion, const QString & userAgent) {
+	SFRequestTemplate prepared;
+	QString accessToken = credentials ? credentials->getAccessToken() : QString();
+	QUrl base = credentials ? credentials->getInstanceUrl() : QUrl();
+	QString prefix = endPoint + apiVersion;
+	QUrl prefixUrl(prefix);
+
+	//validate some important info: instance Url and access token
+	if (!prefixUrl.isValid()) {
+		prepared.mErrorCode = SFResultCode::SFErrorNetwork;
+		prepared.mErrorMessage = QString("Invalid relative path: '%1'").arg(prefix);
+		return prepared;
+	} else if (accessToken.isEmpty()) {
+		prepared.mErrorCode = SFResultCode::SFErrorInvalidAccessToken;
+		prepared.mErrorMessage = QString("Access token is not available. Did you forget to authenticate first?");
+		return prepared;
+	} else if ((base.isEmpty() || !base.isValid()) && prefixUrl.isRelative()) {
+		prepared.mErrorCode = SFResultCode::SFErrorInvalidAccessToken;
+		prepared.mErrorMessage = QString("Instance URL is not valid: %1").arg(base.toString());
+		return prepared;
+	}
+
+	//the path of a call is appended to the resolved prefix, which is the same as resolving the whole relative URL.
+	//without a prefix the path is resolved on its own, it may be an absolute URL
+	if (prefix.isEmpty()) {
+		prepared.mBaseUrl = base.toString();
+	} else {
+		prepared.mBaseUrl = prefixUrl.isRelative() ? base.resolved(prefixUrl).toString() : prefix;
+	}
+	prepared.mHasPrefix = !prefix.isEmpty();
+
+	//the header block, encoded once
+	prepared.mPrototype.setRawHeader(kSFAuthorizationHeader, kSFBearerPrefix + accessToken.toUtf8());
+	if (!userAgent.isEmpty()) {
+		prepared.mPrototype.setRawHeader(kSFUserAgentHeader, userAgent.toUtf8());
+	}
+
+	prepared.mCredentials = credentials;
+	prepared.mInstanceUrl = base;
+	prepared.mGeneration = generation;
+	prepared.mErrorCode = SFResultCode::SFErrorNoError;
+	return prepared;
+}
+
+bool SFRequestTemplate::isCurrent(const SFOAuthCredentials * credentials, int generation) const {
+	//a new login or a refreshed token bumps the generation of the vault, the instance URL is checked in case it is set on its own
+	return this->isValid() && credentials && credentials == mCredentials && generation == mGeneration
+			&& credentials->getInstanceUrl() == mInstanceUrl;
+}
+
+} /* namespace sf */
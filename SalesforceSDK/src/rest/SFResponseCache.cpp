@@ -0,0 +1,65 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFResponseCache.cpp
+*/
+
+#include "SFResponseCache.h"
+#include <QCache>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace sf {
+
+static QCache<QString, SFResponseCache::Entry> sEntries(2048);
+static QMutex sEntriesLock;
+
+bool SFResponseCache::find(const QString & key, Entry * entry) {
+	QMutexLocker locker(&sEntriesLock);
+	Entry *found = sEntries.object(key);
+	if (!found) {
+		return false;
+	}
+	*entry = *found;
+	return true;
+}
+
+void SFResponseCache::insert(const QString & key, const Entry & entry, int size) {
+	QMutexLocker locker(&sEntriesLock);
+	//QCache drops an entry that costs more than the whole cache right away
+	sEntries.insert(key, new Entry(entry), qMax(1, size / 1024));
+}
+
+void SFResponseCache::remove(const QString & key) {
+	QMutexLocker locker(&sEntriesLock);
+	sEntries.remove(key);
+}
+
+void SFResponseCache::clear() {
+	QMutexLocker locker(&sEntriesLock);
+	sEntries.clear();
+}
+
+int SFResponseCache::maxCost() {
+	QMutexLocker locker(&sEntriesLock);
+	return sEntries.maxCost();
+}
+
+void SFResponseCache::setMaxCost(int kilobytes) {
+	QMutexLocker locker(&sEntriesLock);
+	sEntries.setMaxCost(qMax(1, kilobytes));
+}
+
+} /* namespace sf */
@@ -27,6 +27,7 @@
 #include <bb/Application>
 #include <QtNetwork/QNetworkRequest>
 #include <QTextStream>
+#include <QTimer>
 #include "SFGlobal.h"
 #include "SFRestRequest.h"
 #include "SFRestResourceTask.h"
@@ -34,6 +35,8 @@
 #include "SFOAuthCredentials.h"
 #include "SFAccountManager.h"
 #include "SFOAuthCoordinator.h"
+#include "SFRequestScheduler.h"
+#include "SFCollectionTask.h"
 namespace sf {
 
 SFRestAPI *SFRestAPI::sharedInstance = NULL;
@@ -41,7 +44,19 @@ SFRestAPI *SFRestAPI::sharedInstance = NULL;
 static const QChar SOSLReservedQChars[] = {'\\', '?', '&', '|', '!', '{', '}', '[', ']', '(', ')', '^', '~', '*', ':', '"', '\'', '+', '-'};
 static const QChar SOSLEscapeChar = '\\';
 
-SFRestAPI::SFRestAPI() : QObject(0), mEndPoint(DefaultEndpoint), mApiVersion(""), mUserAgent(this->constructUserAgent()), mPendingTasks() {
+static const int kSFMaxBatchSize = 25; //the limit of subrequests in a Composite Batch request
+static const QString kSFCompositePath = "/composite";
+static const QString kSFCompositeBatchPath = "/composite/batch";
+static const QString kSFBatchRequestsKey = "batchRequests";
+static const QString kSFBatchHaltOnErrorKey = "haltOnError";
+static const QString kSFBatchResultsKey = "results";
+static const QString kSFBatchStatusCodeKey = "statusCode";
+static const QString kSFBatchResultKey = "result";
+
+SFRestAPI::SFRestAPI() : QObject(0), mEndPoint(DefaultEndpoint), mApiVersion(""), mUserAgent(this->constructUserAgent()), mPendingTasks(),
+		mBatchWindow(0), mBatchTimer(new QTimer(this)), mBatchQueue(), mBatches(), mBatchSequence(0) {
+	mBatchTimer->setSingleShot(true);
+	connect(mBatchTimer, SIGNAL(timeout()), this, SLOT(onBatchWindowClosed()));
 	connect(SFAuthenticationManager::instance(), SIGNAL(SFOAuthFlowSuccess(SFOAuthInfo*)), this, SLOT(onSFOAuthFlowSuccess(SFOAuthInfo*)));
 	connect(SFAuthenticationManager::instance(), SIGNAL(SFOAuthFlowFailure(SFOAuthInfo*)), this, SLOT(onSFOAuthFlowFailure(SFOAuthInfo*)));
 	connect(SFAuthenticationManager::instance(), SIGNAL(SFOAuthFlowCanceled(SFOAuthInfo*)), this, SLOT(onSFOAuthFlowCanceled(SFOAuthInfo*)));
@@ -51,6 +66,10 @@ SFRestAPI::~SFRestAPI() {
 	for(QQueue<SFRestResourceTask*>::iterator i = mPendingTasks.begin(); i != mPendingTasks.end(); i++) {
 		(*i)->deleteLater();
 	}
+	qDeleteAll(mBatchQueue);
+	for(QHash<int, QList<SFRestResourceTask*> >::iterator i = mBatches.begin(); i != mBatches.end(); i++) {
+		qDeleteAll(i.value());
+	}
 }
 
 /****************************
@@ -67,9 +86,9 @@ const SFOAuthCredentials* SFRestAPI::currentCredentials() {
 	return SFAccountManager::instance()->getCoordinator()->getCredentials();
 }
 
-void SFRestAPI::sendRestRequest(SFRestRequest * request, QObject * resultReciever, const char * resultRecieverSlot, const QVariant & tag) {
+SFGenericTask * SFRestAPI::sendRestRequest(SFRestRequest * request, QObject * resultReciever, const char * resultRecieverSlot, const QVariant & tag) {
 	if (!request) {
-		return;
+		return NULL;
 	}
 
 	SFRestResourceTask *task = this->createRestTask(request, tag);
@@ -77,8 +96,10 @@ void SFRestAPI::sendRestRequest(SFRestRequest * request, QObject * resultRecieve
 	//we do manual connect here, in case we need to move the task to pending queue
 	connect(task, SIGNAL(taskResultReady(sf::SFResult*)), resultReciever, resultRecieverSlot);
 
-	this->startRestTask(task);
-
+	if (!this->enqueueBatchedTask(task)) {
+		this->startRestTask(task);
+	}
+	return task;
 }
 
 
@@ -94,7 +115,32 @@ void SFRestAPI::sendRestRequest(SFRestRequest * request, const QScriptValue & re
 	//we do manual connect here, in case we need to move the task to pending queue
 	qScriptConnect(task, SIGNAL(taskResultReady(sf::SFResult*)), resultReciever, resultRecieverSlot);
 
-	this->startRestTask(task);
+	if (!this->enqueueBatchedTask(task)) {
+		this->startRestTask(task);
+	}
+}
+
+void SFRestAPI::sendCollectionRequest(SFCollectionRequest * request, QObject * resultReciever, const char * resultRecieverSlot, const QVariant & tag) {
+	if (!request) {
+		return;
+	}
+
+	SFCollectionTask *task = this->createCollectionTask(request, tag);
+	if (resultReciever && resultRecieverSlot) {
+		connect(task, SIGNAL(taskResultReady(sf::SFResult*)), resultReciever, resultRecieverSlot);
+	}
+	task->start();
+}
+
+void SFRestAPI::sendCollectionRequest(SFCollectionRequest * request, const QScriptValue & resultReciever, const QScriptValue & resultRecieverSlot, const QVariant & tag) {
+	if (!request || !resultReciever.isQObject() || !resultRecieverSlot.isFunction() || !resultRecieverSlot.engine()) {
+		return;
+	}
+
+	SFCollectionTask *task = this->createCollectionTask(request, tag);
+	qScriptRegisterMetaType(resultRecieverSlot.engine(), SFResult::toScriptValue, SFResult::fromScriptValue);
+	qScriptConnect(task, SIGNAL(taskResultReady(sf::SFResult*)), resultReciever, resultRecieverSlot);
+	task->start();
 }
 
 SFRestRequest * SFRestAPI::requestForVersions() {
@@ -106,22 +152,29 @@ SFRestRequest * SFRestAPI::requestForResources() {
 	return new SFRestRequest(0, "/", HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
 }
 
-SFRestRequest * SFRestAPI::requestForDescribeGlobal() {
-	return new SFRestRequest(0, "/sobjects", HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+SFRestRequest * SFRestAPI::requestForDescribeGlobal(bool conditional) {
+	SFRestRequest * request = new SFRestRequest(0, "/sobjects", HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+	request->setConditional(conditional);
+	return request;
 }
 
-SFRestRequest * SFRestAPI::requestForMetadata(const QString & objectType) {
-	return new SFRestRequest(0, QString("/sobjects/%1").arg(objectType), HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+SFRestRequest * SFRestAPI::requestForMetadata(const QString & objectType, bool conditional) {
+	SFRestRequest * request = new SFRestRequest(0, QString("/sobjects/%1").arg(objectType), HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+	request->setConditional(conditional);
+	return request;
 }
 
-SFRestRequest * SFRestAPI::requestForDescribeObject(const QString & objectType) {
-	return new SFRestRequest(0, QString("/sobjects/%1/describe").arg(objectType), HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+SFRestRequest * SFRestAPI::requestForDescribeObject(const QString & objectType, bool conditional) {
+	SFRestRequest * request = new SFRestRequest(0, QString("/sobjects/%1/describe").arg(objectType), HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+	request->setConditional(conditional);
+	return request;
 }
 
-SFRestRequest * SFRestAPI::requestForRetrieveObject(const QString & objectType, const QString & objectId, const QStringList & fieldList) {
+SFRestRequest * SFRestAPI::requestForRetrieveObject(const QString & objectType, const QString & objectId, const QStringList & fieldList, bool conditional) {
 	QString path = QString("/sobjects/%1/%2").arg(objectType, objectId);
 	QString fieldsStr = fieldList.join(",");
 	SFRestRequest * request = new SFRestRequest(0, path, HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+	request->setConditional(conditional);
 	if (fieldList.size() != 0) {
 		QVariantMap params;
 		params["fields"] = fieldsStr;
@@ -160,6 +213,28 @@ SFRestRequest * SFRestAPI::requestForDeleteObject(const QString & objectType, co
     return new SFRestRequest(0, path, HTTPMethod::HTTPDelete, this->mApiVersion);
 }
 
+SFCollectionRequest * SFRestAPI::requestForCreateObjects(const QString & objectType, const QVariantList & records, bool allOrNone) {
+	SFCollectionRequest *request = new SFCollectionRequest(HTTPMethod::HTTPPost, objectType, records, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+	request->setAllOrNone(allOrNone);
+	return request;
+}
+
+SFCollectionRequest * SFRestAPI::requestForUpdateObjects(const QString & objectType, const QVariantList & records, bool allOrNone) {
+	SFCollectionRequest *request = new SFCollectionRequest(HTTPMethod::HTTPPatch, objectType, records, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+	request->setAllOrNone(allOrNone);
+	return request;
+}
+
+SFCollectionRequest * SFRestAPI::requestForDeleteObjects(const QStringList & objectIds, bool allOrNone) {
+	QVariantList ids;
+	for(QStringList::const_iterator i = objectIds.constBegin(); i != objectIds.constEnd(); i++) {
+		ids.append(*i);
+	}
+	SFCollectionRequest *request = new SFCollectionRequest(HTTPMethod::HTTPDelete, QString(), ids, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+	request->setAllOrNone(allOrNone);
+	return request;
+}
+
 SFRestRequest * SFRestAPI::requestForQuery(const QString & soql) {
 	SFRestRequest *request = new SFRestRequest(0, "/query", HTTPMethod::HTTPGet, this->mApiVersion, this->mEndPoint, this->mUserAgent);
 	QVariantMap params;
@@ -178,6 +253,16 @@ SFRestRequest * SFRestAPI::requestForSearch(const QString & sosl) {
 	return request;
 }
 
+SFRestRequest * SFRestAPI::requestForComposite(SFCompositeRequest * composite) {
+	if (!composite || composite->count() == 0) {
+		return NULL;
+	}
+	SFRestRequest *request = new SFRestRequest(0, kSFCompositePath, HTTPMethod::HTTPPost, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+	request->setRequestParams(composite->toRequestBody());
+	request->setParamsContentType(SFRestRequest::HTTPContentTypeJSON);
+	return request;
+}
+
 SFRestRequest * SFRestAPI::customRequest(const QString & path,
 		const HTTPMethodType & method,
 		const QVariantMap & params,
@@ -322,21 +407,90 @@ void SFRestAPI::onTaskShouldRetry(SFGenericTask* genericTask, SFResult*) {
 	SFAuthenticationManager::instance()->login();
 }
 
+void SFRestAPI::onBatchWindowClosed() {
+	mBatchTimer->stop();
+	while (!mBatchQueue.isEmpty()) {
+		QList<SFRestResourceTask*> tasks = mBatchQueue.mid(0, kSFMaxBatchSize);
+		mBatchQueue.erase(mBatchQueue.begin(), mBatchQueue.begin() + tasks.size());
+		if (tasks.size() == 1) {
+			//nothing to share the round trip with
+			this->startRestTask(tasks.first());
+			continue;
+		}
+
+		QVariantList subrequests;
+		SFRequestPriorityType priority = SFRequestPriority::BackgroundSync;
+		for(QList<SFRestResourceTask*>::const_iterator i = tasks.constBegin(); i != tasks.constEnd(); i++) {
+			subrequests.append((*i)->restRequest()->toBatchSubrequest());
+			priority = qMin(priority, (*i)->priority());
+		}
+		QVariantMap params;
+		params[kSFBatchRequestsKey] = subrequests;
+		params[kSFBatchHaltOnErrorKey] = false;
+
+		SFRestRequest *request = new SFRestRequest(0, kSFCompositeBatchPath, HTTPMethod::HTTPPost, this->mApiVersion, this->mEndPoint, this->mUserAgent);
+		request->setRequestParams(params);
+		request->setParamsContentType(SFRestRequest::HTTPContentTypeJSON);
+		request->setJsonParser(SFRestRequest::JsonParserIndexed);
+		request->setPriority(priority);
+
+		int batchId = ++mBatchSequence;
+		mBatches.insert(batchId, tasks);
+		SFRestResourceTask *task = this->createRestTask(request, batchId);
+		connect(task, SIGNAL(taskResultReady(sf::SFResult*)), this, SLOT(onBatchResultReady(sf::SFResult*)));
+		this->startRestTask(task);
+	}
+}
+
+void SFRestAPI::onBatchResultReady(SFResult* result) {
+	QList<SFRestResourceTask*> tasks = mBatches.take(result->getTag<int>(kSFRestRequestTag));
+	QVariantList responses;
+	if (!result->hasError()) {
+		responses = result->payload<QVariantMap>().value(kSFBatchResultsKey).toList();
+	}
+
+	if (responses.size() != tasks.size()) {
+		//the batch failed as a whole, e.g. composite resources are not available in this API version. Send the requests on their own,
+		//so each of them fails or succeeds the way it would have without batching
+		sfWarning() << "[SFRestAPI] Composite Batch request failed:" << result->code() << result->message() << ". Sending" << tasks.size() << "requests separately.";
+		for(QList<SFRestResourceTask*>::const_iterator i = tasks.constBegin(); i != tasks.constEnd(); i++) {
+			this->startRestTask(*i);
+		}
+		return;
+	}
+
+	for(int i = 0; i < tasks.size(); i++) {
+		QVariantMap response = responses.at(i).toMap();
+		tasks.at(i)->finishWithSubresponse(response.value(kSFBatchStatusCodeKey).toInt(), response.value(kSFBatchResultKey));
+	}
+}
+
 /****************************
  * Protected
  ****************************/
 SFRestResourceTask* SFRestAPI::createRestTask(SFRestRequest * request, const QVariant & tag) {
 	SFRestResourceTask *task = new SFRestResourceTask(getSharedNetworkAccessManager(), request);
+	task->setPriority(request->priority());
 	if (!tag.isNull() && tag.isValid()) {
 		task->putTag(kSFRestRequestTag, tag);
 	}
 
 	task->setRetryCount(1); // give it a change to refresh token and retry;
+	//the caller of sendRestRequest() may cancel the task
+	task->setCancellable(true);
 	connect(task, SIGNAL(taskShouldRetry(sf::SFGenericTask*, sf::SFResult*)), this, SLOT(onTaskShouldRetry(sf::SFGenericTask*, sf::SFResult*)));
 
 	return task;
 }
 
+SFCollectionTask* SFRestAPI::createCollectionTask(SFCollectionRequest * request, const QVariant & tag) {
+	SFCollectionTask *task = new SFCollectionTask(request);
+	if (!tag.isNull() && tag.isValid()) {
+		task->putTag(kSFRestRequestTag, tag);
+	}
+	return task;
+}
+
 void SFRestAPI::startRestTask(SFRestResourceTask * task) {
 	const SFOAuthCredentials* credential = this->currentCredentials();
 	if (!credential || credential->getAccessToken().isNull() || credential->getAccessToken().isEmpty() || !credential->getInstanceUrl().isValid()) {
@@ -346,15 +500,39 @@ void SFRestAPI::startRestTask(SFRestResourceTask * task) {
 			SFAuthenticationManager::instance()->login();
 		}
 	} else {
-		task->startTaskAsync();
+		SFRequestScheduler::instance()->submit(task, credential->getInstanceUrl().host());
 	}
 }
 
+bool SFRestAPI::enqueueBatchedTask(SFRestResourceTask * task) {
+	SFRestRequest *request = task->restRequest();
+	if (mBatchWindow <= 0 || !request || !request->canBeBatched()
+			|| request->endPoint() != this->mEndPoint || request->apiVersion() != this->mApiVersion) {
+		return false;
+	}
+
+	mBatchQueue.append(task);
+	if (mBatchQueue.size() >= kSFMaxBatchSize) {
+		this->onBatchWindowClosed();
+	} else if (!mBatchTimer->isActive()) {
+		//the window opens with the first request and is not extended by the following ones
+		mBatchTimer->start(mBatchWindow);
+	}
+	return true;
+}
+
 void SFRestAPI::resendAllPendingTasks() {
+	const SFOAuthCredentials* credential = this->currentCredentials();
+	QString host = credential ? credential->getInstanceUrl().host() : QString();
 	while(mPendingTasks.size() != 0) {
 		SFRestResourceTask *task = mPendingTasks.dequeue();
 		//we run the task anyway. The task would eventually fail and trigger proper signals
-		QMetaObject::invokeMethod(task, "startTaskAsync", Qt::QueuedConnection);
+		if (SFRequestScheduler::instance()->isRunning(task)) {
+			//waited for a new access token, it still holds its slot
+			QMetaObject::invokeMethod(task, "startTaskAsync", Qt::QueuedConnection);
+		} else {
+			SFRequestScheduler::instance()->submit(task, host);
+		}
 	}
 }
 
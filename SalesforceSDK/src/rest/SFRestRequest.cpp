@@ -25,20 +25,31 @@
 #include "SFOAuthCoordinator.h"
 #include "SFOAuthCredentials.h"
 #include "SFRestAPI.h"
-#include <bb/data/JsonDataAccess>
+#include "SFResponseConsumer.h"
+#include "SFBodyEncoder.h"
+#include "SFRequestTemplate.h"
+#include <QUuid>
 
 namespace sf {
 
 const QString DefaultEndpoint = "/services/data";
 static const QString ContentTypeUrlEncoded = "application/x-www-form-urlencoded; charset=utf-8";
 static const QString ContentTypeJSON = "application/json; charset=utf-8";
-static const QString ContentTypeMultiPart = "multipart/form-data";
+static const QString ContentTypeMultiPart = "multipart/form-data; boundary=%1";
+
+//the resources a Composite Batch subrequest may address
+static const char * const kSFBatchResources[] = {"/sobjects", "/query", "/queryAll", "/search"};
+static const char * const kSFBatchMethodNames[] = {"GET", "HEAD", "DELETE", "POST", "PUT", "PATCH"};
+static const QByteArray kSFSubrequestUrlSafeChars = "/?&=:@{},%+"; //keeps "@{refId.id}" references of composite requests readable
+static const QString kSFBatchBodyKey = "richInput";
+static const QString kSFCompositeBodyKey = "body";
+static const QString kSFReferenceIdKey = "referenceId";
 
 static const QString kAccessTokenHeader = "Authorization";
 static const QString AccessTokenPrefix = "Bearer ";
 
 SFRestRequest::SFRestRequest(QObject * parent, const QString & path, const HTTPMethodType & method, const QString & apiVersion, const QString & endPoint, const QString & userAgent)
-: QObject(parent), mRequestParams(), mParamsContentType(HTTPContentTypeUrlEncoded), mRequestRawData(), mRequestRawHeaders() {
+: QObject(parent), mRequestParams(), mParamsContentType(HTTPContentTypeUrlEncoded), mRequestRawData(), mRequestRawHeaders(), mJsonParser(JsonParserDefault), mPayloadType(PayloadVariant), mStripRecordAttributes(false), mRecordDescribe(), mConditional(false), mPriority(SFRequestPriority::Interactive), mResponseConsumer(NULL) {
 	this->mMethod = method;
 	this->mEndPoint = endPoint;
 	this->mApiVersion = apiVersion;
@@ -51,7 +62,14 @@ SFRestRequest::SFRestRequest(QObject * parent, const QString & path, const HTTPM
 }
 
 SFRestRequest::~SFRestRequest() {
+	delete mResponseConsumer;
+}
 
+void SFRestRequest::setResponseConsumer(SFResponseConsumer * consumer) {
+	if (consumer != mResponseConsumer) {
+		delete mResponseConsumer;
+		mResponseConsumer = consumer;
+	}
 }
 
 QVariant SFRestRequest::param(const QString & key) {
@@ -93,11 +111,6 @@ SFResultCodeType SFRestRequest::prepareNetworkRequest(QNetworkRequest *pOutReque
 		return errorCode;
 	}
 
-	//additional settings
-	if (!mUserAgent.isNull() && !mUserAgent.isEmpty()) {
-		pOutRequest->setRawHeader(QString("User-Agent").toUtf8(), mUserAgent.toUtf8());
-	}
-
 	//add additional headers if available
 	for(QVariantMap::const_iterator i = mRequestRawHeaders.constBegin(); i != mRequestRawHeaders.constEnd(); i++) {
 		if (!i.key().isNull() && i.value().type() != QVariant::ByteArray && i.value().canConvert<QString>()) {
@@ -138,8 +151,10 @@ SFResultCodeType SFRestRequest::prepareNetworkRequest(QNetworkRequest *pOutReque
 		}
 	}
 
-	//for debug
+	//for debug, composing the summary is not free, so skip it when the output is discarded anyway
+#if !defined(SF_NO_DEBUG_OUTPUT) && !defined(SF_NO_WARNING_OUTPUT)
 	sfDebug() << "[SFRestRequest] Request Summary:\n"<< this->composeRequestSummary(*pOutRequest, *pOutData);
+#endif
 	return SFResultCode::SFErrorNoError;
 }
 
@@ -156,46 +171,84 @@ QString SFRestRequest::extractAccessToken(const QNetworkRequest & request) {
 	return headerValue.mid(AccessTokenPrefix.length());
 }
 
+static bool isBatchResource(const QString & path) {
+	for (uint i = 0; i < sizeof(kSFBatchResources) / sizeof(kSFBatchResources[0]); i++) {
+		QLatin1String resource(kSFBatchResources[i]);
+		if (path.startsWith(resource)) {
+			int length = qstrlen(kSFBatchResources[i]);
+			if (path.length() == length || path.at(length) == '/' || path.at(length) == '?') {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool SFRestRequest::canBeBatched() const {
+	//a conditional request needs its own validators and 304 status, which a subrequest can't carry
+	if (mApiVersion.isEmpty() || !isBatchResource(mPath) || mConditional
+			|| !mRequestRawData.isEmpty() || !mRequestBodyFile.isEmpty() || !mRequestRawHeaders.isEmpty() || !mCapturedResponseHeaders.isEmpty() || mResponseConsumer || mPayloadType != PayloadVariant) {
+		return false;
+	}
+	switch (mMethod) {
+	case HTTPMethod::HTTPGet:
+	case HTTPMethod::HTTPDelete:
+		return true;
+	case HTTPMethod::HTTPPost:
+	case HTTPMethod::HTTPPatch:
+		//the body of a subrequest is a JSON object
+		return mRequestParams.isEmpty() || mParamsContentType == HTTPContentTypeJSON;
+	default:
+		return false;
+	}
+}
+
+QVariantMap SFRestRequest::toBatchSubrequest() const {
+	//the URL is relative to the end point, so the version loses its leading slash
+	return this->toSubrequest(mApiVersion.startsWith('/') ? mApiVersion.mid(1) : mApiVersion, kSFBatchBodyKey);
+}
+
+QVariantMap SFRestRequest::toCompositeSubrequest(const QString & referenceId) const {
+	QVariantMap subrequest = this->toSubrequest(mEndPoint + mApiVersion, kSFCompositeBodyKey);
+	subrequest[kSFReferenceIdKey] = referenceId;
+	return subrequest;
+}
+
 /***********************
  * Privates
  ***********************/
 SFResultCodeType SFRestRequest::createNetworkRequest(QNetworkRequest *pOutRequest, QString * pOutErrorMsg) {
 
-	SFResultCodeType errorCode = SFResultCode::SFErrorNoError;
-	QString errorMsg;
-	const SFOAuthCredentials* credentials = SFRestAPI::instance()->currentCredentials();
-	QString accessToken = credentials->getAccessToken();
-	QUrl base = credentials->getInstanceUrl();
-	QString urlTemplate = QString("%1%2%3");
-	QUrl relativeUrl(urlTemplate.arg(mEndPoint.isNull() ? "":mEndPoint, mApiVersion.isNull() ? "":mApiVersion, mPath.isNull() ? "":mPath));
-
-	//validate some important info: instance Url, access token and overall path
-	if (!relativeUrl.isValid() || relativeUrl.isEmpty()) {
-		errorCode = SFResultCode::SFErrorNetwork;
-		errorMsg = QString("Invalid relative path: '%1'").arg(relativeUrl.toString());
-	} else if (accessToken.isNull() || accessToken.isEmpty()) {
-		errorCode = SFResultCode::SFErrorInvalidAccessToken;
-		errorMsg = QString("Access token is not available. Did you forget to authenticate first?");
-	} else if ((base.isEmpty() || !base.isValid()) && relativeUrl.isRelative()) {
-		errorCode = SFResultCode::SFErrorInvalidAccessToken;
-		errorMsg = QString("Instance URL is not valid: %1").arg(base.toString());
+	//the base URL and the header block with the access token and the user agent are prepared once per session
+	SFRequestTemplate prepared = SFRequestTemplate::prepared(mEndPoint, mApiVersion, mUserAgent);
+	if (!prepared.isValid()) {
+		if (pOutErrorMsg) *pOutErrorMsg = prepared.errorMessage();
+		return prepared.errorCode();
 	}
 
-	if (errorCode != 0) {
-		if (pOutErrorMsg) *pOutErrorMsg = errorMsg;
-		return errorCode;
+	QNetworkRequest request = prepared.createRequest(mPath);
+	if (!request.url().isValid() || (mEndPoint.isEmpty() && mApiVersion.isEmpty() && mPath.isEmpty())) {
+		if (pOutErrorMsg) *pOutErrorMsg = QString("Invalid relative path: '%1%2%3'").arg(mEndPoint, mApiVersion, mPath);
+		return SFResultCode::SFErrorNetwork;
 	}
 
-	// now construct the request
-	QUrl url = relativeUrl.isRelative() ? base.resolved(relativeUrl) : relativeUrl;
-	QNetworkRequest request(url);
+	if (pOutRequest) *pOutRequest = request;
+	return SFResultCode::SFErrorNoError;
+}
 
-	//insert access token into header
-	QString headerValue = QString("%1%2").arg(AccessTokenPrefix, accessToken);
-	request.setRawHeader(kAccessTokenHeader.toUtf8(), headerValue.toUtf8());
+QVariantMap SFRestRequest::toSubrequest(const QString & base, const QString & bodyKey) const {
+	QVariantMap subrequest;
+	subrequest["method"] = QString(kSFBatchMethodNames[mMethod]);
 
-	if (pOutRequest) *pOutRequest = request;
-	return errorCode;
+	QByteArray url = QUrl::toPercentEncoding(base + mPath, kSFSubrequestUrlSafeChars);
+	if (!mRequestParams.isEmpty() && mMethod <= HTTPMethod::HTTPDelete) {
+		url.append(url.contains('?') ? '&' : '?');
+		url.append(SFBodyEncoder::encodeUrlEncoded(mRequestParams));
+	} else if (!mRequestParams.isEmpty()) {
+		subrequest[bodyKey] = mRequestParams;
+	}
+	subrequest["url"] = QString::fromAscii(url.constData(), url.size());
+	return subrequest;
 }
 
 bool SFRestRequest::encodeParamsToURL(QUrl & url) {
@@ -203,25 +256,20 @@ bool SFRestRequest::encodeParamsToURL(QUrl & url) {
 		return false;
 	}
 
-		for(QVariantMap::const_iterator i = mRequestParams.constBegin(); i != mRequestParams.constEnd(); i++) {
-			if (i.key().isNull() || i.key().isEmpty()) {
-				sfWarning() << "[SFRestRequest] Invalid parameter key";
-				continue;
-			}
-
-			QString value;
-			if (i.value().type() != QVariant::ByteArray && i.value().canConvert<QString>()) {
-				value = i.value().value<QString>();
-			} else if (i.value().canConvert<QByteArray>()) {
-				value = i.value().value<QByteArray>().toBase64();
-			} else {
-				sfWarning() << "[SFRestRequest] Invalid parameter value:" << i.value();
-				continue;
-			}
-
-			url.addEncodedQueryItem(i.key().toUtf8(), QUrl::toPercentEncoding(value));
-		}
-
+	//append all the parameters to the existing query at once
+	SFBodyEncoder counter;
+	counter.writeUrlEncoded(mRequestParams);
+	if (counter.size() == 0) {
+		return true;
+	}
+	QByteArray query = url.encodedQuery();
+	query.reserve(query.size() + 1 + counter.size());
+	if (!query.isEmpty()) {
+		query.append('&');
+	}
+	SFBodyEncoder encoder(&query);
+	encoder.writeUrlEncoded(mRequestParams);
+	url.setEncodedQuery(query);
 	return true;
 }
 
@@ -232,60 +280,27 @@ bool SFRestRequest::encodeParamsToData(QByteArray * pOutBytes, QString * pOutCon
 
 	switch(this->mParamsContentType) {
 	case HTTPContentTypeJSON: {
-		*pOutBytes = QByteArray(); //clean byte array
-		using namespace bb::data;
-		JsonDataAccess jda;
-		jda.saveToBuffer(QVariant::fromValue<QVariantMap>(mRequestParams), pOutBytes);
-		if (jda.hasError()) {
+		if (!SFBodyEncoder::encodeJson(mRequestParams, pOutBytes)) {
 			return false;
 		}
 		*pOutContentType = ContentTypeJSON;
 		return true;
 	}
 	case HTTPContentTypeMultiPart: {
-		//Currently not supported
-		*pOutContentType = ContentTypeMultiPart;
-		return false;
+		QByteArray boundary = "SFBoundary" + QUuid::createUuid().toString().toAscii().mid(1, 36);
+		*pOutBytes = SFBodyEncoder::encodeMultipart(mRequestParams, boundary);
+		*pOutContentType = ContentTypeMultiPart.arg(QString(boundary));
+		return true;
 	}
 	case HTTPContentTypeUrlEncoded:
 	default: {
-		this->createUrlEncodedContent(pOutBytes);
+		*pOutBytes = SFBodyEncoder::encodeUrlEncoded(mRequestParams);
 		*pOutContentType = ContentTypeUrlEncoded;
 		return true;
 	}
 	}
 }
 
-void SFRestRequest::createUrlEncodedContent(QByteArray *pOutBytes) {
-
-	QString content = "";
-	for(QVariantMap::const_iterator i = mRequestParams.constBegin(); i != mRequestParams.constEnd(); i++) {
-		if (i.key().isNull() || i.key().isEmpty()) {
-			sfWarning() << "[SFRestRequest] Invalid parameter key";
-			continue;
-		}
-
-		QString value;
-		if (i.value().type() != QVariant::ByteArray && i.value().canConvert<QString>()) {
-			value = i.value().value<QString>();
-		} else if (!i.value().isNull() && i.value().canConvert<QByteArray>()) {
-			value = i.value().value<QByteArray>().toBase64();
-		} else {
-			sfWarning() << "[SFRestRequest] Invalid parameter value:" << i.value();
-			continue;
-		}
-
-		//No need to encode, it will go into request body
-		if (i == mRequestParams.constBegin()) {
-			content += QString("%1=%2").arg(i.key(), value);
-		} else {
-			content += QString("&%1=%2").arg(i.key(), value);
-		}
-	}
-
-	*pOutBytes = content.toUtf8();
-}
-
 QString SFRestRequest::composeRequestSummary(const QNetworkRequest & request, QByteArray & data) {
 	QString content = "URL: %1\nHeaders:\n%2\nContent:\n%3";
 	content = content.arg(request.url().toString());
@@ -24,16 +24,48 @@
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QNetworkAccessManager>
 #include <bb/data/JsonDataAccess>
+#include <QFile>
 #include <QStringList>
 #include "SFGlobal.h"
 #include "SFResult.h"
+#include "SFJsonIndexParser.h"
+#include "SFJsonView.h"
+#include "SFRecordBatch.h"
+#include "SFResponseCache.h"
 
 using namespace bb::data;
 
 namespace sf {
 
+static const QString kSFRecordsKey = "records";
+static const QString kSFRecordAttributesKey = "attributes";
+static const QByteArray kSFETagHeader = "ETag";
+static const QByteArray kSFLastModifiedHeader = "Last-Modified";
+static const QByteArray kSFIfNoneMatchHeader = "If-None-Match";
+static const QByteArray kSFIfModifiedSinceHeader = "If-Modified-Since";
+
+/* drops the "attributes" members of records and of the records nested in them */
+static void stripRecordAttributes(QVariant & value) {
+	if (value.type() == QVariant::Map) {
+		QVariantMap map = value.toMap();
+		value.clear(); //so that the map is modified in place instead of copied
+		map.remove(kSFRecordAttributesKey);
+		for (QVariantMap::iterator i = map.begin(); i != map.end(); i++) {
+			stripRecordAttributes(i.value());
+		}
+		value = map;
+	} else if (value.type() == QVariant::List) {
+		QVariantList list = value.toList();
+		value.clear();
+		for (QVariantList::iterator i = list.begin(); i != list.end(); i++) {
+			stripRecordAttributes(*i);
+		}
+		value = list;
+	}
+}
+
 SFRestResourceTask::SFRestResourceTask(QNetworkAccessManager * const networkAccessManager, SFRestRequest * request)
-: SFNetworkAccessTask(networkAccessManager) {
+: SFNetworkAccessTask(networkAccessManager), mRecordBatchConsumer(NULL) {
 	this->mRestRequest = request;
 	if (request) {
 		request->setParent(this);
@@ -42,7 +74,50 @@ SFRestResourceTask::SFRestResourceTask(QNetworkAccessManager * const networkAcce
 }
 
 SFRestResourceTask::~SFRestResourceTask() {
+	//the parsing pool must not see the consumer once it is deleted
+	this->closeResponseStream();
+	delete mRecordBatchConsumer;
+}
+
+void SFRestResourceTask::finishWithSubresponse(int statusCode, const QVariant & content) {
+	mStatus = TaskStatusRunning;
+	if (!mOwnerThread) {
+		//a re-try on 401 sends the task through the network thread, the result must still come back here
+		mOwnerThread = this->thread();
+	}
+	this->prepare();
+
+	//same steps as processReply(), minus the parsing
+	NetworkTaskState state = this->processStatusCode(statusCode, QString(), NULL);
+	if (content.isValid() && !content.isNull()) {
+		QVariant contentObj = content;
+		if (state == StateFinished && this->mRestRequest->stripRecordAttributes() && contentObj.type() == QVariant::Map) {
+			QVariantMap map = contentObj.toMap();
+			contentObj.clear();
+			QVariantMap::iterator records = map.find(kSFRecordsKey);
+			if (records != map.end()) {
+				stripRecordAttributes(*records);
+			}
+			contentObj = map;
+		}
+		if (this->parseJsonContent(contentObj) == StateError) {
+			state = StateError;
+		}
+	}
 
+	mState = state;
+	switch (state) {
+	case StateFinished:
+		mStatus = TaskStatusFinished;
+		break;
+	case StateNeedToRetry:
+		mStatus = TaskStatusWillRetry;
+		break;
+	default:
+		mStatus = TaskStatusError;
+		break;
+	}
+	this->cleanup();
 }
 
 SFNetworkAccessTask::NetworkTaskState SFRestResourceTask::ensureRequest() {
@@ -60,6 +135,57 @@ SFNetworkAccessTask::NetworkTaskState SFRestResourceTask::ensureRequest() {
 		return SFNetworkAccessTask::StateError;
 	}
 	this->mMethod = this->mRestRequest->method();
+	SFResponseConsumer *consumer = this->mRestRequest->responseConsumer();
+	if (!consumer && this->mRestRequest->payloadType() == SFRestRequest::PayloadRecordBatch) {
+		//the columns are built while the records download, the records are never all decoded at once
+		if (!mRecordBatchConsumer) {
+			mRecordBatchConsumer = new SFRecordBatchConsumer(this->mRestRequest->recordDescribe());
+			mRecordBatchConsumer->setStripAttributes(this->mRestRequest->stripRecordAttributes());
+		}
+		consumer = mRecordBatchConsumer;
+	}
+	this->setResponseConsumer(consumer);
+	this->setCapturedResponseHeaders(this->mRestRequest->capturedResponseHeaders());
+
+	if (!this->mRestRequest->requestBodyFile().isEmpty()) {
+		//the body is read from the file while it is uploaded, a re-tried task opens the file again
+		QFile *file = new QFile(this->mRestRequest->requestBodyFile());
+		if (!file->open(QIODevice::ReadOnly)) {
+			this->mResult = mResult ? mResult : SFResult::createErrorResult(SFResultCode::SFErrorGeneric,
+					QString("Cannot read %1: %2").arg(file->fileName(), file->errorString()));
+			delete file;
+			return SFNetworkAccessTask::StateError;
+		}
+		if (this->mRequestData) {
+			this->mRequestData->deleteLater();
+		}
+		this->mRequestBytesArray = QByteArray();
+		this->setRequestData(file);
+		this->mRequest.setHeader(QNetworkRequest::ContentTypeHeader, this->mRestRequest->requestBodyContentType());
+		this->mRequest.setHeader(QNetworkRequest::ContentLengthHeader, file->size());
+		this->mRequest.setAttribute(QNetworkRequest::DoNotBufferUploadDataAttribute, true);
+	}
+
+	this->mCacheKey.clear();
+	this->mCachedPayload = QVariant();
+	if (this->mRestRequest->isConditional() && this->mMethod == HTTPMethod::HTTPGet && !this->mRestRequest->responseConsumer()
+			&& this->mRestRequest->payloadType() != SFRestRequest::PayloadRecordBatch) {
+		//the same URL gives a different payload for another payload type
+		this->mCacheKey = QString("%1%2 %3").arg(this->mRestRequest->payloadType()).arg(this->mRestRequest->stripRecordAttributes())
+				.arg(this->mRequest.url().toString());
+		SFResponseCache::Entry entry;
+		//validators set by the caller win, the caller keeps its own copy of the payload then
+		if (!this->mRequest.hasRawHeader(kSFIfNoneMatchHeader) && !this->mRequest.hasRawHeader(kSFIfModifiedSinceHeader)
+				&& SFResponseCache::find(this->mCacheKey, &entry)) {
+			if (!entry.eTag.isEmpty()) {
+				this->mRequest.setRawHeader(kSFIfNoneMatchHeader, entry.eTag);
+			}
+			if (!entry.lastModified.isEmpty()) {
+				this->mRequest.setRawHeader(kSFIfModifiedSinceHeader, entry.lastModified);
+			}
+			this->mCachedPayload = entry.payload;
+		}
+	}
 
 	return SFNetworkAccessTask::ensureRequest();
 }
@@ -69,6 +195,23 @@ SFNetworkAccessTask::NetworkTaskState SFRestResourceTask::processReply(QNetworkR
 	bool hasStatusCode = false;
 	int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(&hasStatusCode);
 	QString reason = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toString();
+
+	if (this->isResponseStreamed()) {
+		//the consumer already has most of the body, let it finish before looking at the status
+		NetworkTaskState streamState = this->finishResponseStream(reply);
+		if (streamState != StateFinished) {
+			return streamState;
+		}
+		//only successful responses are streamed
+		NetworkTaskState state = this->processStatusCode(statusCode, reason, reply);
+		sfDebug() << "[SFRestResourceTask] Response Summary:" << statusCode << "-" << reason
+				<< "\nHeader: \n" << this->composeReplyHeader(reply) << "\nContent: streamed";
+		if (state != StateFinished) {
+			return state;
+		}
+		return this->parseJsonContent(this->responseConsumer()->result());
+	}
+
 	QByteArray buffer = reply->readAll();
 
 	//process status code or error code
@@ -79,30 +222,81 @@ SFNetworkAccessTask::NetworkTaskState SFRestResourceTask::processReply(QNetworkR
 		state = this->processNetworkErrorCode(reply->error(), reply->errorString());
 	}
 
-	//for debug
+	//for debug, converting the whole body is not free, so skip it when the output is discarded anyway
+#if !defined(SF_NO_DEBUG_OUTPUT) && !defined(SF_NO_WARNING_OUTPUT)
 	sfDebug() << "[SFRestResourceTask] Response Summary:"<< (hasStatusCode ? statusCode : reply->error()) << "-"
 			<< ((reason.isNull() || reason.isEmpty()) ? reply->errorString() : reason)
 			<< "\nHeader: \n" << this->composeReplyHeader(reply) << "\nContent: \n" << QString(buffer);
+#endif
+
+	if (state == StateFinished && statusCode == SFResultCode::SFRestStatusNoChanges) {
+		//no body, the payload is the one the validators were sent for
+		mResult->mPayload = this->mCachedPayload;
+		return state;
+	}
 
 	//parse json
-	JsonDataAccess jda;
-	QVariant contentObj = jda.loadFromBuffer(buffer);
-	if (jda.hasError()) {
+	QVariant contentObj;
+	bool parsed = false;
+	int code = SFResultCode::SFErrorGeneric;
+	QString err;
+	if (state == StateFinished && this->mRestRequest->payloadType() == SFRestRequest::PayloadJsonView) {
+		//index only, values are decoded when they are accessed
+		SFJsonView view = SFJsonView::fromJson(buffer, &err);
+		parsed = view.isValid();
+		contentObj = QVariant::fromValue(view);
+	} else if (this->mRestRequest->jsonParser() == SFRestRequest::JsonParserIndexed) {
+		SFJsonIndexParser parser(buffer);
+		parser.setStripRecordAttributes(this->mRestRequest->stripRecordAttributes());
+		parsed = parser.parse();
+		contentObj = parser.result();
+		err = parser.errorString();
+	} else {
+		JsonDataAccess jda;
+		contentObj = jda.loadFromBuffer(buffer);
+		parsed = !jda.hasError();
+		if (!parsed) {
+			err = jda.error().errorMessage();
+			code = jda.error().errorType();
+		} else if (this->mRestRequest->stripRecordAttributes() && contentObj.type() == QVariant::Map) {
+			QVariantMap content = contentObj.toMap();
+			contentObj.clear(); //so that the maps below are modified in place instead of copied
+			QVariantMap::iterator records = content.find(kSFRecordsKey);
+			if (records != content.end()) {
+				stripRecordAttributes(*records);
+			}
+			contentObj = content;
+		}
+	}
+	if (!parsed) {
 		//check if the content is empty
-		QString content = QString(buffer);
-		if (content.isNull() || content.trimmed().isEmpty()) {
+		if (buffer.trimmed().isEmpty()) {
 			//no content, we rely on status code and reason phrase
 			return state;
 		} else {
 			//parsing error
-			QString err = jda.error().errorMessage();
-			int code = jda.error().errorType();
 			mResult = mResult ? mResult : SFResult::createErrorResult(code, err);
 			return StateError;
 		}
+	} else if (state == StateFinished && this->mRestRequest->payloadType() == SFRestRequest::PayloadRecordBatch
+			&& contentObj.type() == QVariant::Map) {
+		//the decoded records are released once they are copied into the columns
+		SFRecordBatch batch = SFRecordBatch::fromQueryResult(contentObj.toMap(), this->mRestRequest->recordDescribe());
+		return this->parseJsonContent(QVariant::fromValue(batch)) == StateError ? StateError : state;
 	} else if (this->parseJsonContent(contentObj) == StateError) {
 		return StateError;
 	} else {
+		if (state == StateFinished && !this->mCacheKey.isEmpty()) {
+			SFResponseCache::Entry entry;
+			entry.eTag = reply->rawHeader(kSFETagHeader);
+			entry.lastModified = reply->rawHeader(kSFLastModifiedHeader);
+			entry.payload = mResult->mPayload;
+			if (entry.eTag.isEmpty() && entry.lastModified.isEmpty()) {
+				SFResponseCache::remove(this->mCacheKey);
+			} else {
+				SFResponseCache::insert(this->mCacheKey, entry, buffer.size());
+			}
+		}
 		return state;
 	}
 }
@@ -129,7 +323,9 @@ SFNetworkAccessTask::NetworkTaskState SFRestResourceTask::processStatusCode(cons
 		message = (hardcodedReason) ? "Multiple records with given external ID were found." : reason;
 		break;
 	case SFResultCode::SFRestStatusNoChanges:
+		//the answer to a conditional request, the payload is the one the caller already has
 		message = (hardcodedReason) ? "The requested resource has not changed since the specified date and time." : reason;
+		isError = false;
 		break;
 	case SFResultCode::SFRestStatusBadData:
 		message = (hardcodedReason) ? "Invalid request content." : reason;
@@ -157,7 +353,7 @@ SFNetworkAccessTask::NetworkTaskState SFRestResourceTask::processStatusCode(cons
 		if (statusCode >= 200 && statusCode < 300) {
 			message = reason;
 			isError = false;
-		} else if (reply->error() != QNetworkReply::NoError) {
+		} else if (reply && reply->error() != QNetworkReply::NoError) {
 			message = reason.isNull() || reason.isEmpty() ? reply->errorString() : reason;
 		} else {
 			//unhandled status code, we treat it as error
@@ -205,7 +401,13 @@ SFNetworkAccessTask::NetworkTaskState SFRestResourceTask::parseJsonContent(const
 	mResult->mPayload = jsonContent;
 
 	//additional or overwrite message
-	if (jsonContent.canConvert<QVariantMap>()) {
+	if (jsonContent.userType() == qMetaTypeId<SFJsonView>()) {
+		//only successful responses are delivered as a view, so the id is the only interesting part
+		QString id = jsonContent.value<SFJsonView>().path("id").toString();
+		if (!id.isEmpty()) {
+			mResult->mMessage = id;
+		}
+	} else if (jsonContent.canConvert<QVariantMap>()) {
 		QVariantMap map = jsonContent.value<QVariantMap>();
 		if (map.contains("errorCode") && !map["errorCode"].toString().isNull() && !map["errorCode"].toString().isEmpty()) {
 			mResult->mMessage += "\n";
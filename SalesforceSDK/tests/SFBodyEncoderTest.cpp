@@ -0,0 +1,183 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBodyEncoderTest.cpp
+*/
+
+
+#include "SFBodyEncoderTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QtTest/QtTest>
+#include <clocale>
+#include <limits>
+#include "SFBodyEncoder.h"
+
+using namespace bb::data;
+
+namespace sf {
+
+static QByteArray json(const QVariant & value) {
+	QByteArray bytes;
+	if (!SFBodyEncoder::encodeJson(value, &bytes)) {
+		return "<error>";
+	}
+	return bytes;
+}
+
+/* the body of a collection request, 200 records */
+static QVariantMap testPayload() {
+	QVariantList records;
+	for (int i = 0; i < 200; i++) {
+		QVariantMap attributes;
+		attributes.insert("type", "Account");
+		QVariantMap record;
+		record.insert("attributes", attributes);
+		record.insert("Name", QString::fromUtf8("Account \"%1\" \xc3\xa9t\xc3\xa9").arg(i));
+		record.insert("AnnualRevenue", i * 1234.5);
+		record.insert("NumberOfEmployees", i);
+		record.insert("IsActive__c", i % 2 == 0);
+		record.insert("Description", QString("Line 1\nLine 2\tTabbed"));
+		records.append(record);
+	}
+	QVariantMap payload;
+	payload.insert("allOrNone", false);
+	payload.insert("records", records);
+	return payload;
+}
+
+void SFBodyEncoderTest::numbers_data() {
+	QTest::addColumn<QVariant>("value");
+	QTest::addColumn<QByteArray>("expected");
+	QTest::newRow("int") << QVariant(-42) << QByteArray("-42");
+	QTest::newRow("uint") << QVariant(4000000000u) << QByteArray("4000000000");
+	QTest::newRow("qlonglong") << QVariant(Q_INT64_C(-9223372036854775807)) << QByteArray("-9223372036854775807");
+	QTest::newRow("qulonglong") << QVariant(Q_UINT64_C(18446744073709551615)) << QByteArray("18446744073709551615");
+	QTest::newRow("integral double") << QVariant(3.0) << QByteArray("3");
+	QTest::newRow("decimal") << QVariant(0.1) << QByteArray("0.1");
+	QTest::newRow("negative decimal") << QVariant(-1234.5) << QByteArray("-1234.5");
+	QTest::newRow("17 digits") << QVariant(0.1 + 0.2) << QByteArray("0.30000000000000004");
+	QTest::newRow("large") << QVariant(1e300) << QByteArray("1e+300");
+	QTest::newRow("small") << QVariant(1.5e-7) << QByteArray("1.5e-07");
+	QTest::newRow("float") << QVariant::fromValue(0.1f) << QByteArray("0.1");
+	QTest::newRow("float, 9 digits") << QVariant::fromValue(16777217.0f) << QByteArray("16777216");
+	QTest::newRow("NaN") << QVariant(std::numeric_limits<double>::quiet_NaN()) << QByteArray("null");
+	QTest::newRow("infinity") << QVariant(-std::numeric_limits<double>::infinity()) << QByteArray("null");
+	QTest::newRow("bool") << QVariant(true) << QByteArray("true");
+}
+
+void SFBodyEncoderTest::numbers() {
+	QFETCH(QVariant, value);
+	QFETCH(QByteArray, expected);
+	QCOMPARE(json(value), expected);
+}
+
+/* numbers must be written with a decimal point whatever the locale of the process */
+void SFBodyEncoderTest::numbersInCommaLocale() {
+	QByteArray previous(setlocale(LC_NUMERIC, NULL));
+	QLocale defaultLocale;
+	const char *commaLocales[] = {"de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "fr_FR"};
+	bool changed = false;
+	for (uint i = 0; i < sizeof(commaLocales) / sizeof(commaLocales[0]) && !changed; i++) {
+		changed = setlocale(LC_NUMERIC, commaLocales[i]) != NULL;
+	}
+	QLocale::setDefault(QLocale(QLocale::German, QLocale::Germany));
+
+	QByteArray encoded = json(QVariantList() << 1.5 << QVariant::fromValue(0.25f) << -1234567.125);
+
+	setlocale(LC_NUMERIC, previous.constData());
+	QLocale::setDefault(defaultLocale);
+	QCOMPARE(encoded, QByteArray("[1.5,0.25,-1234567.125]"));
+	if (!changed) {
+		QSKIP("No locale with a decimal comma is installed, only the Qt locale was changed", SkipSingle);
+	}
+}
+
+void SFBodyEncoderTest::doublesRoundTrip() {
+	double values[] = {1.0 / 3, 2.0 / 3, 0.1 + 0.7, 123456789.123456789, 5e-324, 1.7976931348623157e308, -0.000123456789012345678};
+	for (uint i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		QByteArray encoded = json(values[i]);
+		QVERIFY2(encoded.toDouble() == values[i], encoded.constData());
+		QVERIFY2(encoded.size() <= 24, encoded.constData());
+	}
+}
+
+void SFBodyEncoderTest::jsonValues() {
+	QVariantMap map;
+	map.insert("text", QString::fromUtf8("quote \" backslash \\ tab \t newline \n control \x01 \xc3\xa9 \xf0\x9f\x98\x80"));
+	map.insert("list", QVariantList() << QVariant() << false << QString());
+	map.insert("date", QDate(2013, 10, 18));
+	map.insert("dateTime", QDateTime(QDate(2013, 10, 18), QTime(10, 5, 30, 250), Qt::UTC));
+	QByteArray encoded = json(map);
+	QCOMPARE(encoded, QByteArray("{\"date\":\"2013-10-18\",\"dateTime\":\"2013-10-18T10:05:30.250+0000\",\"list\":[null,false,\"\"],"
+			"\"text\":\"quote \\\" backslash \\\\ tab \\t newline \\n control \\u0001 \xc3\xa9 \xf0\x9f\x98\x80\"}"));
+
+	//what JsonDataAccess reads back is what was encoded
+	QVariantMap payload = testPayload();
+	JsonDataAccess jda;
+	QVariant decoded = jda.loadFromBuffer(json(payload));
+	QVERIFY(!jda.hasError());
+	QCOMPARE(decoded, QVariant(payload));
+}
+
+void SFBodyEncoderTest::urlEncoded() {
+	QVariantMap params;
+	params.insert("q", QString::fromUtf8("SELECT Id FROM Account WHERE Name = 'A&B \xc3\xa9'"));
+	params.insert("limit", 10);
+	params.insert("bytes", QByteArray("\x01\x02"));
+	QCOMPARE(SFBodyEncoder::encodeUrlEncoded(params),
+			QByteArray("bytes=AQI%3D&limit=10&q=SELECT%20Id%20FROM%20Account%20WHERE%20Name%20%3D%20%27A%26B%20%C3%A9%27"));
+}
+
+/* one allocation per body: the encoder counts the bytes first, then writes into an array of exactly that size */
+void SFBodyEncoderTest::exactlySized() {
+	QVariantMap payload = testPayload();
+	QByteArray bytes;
+	QVERIFY(SFBodyEncoder::encodeJson(payload, &bytes));
+	QCOMPARE(bytes.capacity(), bytes.size());
+	QVariantMap fields;
+	fields.insert("q", QString::fromUtf8("SELECT Name FROM Account WHERE Name LIKE '\xc3\xa9t\xc3\xa9%'"));
+	fields.insert("limit", 2000);
+	QByteArray params = SFBodyEncoder::encodeUrlEncoded(fields);
+	QCOMPARE(params.capacity(), params.size());
+	QByteArray multipart = SFBodyEncoder::encodeMultipart(payload, "boundary");
+	QCOMPARE(multipart.capacity(), multipart.size());
+}
+
+void SFBodyEncoderTest::encodeJson_data() {
+	QTest::addColumn<bool>("useEncoder");
+	QTest::newRow("JsonDataAccess") << false;
+	QTest::newRow("SFBodyEncoder") << true;
+}
+
+/* a 200 records body, the way SFRestRequest used to encode it and the way it does now */
+void SFBodyEncoderTest::encodeJson() {
+	QFETCH(bool, useEncoder);
+	QVariantMap payload = testPayload();
+	QByteArray bytes;
+	if (useEncoder) {
+		QBENCHMARK {
+			SFBodyEncoder::encodeJson(payload, &bytes);
+		}
+	} else {
+		QBENCHMARK {
+			JsonDataAccess jda;
+			bytes.clear();
+			jda.saveToBuffer(payload, &bytes);
+		}
+	}
+	QVERIFY(!bytes.isEmpty());
+}
+
+} /* namespace sf */
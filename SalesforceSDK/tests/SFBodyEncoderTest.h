@@ -0,0 +1,45 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBodyEncoderTest.h
+*/
+
+
+#ifndef SFBODYENCODERTEST_H_
+#define SFBODYENCODERTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * The encodings of SFBodyEncoder, numbers in particular, and its cost compared to JsonDataAccess.
+ */
+class SFBodyEncoderTest : public QObject {
+	Q_OBJECT
+private slots:
+	void numbers_data();
+	void numbers();
+	void numbersInCommaLocale();
+	void doublesRoundTrip();
+	void jsonValues();
+	void urlEncoded();
+	void exactlySized();
+	void encodeJson_data();
+	void encodeJson();
+};
+
+} /* namespace sf */
+#endif /* SFBODYENCODERTEST_H_ */
@@ -0,0 +1,218 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBulkIngestJobTest.cpp
+*/
+
+
+#include "SFBulkIngestJobTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFBulkIngestJob.h"
+#include "SFCsvStreamParser.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRecordSource.h"
+#include "SFRestAPI.h"
+#include "SFTestServer.h"
+
+using namespace bb::data;
+
+Q_DECLARE_METATYPE(sf::SFBulkIngestJob::State)
+
+namespace sf {
+
+static const QByteArray kSFTestJobsPath = "/services/data/v28.0/jobs/ingest";
+static const QByteArray kSFTestJobPath = "/services/data/v28.0/jobs/ingest/750000000000001";
+static const QByteArray kSFTestSuccessfulResults = "\"sf__Id\",\"sf__Created\",Name\n\"001000000000001\",\"true\",\"Acme\"\n";
+static const QByteArray kSFTestFailedResults = "\"sf__Id\",\"sf__Error\",Name\n\"\",\"REQUIRED_FIELD_MISSING:Required fields are missing: [Name]:Name --\",\"\"\n";
+
+/* text that needs quoting, doubles that need all their digits, and an empty field */
+class SFTestRecordSource : public SFRecordSource {
+public:
+	SFTestRecordSource() : mNext(0) {}
+	static int size() { return 4;}
+	static QVariantList record(int i) {
+		switch (i) {
+		case 0: return QVariantList() << QString("Acme") << 0.1 << QString("plain");
+		case 1: return QVariantList() << QString("Smith, \"Jr\"") << 1234567.891 << QString("two\nlines");
+		case 2: return QVariantList() << QString::fromUtf8("Caf\xc3\xa9") << 1.0 / 3.0 << QString();
+		default: return QVariantList() << QString("Last") << -2.5e-300 << QString("trailing space ");
+		}
+	}
+	bool next(QVariantList * values) {
+		if (mNext >= size()) {
+			return false;
+		}
+		*values = record(mNext++);
+		return true;
+	}
+private:
+	int mNext;
+};
+
+/* keeps the rows */
+class SFTestCsvRows : public SFCsvStreamHandler {
+public:
+	QList<QStringList> rows;
+	bool row(const QStringList & fields) {
+		rows.append(fields);
+		return true;
+	}
+};
+
+static QByteArray jobInfo(const QString & state) {
+	return QString("{\"id\":\"750000000000001\",\"operation\":\"insert\",\"object\":\"Account\",\"state\":\"%1\","
+			"\"numberRecordsProcessed\":4,\"numberRecordsFailed\":1}").arg(state).toUtf8();
+}
+
+void SFBulkIngestJobTest::initTestCase() {
+	qRegisterMetaType<sf::SFBulkIngestJob::State>("sf::SFBulkIngestJob::State");
+	mServer = new SFTestServer();
+	QVERIFY(mServer->start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(mServer->baseUrl()));
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+	//every step waits for the previous one, there is nothing to batch
+	mBatchWindow = SFRestAPI::instance()->batchWindow();
+	SFRestAPI::instance()->setBatchWindow(0);
+}
+
+void SFBulkIngestJobTest::cleanupTestCase() {
+	SFRestAPI::instance()->setBatchWindow(mBatchWindow);
+	delete mServer;
+	mServer = NULL;
+}
+
+void SFBulkIngestJobTest::init() {
+	mServer->clearRequests();
+	mServer->setResponse("POST", kSFTestJobsPath, 200, jobInfo("Open"));
+	mServer->setResponse("PUT", kSFTestJobPath + "/batches", 201, QByteArray());
+	mServer->setResponse("PATCH", kSFTestJobPath, 200, jobInfo("UploadComplete"));
+	SFTestServer::Response csv;
+	csv.contentType = "text/csv";
+	csv.body = kSFTestSuccessfulResults;
+	mServer->setResponse("GET", kSFTestJobPath + "/successfulResults/", csv);
+	csv.body = kSFTestFailedResults;
+	mServer->setResponse("GET", kSFTestJobPath + "/failedResults/", csv);
+}
+
+void SFBulkIngestJobTest::ingestRecords() {
+	//the first poll finds the job still running
+	SFTestServer::Response inProgress;
+	inProgress.body = jobInfo("InProgress");
+	mServer->queueResponse("GET", kSFTestJobPath, inProgress);
+	mServer->setResponse("GET", kSFTestJobPath, 200, jobInfo("JobComplete"));
+
+	QTemporaryFile successfulResults;
+	QTemporaryFile failedResults;
+	QVERIFY(successfulResults.open() && failedResults.open());
+	SFBulkIngestJob job;
+	job.setObjectType("Account");
+	job.setRecordSource(new SFTestRecordSource(), QStringList() << "Name" << "AnnualRevenue" << "Description");
+	job.setSuccessfulResultsFile(successfulResults.fileName());
+	job.setFailedResultsFile(failedResults.fileName());
+	job.setPollInterval(100);
+	job.setMaxPollInterval(100);
+	QSignalSpy states(&job, SIGNAL(stateChanged(sf::SFBulkIngestJob::State)));
+	QSignalSpy failures(&job, SIGNAL(failed(int,QString)));
+	job.start();
+	QVERIFY(sfTestWait(&job, SIGNAL(finished()), 30000));
+	QCOMPARE(failures.count(), 0);
+	QCOMPARE(job.state(), SFBulkIngestJob::Complete);
+	QCOMPARE(job.jobId(), QString("750000000000001"));
+	QCOMPARE(job.jobInfo().value("numberRecordsFailed").toInt(), 1);
+
+	QList<SFBulkIngestJob::State> expectedStates;
+	expectedStates << SFBulkIngestJob::Preparing << SFBulkIngestJob::Opening << SFBulkIngestJob::Uploading << SFBulkIngestJob::Closing
+			<< SFBulkIngestJob::Processing << SFBulkIngestJob::DownloadingResults << SFBulkIngestJob::Complete;
+	QCOMPARE(states.count(), expectedStates.size());
+	for (int i = 0; i < states.count(); i++) {
+		QCOMPARE(states.at(i).at(0).value<sf::SFBulkIngestJob::State>(), expectedStates.at(i));
+	}
+
+	//the job was opened for a CSV insert
+	QCOMPARE(mServer->requests("POST", kSFTestJobsPath).size(), 1);
+	JsonDataAccess jda;
+	QVariantMap jobRequest = jda.loadFromBuffer(mServer->requests("POST", kSFTestJobsPath).first().body).toMap();
+	QCOMPARE(jobRequest.value("object").toString(), QString("Account"));
+	QCOMPARE(jobRequest.value("operation").toString(), QString("insert"));
+	QCOMPARE(jobRequest.value("contentType").toString(), QString("CSV"));
+	QCOMPARE(jobRequest.value("lineEnding").toString(), QString("LF"));
+
+	//the upload reads back as the records, doubles included
+	QList<SFTestServer::Request> uploads = mServer->requests("PUT", kSFTestJobPath + "/batches");
+	QCOMPARE(uploads.size(), 1);
+	QVERIFY(uploads.first().headers.value("content-type").startsWith("text/csv"));
+	QVERIFY(!uploads.first().body.contains('\r'));
+	SFTestCsvRows upload;
+	SFCsvStreamParser parser(&upload);
+	QVERIFY(parser.feed(uploads.first().body) && parser.finish());
+	QCOMPARE(upload.rows.size(), SFTestRecordSource::size() + 1);
+	QCOMPARE(upload.rows.first(), QStringList() << "Name" << "AnnualRevenue" << "Description");
+	for (int i = 0; i < SFTestRecordSource::size(); i++) {
+		QVariantList record = SFTestRecordSource::record(i);
+		const QStringList & row = upload.rows.at(i + 1);
+		QCOMPARE(row.size(), 3);
+		QCOMPARE(row.at(0), record.at(0).toString());
+		bool ok = false;
+		QCOMPARE(row.at(1).toDouble(&ok), record.at(1).toDouble());
+		QVERIFY(ok);
+		QCOMPARE(row.at(2), record.at(2).toString());
+	}
+
+	//closed once, polled until complete, then the results were saved
+	QList<SFTestServer::Request> patches = mServer->requests("PATCH", kSFTestJobPath);
+	QCOMPARE(patches.size(), 1);
+	QCOMPARE(jda.loadFromBuffer(patches.first().body).toMap().value("state").toString(), QString("UploadComplete"));
+	int polls = 0;
+	QList<SFTestServer::Request> gets = mServer->requests("GET", kSFTestJobPath);
+	for (int i = 0; i < gets.size(); i++) {
+		polls += (gets.at(i).path == kSFTestJobPath) ? 1 : 0;
+	}
+	QCOMPARE(polls, 2);
+	QFile successful(successfulResults.fileName());
+	QFile failed(failedResults.fileName());
+	QVERIFY(successful.open(QIODevice::ReadOnly) && failed.open(QIODevice::ReadOnly));
+	QCOMPARE(successful.readAll(), kSFTestSuccessfulResults);
+	QCOMPARE(failed.readAll(), kSFTestFailedResults);
+}
+
+void SFBulkIngestJobTest::failedJob() {
+	SFTestServer::Response failedInfo;
+	failedInfo.body = "{\"id\":\"750000000000001\",\"state\":\"Failed\",\"errorMessage\":\"InvalidBatch : Field name not found : Nmae\"}";
+	mServer->setResponse("GET", kSFTestJobPath, failedInfo);
+
+	SFBulkIngestJob job;
+	job.setObjectType("Account");
+	job.setRecordSource(new SFTestRecordSource(), QStringList() << "Nmae" << "AnnualRevenue" << "Description");
+	job.setPollInterval(100);
+	QSignalSpy failures(&job, SIGNAL(failed(int,QString)));
+	job.start();
+	QVERIFY(sfTestWait(&job, SIGNAL(failed(int,QString)), 30000));
+	QCOMPARE(job.state(), SFBulkIngestJob::Failed);
+	QCOMPARE(failures.count(), 1);
+	QCOMPARE(failures.first().at(1).toString(), QString("InvalidBatch : Field name not found : Nmae"));
+	//a job that failed on the server is not aborted, and nothing is downloaded
+	QCOMPARE(mServer->requests("PATCH", kSFTestJobPath).size(), 1);
+	QCOMPARE(mServer->requests("GET", kSFTestJobPath + "/successfulResults/").size(), 0);
+}
+
+} /* namespace sf */
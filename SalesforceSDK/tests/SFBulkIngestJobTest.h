@@ -0,0 +1,48 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBulkIngestJobTest.h
+*/
+
+
+#ifndef SFBULKINGESTJOBTEST_H_
+#define SFBULKINGESTJOBTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * A bulk ingest job from a record source to the downloaded results, against a stand-in server.
+ */
+class SFBulkIngestJobTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+
+	void ingestRecords();
+	void failedJob();
+
+private:
+	SFTestServer *mServer;
+	int mBatchWindow;
+};
+
+} /* namespace sf */
+#endif /* SFBULKINGESTJOBTEST_H_ */
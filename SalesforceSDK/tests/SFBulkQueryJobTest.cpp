@@ -0,0 +1,193 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBulkQueryJobTest.cpp
+*/
+
+
+#include "SFBulkQueryJobTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFBulkQueryJob.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRestAPI.h"
+#include "SFTestServer.h"
+
+using namespace bb::data;
+
+Q_DECLARE_METATYPE(sf::SFBulkQueryJob::State)
+
+namespace sf {
+
+static const QByteArray kSFTestJobsPath = "/services/data/v28.0/jobs/query";
+static const QByteArray kSFTestJobPath = "/services/data/v28.0/jobs/query/750000000000002";
+static const QByteArray kSFTestFirstPagePath = kSFTestJobPath + "/results?maxRecords=2";
+static const QByteArray kSFTestSecondPagePath = kSFTestJobPath + "/results?locator=MQ&maxRecords=2";
+static const QByteArray kSFTestFirstPage = "\"Id\",\"Name\"\n\"001000000000001\",\"Acme\"\n\"001000000000002\",\"Smith, \"\"Jr\"\"\"\n";
+static const QByteArray kSFTestSecondPage = "\"Id\",\"Name\"\n\"001000000000003\",\"\"\n";
+
+static QByteArray jobInfo(const QString & state) {
+	return QString("{\"id\":\"750000000000002\",\"operation\":\"query\",\"object\":\"Account\",\"state\":\"%1\","
+			"\"numberRecordsProcessed\":3}").arg(state).toUtf8();
+}
+
+static SFTestServer::Response page(const QByteArray & body, const QByteArray & locator, int count) {
+	SFTestServer::Response response;
+	response.contentType = "text/csv";
+	response.body = body;
+	response.headers.append(qMakePair(QByteArray("Sforce-Locator"), locator));
+	response.headers.append(qMakePair(QByteArray("Sforce-NumberOfRecords"), QByteArray::number(count)));
+	return response;
+}
+
+static int countPolls(const QList<SFTestServer::Request> & gets) {
+	int polls = 0;
+	for (int i = 0; i < gets.size(); i++) {
+		polls += (gets.at(i).path == kSFTestJobPath) ? 1 : 0;
+	}
+	return polls;
+}
+
+void SFBulkQueryJobTest::initTestCase() {
+	qRegisterMetaType<sf::SFBulkQueryJob::State>("sf::SFBulkQueryJob::State");
+	mServer = new SFTestServer();
+	QVERIFY(mServer->start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(mServer->baseUrl()));
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+	mBatchWindow = SFRestAPI::instance()->batchWindow();
+	SFRestAPI::instance()->setBatchWindow(0);
+}
+
+void SFBulkQueryJobTest::cleanupTestCase() {
+	SFRestAPI::instance()->setBatchWindow(mBatchWindow);
+	delete mServer;
+	mServer = NULL;
+}
+
+void SFBulkQueryJobTest::init() {
+	mServer->clearRequests();
+	mServer->setResponse("POST", kSFTestJobsPath, 200, jobInfo("UploadComplete"));
+	mServer->setResponse("PATCH", kSFTestJobPath, 200, jobInfo("Aborted"));
+	mServer->setResponse("GET", kSFTestJobPath, 200, jobInfo("JobComplete"));
+	mServer->setResponse("GET", kSFTestFirstPagePath, page(kSFTestFirstPage, "MQ", 2));
+	mServer->setResponse("GET", kSFTestSecondPagePath, page(kSFTestSecondPage, "null", 1));
+}
+
+void SFBulkQueryJobTest::queryRows() {
+	//the first poll finds the job still running
+	SFTestServer::Response inProgress;
+	inProgress.body = jobInfo("InProgress");
+	mServer->queueResponse("GET", kSFTestJobPath, inProgress);
+	SFBulkQueryJob job;
+	job.setQuery("SELECT Id, Name FROM Account");
+	job.setOperation(SFBulkQueryJob::QueryAll);
+	job.setMaxRecordsPerPage(2);
+	job.setPollInterval(100);
+	job.setMaxPollInterval(100);
+	QSignalSpy states(&job, SIGNAL(stateChanged(sf::SFBulkQueryJob::State)));
+	QSignalSpy pages(&job, SIGNAL(rowsReady(QStringList,QVariantList)));
+	QSignalSpy failures(&job, SIGNAL(failed(int,QString)));
+	job.start();
+	QVERIFY(sfTestWait(&job, SIGNAL(finished()), 30000));
+	QCOMPARE(failures.count(), 0);
+	QCOMPARE(job.state(), SFBulkQueryJob::Complete);
+	QCOMPARE(job.jobId(), QString("750000000000002"));
+	QCOMPARE(job.rowCount(), 3);
+
+	QList<SFBulkQueryJob::State> expectedStates;
+	expectedStates << SFBulkQueryJob::Opening << SFBulkQueryJob::Processing << SFBulkQueryJob::DownloadingResults << SFBulkQueryJob::Complete;
+	QCOMPARE(states.count(), expectedStates.size());
+	for (int i = 0; i < states.count(); i++) {
+		QCOMPARE(states.at(i).at(0).value<sf::SFBulkQueryJob::State>(), expectedStates.at(i));
+	}
+
+	//the job was created for a CSV queryAll
+	QList<SFTestServer::Request> creations = mServer->requests("POST", kSFTestJobsPath);
+	QCOMPARE(creations.size(), 1);
+	JsonDataAccess jda;
+	QVariantMap jobRequest = jda.loadFromBuffer(creations.first().body).toMap();
+	QCOMPARE(jobRequest.value("operation").toString(), QString("queryAll"));
+	QCOMPARE(jobRequest.value("query").toString(), QString("SELECT Id, Name FROM Account"));
+	QCOMPARE(jobRequest.value("contentType").toString(), QString("CSV"));
+
+	//polled until complete, then every page requested once, the second one with the locator of the first
+	QCOMPARE(countPolls(mServer->requests("GET", kSFTestJobPath)), 2);
+	QCOMPARE(mServer->requests("GET", kSFTestFirstPagePath).size(), 1);
+	QCOMPARE(mServer->requests("GET", kSFTestSecondPagePath).size(), 1);
+
+	//the pages are delivered in order
+	QCOMPARE(pages.count(), 2);
+	QCOMPARE(pages.at(0).at(0).toStringList(), QStringList() << "Id" << "Name");
+	QVariantList rows = pages.at(0).at(1).toList();
+	QCOMPARE(rows.size(), 2);
+	QCOMPARE(rows.at(0).toStringList(), QStringList() << "001000000000001" << "Acme");
+	QCOMPARE(rows.at(1).toStringList(), QStringList() << "001000000000002" << "Smith, \"Jr\"");
+	rows = pages.at(1).at(1).toList();
+	QCOMPARE(rows.size(), 1);
+	QCOMPARE(rows.at(0).toStringList().first(), QString("001000000000003"));
+	QVERIFY(rows.at(0).toStringList().at(1).isEmpty());
+}
+
+void SFBulkQueryJobTest::queryToFile() {
+	QTemporaryFile results;
+	QVERIFY(results.open());
+	SFBulkQueryJob job;
+	job.setQuery("SELECT Id, Name FROM Account");
+	job.setMaxRecordsPerPage(2);
+	job.setResultsFile(results.fileName());
+	job.setPollInterval(100);
+	QSignalSpy pages(&job, SIGNAL(rowsReady(QStringList,QVariantList)));
+	job.start();
+	QVERIFY(sfTestWait(&job, SIGNAL(finished()), 30000));
+	QCOMPARE(job.state(), SFBulkQueryJob::Complete);
+	QCOMPARE(pages.count(), 0);
+	QCOMPARE(job.rowCount(), 3);
+	//the header of the second page is not repeated
+	QFile saved(results.fileName());
+	QVERIFY(saved.open(QIODevice::ReadOnly));
+	QCOMPARE(saved.readAll(), kSFTestFirstPage + kSFTestSecondPage.mid(kSFTestSecondPage.indexOf('\n') + 1));
+}
+
+void SFBulkQueryJobTest::abortWhileProcessing() {
+	SFBulkQueryJob job;
+	job.setQuery("SELECT Id, Name FROM Account");
+	job.setPollInterval(2000);
+	QSignalSpy pages(&job, SIGNAL(rowsReady(QStringList,QVariantList)));
+	job.start();
+	QCOMPARE(job.state(), SFBulkQueryJob::Opening);
+	QVERIFY(sfTestWait(&job, SIGNAL(stateChanged(sf::SFBulkQueryJob::State))));
+	QCOMPARE(job.state(), SFBulkQueryJob::Processing);
+	job.abort();
+	QCOMPARE(job.state(), SFBulkQueryJob::Aborted);
+	//Salesforce is asked to stop the job, and nothing more is polled nor downloaded
+	QVERIFY(sfTestWait(mServer, SIGNAL(requestReceived())));
+	QList<SFTestServer::Request> aborts = mServer->requests("PATCH", kSFTestJobPath);
+	QCOMPARE(aborts.size(), 1);
+	JsonDataAccess jda;
+	QCOMPARE(jda.loadFromBuffer(aborts.first().body).toMap().value("state").toString(), QString("Aborted"));
+	QTest::qWait(3000);
+	QCOMPARE(countPolls(mServer->requests("GET", kSFTestJobPath)), 0);
+	QCOMPARE(mServer->requests("GET", kSFTestJobPath + "/results").size(), 0);
+	QCOMPARE(pages.count(), 0);
+}
+
+} /* namespace sf */
@@ -0,0 +1,50 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFBulkQueryJobTest.h
+*/
+
+
+#ifndef SFBULKQUERYJOBTEST_H_
+#define SFBULKQUERYJOBTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * A bulk query job from its creation to the last page of results, against a stand-in server: the status is polled until the
+ * job completes, then the pages are followed with their "Sforce-Locator" header.
+ */
+class SFBulkQueryJobTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+
+	void queryRows();
+	void queryToFile();
+	void abortWhileProcessing();
+
+private:
+	SFTestServer *mServer;
+	int mBatchWindow;
+};
+
+} /* namespace sf */
+#endif /* SFBULKQUERYJOBTEST_H_ */
@@ -0,0 +1,284 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCodecTest.cpp
+*/
+
+
+#include "SFCodecTest.h"
+#include <QtTest/QtTest>
+#include "SFCodec.h"
+#include "SFSecurityManager.h"
+
+namespace sf {
+
+/*
+ * The hex codec SFSecurityManager used before SFCodec, one character at a time, kept as the baseline of the benchmarks
+ */
+static QString legacyToHex(const QByteArray & in) {
+	static char hexChars[] = "0123456789abcdef";
+	const char * c = in.constData();
+	QString toReturn;
+	for (int i = 0; i < in.length(); ++i) {
+		toReturn += hexChars[(c[i] >> 4) & 0xf];
+		toReturn += hexChars[(c[i]) & 0xf];
+	}
+	return toReturn;
+}
+
+static char legacyNibble(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	} else if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	} else if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+static bool legacyFromHex(const QString in, QByteArray & toReturn) {
+	QString temp(in);
+	temp.replace(" ","");
+	temp.replace(":","");
+	temp.replace(".","");
+	QByteArray content(temp.toLocal8Bit());
+	const char * c(content.constData());
+	if (content.length() == 0 || ((content.length() % 2) != 0)) {
+		return false;
+	}
+	for (int i = 0; i < content.length(); i += 2) {
+		char a = legacyNibble(c[i]);
+		char b = legacyNibble(c[i + 1]);
+		if (a < 0 || b < 0) {
+			toReturn.clear();
+			return false;
+		}
+		toReturn.append((a << 4) | b);
+	}
+	return true;
+}
+
+static QByteArray testBytes(int length) {
+	QByteArray bytes(length, '\0');
+	for (int i = 0; i < length; i++) {
+		bytes[i] = (char) ((i * 131 + 7) & 0xff);
+	}
+	return bytes;
+}
+
+/* about the size of an access token */
+static const int kSFTokenLength = 112;
+
+void SFCodecTest::hex_data() {
+	QTest::addColumn<QByteArray>("data");
+	QTest::newRow("one byte") << QByteArray("\x00", 1);
+	QTest::newRow("every byte value") << testBytes(256);
+	QTest::newRow("odd length") << testBytes(17);
+	QTest::newRow("large") << testBytes(64 * 1024 + 3);
+}
+
+void SFCodecTest::hex() {
+	QFETCH(QByteArray, data);
+	QByteArray hex = SFCodec::toHex(data);
+	QCOMPARE(hex, data.toHex());
+	QCOMPARE(QString::fromLatin1(hex), legacyToHex(data));
+	QByteArray decoded;
+	QVERIFY(SFCodec::fromHex(hex, decoded));
+	QCOMPARE(decoded, data);
+	QVERIFY(SFCodec::fromHex(hex.toUpper(), decoded));
+	QCOMPARE(decoded, data);
+}
+
+void SFCodecTest::invalidHex() {
+	QByteArray out("left over");
+	QVERIFY(!SFCodec::fromHex(QByteArray(), out));
+	QVERIFY(out.isEmpty());
+	QVERIFY(!SFCodec::fromHex("abc", out));
+	QVERIFY(!SFCodec::fromHex("0g", out));
+	QVERIFY(out.isEmpty());
+	//the separators the legacy decoder accepted
+	QVERIFY(SFCodec::fromHex("de:ad be.ef", out));
+	QCOMPARE(out, QByteArray("\xde\xad\xbe\xef"));
+}
+
+void SFCodecTest::base64_data() {
+	QTest::addColumn<QByteArray>("data");
+	QTest::newRow("empty") << QByteArray();
+	QTest::newRow("one byte, two padding") << QByteArray("f");
+	QTest::newRow("two bytes, one padding") << QByteArray("fo");
+	QTest::newRow("no padding") << QByteArray("foo");
+	QTest::newRow("every byte value") << testBytes(256);
+	QTest::newRow("large") << testBytes(64 * 1024 + 1);
+}
+
+void SFCodecTest::base64() {
+	QFETCH(QByteArray, data);
+	QByteArray encoded = SFCodec::toBase64(data);
+	QCOMPARE(encoded, data.toBase64());
+	QByteArray decoded;
+	QVERIFY(SFCodec::fromBase64(encoded, decoded));
+	QCOMPARE(decoded, data);
+	//without padding, and wrapped as some servers send it
+	QByteArray unpadded(encoded);
+	while (unpadded.endsWith('=')) {
+		unpadded.chop(1);
+	}
+	QVERIFY(SFCodec::fromBase64(unpadded, decoded));
+	QCOMPARE(decoded, data);
+	QByteArray wrapped;
+	for (int i = 0; i < encoded.size(); i += 76) {
+		wrapped.append(encoded.mid(i, 76)).append("\r\n");
+	}
+	QVERIFY(SFCodec::fromBase64(wrapped, decoded));
+	QCOMPARE(decoded, data);
+}
+
+void SFCodecTest::invalidBase64() {
+	QByteArray out("left over");
+	QVERIFY(!SFCodec::fromBase64("Zm9v!", out));
+	QVERIFY(out.isEmpty());
+	QVERIFY(!SFCodec::fromBase64("Z", out));
+	QVERIFY(!SFCodec::fromBase64("Zg=a", out));
+}
+
+void SFCodecTest::envelope() {
+	SFSecurityManager *manager = SFSecurityManager::instance();
+	QByteArray clearData("a record to be cached");
+	QByteArray envelope = manager->encryptData(clearData);
+	QVERIFY(SFSecurityManager::isEnvelope(envelope));
+	//a new IV every time
+	QVERIFY(envelope != manager->encryptData(clearData));
+	QCOMPARE(manager->decryptData(envelope), clearData);
+	QCOMPARE(manager->decryptData(manager->encryptData(QByteArray())), QByteArray());
+	for (int i = 0; i < envelope.size(); i++) {
+		QByteArray tampered(envelope);
+		tampered[i] = tampered.at(i) ^ 0x01;
+		QVERIFY2(manager->decryptData(tampered).isNull(), qPrintable(QString("byte %1").arg(i)));
+	}
+	QVERIFY(manager->decryptData(envelope.left(envelope.size() - 1)).isNull());
+}
+
+/* the files written before the envelope hold hex text, they must still be recognized as such and read */
+void SFCodecTest::legacyIsNotEnvelope() {
+	SFSecurityManager *manager = SFSecurityManager::instance();
+	QString token = QString("00D").leftJustified(kSFTokenLength, QChar('x'));
+	QString legacy = manager->encrypt(token);
+	QVERIFY(!SFSecurityManager::isEnvelope(legacy.toLatin1()));
+	QCOMPARE(manager->decrypt(legacy), token);
+}
+
+void SFCodecTest::storedSize_data() {
+	QTest::addColumn<int>("length");
+	QTest::addColumn<bool>("useEnvelope");
+	QTest::newRow("token, hex") << kSFTokenLength << false;
+	QTest::newRow("token, envelope") << kSFTokenLength << true;
+	QTest::newRow("4 KB record, hex") << 4096 << false;
+	QTest::newRow("4 KB record, envelope") << 4096 << true;
+}
+
+/* the number of bytes stored, reported as events */
+void SFCodecTest::storedSize() {
+	QFETCH(int, length);
+	QFETCH(bool, useEnvelope);
+	SFSecurityManager *manager = SFSecurityManager::instance();
+	QString clearText = QString("a").repeated(length);
+	int hexSize = manager->encrypt(clearText).toLatin1().size();
+	int envelopeSize = manager->encryptData(clearText.toUtf8()).size();
+	//the envelope adds a fixed header and MAC, the hex text doubles the whole ciphertext
+	QVERIFY(envelopeSize < hexSize);
+	int stored = useEnvelope ? envelopeSize : hexSize;
+	qDebug() << length << "bytes are stored in" << stored << "bytes";
+	QTest::setBenchmarkResult(stored, QTest::Events);
+}
+
+void SFCodecTest::sealAndOpen_data() {
+	QTest::addColumn<int>("length");
+	QTest::addColumn<bool>("useEnvelope");
+	QTest::newRow("token, hex") << kSFTokenLength << false;
+	QTest::newRow("token, envelope") << kSFTokenLength << true;
+	QTest::newRow("64 KB, hex") << 64 * 1024 << false;
+	QTest::newRow("64 KB, envelope") << 64 * 1024 << true;
+}
+
+/* encrypt, encode, decode and decrypt once, with the legacy hex text or the envelope */
+void SFCodecTest::sealAndOpen() {
+	QFETCH(int, length);
+	QFETCH(bool, useEnvelope);
+	SFSecurityManager *manager = SFSecurityManager::instance();
+	QString clearText = QString("a").repeated(length);
+	QByteArray clearData = clearText.toUtf8();
+	bool ok = true;
+	if (useEnvelope) {
+		QBENCHMARK {
+			ok = ok && manager->decryptData(manager->encryptData(clearData)).size() == length;
+		}
+	} else {
+		QBENCHMARK {
+			ok = ok && manager->decrypt(manager->encrypt(clearText)).size() == length;
+		}
+	}
+	QVERIFY(ok);
+}
+
+void SFCodecTest::hexEncode_data() {
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<bool>("useCodec");
+	QTest::newRow("token, legacy") << testBytes(kSFTokenLength) << false;
+	QTest::newRow("token, SFCodec") << testBytes(kSFTokenLength) << true;
+	QTest::newRow("64 KB, legacy") << testBytes(64 * 1024) << false;
+	QTest::newRow("64 KB, SFCodec") << testBytes(64 * 1024) << true;
+}
+
+void SFCodecTest::hexEncode() {
+	QFETCH(QByteArray, data);
+	QFETCH(bool, useCodec);
+	int size = 0;
+	if (useCodec) {
+		QBENCHMARK {
+			size = SFCodec::toHex(data).size();
+		}
+	} else {
+		QBENCHMARK {
+			size = legacyToHex(data).size();
+		}
+	}
+	QCOMPARE(size, data.size() * 2);
+}
+
+void SFCodecTest::hexDecode_data() {
+	hexEncode_data();
+}
+
+void SFCodecTest::hexDecode() {
+	QFETCH(QByteArray, data);
+	QFETCH(bool, useCodec);
+	QByteArray hex = data.toHex();
+	QString hexText = QString::fromLatin1(hex);
+	QByteArray decoded;
+	if (useCodec) {
+		QBENCHMARK {
+			SFCodec::fromHex(hex, decoded);
+		}
+	} else {
+		QBENCHMARK {
+			decoded.clear();
+			legacyFromHex(hexText, decoded);
+		}
+	}
+	QCOMPARE(decoded, data);
+}
+
+} /* namespace sf */
@@ -0,0 +1,54 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCodecTest.h
+*/
+
+
+#ifndef SFCODECTEST_H_
+#define SFCODECTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * The hex and base64 codecs and the binary envelope of SFSecurityManager. The benchmarks compare the envelope with the
+ * legacy hex text, in stored size and in time, and the codecs with the hex code they replace.
+ */
+class SFCodecTest : public QObject {
+	Q_OBJECT
+private slots:
+	void hex_data();
+	void hex();
+	void invalidHex();
+	void base64_data();
+	void base64();
+	void invalidBase64();
+	void envelope();
+	void legacyIsNotEnvelope();
+
+	void storedSize_data();
+	void storedSize();
+	void sealAndOpen_data();
+	void sealAndOpen();
+	void hexEncode_data();
+	void hexEncode();
+	void hexDecode_data();
+	void hexDecode();
+};
+
+} /* namespace sf */
+#endif /* SFCODECTEST_H_ */
@@ -0,0 +1,242 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCollectionTaskTest.cpp
+*/
+
+#include "SFCollectionTaskTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFCollectionRequest.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRestAPI.h"
+#include "SFTestServer.h"
+
+using namespace bb::data;
+
+namespace sf {
+
+static const QByteArray kSFTestCollectionPath = "/services/data/v28.0/composite/sobjects";
+
+/* @return the id of record @a index, as an Account id */
+static QString recordId(int index) {
+	return "001" + QString::number(index).rightJustified(12, '0');
+}
+
+/* @return @a count records to update, starting at record @a first */
+static QVariantList records(int first, int count) {
+	QVariantList records;
+	for (int i = first; i < first + count; i++) {
+		QVariantMap record;
+		record["Id"] = recordId(i);
+		record["Name"] = QString("Account %1").arg(i);
+		records << record;
+	}
+	return records;
+}
+
+/* @return the response of a chunk of @a count records starting at record @a first, the ones at @a failing fail */
+static QByteArray chunkResponse(int first, int count, const QList<int> & failing = QList<int>()) {
+	QByteArray body("[");
+	for (int i = first; i < first + count; i++) {
+		if (i > first) {
+			body.append(',');
+		}
+		if (failing.contains(i)) {
+			body.append("{\"id\":\"").append(recordId(i).toUtf8()).append("\",\"success\":false,\"errors\":"
+					"[{\"statusCode\":\"FIELD_CUSTOM_VALIDATION_EXCEPTION\",\"message\":\"Name is too long\",\"fields\":[\"Name\"]}]}");
+		} else {
+			body.append("{\"id\":\"").append(recordId(i).toUtf8()).append("\",\"success\":true,\"errors\":[]}");
+		}
+	}
+	return body.append(']');
+}
+
+static SFTestServer::Response response(const QByteArray & body, int status = 200) {
+	SFTestServer::Response response;
+	response.status = status;
+	response.body = body;
+	return response;
+}
+
+/* @return the records of the bodies of the chunks the server got */
+static QList<QVariantList> chunkRecords(SFTestServer *server) {
+	QList<QVariantList> chunks;
+	QList<SFTestServer::Request> requests = server->requests("PATCH", kSFTestCollectionPath);
+	JsonDataAccess jda;
+	for (int i = 0; i < requests.size(); i++) {
+		chunks << jda.loadFromBuffer(requests.at(i).body).toMap().value("records").toList();
+	}
+	return chunks;
+}
+
+static bool sendCollection(SFCollectionRequest *request, SFTestResultReceiver & receiver) {
+	SFRestAPI::instance()->sendCollectionRequest(request, &receiver, SLOT(onResult(sf::SFResult*)));
+	return receiver.received || sfTestWait(&receiver, SIGNAL(resultReceived()));
+}
+
+void SFCollectionTaskTest::initTestCase() {
+	mServer = new SFTestServer(this);
+	QVERIFY(mServer->start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(mServer->baseUrl()));
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+	SFRestAPI::instance()->setBatchWindow(0);
+}
+
+void SFCollectionTaskTest::init() {
+	mServer->clearRequests();
+}
+
+void SFCollectionTaskTest::cleanup() {
+	mServer->setHoldResponses(false);
+	mServer->releaseResponses();
+}
+
+void SFCollectionTaskTest::chunks() {
+	SFCollectionRequest *request = SFRestAPI::instance()->requestForUpdateObjects("Account", records(0, 450), true);
+	QCOMPARE(request->chunkCount(), 3);
+	QCOMPARE(request->chunkSize(2), 50);
+	request->setMaxRequestsInFlight(1);
+	mServer->queueResponse("PATCH", kSFTestCollectionPath, response(chunkResponse(0, 200)));
+	mServer->queueResponse("PATCH", kSFTestCollectionPath, response(chunkResponse(200, 200)));
+	mServer->queueResponse("PATCH", kSFTestCollectionPath, response(chunkResponse(400, 50)));
+
+	SFTestResultReceiver receiver;
+	QVERIFY(sendCollection(request, receiver));
+	QVERIFY(!receiver.hasError);
+
+	//one call per chunk, in the order of the records
+	QList<QVariantList> chunks = chunkRecords(mServer);
+	QCOMPARE(chunks.size(), 3);
+	QCOMPARE(chunks.at(0).size(), 200);
+	QCOMPARE(chunks.at(1).size(), 200);
+	QCOMPARE(chunks.at(2).size(), 50);
+	QCOMPARE(chunks.at(1).first().toMap().value("Id").toString(), recordId(200));
+	QCOMPARE(chunks.at(2).last().toMap().value("Id").toString(), recordId(449));
+	QCOMPARE(chunks.at(0).first().toMap().value("attributes").toMap().value("type").toString(), QString("Account"));
+	JsonDataAccess jda;
+	QCOMPARE(jda.loadFromBuffer(mServer->requests().first().body).toMap().value("allOrNone").toBool(), true);
+
+	QVariantList results = receiver.payload.toList();
+	QCOMPARE(results.size(), 450);
+	for (int i = 0; i < results.size(); i++) {
+		QCOMPARE(results.at(i).toMap().value("id").toString(), recordId(i));
+		QVERIFY(results.at(i).toMap().value("success").toBool());
+	}
+}
+
+void SFCollectionTaskTest::requestsInFlight() {
+	mServer->setResponse("PATCH", kSFTestCollectionPath, 200, chunkResponse(0, 200));
+	mServer->setHoldResponses(true);
+	SFCollectionRequest *request = SFRestAPI::instance()->requestForUpdateObjects("Account", records(0, 1000));
+	request->setMaxRequestsInFlight(2);
+	SFTestResultReceiver receiver;
+	SFRestAPI::instance()->sendCollectionRequest(request, &receiver, SLOT(onResult(sf::SFResult*)));
+
+	//the other chunks wait for these ones
+	for (int i = 0; i < 250 && mServer->requests().size() < 2; i++) {
+		QTest::qWait(20);
+	}
+	QTest::qWait(200);
+	QCOMPARE(mServer->requests().size(), 2);
+	QVERIFY(!receiver.received);
+
+	//an answered chunk makes room for the next one
+	mServer->releaseResponses();
+	for (int i = 0; i < 250 && mServer->requests().size() < 4; i++) {
+		QTest::qWait(20);
+	}
+	QTest::qWait(200);
+	QCOMPARE(mServer->requests().size(), 4);
+
+	mServer->setHoldResponses(false);
+	mServer->releaseResponses();
+	QVERIFY(receiver.received || sfTestWait(&receiver, SIGNAL(resultReceived())));
+	QCOMPARE(mServer->requests().size(), 5);
+	QCOMPARE(receiver.payload.toList().size(), 1000);
+}
+
+void SFCollectionTaskTest::mergedResults() {
+	SFCollectionRequest *request = SFRestAPI::instance()->requestForUpdateObjects("Account", records(0, 450));
+	request->setMaxRequestsInFlight(1);
+	mServer->queueResponse("PATCH", kSFTestCollectionPath, response(chunkResponse(0, 200, QList<int>() << 3 << 199)));
+	//the second chunk fails as a whole
+	mServer->queueResponse("PATCH", kSFTestCollectionPath,
+			response("[{\"message\":\"Request limit exceeded\",\"errorCode\":\"REQUEST_LIMIT_EXCEEDED\"}]", 403));
+	mServer->queueResponse("PATCH", kSFTestCollectionPath, response(chunkResponse(400, 50, QList<int>() << 449)));
+
+	SFTestResultReceiver receiver;
+	QVERIFY(sendCollection(request, receiver));
+	QVERIFY(receiver.hasError);
+	QVERIFY(receiver.message.contains("247 of 450 records succeeded."));
+
+	//an entry per record, in order, whichever chunk it was in
+	QVariantList results = receiver.payload.toList();
+	QCOMPARE(results.size(), 450);
+	QVERIFY(results.at(0).toMap().value("success").toBool());
+	QVERIFY(!results.at(3).toMap().value("success").toBool());
+	QCOMPARE(results.at(3).toMap().value("errors").toList().first().toMap().value("statusCode").toString(),
+			QString("FIELD_CUSTOM_VALIDATION_EXCEPTION"));
+	QVERIFY(!results.at(199).toMap().value("success").toBool());
+	for (int i = 200; i < 400; i++) {
+		QVariantMap result = results.at(i).toMap();
+		QCOMPARE(result.value("id").toString(), recordId(i));
+		QVERIFY(!result.value("success").toBool());
+		QCOMPARE(result.value("errors").toList().size(), 1);
+	}
+	QVERIFY(results.at(400).toMap().value("success").toBool());
+	QCOMPARE(results.at(449).toMap().value("id").toString(), recordId(449));
+	QVERIFY(!results.at(449).toMap().value("success").toBool());
+}
+
+void SFCollectionTaskTest::deleteChunks() {
+	QStringList ids;
+	for (int i = 0; i < 250; i++) {
+		ids << recordId(i);
+	}
+	SFCollectionRequest *request = SFRestAPI::instance()->requestForDeleteObjects(ids);
+	request->setMaxRequestsInFlight(1);
+	mServer->queueResponse("DELETE", kSFTestCollectionPath, response(chunkResponse(0, 200)));
+	mServer->queueResponse("DELETE", kSFTestCollectionPath, response(chunkResponse(200, 50)));
+
+	SFTestResultReceiver receiver;
+	QVERIFY(sendCollection(request, receiver));
+	QVERIFY(!receiver.hasError);
+	QCOMPARE(receiver.payload.toList().size(), 250);
+
+	//the ids go in the query string
+	QList<SFTestServer::Request> requests = mServer->requests("DELETE", kSFTestCollectionPath);
+	QCOMPARE(requests.size(), 2);
+	QUrl second(QString::fromUtf8(requests.at(1).path));
+	QStringList sentIds = second.queryItemValue("ids").split(',');
+	QCOMPARE(sentIds.size(), 50);
+	QCOMPARE(sentIds.first(), recordId(200));
+	QCOMPARE(second.queryItemValue("allOrNone"), QString("false"));
+}
+
+void SFCollectionTaskTest::noRecords() {
+	SFTestResultReceiver receiver;
+	QVERIFY(sendCollection(SFRestAPI::instance()->requestForCreateObjects("Account", QVariantList()), receiver));
+	QVERIFY(!receiver.hasError);
+	QVERIFY(receiver.payload.toList().isEmpty());
+	QCOMPARE(mServer->requests().size(), 0);
+}
+
+} /* namespace sf */
@@ -0,0 +1,50 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCollectionTaskTest.h
+*/
+
+#ifndef SFCOLLECTIONTASKTEST_H_
+#define SFCOLLECTIONTASKTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * sObject Collections requests against a stand-in server: records split into chunks of 200, the limit of chunks in flight,
+ * and the results of the chunks merged in the order of the records, including a chunk that failed as a whole.
+ */
+class SFCollectionTaskTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void init();
+	void cleanup();
+
+	void chunks();
+	void requestsInFlight();
+	void mergedResults();
+	void deleteChunks();
+	void noRecords();
+
+private:
+	SFTestServer *mServer;
+};
+
+} /* namespace sf */
+#endif /* SFCOLLECTIONTASKTEST_H_ */
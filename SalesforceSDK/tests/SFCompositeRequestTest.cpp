@@ -0,0 +1,181 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCompositeRequestTest.cpp
+*/
+
+#include "SFCompositeRequestTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFCompositeRequest.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFTestServer.h"
+
+using namespace bb::data;
+
+namespace sf {
+
+static const QByteArray kSFTestCompositePath = "/services/data/v28.0/composite";
+
+/* @return the body of the last Composite request the server got */
+static QVariantMap lastCompositeBody(SFTestServer *server) {
+	QList<SFTestServer::Request> requests = server->requests("POST", kSFTestCompositePath);
+	JsonDataAccess jda;
+	return requests.isEmpty() ? QVariantMap() : jda.loadFromBuffer(requests.last().body).toMap();
+}
+
+/* send the composite request and wait for its result */
+static bool sendComposite(SFCompositeRequest & composite, SFTestResultReceiver & receiver) {
+	SFRestAPI *api = SFRestAPI::instance();
+	SFRestRequest *request = api->requestForComposite(&composite);
+	if (!request) {
+		return false;
+	}
+	api->sendRestRequest(request, &receiver, SLOT(onResult(sf::SFResult*)));
+	return receiver.received || sfTestWait(&receiver, SIGNAL(resultReceived()));
+}
+
+void SFCompositeRequestTest::initTestCase() {
+	mServer = new SFTestServer(this);
+	QVERIFY(mServer->start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(mServer->baseUrl()));
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+	SFRestAPI::instance()->setBatchWindow(0);
+}
+
+void SFCompositeRequestTest::init() {
+	mServer->clearRequests();
+}
+
+void SFCompositeRequestTest::references() {
+	mServer->setResponse("POST", kSFTestCompositePath, 200, "{\"compositeResponse\":["
+			"{\"body\":{\"id\":\"001D000000K0fXOIAZ\",\"success\":true,\"errors\":[]},\"httpHeaders\":{},\"httpStatusCode\":201,\"referenceId\":\"newAccount\"},"
+			"{\"body\":{\"id\":\"003D000000QV9n2IAD\",\"success\":true,\"errors\":[]},\"httpHeaders\":{},\"httpStatusCode\":201,\"referenceId\":\"newContact\"},"
+			"{\"body\":null,\"httpHeaders\":{},\"httpStatusCode\":204,\"referenceId\":\"renamedAccount\"}]}");
+
+	SFRestAPI *api = SFRestAPI::instance();
+	SFCompositeRequest composite;
+	QVariantMap account;
+	account["Name"] = "Acme";
+	QVERIFY(composite.add("newAccount", api->requestForCreateObject("Account", account)));
+	QVariantMap contact;
+	contact["LastName"] = "Smith";
+	contact["AccountId"] = SFCompositeRequest::reference("newAccount");
+	QVERIFY(composite.add("newContact", api->requestForCreateObject("Contact", contact)));
+	QVariantMap rename;
+	rename["Name"] = "Acme Inc.";
+	QVERIFY(composite.add("renamedAccount", api->requestForUpdateObject("Account", SFCompositeRequest::reference("newAccount"), rename)));
+	QCOMPARE(composite.count(), 3);
+	QCOMPARE(composite.referenceIds(), QStringList() << "newAccount" << "newContact" << "renamedAccount");
+
+	SFTestResultReceiver receiver;
+	QVERIFY(sendComposite(composite, receiver));
+	QVERIFY(!receiver.hasError);
+
+	//one round trip, the subrequests in the order they were added
+	QCOMPARE(mServer->requests().size(), 1);
+	QVariantMap body = lastCompositeBody(mServer);
+	QCOMPARE(body.value("allOrNone").toBool(), false);
+	QVariantList subrequests = body.value("compositeRequest").toList();
+	QCOMPARE(subrequests.size(), 3);
+	QVariantMap first = subrequests.at(0).toMap();
+	QCOMPARE(first.value("method").toString(), QString("POST"));
+	QCOMPARE(first.value("url").toString(), QString("/services/data/v28.0/sobjects/Account"));
+	QCOMPARE(first.value("referenceId").toString(), QString("newAccount"));
+	QCOMPARE(first.value("body").toMap().value("Name").toString(), QString("Acme"));
+
+	//the references are sent as they are, in fields and in paths
+	QVariantMap second = subrequests.at(1).toMap();
+	QCOMPARE(second.value("body").toMap().value("AccountId").toString(), QString("@{newAccount.id}"));
+	QVariantMap third = subrequests.at(2).toMap();
+	QCOMPARE(third.value("method").toString(), QString("PATCH"));
+	QCOMPARE(third.value("url").toString(), QString("/services/data/v28.0/sobjects/Account/@{newAccount.id}"));
+	QCOMPARE(SFCompositeRequest::reference("query", "records[0].Id"), QString("@{query.records[0].Id}"));
+
+	QVariantMap responses = SFCompositeRequest::responsesByReference(receiver.payload);
+	QCOMPARE(responses.size(), 3);
+	QCOMPARE(responses.value("newContact").toMap().value("body").toMap().value("id").toString(), QString("003D000000QV9n2IAD"));
+	QCOMPARE(responses.value("renamedAccount").toMap().value("httpStatusCode").toInt(), 204);
+}
+
+void SFCompositeRequestTest::allOrNone() {
+	//a failed subrequest rolls back the ones before it, the Composite request itself succeeds
+	mServer->setResponse("POST", kSFTestCompositePath, 200, "{\"compositeResponse\":["
+			"{\"body\":[{\"errorCode\":\"PROCESSING_HALTED\",\"message\":\"The transaction was rolled back since another operation in the same transaction failed.\"}],"
+			"\"httpHeaders\":{},\"httpStatusCode\":400,\"referenceId\":\"newAccount\"},"
+			"{\"body\":[{\"message\":\"Required fields are missing: [LastName]\",\"errorCode\":\"REQUIRED_FIELD_MISSING\",\"fields\":[\"LastName\"]}],"
+			"\"httpHeaders\":{},\"httpStatusCode\":400,\"referenceId\":\"newContact\"}]}");
+
+	SFRestAPI *api = SFRestAPI::instance();
+	SFCompositeRequest composite;
+	composite.setAllOrNone(true);
+	QVariantMap account;
+	account["Name"] = "Acme";
+	QVERIFY(composite.add("newAccount", api->requestForCreateObject("Account", account)));
+	QVariantMap contact;
+	contact["AccountId"] = SFCompositeRequest::reference("newAccount");
+	QVERIFY(composite.add("newContact", api->requestForCreateObject("Contact", contact)));
+
+	SFTestResultReceiver receiver;
+	QVERIFY(sendComposite(composite, receiver));
+	QVERIFY(!receiver.hasError);
+	QCOMPARE(lastCompositeBody(mServer).value("allOrNone").toBool(), true);
+
+	QVariantMap responses = SFCompositeRequest::responsesByReference(receiver.payload);
+	QCOMPARE(responses.size(), 2);
+	QVariantMap rolledBack = responses.value("newAccount").toMap();
+	QCOMPARE(rolledBack.value("httpStatusCode").toInt(), 400);
+	QCOMPARE(rolledBack.value("body").toList().first().toMap().value("errorCode").toString(), QString("PROCESSING_HALTED"));
+	QVariantMap failed = responses.value("newContact").toMap();
+	QCOMPARE(failed.value("body").toList().first().toMap().value("errorCode").toString(), QString("REQUIRED_FIELD_MISSING"));
+}
+
+void SFCompositeRequestTest::rejectedSubrequests() {
+	SFRestAPI *api = SFRestAPI::instance();
+	SFCompositeRequest composite;
+	QVERIFY(!composite.add("account", NULL));
+	QVERIFY(!composite.add("1account", api->requestForDescribeObject("Account")));
+	QVERIFY(!composite.add("new account", api->requestForDescribeObject("Account")));
+	QVERIFY(composite.add("account", api->requestForDescribeObject("Account")));
+	QVERIFY(!composite.add("account", api->requestForDescribeObject("Contact")));
+
+	//a subrequest can't carry its own headers, nor leave the versioned end point
+	SFRestRequest *withHeaders = api->requestForQuery("SELECT Id FROM Account");
+	QVariantMap headers;
+	headers["Sforce-Query-Options"] = "batchSize=200";
+	withHeaders->setRequestRawHeaders(headers);
+	QVERIFY(!composite.add("query", withHeaders));
+	QVERIFY(!composite.add("custom", api->customRequest("/services/apexrest/orders", HTTPMethod::HTTPGet, QVariantMap(), SFRestRequest::HTTPContentTypeUrlEncoded)));
+	QCOMPARE(composite.count(), 1);
+
+	for (int i = composite.count(); i < SFCompositeRequest::MaxSubrequests; i++) {
+		QVERIFY(composite.add(QString("describe%1").arg(i), api->requestForDescribeObject("Account")));
+	}
+	QVERIFY(!composite.add("oneTooMany", api->requestForDescribeObject("Account")));
+	QCOMPARE(composite.count(), int(SFCompositeRequest::MaxSubrequests));
+
+	SFCompositeRequest empty;
+	QVERIFY(!api->requestForComposite(&empty));
+	QCOMPARE(mServer->requests().size(), 0);
+}
+
+} /* namespace sf */
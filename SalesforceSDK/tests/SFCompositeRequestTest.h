@@ -0,0 +1,47 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCompositeRequestTest.h
+*/
+
+#ifndef SFCOMPOSITEREQUESTTEST_H_
+#define SFCOMPOSITEREQUESTTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * Composite requests against a stand-in server: references between subrequests in paths and fields, the all-or-none flag
+ * with a rolled back response, and the subrequests add() refuses.
+ */
+class SFCompositeRequestTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void init();
+
+	void references();
+	void allOrNone();
+	void rejectedSubrequests();
+
+private:
+	SFTestServer *mServer;
+};
+
+} /* namespace sf */
+#endif /* SFCOMPOSITEREQUESTTEST_H_ */
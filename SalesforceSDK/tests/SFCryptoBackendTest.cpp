@@ -0,0 +1,203 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCryptoBackendTest.cpp
+*/
+
+
+#include "SFCryptoBackendTest.h"
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QtTest/QtTest>
+#include "CipherContext.hpp"
+#include "SFCryptoBackend.h"
+
+namespace sf {
+
+static const int kSFThroughputBytes = 16 * 1024 * 1024;
+
+/* one row per backend compiled in, for the known-answer tests */
+static void addBackendRows(const char *vector, const QByteArray & key, const QByteArray & input, const QByteArray & expected) {
+	QStringList backends = SFCryptoBackend::availableBackends();
+	for (int i = 0; i < backends.size(); i++) {
+		QTest::newRow(QString("%1, %2").arg(backends.at(i), vector).toUtf8().constData())
+				<< backends.at(i) << key << input << expected;
+	}
+}
+
+static void addVectorColumns() {
+	QTest::addColumn<QString>("backend");
+	QTest::addColumn<QByteArray>("key");
+	QTest::addColumn<QByteArray>("input");
+	QTest::addColumn<QByteArray>("expected");
+}
+
+static QByteArray crypt(SFCryptoBackend *backend, bool isEncrypt, const QByteArray & key, const QByteArray & iv, const QByteArray & in) {
+	QScopedPointer<CipherContext> context(backend->createCipherContext(key));
+	QByteArray out(in.size(), '\0');
+	if (context.isNull() || !context->isValid() || !context->crypt(isEncrypt, iv, in, out)) {
+		return QByteArray();
+	}
+	return out;
+}
+
+static const QByteArray kSFAesIv = QByteArray::fromHex("000102030405060708090a0b0c0d0e0f");
+
+void SFCryptoBackendTest::aesCbc_data() {
+	addVectorColumns();
+	//NIST SP 800-38A, F.2.1 CBC-AES128.Encrypt
+	addBackendRows("SP 800-38A F.2.1", QByteArray::fromHex("2b7e151628aed2a6abf7158809cf4f3c"),
+			QByteArray::fromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+					"30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710"),
+			QByteArray::fromHex("7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b2"
+					"73bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7"));
+}
+
+void SFCryptoBackendTest::aesCbc() {
+	QFETCH(QString, backend);
+	QFETCH(QByteArray, key);
+	QFETCH(QByteArray, input);
+	QFETCH(QByteArray, expected);
+	SFCryptoBackend *cryptoBackend = SFCryptoBackend::backend(backend);
+	QVERIFY(cryptoBackend);
+	QCOMPARE(crypt(cryptoBackend, true, key, kSFAesIv, input).toHex(), expected.toHex());
+	QCOMPARE(crypt(cryptoBackend, false, key, kSFAesIv, expected).toHex(), input.toHex());
+}
+
+void SFCryptoBackendTest::sha256_data() {
+	addVectorColumns();
+	//FIPS 180-2 examples
+	addBackendRows("empty", QByteArray(), QByteArray(""),
+			QByteArray::fromHex("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+	addBackendRows("abc", QByteArray(), QByteArray("abc"),
+			QByteArray::fromHex("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"));
+}
+
+void SFCryptoBackendTest::sha256() {
+	QFETCH(QString, backend);
+	QFETCH(QByteArray, input);
+	QFETCH(QByteArray, expected);
+	SFCryptoBackend *cryptoBackend = SFCryptoBackend::backend(backend);
+	QVERIFY(cryptoBackend);
+	QCOMPARE(cryptoBackend->sha256(input).toHex(), expected.toHex());
+}
+
+void SFCryptoBackendTest::hmacSha256_data() {
+	addVectorColumns();
+	//RFC 4231, test cases 2 and 6
+	addBackendRows("RFC 4231 #2", QByteArray("Jefe"), QByteArray("what do ya want for nothing?"),
+			QByteArray::fromHex("5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"));
+	addBackendRows("RFC 4231 #6", QByteArray(131, '\xaa'), QByteArray("Test Using Larger Than Block-Size Key - Hash Key First"),
+			QByteArray::fromHex("60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"));
+}
+
+void SFCryptoBackendTest::hmacSha256() {
+	QFETCH(QString, backend);
+	QFETCH(QByteArray, key);
+	QFETCH(QByteArray, input);
+	QFETCH(QByteArray, expected);
+	SFCryptoBackend *cryptoBackend = SFCryptoBackend::backend(backend);
+	QVERIFY(cryptoBackend);
+	QCOMPARE(cryptoBackend->hmacSha256(key, input).toHex(), expected.toHex());
+}
+
+void SFCryptoBackendTest::randomBytes_data() {
+	QTest::addColumn<QString>("backend");
+	QStringList backends = SFCryptoBackend::availableBackends();
+	for (int i = 0; i < backends.size(); i++) {
+		QTest::newRow(backends.at(i).toUtf8().constData()) << backends.at(i);
+	}
+}
+
+void SFCryptoBackendTest::randomBytes() {
+	QFETCH(QString, backend);
+	SFCryptoBackend *cryptoBackend = SFCryptoBackend::backend(backend);
+	QVERIFY(cryptoBackend);
+	QByteArray first(32, '\0');
+	QByteArray second(32, '\0');
+	QVERIFY(cryptoBackend->randomBytes(first));
+	QVERIFY(cryptoBackend->randomBytes(second));
+	QVERIFY(first != QByteArray(32, '\0'));
+	QVERIFY(first != second);
+}
+
+/* what one backend encrypts, every other one decrypts */
+void SFCryptoBackendTest::crossBackend() {
+	QStringList backends = SFCryptoBackend::availableBackends();
+	if (backends.size() < 2) {
+		QSKIP("only one crypto backend is compiled in", SkipAll);
+	}
+	QByteArray key(16, '\0');
+	QByteArray iv(16, '\0');
+	QByteArray clearText(64 * 1024, '\0');
+	QVERIFY(SFCryptoBackend::instance()->randomBytes(key));
+	QVERIFY(SFCryptoBackend::instance()->randomBytes(iv));
+	QVERIFY(SFCryptoBackend::instance()->randomBytes(clearText));
+	for (int i = 0; i < backends.size(); i++) {
+		QByteArray cipherText = crypt(SFCryptoBackend::backend(backends.at(i)), true, key, iv, clearText);
+		QVERIFY(!cipherText.isEmpty());
+		for (int j = 0; j < backends.size(); j++) {
+			QVERIFY(crypt(SFCryptoBackend::backend(backends.at(j)), false, key, iv, cipherText) == clearText);
+			QCOMPARE(SFCryptoBackend::backend(backends.at(j))->sha256(clearText).toHex(),
+					SFCryptoBackend::backend(backends.at(i))->sha256(clearText).toHex());
+		}
+	}
+}
+
+void SFCryptoBackendTest::throughput_data() {
+	QTest::addColumn<QString>("backend");
+	QTest::addColumn<QString>("operation");
+	QTest::addColumn<int>("length");
+	QStringList backends = SFCryptoBackend::availableBackends();
+	const char *operations[] = {"encrypt", "decrypt", "sha256"};
+	for (int i = 0; i < backends.size(); i++) {
+		for (unsigned int j = 0; j < sizeof(operations) / sizeof(operations[0]); j++) {
+			QTest::newRow(QString("%1, %2, 64 B").arg(backends.at(i), operations[j]).toUtf8().constData())
+					<< backends.at(i) << QString(operations[j]) << 64;
+			QTest::newRow(QString("%1, %2, 64 KB").arg(backends.at(i), operations[j]).toUtf8().constData())
+					<< backends.at(i) << QString(operations[j]) << 64 * 1024;
+		}
+	}
+}
+
+/* reported in bytes per second, one row per backend to compare them */
+void SFCryptoBackendTest::throughput() {
+	QFETCH(QString, backend);
+	QFETCH(QString, operation);
+	QFETCH(int, length);
+	SFCryptoBackend *cryptoBackend = SFCryptoBackend::backend(backend);
+	QVERIFY(cryptoBackend);
+	QByteArray key(16, '\x2b');
+	QByteArray input(length, '\x6b');
+	QByteArray output(length, '\0');
+	QScopedPointer<CipherContext> context(cryptoBackend->createCipherContext(key));
+	QVERIFY(!context.isNull() && context->isValid());
+	bool isEncrypt = (operation == "encrypt");
+	bool isHash = (operation == "sha256");
+	int count = kSFThroughputBytes / length;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < count; i++) {
+		if (isHash) {
+			cryptoBackend->sha256(input);
+		} else {
+			context->crypt(isEncrypt, kSFAesIv, input, output);
+		}
+	}
+	qint64 elapsed = qMax(qint64(1), timer.elapsed());
+	QTest::setBenchmarkResult(count * (qreal) length * 1000 / elapsed, QTest::BytesPerSecond);
+}
+
+} /* namespace sf */
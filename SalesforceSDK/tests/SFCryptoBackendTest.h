@@ -0,0 +1,47 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCryptoBackendTest.h
+*/
+
+
+#ifndef SFCRYPTOBACKENDTEST_H_
+#define SFCRYPTOBACKENDTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * Known-answer tests of every crypto backend compiled in, a cross check between them, and their throughput.
+ */
+class SFCryptoBackendTest : public QObject {
+	Q_OBJECT
+private slots:
+	void aesCbc_data();
+	void aesCbc();
+	void sha256_data();
+	void sha256();
+	void hmacSha256_data();
+	void hmacSha256();
+	void randomBytes_data();
+	void randomBytes();
+	void crossBackend();
+	void throughput_data();
+	void throughput();
+};
+
+} /* namespace sf */
+#endif /* SFCRYPTOBACKENDTEST_H_ */
@@ -0,0 +1,116 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCsvStreamParserTest.cpp
+*/
+
+
+#include "SFCsvStreamParserTest.h"
+#include <QtTest/QtTest>
+#include "SFCsvStreamParser.h"
+
+Q_DECLARE_METATYPE(QList<QStringList>)
+
+namespace sf {
+
+/* keeps the rows */
+class SFCsvRowCollector : public SFCsvStreamHandler {
+public:
+	QList<QStringList> rows;
+	bool row(const QStringList & fields) {
+		rows.append(fields);
+		return true;
+	}
+};
+
+static bool parseInChunks(const QByteArray & csv, int chunkSize, QList<QStringList> * pOutRows) {
+	SFCsvRowCollector collector;
+	SFCsvStreamParser parser(&collector);
+	for (int i = 0; i < csv.size(); i += chunkSize) {
+		if (!parser.feed(csv.mid(i, chunkSize))) {
+			return false;
+		}
+	}
+	if (!parser.finish()) {
+		return false;
+	}
+	*pOutRows = collector.rows;
+	return true;
+}
+
+void SFCsvStreamParserTest::quoting_data() {
+	QTest::addColumn<QByteArray>("csv");
+	QTest::addColumn<QList<QStringList> >("rows");
+	QTest::newRow("plain") << QByteArray("Id,Name\n001,Acme\n")
+			<< (QList<QStringList>() << (QStringList() << "Id" << "Name") << (QStringList() << "001" << "Acme"));
+	QTest::newRow("CRLF, no final line break") << QByteArray("a,b\r\nc,d")
+			<< (QList<QStringList>() << (QStringList() << "a" << "b") << (QStringList() << "c" << "d"));
+	QTest::newRow("empty fields") << QByteArray(",\n,x,\n")
+			<< (QList<QStringList>() << (QStringList() << "" << "") << (QStringList() << "" << "x" << ""));
+	QTest::newRow("empty lines") << QByteArray("\na\n\r\n\nb\n")
+			<< (QList<QStringList>() << (QStringList() << "a") << (QStringList() << "b"));
+	QTest::newRow("quoted delimiter") << QByteArray("\"Acme, Inc.\",1\n")
+			<< (QList<QStringList>() << (QStringList() << "Acme, Inc." << "1"));
+	QTest::newRow("escaped quotes") << QByteArray("\"say \"\"hi\"\"\",\"\"\"\"\n")
+			<< (QList<QStringList>() << (QStringList() << "say \"hi\"" << "\""));
+	QTest::newRow("quoted line breaks") << QByteArray("\"line 1\nline 2\",\"a\r\nb\"\r\nnext,row\r\n")
+			<< (QList<QStringList>() << (QStringList() << "line 1\nline 2" << "a\r\nb") << (QStringList() << "next" << "row"));
+	QTest::newRow("quoted empty field") << QByteArray("\"\"\n\"\",\"\"\n")
+			<< (QList<QStringList>() << (QStringList() << "") << (QStringList() << "" << ""));
+	QTest::newRow("UTF-8") << QByteArray("\xc3\xa9t\xc3\xa9,\"\xe2\x82\xac \xf0\x9f\x98\x80\"\n")
+			<< (QList<QStringList>() << (QStringList() << QString::fromUtf8("\xc3\xa9t\xc3\xa9") << QString::fromUtf8("\xe2\x82\xac \xf0\x9f\x98\x80")));
+}
+
+void SFCsvStreamParserTest::quoting() {
+	QFETCH(QByteArray, csv);
+	QFETCH(QList<QStringList>, rows);
+	for (int chunkSize = 1; chunkSize <= csv.size(); chunkSize++) {
+		QList<QStringList> parsed;
+		QVERIFY2(parseInChunks(csv, chunkSize, &parsed), qPrintable(QString("chunk size %1").arg(chunkSize)));
+		QVERIFY2(parsed == rows, qPrintable(QString("chunk size %1").arg(chunkSize)));
+	}
+}
+
+void SFCsvStreamParserTest::invalidDocuments_data() {
+	QTest::addColumn<QByteArray>("csv");
+	QTest::newRow("unterminated quoted field") << QByteArray("a,\"b\n");
+	QTest::newRow("quote in an unquoted field") << QByteArray("a,b\"c\n");
+	QTest::newRow("text after a quoted field") << QByteArray("\"a\"b,c\n");
+}
+
+void SFCsvStreamParserTest::invalidDocuments() {
+	QFETCH(QByteArray, csv);
+	QList<QStringList> rows;
+	QVERIFY(!parseInChunks(csv, 1, &rows));
+	QVERIFY(!parseInChunks(csv, csv.size(), &rows));
+}
+
+void SFCsvStreamParserTest::recordsConsumer() {
+	QByteArray csv("\"Id\",\"Name\"\n\"001\",\"Acme, Inc.\"\n\"002\",\"\"\"Quoted\"\"\"\n");
+	SFCsvRecordsConsumer consumer;
+	QVERIFY(consumer.begin(200, "text/csv"));
+	for (int i = 0; i < csv.size(); i += 5) {
+		QVERIFY(consumer.consume(csv.mid(i, 5)));
+	}
+	QVERIFY(consumer.finish());
+	QCOMPARE(consumer.columns(), QStringList() << "Id" << "Name");
+	QCOMPARE(consumer.rowCount(), 2);
+	QVariantList rows = consumer.result().toMap().value("rows").toList();
+	QCOMPARE(rows.size(), 2);
+	QCOMPARE(rows.at(0).toStringList(), QStringList() << "001" << "Acme, Inc.");
+	QCOMPARE(rows.at(1).toStringList(), QStringList() << "002" << "\"Quoted\"");
+}
+
+} /* namespace sf */
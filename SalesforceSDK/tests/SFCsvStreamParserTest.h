@@ -0,0 +1,41 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFCsvStreamParserTest.h
+*/
+
+
+#ifndef SFCSVSTREAMPARSERTEST_H_
+#define SFCSVSTREAMPARSERTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * SFCsvStreamParser must split rows and fields as RFC 4180 does, quoted fields included, whatever the chunk boundaries.
+ */
+class SFCsvStreamParserTest : public QObject {
+	Q_OBJECT
+private slots:
+	void quoting_data();
+	void quoting();
+	void invalidDocuments_data();
+	void invalidDocuments();
+	void recordsConsumer();
+};
+
+} /* namespace sf */
+#endif /* SFCSVSTREAMPARSERTEST_H_ */
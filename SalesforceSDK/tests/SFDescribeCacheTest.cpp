@@ -0,0 +1,186 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFDescribeCacheTest.cpp
+*/
+
+
+
+#include "SFDescribeCacheTest.h"
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFDescribeCache.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRestAPI.h"
+#include "SFTestServer.h"
+
+namespace sf {
+
+static const QByteArray kSFTestDescribePath = "/services/data/v28.0/sobjects/Account/describe";
+static const QByteArray kSFTestLastModified = "Fri, 18 Oct 2013 10:00:00 GMT";
+static const QByteArray kSFTestDescribe = "{\"name\":\"Account\",\"label\":\"Account\",\"fields\":"
+		"[{\"name\":\"Id\",\"type\":\"id\"},{\"name\":\"Name\",\"type\":\"string\",\"length\":255}]}";
+
+/* @return the documents written by the cache, in every scope */
+static QStringList cachedFiles() {
+	QStringList files;
+	QDir root(QDir::home().absoluteFilePath("sf_describe_cache"));
+	QStringList scopes = root.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	for (int i = 0; i < scopes.size(); i++) {
+		QDir scope(root.absoluteFilePath(scopes.at(i)));
+		QStringList names = scope.entryList(QStringList() << "*", QDir::Files);
+		for (int j = 0; j < names.size(); j++) {
+			if (!names.at(j).endsWith(".tmp")) {
+				files << scope.absoluteFilePath(names.at(j));
+			}
+		}
+	}
+	return files;
+}
+
+/* documents are written in the global thread pool */
+static bool waitForFiles(int count) {
+	for (int i = 0; i < 250 && cachedFiles().size() < count; i++) {
+		QTest::qWait(20);
+	}
+	return cachedFiles().size() == count;
+}
+
+static SFTestServer::Response describeResponse(const QByteArray & body) {
+	SFTestServer::Response response;
+	response.body = body;
+	response.headers << qMakePair(QByteArray("Last-Modified"), kSFTestLastModified);
+	return response;
+}
+
+void SFDescribeCacheTest::initTestCase() {
+	qRegisterMetaType<SFDescribeCache::Kind>("sf::SFDescribeCache::Kind");
+	mServer = new SFTestServer(this);
+	QVERIFY(mServer->start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(mServer->baseUrl()));
+	credentials->setIdentityUrl(QUrl("https://login.salesforce.com/id/00Dtest000000001AAA/005test000000001AAA"));
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+	mServer->setResponse("GET", kSFTestDescribePath, describeResponse(kSFTestDescribe));
+}
+
+void SFDescribeCacheTest::cleanupTestCase() {
+	SFDescribeCache::instance()->clear();
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+}
+
+void SFDescribeCacheTest::init() {
+	SFDescribeCache::instance()->clear();
+	mServer->clearRequests();
+}
+
+void SFDescribeCacheTest::fetchAndStore() {
+	SFDescribeCache *cache = SFDescribeCache::instance();
+	QSignalSpy updated(cache, SIGNAL(updated(sf::SFDescribeCache::Kind, const QString &, const QVariantMap &)));
+	QVERIFY(cache->describe("Account").isEmpty());
+	QVERIFY(sfTestWait(cache, SIGNAL(updated(sf::SFDescribeCache::Kind, const QString &, const QVariantMap &))));
+	QCOMPARE(updated.size(), 1);
+	QCOMPARE(updated.first().at(1).toString(), QString("Account"));
+	QCOMPARE(mServer->requests("GET", kSFTestDescribePath).size(), 1);
+	//nothing cached yet, so nothing to revalidate against
+	QVERIFY(!mServer->requests("GET", kSFTestDescribePath).first().headers.contains("if-modified-since"));
+
+	QVariantMap describe = cache->describe("Account");
+	QCOMPARE(describe.value("name").toString(), QString("Account"));
+	QCOMPARE(describe.value("fields").toList().size(), 2);
+	//revalidated once per session
+	QCOMPARE(mServer->requests("GET", kSFTestDescribePath).size(), 1);
+
+	QVERIFY(waitForFiles(1));
+	QFile file(cachedFiles().first());
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QByteArray data = file.readAll();
+	QVERIFY(data.startsWith("SFDC"));
+	QVERIFY(data.contains(kSFTestLastModified));
+	QVERIFY(!data.contains("\"length\""));
+	QVERIFY(!data.contains("string"));
+}
+
+void SFDescribeCacheTest::loadFromDisk() {
+	SFDescribeCache *cache = SFDescribeCache::instance();
+	cache->describe("Account");
+	QVERIFY(sfTestWait(cache, SIGNAL(updated(sf::SFDescribeCache::Kind, const QString &, const QVariantMap &))));
+	QVERIFY(waitForFiles(1));
+
+	//another API version is another scope, the decoded documents are dropped
+	SFRestAPI::instance()->setApiVersion("/v29.0");
+	QVERIFY(cache->metadata("Contact").isEmpty());
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+	int requests = mServer->requests("GET", kSFTestDescribePath).size();
+	QVariantMap describe = cache->describe("Account");
+	QCOMPARE(describe.value("label").toString(), QString("Account"));
+	QCOMPARE(describe.value("fields").toList().at(1).toMap().value("length").toInt(), 255);
+	QCOMPARE(mServer->requests("GET", kSFTestDescribePath).size(), requests);
+}
+
+void SFDescribeCacheTest::revalidate() {
+	SFDescribeCache *cache = SFDescribeCache::instance();
+	cache->describe("Account");
+	QVERIFY(sfTestWait(cache, SIGNAL(updated(sf::SFDescribeCache::Kind, const QString &, const QVariantMap &))));
+	QVERIFY(waitForFiles(1));
+
+	//unchanged: a 304 without body, nothing is emitted
+	SFTestServer::Response notModified;
+	notModified.status = 304;
+	notModified.contentType = QByteArray();
+	mServer->queueResponse("GET", kSFTestDescribePath, notModified);
+	QSignalSpy updated(cache, SIGNAL(updated(sf::SFDescribeCache::Kind, const QString &, const QVariantMap &)));
+	QSignalSpy failed(cache, SIGNAL(failed(sf::SFDescribeCache::Kind, const QString &, int, const QString &)));
+	mServer->clearRequests();
+	cache->refresh(SFDescribeCache::Describe, "Account");
+	QVERIFY(sfTestWait(mServer, SIGNAL(requestReceived())));
+	QCOMPARE(mServer->requests().first().headers.value("if-modified-since"), kSFTestLastModified);
+	QTest::qWait(200);
+	QCOMPARE(updated.size(), 0);
+	QCOMPARE(failed.size(), 0);
+	QCOMPARE(cache->describe("Account").value("fields").toList().size(), 2);
+
+	//changed: the new document replaces the cached one
+	QByteArray changed = QByteArray(kSFTestDescribe).replace("\"label\":\"Account\"", "\"label\":\"Customer\"");
+	mServer->queueResponse("GET", kSFTestDescribePath, describeResponse(changed));
+	cache->refresh(SFDescribeCache::Describe, "Account");
+	QVERIFY(sfTestWait(cache, SIGNAL(updated(sf::SFDescribeCache::Kind, const QString &, const QVariantMap &))));
+	QCOMPARE(updated.size(), 1);
+	QCOMPARE(updated.first().at(2).toMap().value("label").toString(), QString("Customer"));
+	QCOMPARE(cache->describe("Account").value("label").toString(), QString("Customer"));
+}
+
+void SFDescribeCacheTest::clear() {
+	SFDescribeCache *cache = SFDescribeCache::instance();
+	cache->describe("Account");
+	QVERIFY(sfTestWait(cache, SIGNAL(updated(sf::SFDescribeCache::Kind, const QString &, const QVariantMap &))));
+	QVERIFY(waitForFiles(1));
+	cache->clear();
+	QVERIFY(cachedFiles().isEmpty());
+	mServer->clearRequests();
+	QVERIFY(cache->describe("Account").isEmpty());
+	//fetched again, without a date to revalidate against
+	QVERIFY(sfTestWait(mServer, SIGNAL(requestReceived())));
+	QVERIFY(!mServer->requests().first().headers.contains("if-modified-since"));
+	QVERIFY(sfTestWait(cache, SIGNAL(updated(sf::SFDescribeCache::Kind, const QString &, const QVariantMap &))));
+}
+
+} /* namespace sf */
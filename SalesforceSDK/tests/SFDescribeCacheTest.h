@@ -0,0 +1,51 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFDescribeCacheTest.h
+*/
+
+
+
+#ifndef SFDESCRIBECACHETEST_H_
+#define SFDESCRIBECACHETEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * The describe cache against a stand-in server: the first fetch, the encrypted files, reading a document back from disk,
+ * revalidation with "If-Modified-Since" and removing everything on clear().
+ */
+class SFDescribeCacheTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+
+	void fetchAndStore();
+	void loadFromDisk();
+	void revalidate();
+	void clear();
+
+private:
+	SFTestServer *mServer;
+};
+
+} /* namespace sf */
+#endif /* SFDESCRIBECACHETEST_H_ */
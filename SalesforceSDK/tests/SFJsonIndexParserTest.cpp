@@ -0,0 +1,106 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonIndexParserTest.cpp
+*/
+
+
+#include "SFJsonIndexParserTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QtTest/QtTest>
+#include "SFJsonIndexParser.h"
+#include "SFTestData.h"
+
+using namespace bb::data;
+
+namespace sf {
+
+static const int kSFMegabyte = 1024 * 1024;
+
+void SFJsonIndexParserTest::sameAsJsonDataAccess_data() {
+	QTest::addColumn<QByteArray>("json");
+	QTest::newRow("scalars") << QByteArray("[0,-1,3.25,-2.5e-3,1E+2,9223372036854775807,true,false,null]");
+	QTest::newRow("strings") << QByteArray("[\"\",\"a\\\"b\\\\c\\/d\",\"\\b\\f\\n\\r\\t\",\"\\u00e9\\u20AC\",\"\\ud83d\\ude00\",\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"]");
+	//strings are scanned eight bytes at a time, the quotes and backslashes fall on every position of a word
+	QTest::newRow("escapes in words") << QByteArray("[\"1234567\\\"\",\"123456\\\\\",\"12345678\\n12345678\",\"\\\"1234567890123456\\\"\"]");
+	QTest::newRow("nested") << QByteArray("{\"a\":{\"b\":[[],{},[{\"c\":null}]]},\"d\":[1,[2,[3]]],\"e\":{}}");
+	QTest::newRow("whitespace") << QByteArray(" \r\n\t{ \"a\" : [ 1 , 2 ] ,\n\"b\" : \"x\" } \n");
+	QTest::newRow("small page, sequential") << sfTestQueryPage(10);
+	QTest::newRow("large page, parallel") << sfTestQueryPage(5000);
+}
+
+void SFJsonIndexParserTest::sameAsJsonDataAccess() {
+	QFETCH(QByteArray, json);
+	JsonDataAccess jda;
+	QVariant expected = jda.loadFromBuffer(json);
+	QVERIFY(!jda.hasError());
+
+	SFJsonIndexParser parser(json);
+	QVERIFY2(parser.parse(), qPrintable(parser.errorString()));
+	QCOMPARE(parser.result(), expected);
+}
+
+void SFJsonIndexParserTest::invalidDocuments_data() {
+	QTest::addColumn<QByteArray>("json");
+	QTest::newRow("empty") << QByteArray("");
+	QTest::newRow("unterminated object") << QByteArray("{\"a\":1");
+	QTest::newRow("unterminated string") << QByteArray("[\"abc");
+	QTest::newRow("trailing comma") << QByteArray("[1,]");
+	QTest::newRow("missing colon") << QByteArray("{\"a\" 1}");
+	QTest::newRow("bad literal") << QByteArray("[tru]");
+	QTest::newRow("mismatched bracket") << QByteArray("{\"a\":[1}");
+	QByteArray page = sfTestQueryPage(1000);
+	QTest::newRow("truncated page") << page.left(page.size() - 2);
+	QTest::newRow("bad record in a parallel page") << page.replace("\"IsDeleted\":true,\"Description\"", "\"IsDeleted\":true,,\"Description\"");
+}
+
+void SFJsonIndexParserTest::invalidDocuments() {
+	QFETCH(QByteArray, json);
+	SFJsonIndexParser parser(json);
+	QVERIFY(!parser.parse());
+	QVERIFY(!parser.errorString().isEmpty());
+}
+
+void SFJsonIndexParserTest::parseQueryPage_data() {
+	QTest::addColumn<QByteArray>("json");
+	QTest::addColumn<bool>("useIndexParser");
+	int sizes[] = {1, 10, 50};
+	for (uint i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		QByteArray page = sfTestQueryPageOfSize(sizes[i] * kSFMegabyte);
+		QTest::newRow(qPrintable(QString("%1 MB, JsonDataAccess").arg(sizes[i]))) << page << false;
+		QTest::newRow(qPrintable(QString("%1 MB, SFJsonIndexParser").arg(sizes[i]))) << page << true;
+	}
+}
+
+void SFJsonIndexParserTest::parseQueryPage() {
+	QFETCH(QByteArray, json);
+	QFETCH(bool, useIndexParser);
+	QVariant result;
+	if (useIndexParser) {
+		QBENCHMARK {
+			SFJsonIndexParser parser(json);
+			parser.parse();
+			result = parser.result();
+		}
+	} else {
+		QBENCHMARK {
+			JsonDataAccess jda;
+			result = jda.loadFromBuffer(json);
+		}
+	}
+	QVERIFY(result.toMap().value("records").toList().size() > 0);
+}
+
+} /* namespace sf */
@@ -0,0 +1,43 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonIndexParserTest.h
+*/
+
+
+#ifndef SFJSONINDEXPARSERTEST_H_
+#define SFJSONINDEXPARSERTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * SFJsonIndexParser must build the same documents as JsonDataAccess, with the records materialized in parallel or not.
+ * The benchmarks compare both parsers on query pages of 1, 10 and 50 MB.
+ */
+class SFJsonIndexParserTest : public QObject {
+	Q_OBJECT
+private slots:
+	void sameAsJsonDataAccess_data();
+	void sameAsJsonDataAccess();
+	void invalidDocuments_data();
+	void invalidDocuments();
+	void parseQueryPage_data();
+	void parseQueryPage();
+};
+
+} /* namespace sf */
+#endif /* SFJSONINDEXPARSERTEST_H_ */
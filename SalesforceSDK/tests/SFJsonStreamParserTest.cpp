@@ -0,0 +1,263 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonStreamParserTest.cpp
+*/
+
+
+#include "SFJsonStreamParserTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QElapsedTimer>
+#include <QtTest/QtTest>
+#include "SFJsonStreamParser.h"
+#include "SFTestData.h"
+
+using namespace bb::data;
+
+namespace sf {
+
+static const int kSFMegabyte = 1024 * 1024;
+static const int kSFChunkSize = 16 * 1024; //about what a socket read gives
+
+enum {
+	ParseWithJsonDataAccess,
+	ParseWithBuilder,
+	ParseRecordByRecord
+};
+
+/* counts the records and drops them, the way a consumer that stores them as they arrive does */
+class SFTestRecordCounter : public SFJsonRecordsConsumer {
+public:
+	SFTestRecordCounter() : timer(NULL), firstRecordNsecs(-1), peakHeap(0), samplePeak(false) {}
+	QElapsedTimer *timer;
+	qint64 firstRecordNsecs;
+	qint64 peakHeap;
+	bool samplePeak;
+protected:
+	bool processRecord(int index, const QVariant & record) {
+		Q_UNUSED(record);
+		if (index == 0 && timer) {
+			firstRecordNsecs = timer->nsecsElapsed();
+		}
+		if (samplePeak) {
+			peakHeap = qMax(peakHeap, sfTestHeapInUse());
+		}
+		return true;
+	}
+};
+
+/* feeds the document in chunks of the given size */
+static bool parseInChunks(const QByteArray & json, int chunkSize, QVariant * pOutResult) {
+	SFJsonVariantBuilder builder;
+	SFJsonStreamParser parser(&builder);
+	for (int i = 0; i < json.size(); i += chunkSize) {
+		if (!parser.feed(json.mid(i, chunkSize))) {
+			return false;
+		}
+	}
+	if (!parser.finish() || !builder.isComplete()) {
+		return false;
+	}
+	*pOutResult = builder.result();
+	return true;
+}
+
+/* feeds the records in chunks of the given size, the way SFNetworkAccessTask does */
+static bool consumeInChunks(SFJsonRecordsConsumer & consumer, const QByteArray & json, int chunkSize) {
+	if (!consumer.begin(200, "application/json;charset=UTF-8")) {
+		return false;
+	}
+	for (int i = 0; i < json.size(); i += chunkSize) {
+		if (!consumer.consume(json.mid(i, chunkSize))) {
+			return false;
+		}
+	}
+	return consumer.finish();
+}
+
+/* @return the number of records of the page, 0 on error. @a pOutPeakHeap gets the heap in use when it was the highest */
+static int parse(const QByteArray & json, int mode, qint64 * pOutPeakHeap) {
+	if (mode == ParseWithJsonDataAccess) {
+		JsonDataAccess jda;
+		QVariant result = jda.loadFromBuffer(json);
+		if (pOutPeakHeap) {
+			*pOutPeakHeap = sfTestHeapInUse();
+		}
+		return result.toMap().value("records").toList().size();
+	}
+	if (mode == ParseWithBuilder) {
+		QVariant result;
+		if (!parseInChunks(json, kSFChunkSize, &result)) {
+			return 0;
+		}
+		if (pOutPeakHeap) {
+			*pOutPeakHeap = sfTestHeapInUse();
+		}
+		return result.toMap().value("records").toList().size();
+	}
+	SFTestRecordCounter consumer;
+	consumer.samplePeak = (pOutPeakHeap != NULL);
+	if (!consumeInChunks(consumer, json, kSFChunkSize)) {
+		return 0;
+	}
+	if (pOutPeakHeap) {
+		*pOutPeakHeap = consumer.peakHeap;
+	}
+	return consumer.recordCount();
+}
+
+void SFJsonStreamParserTest::chunkBoundaries_data() {
+	QTest::addColumn<QByteArray>("json");
+	QTest::newRow("scalars") << QByteArray("[0,-1,3.25,-2.5e-3,1E+2,9223372036854775807,true,false,null]");
+	QTest::newRow("strings") << QByteArray("[\"\",\"a\\\"b\\\\c\\/d\",\"\\b\\f\\n\\r\\t\",\"\\u00e9\\u20AC\",\"\\ud83d\\ude00\",\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"]");
+	QTest::newRow("nested") << QByteArray("{\"a\":{\"b\":[[],{},[{\"c\":null}]]},\"d\":[1,[2,[3]]],\"e\":{}}");
+	QTest::newRow("whitespace") << QByteArray(" \r\n\t{ \"a\" : [ 1 , 2 ] ,\n\"b\" : \"x\" } \n");
+	QTest::newRow("query page") << sfTestQueryPage(20);
+}
+
+void SFJsonStreamParserTest::chunkBoundaries() {
+	QFETCH(QByteArray, json);
+	JsonDataAccess jda;
+	QVariant expected = jda.loadFromBuffer(json);
+	QVERIFY(!jda.hasError());
+
+	//every split of every token, up to the whole document at once
+	int maxChunkSize = qMin(json.size(), 64);
+	for (int chunkSize = 1; chunkSize <= maxChunkSize; chunkSize++) {
+		QVariant result;
+		QVERIFY2(parseInChunks(json, chunkSize, &result), qPrintable(QString("chunk size %1").arg(chunkSize)));
+		QVERIFY2(result == expected, qPrintable(QString("chunk size %1").arg(chunkSize)));
+	}
+	QVariant result;
+	QVERIFY(parseInChunks(json, json.size(), &result));
+	QCOMPARE(result, expected);
+}
+
+void SFJsonStreamParserTest::invalidDocuments_data() {
+	QTest::addColumn<QByteArray>("json");
+	QTest::newRow("unterminated object") << QByteArray("{\"a\":1");
+	QTest::newRow("unterminated string") << QByteArray("[\"abc");
+	QTest::newRow("trailing comma") << QByteArray("[1,]");
+	QTest::newRow("missing colon") << QByteArray("{\"a\" 1}");
+	QTest::newRow("bad literal") << QByteArray("[tru]");
+	QTest::newRow("bad escape") << QByteArray("[\"\\x\"]");
+	QTest::newRow("mismatched bracket") << QByteArray("{\"a\":[1}");
+	QTest::newRow("two documents") << QByteArray("{} {}");
+}
+
+void SFJsonStreamParserTest::invalidDocuments() {
+	QFETCH(QByteArray, json);
+	QVariant result;
+	QVERIFY(!parseInChunks(json, 1, &result));
+	QVERIFY(!parseInChunks(json, json.size(), &result));
+}
+
+void SFJsonStreamParserTest::recordsConsumer() {
+	QByteArray json = sfTestQueryPage(50);
+	JsonDataAccess jda;
+	QVariant expected = jda.loadFromBuffer(json);
+	QVERIFY(!jda.hasError());
+
+	int chunkSizes[] = {1, 13, 4096, json.size()};
+	for (uint i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++) {
+		SFJsonRecordsConsumer consumer;
+		QVERIFY2(consumeInChunks(consumer, json, chunkSizes[i]), qPrintable(consumer.errorString()));
+		QCOMPARE(consumer.recordCount(), 50);
+		QCOMPARE(consumer.result(), expected);
+	}
+
+	SFJsonRecordsConsumer consumer;
+	QVERIFY(!consumeInChunks(consumer, json.left(json.size() - 1), 4096));
+	QVERIFY(!consumer.errorString().isEmpty());
+}
+
+void SFJsonStreamParserTest::parseQueryPage_data() {
+	QTest::addColumn<QByteArray>("json");
+	QTest::addColumn<int>("mode");
+	int sizes[] = {1, 10};
+	for (uint i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		QByteArray page = sfTestQueryPageOfSize(sizes[i] * kSFMegabyte);
+		QTest::newRow(qPrintable(QString("%1 MB, JsonDataAccess").arg(sizes[i]))) << page << (int) ParseWithJsonDataAccess;
+		QTest::newRow(qPrintable(QString("%1 MB, SFJsonStreamParser, whole document").arg(sizes[i]))) << page << (int) ParseWithBuilder;
+		QTest::newRow(qPrintable(QString("%1 MB, SFJsonStreamParser, record by record").arg(sizes[i]))) << page << (int) ParseRecordByRecord;
+	}
+}
+
+/* the time to parse a whole page, the stream parser is fed the way a download is, in chunks */
+void SFJsonStreamParserTest::parseQueryPage() {
+	QFETCH(QByteArray, json);
+	QFETCH(int, mode);
+	int records = 0;
+	QBENCHMARK {
+		records = parse(json, mode, NULL);
+	}
+	QVERIFY(records > 0);
+}
+
+void SFJsonStreamParserTest::firstRecordLatency_data() {
+	QTest::addColumn<int>("mode");
+	QTest::newRow("JsonDataAccess") << (int) ParseWithJsonDataAccess;
+	QTest::newRow("SFJsonStreamParser, record by record") << (int) ParseRecordByRecord;
+}
+
+/*
+ * The time until the first record of a 10 MB page can be used. JsonDataAccess needs the whole document, the records
+ * consumer hands the first record over as soon as its chunk is fed.
+ */
+void SFJsonStreamParserTest::firstRecordLatency() {
+	QFETCH(int, mode);
+	QByteArray json = sfTestQueryPageOfSize(10 * kSFMegabyte);
+	QElapsedTimer timer;
+	qint64 latency = -1;
+	if (mode == ParseWithJsonDataAccess) {
+		timer.start();
+		JsonDataAccess jda;
+		QVariant result = jda.loadFromBuffer(json);
+		latency = timer.nsecsElapsed();
+		QVERIFY(!result.toMap().value("records").toList().isEmpty());
+	} else {
+		SFTestRecordCounter consumer;
+		consumer.timer = &timer;
+		timer.start();
+		QVERIFY(consumeInChunks(consumer, json, kSFChunkSize));
+		latency = consumer.firstRecordNsecs;
+	}
+	QVERIFY(latency >= 0);
+	qDebug() << "first record after" << latency / 1000 << "us";
+	QTest::setBenchmarkResult(latency / 1000, QTest::Events);
+}
+
+void SFJsonStreamParserTest::peakMemory_data() {
+	firstRecordLatency_data();
+	QTest::newRow("SFJsonStreamParser, whole document") << (int) ParseWithBuilder;
+}
+
+/*
+ * The heap in use beyond the response bytes while a 10 MB page is parsed, in bytes. The record by record consumer is
+ * sampled at every record, for the parsers that build the whole document it is measured once the document is built,
+ * which is when they use the most.
+ */
+void SFJsonStreamParserTest::peakMemory() {
+	QFETCH(int, mode);
+	QByteArray json = sfTestQueryPageOfSize(10 * kSFMegabyte);
+	qint64 before = sfTestHeapInUse();
+	qint64 peak = 0;
+	QVERIFY(parse(json, mode, &peak) > 0);
+	peak -= before;
+	qDebug() << "peak" << peak / 1024 << "KB for a page of" << json.size() / 1024 << "KB";
+	QTest::setBenchmarkResult(peak, QTest::Events);
+}
+
+} /* namespace sf */
@@ -0,0 +1,49 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonStreamParserTest.h
+*/
+
+
+#ifndef SFJSONSTREAMPARSERTEST_H_
+#define SFJSONSTREAMPARSERTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * SFJsonStreamParser must build the same documents as JsonDataAccess whatever the chunk boundaries. The benchmarks
+ * compare both on query pages of 1 and 10 MB: parsing time, time to the first record, and peak memory.
+ */
+class SFJsonStreamParserTest : public QObject {
+	Q_OBJECT
+private slots:
+	void chunkBoundaries_data();
+	void chunkBoundaries();
+	void invalidDocuments_data();
+	void invalidDocuments();
+	void recordsConsumer();
+
+	void parseQueryPage_data();
+	void parseQueryPage();
+	void firstRecordLatency_data();
+	void firstRecordLatency();
+	void peakMemory_data();
+	void peakMemory();
+};
+
+} /* namespace sf */
+#endif /* SFJSONSTREAMPARSERTEST_H_ */
@@ -0,0 +1,117 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonViewTest.cpp
+*/
+
+#include "SFJsonViewTest.h"
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFJsonView.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFTestData.h"
+#include "SFTestServer.h"
+
+namespace sf {
+
+static const QByteArray kSFTestQueryPath = "/services/data/v28.0/query";
+static const QByteArray kSFTestDocument = "{\"totalSize\":3,\"done\":true,\"records\":["
+		"{\"attributes\":{\"type\":\"Account\"},\"Name\":\"Acme\",\"Owner\":{\"Name\":\"Jane\"},\"Tags\":[\"a\",\"b\"]},"
+		"{\"Name\":\"Glob\\u00e9x\",\"Owner\":null,\"Tags\":[]},"
+		"{\"Name\":\"Initech\",\"Owner\":{\"Name\":\"Bill\"},\"Amount\":12.5,\"Closed\":true}],"
+		"\"we\\\"ird\":1}";
+
+void SFJsonViewTest::initTestCase() {
+	mServer = new SFTestServer(this);
+	QVERIFY(mServer->start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(mServer->baseUrl()));
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+	SFRestAPI::instance()->setBatchWindow(0);
+}
+
+void SFJsonViewTest::path_data() {
+	QTest::addColumn<QString>("path");
+	QTest::addColumn<int>("type");
+	QTest::addColumn<QString>("text");
+
+	QTest::newRow("empty path") << "" << int(SFJsonValue::Object) << "";
+	QTest::newRow("number") << "totalSize" << int(SFJsonValue::Number) << "3";
+	QTest::newRow("boolean") << "done" << int(SFJsonValue::Bool) << "true";
+	QTest::newRow("array") << "records" << int(SFJsonValue::Array) << "";
+	QTest::newRow("element member") << "records[0].Name" << int(SFJsonValue::String) << "Acme";
+	QTest::newRow("nested object") << "records[0].Owner.Name" << int(SFJsonValue::String) << "Jane";
+	QTest::newRow("attributes") << "records[0].attributes.type" << int(SFJsonValue::String) << "Account";
+	QTest::newRow("nested array") << "records[0].Tags[1]" << int(SFJsonValue::String) << "b";
+	QTest::newRow("escaped string") << "records[1].Name" << int(SFJsonValue::String) << QString::fromUtf8("Glob\xc3\xa9x");
+	QTest::newRow("null") << "records[1].Owner" << int(SFJsonValue::Null) << "";
+	QTest::newRow("last element") << "records[2].Owner.Name" << int(SFJsonValue::String) << "Bill";
+	QTest::newRow("decimal") << "records[2].Amount" << int(SFJsonValue::Number) << "12.5";
+	QTest::newRow("escaped key") << "we\"ird" << int(SFJsonValue::Number) << "1";
+
+	QTest::newRow("member of null") << "records[1].Owner.Name" << int(SFJsonValue::Undefined) << "";
+	QTest::newRow("empty array") << "records[1].Tags[0]" << int(SFJsonValue::Undefined) << "";
+	QTest::newRow("index out of range") << "records[3].Name" << int(SFJsonValue::Undefined) << "";
+	QTest::newRow("negative index") << "records[-1]" << int(SFJsonValue::Undefined) << "";
+	QTest::newRow("index not a number") << "records[x].Name" << int(SFJsonValue::Undefined) << "";
+	QTest::newRow("unclosed bracket") << "records[0" << int(SFJsonValue::Undefined) << "";
+	QTest::newRow("key of an array") << "records.Name" << int(SFJsonValue::Undefined) << "";
+	QTest::newRow("index of an object") << "records[0].Owner[0]" << int(SFJsonValue::Undefined) << "";
+	QTest::newRow("missing key") << "records[0].Industry" << int(SFJsonValue::Undefined) << "";
+}
+
+void SFJsonViewTest::path() {
+	QFETCH(QString, path);
+	QFETCH(int, type);
+	QFETCH(QString, text);
+
+	QString error;
+	SFJsonView view = SFJsonView::fromJson(kSFTestDocument, &error);
+	QVERIFY2(view.isValid(), qPrintable(error));
+	SFJsonValue value = view.path(path);
+	QCOMPARE(int(value.type()), type);
+	QCOMPARE(value.toString(), text);
+}
+
+void SFJsonViewTest::restPayload() {
+	mServer->setResponse("GET", kSFTestQueryPath, 200, sfTestQueryPage(20));
+	SFRestAPI *api = SFRestAPI::instance();
+	SFRestRequest *request = api->requestForQuery("SELECT Id, Name, Owner.Name FROM Account");
+	request->setPayloadType(SFRestRequest::PayloadJsonView);
+	SFTestResultReceiver receiver;
+	api->sendRestRequest(request, &receiver, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&receiver, SIGNAL(resultReceived())));
+
+	QVERIFY(!receiver.hasError);
+	QCOMPARE(receiver.payload.userType(), qMetaTypeId<SFJsonView>());
+	SFJsonView view = receiver.payload.value<SFJsonView>();
+	QVERIFY(view.isValid());
+	QCOMPARE(view.path("totalSize").toLongLong(), 20LL);
+	QCOMPARE(view.path("records").size(), 20);
+	QCOMPARE(view.path("records[7].Owner.Name").toString(), QString("Owner 0"));
+	QCOMPARE(view.path("records[19].NumberOfEmployees").toLongLong(), 19LL);
+	QVERIFY(view.path("records[20]").isUndefined());
+
+	//the same values as the whole document decoded
+	QVariantMap records = view.toVariant().toMap();
+	QCOMPARE(view.path("records[3].Name").toString(), records.value("records").toList().at(3).toMap().value("Name").toString());
+}
+
+} /* namespace sf */
@@ -0,0 +1,45 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFJsonViewTest.h
+*/
+
+#ifndef SFJSONVIEWTEST_H_
+#define SFJSONVIEWTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * Lookups with SFJsonView::path(), on a document and on the payload of a REST request against a stand-in server.
+ */
+class SFJsonViewTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+
+	void path_data();
+	void path();
+	void restPayload();
+
+private:
+	SFTestServer *mServer;
+};
+
+} /* namespace sf */
+#endif /* SFJSONVIEWTEST_H_ */
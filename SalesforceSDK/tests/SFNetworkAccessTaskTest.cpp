@@ -0,0 +1,165 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFNetworkAccessTaskTest.cpp
+*/
+
+
+#include "SFNetworkAccessTaskTest.h"
+#include <QThread>
+#include <QtTest/QtTest>
+#include "SFGlobal.h"
+#include "SFNetworkAccessTask.h"
+#include "SFResponseConsumer.h"
+#include "SFTestServer.h"
+
+namespace sf {
+
+/* QThread::msleep() is protected in Qt 4 */
+class SFTestSleeper : public QThread {
+public:
+	using QThread::msleep;
+};
+
+/*
+ * Collects the streamed body. A non-zero delay makes the consumer fall behind the socket.
+ */
+class SFTestConsumer : public SFResponseConsumer {
+public:
+	explicit SFTestConsumer(unsigned long delayMsec = 0) : mDelay(delayMsec), mChunks(0), mFinished(false) {}
+	bool begin(int statusCode, const QByteArray & contentType) {
+		Q_UNUSED(contentType);
+		return statusCode == 200;
+	}
+	bool consume(const QByteArray & chunk) {
+		if (mDelay > 0) {
+			SFTestSleeper::msleep(mDelay);
+		}
+		mBody.append(chunk);
+		mChunks++;
+		return true;
+	}
+	bool finish() { mFinished = true; return true;}
+	QVariant result() const { return QVariant(mBody.size());}
+	QString errorString() const { return QString("consumer error");}
+
+	QByteArray mBody;
+	unsigned long mDelay;
+	int mChunks;
+	bool mFinished;
+
+};
+
+static QByteArray testBody(int size) {
+	QByteArray body;
+	body.reserve(size);
+	for (int i = 0; body.size() < size; i++) {
+		body.append(QByteArray::number(i)).append(',');
+	}
+	body.truncate(size);
+	return body;
+}
+
+void SFNetworkAccessTaskTest::initTestCase() {
+	mServer = new SFTestServer();
+	QVERIFY(mServer->start());
+}
+
+void SFNetworkAccessTaskTest::cleanupTestCase() {
+	delete mServer;
+	mServer = NULL;
+}
+
+void SFNetworkAccessTaskTest::init() {
+	mServer->clearRequests();
+}
+
+void SFNetworkAccessTaskTest::bufferedResponse() {
+	mServer->setResponse("GET", "/buffered", 200, "{\"ok\":true}");
+	SFTestResultReceiver receiver;
+	SFNetworkAccessTask *task = new SFNetworkAccessTask(getSharedNetworkAccessManager(), mServer->baseUrl() + "/buffered?q=1", HTTPMethod::HTTPGet);
+	task->startTaskAsync(&receiver, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&receiver, SIGNAL(resultReceived())));
+
+	QVERIFY(!receiver.hasError);
+	QCOMPARE(receiver.payload.toByteArray(), QByteArray("{\"ok\":true}"));
+	QVERIFY(receiver.tags.contains(kSFTaskEventLoopHopsTag));
+	QVERIFY(receiver.tags.contains(kSFTaskThreadSwitchesTag));
+	QCOMPARE(mServer->requests().size(), 1);
+	QCOMPARE(mServer->requests().first().path, QByteArray("/buffered?q=1"));
+}
+
+void SFNetworkAccessTaskTest::errorResponse() {
+	SFTestResultReceiver receiver;
+	SFNetworkAccessTask *task = new SFNetworkAccessTask(getSharedNetworkAccessManager(), mServer->baseUrl() + "/missing", HTTPMethod::HTTPGet);
+	task->startTaskAsync(&receiver, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&receiver, SIGNAL(resultReceived())));
+	QVERIFY(receiver.hasError);
+}
+
+void SFNetworkAccessTaskTest::streamedResponse() {
+	const QByteArray body = testBody(300 * 1024);
+	mServer->setResponse("GET", "/streamed", 200, body);
+	SFTestConsumer consumer;
+	SFTestResultReceiver receiver;
+	SFNetworkAccessTask *task = new SFNetworkAccessTask(getSharedNetworkAccessManager(), mServer->baseUrl() + "/streamed", HTTPMethod::HTTPGet);
+	task->setResponseConsumer(&consumer);
+	task->startTaskAsync(&receiver, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&receiver, SIGNAL(resultReceived())));
+
+	QVERIFY(!receiver.hasError);
+	QCOMPARE(receiver.payload.toInt(), body.size());
+	QVERIFY(consumer.mFinished);
+	QVERIFY(consumer.mBody == body);
+}
+
+void SFNetworkAccessTaskTest::streamedToSlowConsumer() {
+	//more than the high-water mark, so that the task has to stop reading while the consumer catches up
+	const QByteArray body = testBody(4 * 1024 * 1024);
+	mServer->setResponse("GET", "/slow", 200, body);
+	SFTestConsumer consumer(2);
+	SFTestResultReceiver receiver;
+	SFNetworkAccessTask *task = new SFNetworkAccessTask(getSharedNetworkAccessManager(), mServer->baseUrl() + "/slow", HTTPMethod::HTTPGet);
+	task->setResponseConsumer(&consumer);
+	task->startTaskAsync(&receiver, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&receiver, SIGNAL(resultReceived()), 120000));
+
+	QVERIFY(!receiver.hasError);
+	QVERIFY(consumer.mFinished);
+	QCOMPARE(consumer.mBody.size(), body.size());
+	QVERIFY(consumer.mBody == body);
+}
+
+void SFNetworkAccessTaskTest::roundTrip() {
+	mServer->setResponse("GET", "/roundtrip", 200, "{}");
+	SFTestResultReceiver receiver;
+	QVariantHash tags;
+	QBENCHMARK {
+		receiver.reset();
+		SFNetworkAccessTask *task = new SFNetworkAccessTask(getSharedNetworkAccessManager(), mServer->baseUrl() + "/roundtrip", HTTPMethod::HTTPGet);
+		task->startTaskAsync(&receiver, SLOT(onResult(sf::SFResult*)));
+		QVERIFY(sfTestWait(&receiver, SIGNAL(resultReceived())));
+		tags = receiver.tags;
+	}
+	QVERIFY(!receiver.hasError);
+	int hops = tags.value(kSFTaskEventLoopHopsTag).toInt();
+	int switches = tags.value(kSFTaskThreadSwitchesTag).toInt();
+	qDebug() << "event loop hops:" << hops << "thread switches:" << switches;
+	//a plain request goes to the network thread and back, and is parsed once
+	QVERIFY(switches <= 4);
+	QVERIFY(hops <= 8);
+}
+
+} /* namespace sf */
@@ -0,0 +1,51 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFNetworkAccessTaskTest.h
+*/
+
+
+#ifndef SFNETWORKACCESSTASKTEST_H_
+#define SFNETWORKACCESSTASKTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * Requests against a stand-in server, buffered or streamed to a consumer, and the event loop hops and thread switches of a round trip.
+ */
+class SFNetworkAccessTaskTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+
+	void bufferedResponse();
+	void errorResponse();
+	void streamedResponse();
+	void streamedToSlowConsumer();
+
+	void roundTrip();
+
+private:
+	SFTestServer *mServer;
+};
+
+} /* namespace sf */
+#endif /* SFNETWORKACCESSTASKTEST_H_ */
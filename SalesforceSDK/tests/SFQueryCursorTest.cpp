@@ -0,0 +1,218 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFQueryCursorTest.cpp
+*/
+
+#include "SFQueryCursorTest.h"
+#include <QDeclarativeComponent>
+#include <QDeclarativeEngine>
+#include <QSignalSpy>
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFGlobal.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFQueryCursor.h"
+#include "SFRestAPI.h"
+#include "SFTestData.h"
+#include "SFTestServer.h"
+
+namespace sf {
+
+static const QByteArray kSFTestQueryPath = "/services/data/v28.0/query?";
+static const QByteArray kSFTestNextPagePath = "/services/data/v28.0/query/01gD0000002HU6KIAW-";
+static const int kSFTestPageSize = 200;
+
+/* @return the path of the page starting at record @a offset */
+static QByteArray nextPagePath(int offset) {
+	return kSFTestNextPagePath + QByteArray::number(offset);
+}
+
+/* @return page @a index out of @a pageCount, pointing at the next one */
+static QByteArray queryPage(int index, int pageCount) {
+	QByteArray page = sfTestQueryPage(kSFTestPageSize);
+	page.replace("\"totalSize\":" + QByteArray::number(kSFTestPageSize), "\"totalSize\":" + QByteArray::number(kSFTestPageSize * pageCount));
+	if (index < pageCount - 1) {
+		page.replace("\"done\":true", "\"done\":false,\"nextRecordsUrl\":\"" + nextPagePath((index + 1) * kSFTestPageSize) + "\"");
+	}
+	return page;
+}
+
+/* answer the query with @a pageCount pages */
+static void setQueryPages(SFTestServer *server, int pageCount) {
+	server->setResponse("GET", kSFTestQueryPath, 200, queryPage(0, pageCount));
+	for (int i = 1; i < pageCount; i++) {
+		server->setResponse("GET", nextPagePath(i * kSFTestPageSize), 200, queryPage(i, pageCount));
+	}
+}
+
+/* the records of the pages delivered so far */
+static int recordCount(const QSignalSpy & pageSpy) {
+	int count = 0;
+	for (int i = 0; i < pageSpy.size(); i++) {
+		count += pageSpy.at(i).at(0).toList().size();
+	}
+	return count;
+}
+
+void SFQueryCursorTest::initTestCase() {
+	mServer = new SFTestServer(this);
+	QVERIFY(mServer->start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(mServer->baseUrl()));
+	SFRestAPI::instance()->setApiVersion("/v28.0");
+	SFRestAPI::instance()->setBatchWindow(0);
+}
+
+void SFQueryCursorTest::init() {
+	mServer->clearRequests();
+}
+
+void SFQueryCursorTest::pages() {
+	setQueryPages(mServer, 3);
+	SFQueryCursor cursor;
+	cursor.setQuery("SELECT Id, Name FROM Account");
+	cursor.setBatchSize(kSFTestPageSize);
+	QSignalSpy pageSpy(&cursor, SIGNAL(pageReady(QVariantList)));
+	QSignalSpy failedSpy(&cursor, SIGNAL(failed(int, QString)));
+	cursor.start();
+	QVERIFY(cursor.isActive());
+	QVERIFY(sfTestWait(&cursor, SIGNAL(finished())));
+
+	QCOMPARE(failedSpy.size(), 0);
+	QCOMPARE(pageSpy.size(), 3);
+	QCOMPARE(recordCount(pageSpy), 3 * kSFTestPageSize);
+	QCOMPARE(cursor.totalSize(), 3 * kSFTestPageSize);
+	QCOMPARE(cursor.deliveredRecords(), 3 * kSFTestPageSize);
+	QVERIFY(!cursor.isActive());
+
+	//one request per page, in order, each with the batch size
+	QList<SFTestServer::Request> requests = mServer->requests();
+	QCOMPARE(requests.size(), 3);
+	QVERIFY(requests.at(0).path.startsWith(kSFTestQueryPath));
+	QCOMPARE(requests.at(1).path, nextPagePath(kSFTestPageSize));
+	QCOMPARE(requests.at(2).path, nextPagePath(2 * kSFTestPageSize));
+	for (int i = 0; i < requests.size(); i++) {
+		QCOMPARE(requests.at(i).headers.value("sforce-query-options"), QByteArray("batchSize=200"));
+	}
+}
+
+void SFQueryCursorTest::fetchOnDemand() {
+	setQueryPages(mServer, 5);
+	SFQueryCursor cursor;
+	cursor.setQuery("SELECT Id, Name FROM Account");
+	cursor.setAutoFetch(false);
+	cursor.setMaxPagesHeld(2);
+	QSignalSpy pageSpy(&cursor, SIGNAL(pageReady(QVariantList)));
+	QSignalSpy finishedSpy(&cursor, SIGNAL(finished()));
+	cursor.start();
+
+	//the cursor fills up to the limit, then waits for the consumer
+	for (int i = 0; i < 50 && mServer->requests().size() < 2; i++) {
+		QTest::qWait(20);
+	}
+	QTest::qWait(200);
+	QCOMPARE(mServer->requests().size(), 2);
+	QCOMPARE(pageSpy.size(), 0);
+
+	//a page leaving the cursor makes room for the next one
+	cursor.fetchNext();
+	QCOMPARE(pageSpy.size(), 1);
+	QVERIFY(sfTestWait(mServer, SIGNAL(requestReceived())));
+	QCOMPARE(mServer->requests().size(), 3);
+
+	for (int i = 1; i < 5; i++) {
+		if (pageSpy.size() == i) {
+			cursor.fetchNext();
+		}
+		for (int j = 0; j < 250 && pageSpy.size() <= i; j++) {
+			QTest::qWait(20);
+		}
+		QCOMPARE(pageSpy.size(), i + 1);
+	}
+	QCOMPARE(finishedSpy.size(), 1);
+	QCOMPARE(cursor.deliveredRecords(), 5 * kSFTestPageSize);
+	QCOMPARE(mServer->requests().size(), 5);
+}
+
+void SFQueryCursorTest::cancelAbortsDownload() {
+	setQueryPages(mServer, 3);
+	//the second page never finishes downloading
+	SFTestServer::Response stalled;
+	stalled.body = queryPage(1, 3).left(100);
+	stalled.declaredLength = stalled.body.size() + 1000;
+	mServer->setResponse("GET", nextPagePath(kSFTestPageSize), stalled);
+
+	SFQueryCursor cursor;
+	cursor.setQuery("SELECT Id, Name FROM Account");
+	QSignalSpy pageSpy(&cursor, SIGNAL(pageReady(QVariantList)));
+	QSignalSpy cancelledSpy(&cursor, SIGNAL(cancelled()));
+	QSignalSpy closedSpy(mServer, SIGNAL(connectionClosed()));
+	cursor.start();
+	QVERIFY(sfTestWait(&cursor, SIGNAL(pageReady(QVariantList))));
+	for (int i = 0; i < 250 && mServer->requests().size() < 2; i++) {
+		QTest::qWait(20);
+	}
+	QCOMPARE(mServer->requests().size(), 2);
+
+	cursor.cancel();
+	QCOMPARE(cancelledSpy.size(), 1);
+	QVERIFY(!cursor.isActive());
+	//the reply is aborted, which closes its connection
+	QVERIFY(closedSpy.size() > 0 || sfTestWait(mServer, SIGNAL(connectionClosed())));
+	QTest::qWait(200);
+	QCOMPARE(pageSpy.size(), 1);
+	QCOMPARE(mServer->requests().size(), 2);
+}
+
+void SFQueryCursorTest::qmlCursor() {
+	setQueryPages(mServer, 2);
+	sfRegisterMetaTypes();
+	QDeclarativeEngine engine;
+	QDeclarativeComponent component(&engine);
+	component.setData("import sf 1.0\n"
+			"SFQueryCursor {\n"
+			"	property int received: 0\n"
+			"	property bool done: false\n"
+			"	query: \"SELECT Id, Name FROM Account\"\n"
+			"	batchSize: 250\n"
+			"	maxPagesHeld: 3\n"
+			"	onPageReady: received += records.length\n"
+			"	onFinished: done = true\n"
+			"}\n", QUrl());
+	QObject *object = component.create();
+	QVERIFY2(object, qPrintable(component.errorString()));
+	SFQueryCursor *cursor = qobject_cast<SFQueryCursor*>(object);
+	QVERIFY(cursor);
+	QCOMPARE(cursor->query(), QString("SELECT Id, Name FROM Account"));
+	QCOMPARE(cursor->batchSize(), 250);
+	QCOMPARE(cursor->maxPagesHeld(), 3);
+	QVERIFY(cursor->autoFetch());
+	QCOMPARE(object->property("active").toBool(), false);
+
+	//started the way QML does it, through the meta object
+	QVERIFY(QMetaObject::invokeMethod(object, "start"));
+	QVERIFY(sfTestWait(object, SIGNAL(finished())));
+	QCOMPARE(object->property("received").toInt(), 2 * kSFTestPageSize);
+	QCOMPARE(object->property("done").toBool(), true);
+	QCOMPARE(object->property("totalSize").toInt(), 2 * kSFTestPageSize);
+	QCOMPARE(object->property("deliveredRecords").toInt(), 2 * kSFTestPageSize);
+	delete object;
+}
+
+} /* namespace sf */
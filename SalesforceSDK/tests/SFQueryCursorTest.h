@@ -0,0 +1,48 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFQueryCursorTest.h
+*/
+
+#ifndef SFQUERYCURSORTEST_H_
+#define SFQUERYCURSORTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * The query cursor against a stand-in server: following "nextRecordsUrl", delivering pages on demand, aborting the page
+ * being downloaded on cancel() and driving the cursor from QML.
+ */
+class SFQueryCursorTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void init();
+
+	void pages();
+	void fetchOnDemand();
+	void cancelAbortsDownload();
+	void qmlCursor();
+
+private:
+	SFTestServer *mServer;
+};
+
+} /* namespace sf */
+#endif /* SFQUERYCURSORTEST_H_ */
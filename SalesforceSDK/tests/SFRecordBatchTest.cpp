@@ -0,0 +1,233 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordBatchTest.cpp
+*/
+
+
+#include "SFRecordBatchTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRecordBatch.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFTestData.h"
+#include "SFTestServer.h"
+
+using namespace bb::data;
+
+namespace sf {
+
+static const int kSFTestRecordCount = 10000;
+static const int kSFTestChunkSize = 16 * 1024;
+
+/* the heap in use after every record, to find the highest point */
+class SFTestBatchSampler : public SFRecordBatchConsumer {
+public:
+	SFTestBatchSampler() : peak(0) {}
+	qint64 peak;
+protected:
+	bool processRecord(int index, const QVariant & record) {
+		bool processed = SFRecordBatchConsumer::processRecord(index, record);
+		peak = qMax(peak, sfTestHeapInUse());
+		return processed;
+	}
+};
+
+/* feeds the response in chunks, the way SFNetworkAccessTask does */
+static bool consumeInChunks(SFRecordBatchConsumer & consumer, const QByteArray & json) {
+	if (!consumer.begin(200, "application/json;charset=UTF-8")) {
+		return false;
+	}
+	for (int i = 0; i < json.size(); i += kSFTestChunkSize) {
+		if (!consumer.consume(json.mid(i, kSFTestChunkSize))) {
+			return false;
+		}
+	}
+	return consumer.finish();
+}
+
+static QVariantMap describeField(const QString & name, const QString & type) {
+	QVariantMap field;
+	field.insert("name", name);
+	field.insert("type", type);
+	return field;
+}
+
+void SFRecordBatchTest::streamedMatchesDecoded() {
+	QByteArray json = sfTestQueryPage(1000);
+	JsonDataAccess jda;
+	QVariantMap content = jda.loadFromBuffer(json).toMap();
+	QVERIFY(!jda.hasError());
+	SFRecordBatch decoded = SFRecordBatch::fromQueryResult(content);
+
+	SFRecordBatchConsumer consumer;
+	QVERIFY(consumeInChunks(consumer, json));
+	SFRecordBatch streamed = consumer.result().value<SFRecordBatch>();
+	QCOMPARE(streamed.rowCount(), 1000);
+	QCOMPARE(streamed.columnNames(), decoded.columnNames());
+	for (int c = 0; c < streamed.columnCount(); c++) {
+		QCOMPARE((int) streamed.columnType(c), (int) decoded.columnType(c));
+	}
+	QCOMPARE(streamed.metadata(), decoded.metadata());
+	QCOMPARE(streamed.metadata().value("totalSize").toInt(), 1000);
+	QCOMPARE(streamed.toVariant(), decoded.toVariant());
+}
+
+void SFRecordBatchTest::columnTypes() {
+	QVariantList fields;
+	fields << describeField("CreatedDate", "datetime") << describeField("Description", "textarea");
+	QVariantMap describe;
+	describe.insert("fields", fields);
+	SFRecordBatchConsumer consumer(describe);
+	consumer.setStripAttributes(true);
+	QVERIFY(consumeInChunks(consumer, sfTestQueryPage(10)));
+	SFRecordBatch batch = consumer.batch();
+	QCOMPARE(batch.rowCount(), 10);
+	QCOMPARE(batch.columnIndex("attributes"), -1);
+	QCOMPARE(batch.columnType(batch.columnIndex("Id")), SFRecordBatch::ColumnId);
+	QCOMPARE(batch.columnType(batch.columnIndex("Name")), SFRecordBatch::ColumnString);
+	//the first values are integers, "0" and "1234.5" then "2469"
+	QCOMPARE(batch.columnType(batch.columnIndex("AnnualRevenue")), SFRecordBatch::ColumnDouble);
+	QCOMPARE(batch.doubleAt(1, batch.columnIndex("AnnualRevenue")), 1234.5);
+	QCOMPARE(batch.doubleAt(2, batch.columnIndex("AnnualRevenue")), 2469.0);
+	QCOMPARE(batch.columnType(batch.columnIndex("NumberOfEmployees")), SFRecordBatch::ColumnInteger);
+	QCOMPARE(batch.columnType(batch.columnIndex("IsDeleted")), SFRecordBatch::ColumnBool);
+	QCOMPARE(batch.columnType(batch.columnIndex("Description")), SFRecordBatch::ColumnString);
+	QVERIFY(batch.isNull(0, batch.columnIndex("Description")));
+	int created = batch.columnIndex("CreatedDate");
+	QCOMPARE(batch.columnType(created), SFRecordBatch::ColumnDateTime);
+	QCOMPARE(batch.dateTimeAt(3, created), QDateTime(QDate(2013, 10, 18), QTime(10, 0), Qt::UTC));
+	QCOMPARE(batch.stringAt(3, created), QString("2013-10-18T10:00:00.000+0000"));
+	QCOMPARE(batch.columnType(batch.columnIndex("Owner")), SFRecordBatch::ColumnVariant);
+	QVERIFY(!batch.row(6).value("Owner").toMap().contains("attributes"));
+}
+
+/* columns whose later values don't fit the type of the first ones */
+void SFRecordBatchTest::widenedColumns() {
+	QByteArray json = "{\"done\":true,\"records\":["
+			"{\"Mixed\":1,\"When\":\"2013-10-18\",\"Flag\":null},"
+			"{\"Mixed\":\"one\",\"When\":\"soon\",\"Late\":2.5},"
+			"{\"Mixed\":null,\"When\":null,\"Flag\":true}]}";
+	QVariantList fields;
+	fields << describeField("When", "date");
+	QVariantMap describe;
+	describe.insert("fields", fields);
+	SFRecordBatchConsumer consumer(describe);
+	QVERIFY(consumeInChunks(consumer, json));
+	SFRecordBatch batch = consumer.batch();
+	QCOMPARE(batch.rowCount(), 3);
+	QCOMPARE(batch.columnNames(), QStringList() << "Flag" << "Mixed" << "When" << "Late");
+
+	int mixed = batch.columnIndex("Mixed");
+	QCOMPARE(batch.columnType(mixed), SFRecordBatch::ColumnVariant);
+	QCOMPARE(batch.value(0, mixed).toLongLong(), Q_INT64_C(1));
+	QCOMPARE(batch.value(1, mixed).toString(), QString("one"));
+	QVERIFY(batch.isNull(2, mixed));
+	int when = batch.columnIndex("When");
+	QCOMPARE(batch.columnType(when), SFRecordBatch::ColumnString);
+	QCOMPARE(batch.stringAt(0, when), QString("2013-10-18"));
+	QCOMPARE(batch.stringAt(1, when), QString("soon"));
+	int flag = batch.columnIndex("Flag");
+	QCOMPARE(batch.columnType(flag), SFRecordBatch::ColumnBool);
+	QVERIFY(batch.isNull(0, flag));
+	QVERIFY(batch.isNull(1, flag));
+	QVERIFY(batch.boolAt(2, flag));
+	int late = batch.columnIndex("Late");
+	QCOMPARE(batch.columnType(late), SFRecordBatch::ColumnDouble);
+	QVERIFY(batch.isNull(0, late));
+	QCOMPARE(batch.doubleAt(1, late), 2.5);
+	QVERIFY(batch.isNull(2, late));
+
+	//the same types as from the decoded records
+	JsonDataAccess jda;
+	SFRecordBatch decoded = SFRecordBatch::fromQueryResult(jda.loadFromBuffer(json).toMap(), describe);
+	for (int c = 0; c < batch.columnCount(); c++) {
+		QCOMPARE((int) decoded.columnType(decoded.columnIndex(batch.columnNames().at(c))), (int) batch.columnType(c));
+	}
+}
+
+void SFRecordBatchTest::notAQueryResult() {
+	SFRecordBatchConsumer consumer;
+	QVERIFY(consumeInChunks(consumer, "[{\"id\":\"001000000000001\",\"success\":true}]"));
+	QCOMPARE(consumer.result().type(), QVariant::List);
+	QCOMPARE(consumer.result().toList().first().toMap().value("success").toBool(), true);
+	QVERIFY(!consumeInChunks(consumer, "{\"records\":[{\"Id\":"));
+	QVERIFY(!consumer.errorString().isEmpty());
+}
+
+/* a query whose payload is a batch, through SFRestAPI and a stand-in server */
+void SFRecordBatchTest::recordBatchPayload() {
+	SFTestServer server;
+	QVERIFY(server.start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(server.baseUrl()));
+	SFRestAPI *api = SFRestAPI::instance();
+	api->setApiVersion("/v28.0");
+	server.setResponse("GET", "/services/data/v28.0/query", 200, sfTestQueryPage(500));
+
+	SFRestRequest *request = api->requestForQuery(QString("SELECT Id, Name FROM Account"));
+	request->setPayloadType(SFRestRequest::PayloadRecordBatch);
+	request->setStripRecordAttributes(true);
+	SFTestResultReceiver receiver;
+	api->sendRestRequest(request, &receiver, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&receiver, SIGNAL(resultReceived())));
+	QVERIFY(!receiver.hasError);
+	QVERIFY(receiver.payload.canConvert<SFRecordBatch>());
+	SFRecordBatch batch = receiver.payload.value<SFRecordBatch>();
+	QCOMPARE(batch.rowCount(), 500);
+	QCOMPARE(batch.columnIndex("attributes"), -1);
+	QCOMPARE(batch.metadata().value("done").toBool(), true);
+	QCOMPARE(batch.row(499).value("NumberOfEmployees").toInt(), 499);
+}
+
+void SFRecordBatchTest::peakMemory_data() {
+	QTest::addColumn<bool>("streamed");
+	QTest::newRow("JsonDataAccess, then SFRecordBatch::fromQueryResult()") << false;
+	QTest::newRow("SFRecordBatchConsumer") << true;
+}
+
+/* the highest heap use while 10k records are turned into a batch, in bytes above what was in use before */
+void SFRecordBatchTest::peakMemory() {
+	QFETCH(bool, streamed);
+	QByteArray json = sfTestQueryPage(kSFTestRecordCount);
+	qint64 before = sfTestHeapInUse();
+	qint64 peak = 0;
+	int rowCount = 0;
+	if (streamed) {
+		SFTestBatchSampler consumer;
+		QVERIFY(consumeInChunks(consumer, json));
+		peak = qMax(consumer.peak, sfTestHeapInUse());
+		rowCount = consumer.batch().rowCount();
+	} else {
+		JsonDataAccess jda;
+		QVariantMap content = jda.loadFromBuffer(json).toMap();
+		SFRecordBatch batch = SFRecordBatch::fromQueryResult(content);
+		//the decoded response and the batch are both alive here
+		peak = sfTestHeapInUse();
+		rowCount = batch.rowCount();
+	}
+	QCOMPARE(rowCount, kSFTestRecordCount);
+	qint64 held = peak - before;
+	qDebug() << "peak" << held / 1024 << "KB above the response text";
+	QTest::setBenchmarkResult(held, QTest::Events);
+}
+
+} /* namespace sf */
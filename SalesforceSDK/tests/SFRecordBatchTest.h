@@ -0,0 +1,45 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordBatchTest.h
+*/
+
+
+#ifndef SFRECORDBATCHTEST_H_
+#define SFRECORDBATCHTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * Record batches built while the response is parsed, compared with the ones built from the decoded response, and the
+ * peak memory of both ways.
+ */
+class SFRecordBatchTest : public QObject {
+	Q_OBJECT
+private slots:
+	void streamedMatchesDecoded();
+	void columnTypes();
+	void widenedColumns();
+	void notAQueryResult();
+	void recordBatchPayload();
+
+	void peakMemory_data();
+	void peakMemory();
+};
+
+} /* namespace sf */
+#endif /* SFRECORDBATCHTEST_H_ */
@@ -0,0 +1,203 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordDecoderTest.cpp
+*/
+
+
+
+#include "SFRecordDecoderTest.h"
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRecordDecoder.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFTestData.h"
+#include "SFTestServer.h"
+
+/* the records of sfTestQueryPage() */
+struct SFTestAccount {
+	QString id;
+	QString name;
+	sf::SFNullable<double> revenue;
+	int employees;
+	bool deleted;
+	sf::SFNullable<QString> description;
+	QDateTime created;
+	QString ownerName;
+
+	static QString sObjectType() { return "Account"; }
+	static void bindFields(sf::SFRecordFields<SFTestAccount> & fields) {
+		fields.add("Id", SF_RECORD_MEMBER(&SFTestAccount::id))
+			.add("Name", SF_RECORD_MEMBER(&SFTestAccount::name))
+			.add("AnnualRevenue", SF_RECORD_MEMBER(&SFTestAccount::revenue))
+			.add("NumberOfEmployees", SF_RECORD_MEMBER(&SFTestAccount::employees))
+			.add("IsDeleted", SF_RECORD_MEMBER(&SFTestAccount::deleted))
+			.add("Description", SF_RECORD_MEMBER(&SFTestAccount::description))
+			.add("CreatedDate", SF_RECORD_MEMBER(&SFTestAccount::created))
+			.add("Owner.Name", SF_RECORD_MEMBER(&SFTestAccount::ownerName));
+	}
+};
+Q_DECLARE_METATYPE(SFTestAccount)
+
+/* another record type, bound to some of the same fields */
+struct SFTestAccountName {
+	QString id;
+	QString name;
+
+	static QString sObjectType() { return "Account"; }
+	static void bindFields(sf::SFRecordFields<SFTestAccountName> & fields) {
+		fields.add("Id", SF_RECORD_MEMBER(&SFTestAccountName::id))
+			.add("Name", SF_RECORD_MEMBER(&SFTestAccountName::name));
+	}
+};
+Q_DECLARE_METATYPE(SFTestAccountName)
+
+namespace sf {
+
+static const int kSFTestChunkSize = 1000;
+
+/* feeds the response in chunks, the way SFNetworkAccessTask does */
+template<class T>
+static bool decodeInChunks(SFRecordDecoder<T> & decoder, const QByteArray & json) {
+	if (!decoder.begin(200, "application/json;charset=UTF-8")) {
+		return false;
+	}
+	for (int i = 0; i < json.size(); i += kSFTestChunkSize) {
+		if (!decoder.consume(json.mid(i, kSFTestChunkSize))) {
+			return false;
+		}
+	}
+	return decoder.finish();
+}
+
+void SFRecordDecoderTest::decodeRecords() {
+	SFRecordDecoder<SFTestAccount> decoder;
+	QVERIFY(decodeInChunks(decoder, sfTestQueryPage(20)));
+	QVERIFY(decoder.errorString().isNull());
+	QCOMPARE(decoder.recordCount(), 20);
+	QVector<SFTestAccount> accounts = decoder.records();
+	QCOMPARE(accounts.size(), 20);
+	for (int i = 0; i < accounts.size(); i++) {
+		const SFTestAccount & account = accounts.at(i);
+		QCOMPARE(account.id, QString::number(i).rightJustified(15, '0').replace(0, 3, "001"));
+		QCOMPARE(account.name, QString::fromUtf8("Account \"%1\" \xc3\xa9t\xc3\xa9 \xe2\x82\xac").arg(i));
+		QVERIFY(!account.revenue.isNull());
+		QCOMPARE(account.revenue.value(), i * 1234.5);
+		QCOMPARE(account.employees, i);
+		QCOMPARE(account.deleted, i % 2 == 1);
+		QVERIFY(account.description.isNull());
+		QCOMPARE(account.created, QDateTime(QDate(2013, 10, 18), QTime(10, 0), Qt::UTC));
+		QCOMPARE(account.ownerName, QString("Owner %1").arg(i % 7));
+	}
+	QCOMPARE(decoder.metadata().value("totalSize").toInt(), 20);
+	QCOMPARE(decoder.metadata().value("done").toBool(), true);
+	QVERIFY(!decoder.metadata().contains("records"));
+}
+
+/* the first record binds the keys by position, the others don't follow it */
+void SFRecordDecoderTest::reorderedKeys() {
+	QByteArray json = "{\"records\":["
+			"{\"Id\":\"001A\",\"Name\":\"A\",\"Owner\":{\"Name\":\"Owner A\"},\"NumberOfEmployees\":1},"
+			"{\"Owner\":{\"Name\":\"Owner B\"},\"NumberOfEmployees\":2.6,\"Name\":\"B\",\"Id\":\"001B\"},"
+			"{\"Name\":\"C\",\"Owner\":null,\"Parent\":{\"Name\":\"Not bound\"},\"Id\":\"001C\"},"
+			"{\"Id\":\"001D\",\"Contacts\":{\"records\":[{\"Name\":\"Sub-query\"}]},\"Name\":\"D\",\"AnnualRevenue\":null}"
+			"],\"totalSize\":4,\"done\":true}";
+	SFRecordDecoder<SFTestAccount> decoder;
+	QVERIFY(decodeInChunks(decoder, json));
+	QVector<SFTestAccount> accounts = decoder.records();
+	QCOMPARE(accounts.size(), 4);
+	QCOMPARE(accounts.at(0).id, QString("001A"));
+	QCOMPARE(accounts.at(0).ownerName, QString("Owner A"));
+	QCOMPARE(accounts.at(0).employees, 1);
+	QCOMPARE(accounts.at(1).id, QString("001B"));
+	QCOMPARE(accounts.at(1).name, QString("B"));
+	QCOMPARE(accounts.at(1).ownerName, QString("Owner B"));
+	QCOMPARE(accounts.at(1).employees, 3);
+	QCOMPARE(accounts.at(2).id, QString("001C"));
+	QCOMPARE(accounts.at(2).name, QString("C"));
+	QVERIFY(accounts.at(2).ownerName.isNull());
+	QCOMPARE(accounts.at(3).id, QString("001D"));
+	QCOMPARE(accounts.at(3).name, QString("D"));
+	QVERIFY(accounts.at(3).revenue.isNull());
+	QCOMPARE(decoder.metadata().value("totalSize").toInt(), 4);
+}
+
+void SFRecordDecoderTest::recordsOfOtherType() {
+	SFRecordDecoder<SFTestAccountName> decoder;
+	QVERIFY(decodeInChunks(decoder, sfTestQueryPage(5)));
+	QVariant result = decoder.result();
+	QCOMPARE(result.userType(), qMetaTypeId<SFDecodedRecords>());
+	SFDecodedRecords records = result.value<SFDecodedRecords>();
+	QCOMPARE(records.count(), 5);
+	QCOMPARE(records.records<SFTestAccountName>().size(), 5);
+	QCOMPARE(records.records<SFTestAccountName>().at(4).name, decoder.records().at(4).name);
+	QVERIFY(records.records<SFTestAccount>().isEmpty());
+	QVERIFY(SFDecodedRecords().records<SFTestAccount>().isEmpty());
+}
+
+/* the payload as QVariantMap has the layout of the JSON of the records */
+void SFRecordDecoderTest::toVariant() {
+	SFRecordDecoder<SFTestAccount> decoder;
+	QVERIFY(decodeInChunks(decoder, sfTestQueryPage(3)));
+	QVariantMap content = decoder.result().value<SFDecodedRecords>().toVariant().toMap();
+	QCOMPARE(content.value("totalSize").toInt(), 3);
+	QVariantList records = content.value("records").toList();
+	QCOMPARE(records.size(), 3);
+	QVariantMap record = records.at(2).toMap();
+	QCOMPARE(record.value("Id").toString(), QString("001000000000002"));
+	QCOMPARE(record.value("AnnualRevenue").toDouble(), 2469.0);
+	QCOMPARE(record.value("IsDeleted").toBool(), false);
+	QVERIFY(record.contains("Description"));
+	QVERIFY(!record.value("Description").isValid());
+	QCOMPARE(record.value("CreatedDate").toString(), QString("2013-10-18T10:00:00.000+0000"));
+	QCOMPARE(record.value("Owner").toMap().value("Name").toString(), QString("Owner 2"));
+}
+
+void SFRecordDecoderTest::generatedQuery() {
+	QCOMPARE(sfRecordFieldNames<SFTestAccountName>(), QStringList() << "Id" << "Name");
+	QCOMPARE(SFRestAPI::instance()->generateSOQLQuery<SFTestAccount>("IsDeleted = false", QStringList() << "Name", 10),
+			QString("SELECT Id,Name,AnnualRevenue,NumberOfEmployees,IsDeleted,Description,CreatedDate,Owner.Name FROM Account "
+					"WHERE IsDeleted = false ORDER BY Name LIMIT 10"));
+}
+
+void SFRecordDecoderTest::typedQuery() {
+	SFTestServer server;
+	QVERIFY(server.start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(server.baseUrl()));
+	SFRestAPI *api = SFRestAPI::instance();
+	api->setApiVersion("/v28.0");
+	server.setResponse("GET", "/services/data/v28.0/query", 200, sfTestQueryPage(300));
+
+	SFRestRequest *request = api->requestForQuery<SFTestAccount>("", QStringList() << "Name");
+	SFTestResultReceiver receiver;
+	api->sendRestRequest(request, &receiver, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&receiver, SIGNAL(resultReceived())));
+	QVERIFY(!receiver.hasError);
+	QCOMPARE(server.requests("GET", "/services/data/v28.0/query").size(), 1);
+	QVERIFY(server.requests("GET", "/services/data/v28.0/query").first().path.contains("Owner.Name"));
+	QCOMPARE(receiver.payload.userType(), qMetaTypeId<SFDecodedRecords>());
+	QVector<SFTestAccount> accounts = receiver.payload.value<SFDecodedRecords>().records<SFTestAccount>();
+	QCOMPARE(accounts.size(), 300);
+	QCOMPARE(accounts.at(299).employees, 299);
+	QCOMPARE(accounts.at(299).ownerName, QString("Owner %1").arg(299 % 7));
+}
+
+} /* namespace sf */
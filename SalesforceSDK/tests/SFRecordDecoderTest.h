@@ -0,0 +1,44 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRecordDecoderTest.h
+*/
+
+
+
+#ifndef SFRECORDDECODERTEST_H_
+#define SFRECORDDECODERTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * Typed records decoded from the parser events: the conversions of the members, parent record fields, keys that change
+ * order between records, the type check of the payload and the SELECT list generated from the fields.
+ */
+class SFRecordDecoderTest : public QObject {
+	Q_OBJECT
+private slots:
+	void decodeRecords();
+	void reorderedKeys();
+	void recordsOfOtherType();
+	void toVariant();
+	void generatedQuery();
+	void typedQuery();
+};
+
+} /* namespace sf */
+#endif /* SFRECORDDECODERTEST_H_ */
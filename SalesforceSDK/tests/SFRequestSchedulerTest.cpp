@@ -0,0 +1,211 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRequestSchedulerTest.cpp
+*/
+
+
+
+#include "SFRequestSchedulerTest.h"
+#include <QNetworkAccessManager>
+#include <QtTest/QtTest>
+#include "SFNetworkAccessTask.h"
+#include "SFRequestScheduler.h"
+
+namespace sf {
+
+/* a task that only records when the scheduler starts it, and finishes when told to */
+class SFTestScheduledTask : public SFNetworkAccessTask {
+public:
+	SFTestScheduledTask(QNetworkAccessManager *manager, SFRequestPriorityType priority, const QString & name, QStringList *started)
+			: SFNetworkAccessTask(manager, QUrl("http://scheduler.test/" + name)), mName(name), mStarted(started) {
+		this->setPriority(priority);
+	}
+	void startTaskAsync(QObject *resultReceiver = NULL, const char *resultReceiverSlot = NULL) {
+		Q_UNUSED(resultReceiver);
+		Q_UNUSED(resultReceiverSlot);
+		mStarted->append(mName);
+	}
+	void complete() {
+		emit taskFinished(this);
+	}
+private:
+	QString mName;
+	QStringList *mStarted;
+};
+
+/* the tasks of a test, deleted with it so that the scheduler releases their slots even if the test fails */
+class SFTestSchedulerTasks : public QObject {
+public:
+	explicit SFTestSchedulerTasks(const QString & host) : mHost(host) {}
+	~SFTestSchedulerTasks() {
+		//before the network access manager goes
+		QObjectList tasks = this->children();
+		qDeleteAll(tasks);
+	}
+	QStringList started;
+
+	SFTestScheduledTask * submit(SFRequestPriorityType priority, const QString & name) {
+		SFTestScheduledTask *task = new SFTestScheduledTask(&mManager, priority, name, &started);
+		task->setParent(this);
+		mTasks.insert(name, task);
+		SFRequestScheduler::instance()->submit(task, mHost);
+		return task;
+	}
+	SFTestScheduledTask * task(const QString & name) const { return mTasks.value(name); }
+	void complete(const QString & name) { mTasks.value(name)->complete(); }
+
+private:
+	QString mHost;
+	QNetworkAccessManager mManager;
+	QHash<QString, SFTestScheduledTask*> mTasks;
+};
+
+static QStringList names(const QString & prefix, int count) {
+	QStringList names;
+	for (int i = 0; i < count; i++) {
+		names << prefix + QString::number(i);
+	}
+	return names;
+}
+
+void SFRequestSchedulerTest::init() {
+	SFRequestScheduler::instance()->setMaxRequestsPerHost(6);
+	SFRequestScheduler::instance()->setReservedInteractiveSlots(2);
+}
+
+void SFRequestSchedulerTest::cleanup() {
+	this->init();
+}
+
+void SFRequestSchedulerTest::perHostLimit() {
+	SFRequestScheduler *scheduler = SFRequestScheduler::instance();
+	QCOMPARE(scheduler->maxRequestsPerHost(), 6);
+	SFTestSchedulerTasks tasks("limit.test");
+	for (int i = 0; i < 8; i++) {
+		tasks.submit(SFRequestPriority::Interactive, "i" + QString::number(i));
+	}
+	QCOMPARE(tasks.started, names("i", 6));
+	QVERIFY(scheduler->isRunning(tasks.task("i5")));
+	QVERIFY(!scheduler->isRunning(tasks.task("i6")));
+
+	//another host has its own slots
+	SFTestSchedulerTasks otherHost("other.limit.test");
+	otherHost.submit(SFRequestPriority::Interactive, "o0");
+	QCOMPARE(otherHost.started, QStringList() << "o0");
+
+	tasks.complete("i2");
+	QVERIFY(!scheduler->isRunning(tasks.task("i2")));
+	QCOMPARE(tasks.started, names("i", 7));
+	tasks.complete("i0");
+	tasks.complete("i1");
+	QCOMPARE(tasks.started, names("i", 8));
+}
+
+void SFRequestSchedulerTest::interactiveSlots() {
+	SFRequestScheduler *scheduler = SFRequestScheduler::instance();
+	QCOMPARE(scheduler->reservedInteractiveSlots(), 2);
+	SFTestSchedulerTasks tasks("reserved.test");
+	for (int i = 0; i < 6; i++) {
+		tasks.submit(SFRequestPriority::Prefetch, "p" + QString::number(i));
+	}
+	//bulk traffic leaves the last two slots free
+	QCOMPARE(tasks.started, names("p", 4));
+
+	tasks.submit(SFRequestPriority::Interactive, "i0");
+	tasks.submit(SFRequestPriority::Interactive, "i1");
+	QCOMPARE(tasks.started, names("p", 4) << "i0" << "i1");
+	tasks.submit(SFRequestPriority::Interactive, "i2");
+	QCOMPARE(tasks.started.size(), 6);
+
+	//a free slot goes to the waiting interactive task, not to the prefetch tasks queued before it
+	tasks.complete("p0");
+	QCOMPARE(tasks.started.last(), QString("i2"));
+	//bulk tasks still wait while four slots are in use
+	tasks.complete("i0");
+	tasks.complete("i1");
+	QCOMPARE(tasks.started.size(), 7);
+	tasks.complete("i2");
+	QCOMPARE(tasks.started.last(), QString("p4"));
+}
+
+void SFRequestSchedulerTest::priorityOrder() {
+	SFRequestScheduler *scheduler = SFRequestScheduler::instance();
+	scheduler->setMaxRequestsPerHost(1);
+	scheduler->setReservedInteractiveSlots(0);
+	SFTestSchedulerTasks tasks("order.test");
+	tasks.submit(SFRequestPriority::Interactive, "blocker");
+	QStringList bulk;
+	bulk << "b0" << "b1";
+	for (int i = 0; i < bulk.size(); i++) {
+		tasks.submit(SFRequestPriority::BackgroundSync, bulk.at(i));
+	}
+	for (int i = 0; i < 4; i++) {
+		tasks.submit(SFRequestPriority::Prefetch, "p" + QString::number(i));
+	}
+	tasks.submit(SFRequestPriority::Interactive, "i0");
+	QCOMPARE(tasks.started, QStringList() << "blocker");
+
+	//one task at a time, in the order the scheduler picks them
+	QString running = "blocker";
+	for (int i = 0; i < 7; i++) {
+		tasks.complete(running);
+		QCOMPARE(tasks.started.size(), i + 2);
+		running = tasks.started.last();
+	}
+	QStringList order = tasks.started.mid(1);
+	QCOMPARE(order.first(), QString("i0"));
+
+	//two prefetch tasks for every background one, each class in submission order
+	QStringList prefetch = order.filter("p");
+	QStringList background = order.filter("b");
+	QCOMPARE(prefetch, names("p", 4));
+	QCOMPARE(background, names("b", 2));
+	QCOMPARE(order.mid(1, 3).filter("b").size(), 1);
+	QCOMPARE(order.mid(4, 3).filter("b").size(), 1);
+	tasks.complete(running);
+}
+
+void SFRequestSchedulerTest::authCriticalStartsImmediately() {
+	SFRequestScheduler *scheduler = SFRequestScheduler::instance();
+	SFTestSchedulerTasks tasks("auth.test");
+	for (int i = 0; i < 7; i++) {
+		tasks.submit(SFRequestPriority::Interactive, "i" + QString::number(i));
+	}
+	QCOMPARE(tasks.started.size(), 6);
+	SFTestScheduledTask *refresh = tasks.submit(SFRequestPriority::AuthCritical, "refresh");
+	QCOMPARE(tasks.started.last(), QString("refresh"));
+	QVERIFY(scheduler->isRunning(refresh));
+
+	//its slot counts while it runs, then goes to the queued task
+	tasks.complete("i0");
+	QCOMPARE(tasks.started.size(), 7);
+	tasks.complete("refresh");
+	QCOMPARE(tasks.started.last(), QString("i6"));
+}
+
+void SFRequestSchedulerTest::destroyedWhileQueued() {
+	SFRequestScheduler *scheduler = SFRequestScheduler::instance();
+	scheduler->setMaxRequestsPerHost(1);
+	SFTestSchedulerTasks tasks("destroyed.test");
+	tasks.submit(SFRequestPriority::Interactive, "running");
+	SFTestScheduledTask *queued = tasks.submit(SFRequestPriority::Interactive, "queued");
+	tasks.submit(SFRequestPriority::Interactive, "next");
+	delete queued;
+	tasks.complete("running");
+	QCOMPARE(tasks.started, QStringList() << "running" << "next");
+}
+
+} /* namespace sf */
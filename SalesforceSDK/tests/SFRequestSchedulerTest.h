@@ -0,0 +1,46 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRequestSchedulerTest.h
+*/
+
+
+
+#ifndef SFREQUESTSCHEDULERTEST_H_
+#define SFREQUESTSCHEDULERTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * The order in which the scheduler starts tasks, the per host limit, the slots reserved for interactive tasks and
+ * authentication tasks that ignore every limit. Each test uses its own host, so a failed one doesn't hold slots of the next.
+ */
+class SFRequestSchedulerTest : public QObject {
+	Q_OBJECT
+private slots:
+	void init();
+	void cleanup();
+
+	void perHostLimit();
+	void interactiveSlots();
+	void priorityOrder();
+	void authCriticalStartsImmediately();
+	void destroyedWhileQueued();
+};
+
+} /* namespace sf */
+#endif /* SFREQUESTSCHEDULERTEST_H_ */
@@ -0,0 +1,162 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRequestTemplateTest.cpp
+*/
+
+#include "SFRequestTemplateTest.h"
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRequestTemplate.h"
+#include "SFRestAPI.h"
+#include "SFTestServer.h"
+#include "SFTokenVault.h"
+
+namespace sf {
+
+static const QString kSFTestEndPoint = "/services/data";
+static const QString kSFTestApiVersion = "/v28.0";
+static const QString kSFTestUserAgent = "SalesforceSDKTests";
+static const QByteArray kSFTestQueryPath = "/services/data/v28.0/query";
+static const QByteArray kSFTestQueryResult = "{\"totalSize\":0,\"done\":true,\"records\":[]}";
+
+static SFOAuthCredentials * credentials() {
+	return SFAccountManager::instance()->getCoordinator()->getCredentials();
+}
+
+static SFRequestTemplate prepared() {
+	return SFRequestTemplate::prepared(kSFTestEndPoint, kSFTestApiVersion, kSFTestUserAgent);
+}
+
+/* send a query and wait for its result. @return whether it succeeded */
+static bool sendQuery() {
+	SFTestResultReceiver receiver;
+	SFRestAPI *api = SFRestAPI::instance();
+	api->sendRestRequest(api->requestForQuery("SELECT Id FROM Account"), &receiver, SLOT(onResult(sf::SFResult*)));
+	return (receiver.received || sfTestWait(&receiver, SIGNAL(resultReceived()))) && !receiver.hasError;
+}
+
+/* @return the "Authorization" header of the last request @a server got */
+static QByteArray lastAuthorization(SFTestServer *server) {
+	return server->requests().isEmpty() ? QByteArray() : server->requests().last().headers.value("authorization");
+}
+
+void SFRequestTemplateTest::initTestCase() {
+	mServer = new SFTestServer(this);
+	mOtherServer = new SFTestServer(this);
+	QVERIFY(mServer->start());
+	QVERIFY(mOtherServer->start());
+	mServer->setResponse("GET", kSFTestQueryPath, 200, kSFTestQueryResult);
+	mOtherServer->setResponse("GET", kSFTestQueryPath, 200, kSFTestQueryResult);
+	SFRestAPI::instance()->setApiVersion(kSFTestApiVersion);
+	SFRestAPI::instance()->setBatchWindow(0);
+}
+
+void SFRequestTemplateTest::cleanupTestCase() {
+	SFRequestTemplate::clearCache();
+}
+
+void SFRequestTemplateTest::init() {
+	QVERIFY(credentials());
+	credentials()->setAccessToken("00Dtest!token");
+	credentials()->setInstanceUrl(QUrl(mServer->baseUrl()));
+	mServer->clearRequests();
+	mOtherServer->clearRequests();
+}
+
+void SFRequestTemplateTest::reused() {
+	SFRequestTemplate first = prepared();
+	QVERIFY(first.isValid());
+	QCOMPARE(first.baseUrl(), mServer->baseUrl() + "/services/data/v28.0");
+	QNetworkRequest request = first.createRequest("/sobjects/Account/describe");
+	QCOMPARE(request.url(), mServer->url("/services/data/v28.0/sobjects/Account/describe"));
+	QCOMPARE(request.rawHeader("Authorization"), QByteArray("Bearer 00Dtest!token"));
+	QCOMPARE(request.rawHeader("User-Agent"), kSFTestUserAgent.toUtf8());
+
+	//nothing changed, the same template serves every request
+	SFRequestTemplate second = prepared();
+	QVERIFY(second.isValid());
+	QCOMPARE(second.baseUrl(), first.baseUrl());
+	QCOMPARE(second.createRequest("/limits").rawHeader("Authorization"), request.rawHeader("Authorization"));
+
+	QVERIFY(sendQuery());
+	QVERIFY(sendQuery());
+	QCOMPARE(mServer->requests("GET", kSFTestQueryPath).size(), 2);
+	QCOMPARE(lastAuthorization(mServer), QByteArray("Bearer 00Dtest!token"));
+}
+
+void SFRequestTemplateTest::vaultGeneration() {
+	QVERIFY(sendQuery());
+	QCOMPARE(lastAuthorization(mServer), QByteArray("Bearer 00Dtest!token"));
+
+	//a refreshed token is stored in the vault, which bumps its generation
+	int generation = SFTokenVault::instance()->generation();
+	credentials()->setAccessToken("00Dtest!refreshed");
+	QVERIFY(SFTokenVault::instance()->generation() != generation);
+	QCOMPARE(prepared().createRequest("/limits").rawHeader("Authorization"), QByteArray("Bearer 00Dtest!refreshed"));
+	QVERIFY(sendQuery());
+	QCOMPARE(lastAuthorization(mServer), QByteArray("Bearer 00Dtest!refreshed"));
+
+	//the vault reloaded from disk still holds the same token
+	SFTokenVault::instance()->invalidate();
+	QVERIFY(sendQuery());
+	QCOMPARE(lastAuthorization(mServer), QByteArray("Bearer 00Dtest!refreshed"));
+}
+
+void SFRequestTemplateTest::instanceUrl() {
+	QVERIFY(sendQuery());
+	QCOMPARE(mServer->requests().size(), 1);
+
+	//set on its own, without touching the tokens
+	int generation = SFTokenVault::instance()->generation();
+	credentials()->setInstanceUrl(QUrl(mOtherServer->baseUrl()));
+	QCOMPARE(SFTokenVault::instance()->generation(), generation);
+	QCOMPARE(prepared().baseUrl(), mOtherServer->baseUrl() + "/services/data/v28.0");
+	QVERIFY(sendQuery());
+	QCOMPARE(mServer->requests().size(), 1);
+	QCOMPARE(mOtherServer->requests("GET", kSFTestQueryPath).size(), 1);
+	QCOMPARE(lastAuthorization(mOtherServer), QByteArray("Bearer 00Dtest!token"));
+}
+
+void SFRequestTemplateTest::newCredentials() {
+	QVERIFY(sendQuery());
+	QCOMPARE(mServer->requests().size(), 1);
+
+	//a new session builds new credentials, the tokens stay in the vault
+	SFAccountManager::instance()->clearAccountState(false);
+	SFOAuthCredentials *session = credentials();
+	QVERIFY(session);
+	QCOMPARE(session->getAccessToken(), QString("00Dtest!token"));
+	session->setInstanceUrl(QUrl(mOtherServer->baseUrl()));
+	QVERIFY(sendQuery());
+	QCOMPARE(mServer->requests().size(), 1);
+	QCOMPARE(mOtherServer->requests("GET", kSFTestQueryPath).size(), 1);
+}
+
+void SFRequestTemplateTest::revokedToken() {
+	QVERIFY(prepared().isValid());
+	credentials()->revokeAccessToken();
+	SFRequestTemplate revoked = prepared();
+	QVERIFY(!revoked.isValid());
+	QCOMPARE(revoked.errorCode(), SFResultCode::SFErrorInvalidAccessToken);
+
+	//a failed template isn't cached, the next token is picked up
+	credentials()->setAccessToken("00Dtest!login");
+	QCOMPARE(prepared().createRequest("/limits").rawHeader("Authorization"), QByteArray("Bearer 00Dtest!login"));
+}
+
+} /* namespace sf */
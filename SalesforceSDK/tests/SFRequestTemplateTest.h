@@ -0,0 +1,51 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRequestTemplateTest.h
+*/
+
+#ifndef SFREQUESTTEMPLATETEST_H_
+#define SFREQUESTTEMPLATETEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * Prepared request templates must follow the session: a new token in the vault, a new instance URL or new credentials
+ * prepare them again, which the requests sent to the stand-in servers show.
+ */
+class SFRequestTemplateTest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+
+	void reused();
+	void vaultGeneration();
+	void instanceUrl();
+	void newCredentials();
+	void revokedToken();
+
+private:
+	SFTestServer *mServer;
+	SFTestServer *mOtherServer;
+};
+
+} /* namespace sf */
+#endif /* SFREQUESTTEMPLATETEST_H_ */
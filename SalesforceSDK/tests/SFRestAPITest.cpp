@@ -0,0 +1,239 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRestAPITest.cpp
+*/
+
+
+#include "SFRestAPITest.h"
+#include <bb/data/JsonDataAccess>
+#include <QtTest/QtTest>
+#include "SFAccountManager.h"
+#include "SFOAuthCoordinator.h"
+#include "SFOAuthCredentials.h"
+#include "SFRestAPI.h"
+#include "SFRestRequest.h"
+#include "SFTestServer.h"
+
+using namespace bb::data;
+
+namespace sf {
+
+static const QString kSFTestApiVersion = "/v28.0";
+static const QByteArray kSFTestBatchPath = "/services/data/v28.0/composite/batch";
+static const QByteArray kSFTestQueryPath = "/services/data/v28.0/query";
+static const QByteArray kSFTestAccountPath = "/services/data/v28.0/sobjects/Account/001000000000304";
+
+static QByteArray queryResult(const QString & name) {
+	return QString("{\"totalSize\":1,\"done\":true,\"records\":[{\"attributes\":{\"type\":\"Account\"},\"Name\":\"%1\"}]}").arg(name).toUtf8();
+}
+
+static QString firstRecordName(const QVariant & payload) {
+	QVariantList records = payload.toMap().value("records").toList();
+	return records.isEmpty() ? QString() : records.first().toMap().value("Name").toString();
+}
+
+/* both results are delivered in the same pass of the event loop, so the first may be there before the second is waited for */
+static bool waitForResults(SFTestResultReceiver & first, SFTestResultReceiver & second) {
+	if (!first.received && !sfTestWait(&first, SIGNAL(resultReceived()))) {
+		return false;
+	}
+	return second.received || sfTestWait(&second, SIGNAL(resultReceived()));
+}
+
+void SFRestAPITest::initTestCase() {
+	mServer = new SFTestServer();
+	QVERIFY(mServer->start());
+	SFOAuthCredentials *credentials = SFAccountManager::instance()->getCoordinator()->getCredentials();
+	QVERIFY(credentials);
+	credentials->setAccessToken("00Dtest!token");
+	credentials->setInstanceUrl(QUrl(mServer->baseUrl()));
+	SFRestAPI::instance()->setApiVersion(kSFTestApiVersion);
+	mBatchWindow = SFRestAPI::instance()->batchWindow();
+	SFRestAPI::instance()->setBatchWindow(50);
+}
+
+void SFRestAPITest::cleanupTestCase() {
+	SFRestAPI::instance()->setBatchWindow(mBatchWindow);
+	delete mServer;
+	mServer = NULL;
+}
+
+void SFRestAPITest::init() {
+	mServer->clearRequests();
+}
+
+void SFRestAPITest::batchedRequests() {
+	SFTestServer::Response batch;
+	batch.body = "{\"hasErrors\":true,\"results\":["
+			"{\"statusCode\":200,\"result\":" + queryResult("Batched") + "},"
+			"{\"statusCode\":400,\"result\":[{\"errorCode\":\"MALFORMED_QUERY\",\"message\":\"unexpected token\"}]}]}";
+	mServer->setResponse("POST", kSFTestBatchPath, batch);
+
+	SFTestResultReceiver first;
+	SFTestResultReceiver second;
+	SFRestAPI *api = SFRestAPI::instance();
+	api->sendRestRequest(api->requestForQuery(QString("SELECT Name FROM Account")), &first, SLOT(onResult(sf::SFResult*)));
+	api->sendRestRequest(api->requestForQuery(QString("SELECT FROM")), &second, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(waitForResults(first, second));
+
+	//one round trip, with both requests in it
+	QCOMPARE(mServer->requests().size(), 1);
+	QCOMPARE(mServer->requests("POST", kSFTestBatchPath).size(), 1);
+	JsonDataAccess jda;
+	QVariantList subrequests = jda.loadFromBuffer(mServer->requests().first().body).toMap().value("batchRequests").toList();
+	QCOMPARE(subrequests.size(), 2);
+	QCOMPARE(subrequests.at(0).toMap().value("method").toString(), QString("GET"));
+	QVERIFY(subrequests.at(0).toMap().value("url").toString().startsWith("v28.0/query?q="));
+
+	//each request gets the result it would have got on its own
+	QVERIFY(!first.hasError);
+	QCOMPARE(firstRecordName(first.payload), QString("Batched"));
+	QVERIFY(second.hasError);
+}
+
+void SFRestAPITest::fallbackWhenBatchFails() {
+	//e.g. an API version without composite resources
+	SFTestServer::Response notFound;
+	notFound.status = 404;
+	notFound.body = "[{\"errorCode\":\"NOT_FOUND\",\"message\":\"The requested resource does not exist\"}]";
+	mServer->setResponse("POST", kSFTestBatchPath, notFound);
+	mServer->setResponse("GET", kSFTestQueryPath, 200, queryResult("Separate"));
+
+	SFTestResultReceiver first;
+	SFTestResultReceiver second;
+	SFRestAPI *api = SFRestAPI::instance();
+	api->sendRestRequest(api->requestForQuery(QString("SELECT Name FROM Account")), &first, SLOT(onResult(sf::SFResult*)));
+	api->sendRestRequest(api->requestForQuery(QString("SELECT Name FROM Contact")), &second, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(waitForResults(first, second));
+
+	QCOMPARE(mServer->requests("POST", kSFTestBatchPath).size(), 1);
+	QCOMPARE(mServer->requests("GET", kSFTestQueryPath).size(), 2);
+	QVERIFY(!first.hasError);
+	QVERIFY(!second.hasError);
+	QCOMPARE(firstRecordName(first.payload), QString("Separate"));
+	QCOMPARE(firstRecordName(second.payload), QString("Separate"));
+}
+
+/* record and metadata reads are batched like queries */
+void SFRestAPITest::batchedReads() {
+	SFTestServer::Response batch;
+	batch.body = "{\"hasErrors\":false,\"results\":["
+			"{\"statusCode\":200,\"result\":{\"attributes\":{\"type\":\"Account\"},\"Name\":\"Acme\",\"Industry\":\"Energy\"}},"
+			"{\"statusCode\":200,\"result\":{\"objectDescribe\":{\"name\":\"Account\",\"queryable\":true},\"recentItems\":[]}}]}";
+	mServer->setResponse("POST", kSFTestBatchPath, batch);
+
+	SFTestResultReceiver record;
+	SFTestResultReceiver metadata;
+	SFRestAPI *api = SFRestAPI::instance();
+	api->sendRestRequest(api->requestForRetrieveObject("Account", "001000000000018", QStringList() << "Name" << "Industry"),
+			&record, SLOT(onResult(sf::SFResult*)));
+	api->sendRestRequest(api->requestForMetadata("Account"), &metadata, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(waitForResults(record, metadata));
+
+	QCOMPARE(mServer->requests().size(), 1);
+	JsonDataAccess jda;
+	QVariantList subrequests = jda.loadFromBuffer(mServer->requests("POST", kSFTestBatchPath).first().body).toMap().value("batchRequests").toList();
+	QCOMPARE(subrequests.size(), 2);
+	QCOMPARE(subrequests.at(0).toMap().value("method").toString(), QString("GET"));
+	QVERIFY(subrequests.at(0).toMap().value("url").toString().startsWith("v28.0/sobjects/Account/001000000000018?fields=Name"));
+	QCOMPARE(subrequests.at(1).toMap().value("method").toString(), QString("GET"));
+	QCOMPARE(subrequests.at(1).toMap().value("url").toString(), QString("v28.0/sobjects/Account"));
+
+	QVERIFY(!record.hasError);
+	QCOMPARE(record.payload.toMap().value("Industry").toString(), QString("Energy"));
+	QVERIFY(!metadata.hasError);
+	QCOMPARE(metadata.payload.toMap().value("objectDescribe").toMap().value("name").toString(), QString("Account"));
+}
+
+void SFRestAPITest::conditionalRequestNotBatched() {
+	mServer->setResponse("GET", kSFTestQueryPath, 200, queryResult("Separate"));
+
+	SFTestResultReceiver first;
+	SFTestResultReceiver second;
+	SFRestAPI *api = SFRestAPI::instance();
+	SFRestRequest *conditional = api->requestForQuery(QString("SELECT Name FROM Account"));
+	conditional->setConditional(true);
+	api->sendRestRequest(conditional, &first, SLOT(onResult(sf::SFResult*)));
+	api->sendRestRequest(api->requestForQuery(QString("SELECT Name FROM Contact")), &second, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(waitForResults(first, second));
+
+	//the conditional request went out at once, which left a single request in the window, sent on its own as well
+	QCOMPARE(mServer->requests("POST", kSFTestBatchPath).size(), 0);
+	QCOMPARE(mServer->requests("GET", kSFTestQueryPath).size(), 2);
+	QVERIFY(!first.hasError);
+	QVERIFY(!second.hasError);
+}
+
+/* the factories create requests that can be batched, revalidation is asked for */
+void SFRestAPITest::conditionalIsOptIn() {
+	SFRestAPI *api = SFRestAPI::instance();
+	QList<SFRestRequest*> requests;
+	requests << api->requestForDescribeGlobal() << api->requestForMetadata("Account") << api->requestForDescribeObject("Account")
+			<< api->requestForRetrieveObject("Account", "001000000000304", QStringList() << "Name");
+	for (int i = 0; i < requests.size(); i++) {
+		QVERIFY(!requests.at(i)->isConditional());
+		QVERIFY(requests.at(i)->canBeBatched());
+	}
+	qDeleteAll(requests);
+	requests.clear();
+	requests << api->requestForDescribeGlobal(true) << api->requestForMetadata("Account", true) << api->requestForDescribeObject("Account", true)
+			<< api->requestForRetrieveObject("Account", "001000000000304", QStringList() << "Name", true);
+	for (int i = 0; i < requests.size(); i++) {
+		QVERIFY(requests.at(i)->isConditional());
+		QVERIFY(!requests.at(i)->canBeBatched());
+	}
+	qDeleteAll(requests);
+}
+
+void SFRestAPITest::notModifiedIsSuccess() {
+	SFTestServer::Response record;
+	record.body = "{\"attributes\":{\"type\":\"Account\"},\"Id\":\"001000000000304\",\"Name\":\"Acme\"}";
+	record.headers.append(qMakePair(QByteArray("ETag"), QByteArray("\"v1\"")));
+	mServer->queueResponse("GET", kSFTestAccountPath, record);
+	SFTestServer::Response notModified;
+	notModified.status = 304;
+	notModified.headers.append(qMakePair(QByteArray("ETag"), QByteArray("\"v1\"")));
+	mServer->setResponse("GET", kSFTestAccountPath, notModified);
+
+	SFRestAPI *api = SFRestAPI::instance();
+	SFTestResultReceiver first;
+	api->sendRestRequest(api->requestForRetrieveObject("Account", "001000000000304", QStringList(), true), &first, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&first, SIGNAL(resultReceived())));
+	QVERIFY(!first.hasError);
+	QCOMPARE(first.payload.toMap().value("Name").toString(), QString("Acme"));
+
+	//revalidated with the ETag of the first response, the 304 is a success that carries the same payload
+	SFTestResultReceiver second;
+	api->sendRestRequest(api->requestForRetrieveObject("Account", "001000000000304", QStringList(), true), &second, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&second, SIGNAL(resultReceived())));
+	QList<SFTestServer::Request> gets = mServer->requests("GET", kSFTestAccountPath);
+	QCOMPARE(gets.size(), 2);
+	QVERIFY(!gets.at(0).headers.contains("if-none-match"));
+	QCOMPARE(gets.at(1).headers.value("if-none-match"), QByteArray("\"v1\""));
+	QVERIFY(!second.hasError);
+	QCOMPARE(second.code, 304);
+	QCOMPARE(second.payload, first.payload);
+
+	//a request that didn't ask for revalidation is sent without validators
+	SFTestResultReceiver third;
+	api->sendRestRequest(api->requestForRetrieveObject("Account", "001000000000304", QStringList()), &third, SLOT(onResult(sf::SFResult*)));
+	QVERIFY(sfTestWait(&third, SIGNAL(resultReceived())));
+	gets = mServer->requests("GET", kSFTestAccountPath);
+	QCOMPARE(gets.size(), 3);
+	QVERIFY(!gets.at(2).headers.contains("if-none-match"));
+}
+
+} /* namespace sf */
@@ -0,0 +1,52 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFRestAPITest.h
+*/
+
+
+#ifndef SFRESTAPITEST_H_
+#define SFRESTAPITEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+class SFTestServer;
+
+/*
+ * Batching and revalidation of SFRestAPI against a stand-in server, whose instance URL replaces the one of the current credentials.
+ */
+class SFRestAPITest : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+
+	void batchedRequests();
+	void fallbackWhenBatchFails();
+	void batchedReads();
+	void conditionalRequestNotBatched();
+	void conditionalIsOptIn();
+	void notModifiedIsSuccess();
+
+private:
+	SFTestServer *mServer;
+	int mBatchWindow;
+};
+
+} /* namespace sf */
+#endif /* SFRESTAPITEST_H_ */
@@ -0,0 +1,108 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFSecurityManagerTest.cpp
+*/
+
+
+#include "SFSecurityManagerTest.h"
+#include <QElapsedTimer>
+#include <QtTest/QtTest>
+#include "SFSecurityManager.h"
+
+namespace sf {
+
+static const qint64 kSFThroughputBytes = 4 * 1024 * 1024; //encrypted by every throughput measurement
+
+static QStringList testStrings(int count, int length) {
+	QStringList strings;
+	for (int i = 0; i < count; i++) {
+		strings.append(QString("record %1 ").arg(i).leftJustified(length, QChar('x')));
+	}
+	return strings;
+}
+
+void SFSecurityManagerTest::roundTrip() {
+	SFSecurityManager *manager = SFSecurityManager::instance();
+	QStringList strings = testStrings(3, 40);
+	strings << "" << QString::fromUtf8("\xe2\x82\xac\xf0\x9f\x98\x80");
+	for (int i = 0; i < strings.size(); i++) {
+		QString cipherText = manager->encrypt(strings.at(i));
+		QVERIFY(!cipherText.isNull());
+		QVERIFY(cipherText != strings.at(i));
+		QCOMPARE(manager->decrypt(cipherText), strings.at(i));
+	}
+	QVERIFY(manager->decrypt("not hex").isNull());
+}
+
+void SFSecurityManagerTest::batchRoundTrip() {
+	SFSecurityManager *manager = SFSecurityManager::instance();
+	//below and above the size from which batches are spread over threads
+	int counts[] = {5, 1000};
+	for (uint i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		QStringList strings = testStrings(counts[i], 64);
+		QStringList cipherTexts = manager->encryptMany(strings);
+		QCOMPARE(cipherTexts.size(), strings.size());
+		QCOMPARE(cipherTexts.at(1), manager->encrypt(strings.at(1)));
+		QCOMPARE(manager->decryptMany(cipherTexts), strings);
+	}
+}
+
+void SFSecurityManagerTest::encryptThroughput_data() {
+	QTest::addColumn<int>("length");
+	QTest::newRow("64 B strings") << 64;
+	QTest::newRow("4 KB strings") << 4096;
+}
+
+/* one string at a time, reported in bytes of clear text per second */
+void SFSecurityManagerTest::encryptThroughput() {
+	QFETCH(int, length);
+	SFSecurityManager *manager = SFSecurityManager::instance();
+	QString clearText = testStrings(1, length).first();
+	int count = kSFThroughputBytes / length;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < count; i++) {
+		manager->encrypt(clearText);
+	}
+	qint64 elapsed = qMax(qint64(1), timer.elapsed());
+	QTest::setBenchmarkResult(count * (qreal) length * 1000 / elapsed, QTest::BytesPerSecond);
+}
+
+void SFSecurityManagerTest::batchThroughput_data() {
+	QTest::addColumn<int>("length");
+	QTest::addColumn<bool>("decrypt");
+	QTest::newRow("encryptMany, 64 B strings") << 64 << false;
+	QTest::newRow("encryptMany, 4 KB strings") << 4096 << false;
+	QTest::newRow("decryptMany, 64 B strings") << 64 << true;
+	QTest::newRow("decryptMany, 4 KB strings") << 4096 << true;
+}
+
+/* whole batches spread over the threads, reported in bytes of clear text per second */
+void SFSecurityManagerTest::batchThroughput() {
+	QFETCH(int, length);
+	QFETCH(bool, decrypt);
+	SFSecurityManager *manager = SFSecurityManager::instance();
+	QStringList clearTexts = testStrings(kSFThroughputBytes / length, length);
+	QStringList cipherTexts = manager->encryptMany(clearTexts);
+	QElapsedTimer timer;
+	timer.start();
+	QStringList results = decrypt ? manager->decryptMany(cipherTexts) : manager->encryptMany(clearTexts);
+	qint64 elapsed = qMax(qint64(1), timer.elapsed());
+	QCOMPARE(results.size(), clearTexts.size());
+	QTest::setBenchmarkResult(clearTexts.size() * (qreal) length * 1000 / elapsed, QTest::BytesPerSecond);
+}
+
+} /* namespace sf */
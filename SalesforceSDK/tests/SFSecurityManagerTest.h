@@ -0,0 +1,42 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFSecurityManagerTest.h
+*/
+
+
+#ifndef SFSECURITYMANAGERTEST_H_
+#define SFSECURITYMANAGERTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * Round trips of SFSecurityManager, one string at a time and in batches, and their throughput in bytes per second.
+ */
+class SFSecurityManagerTest : public QObject {
+	Q_OBJECT
+private slots:
+	void roundTrip();
+	void batchRoundTrip();
+	void encryptThroughput_data();
+	void encryptThroughput();
+	void batchThroughput_data();
+	void batchThroughput();
+};
+
+} /* namespace sf */
+#endif /* SFSECURITYMANAGERTEST_H_ */
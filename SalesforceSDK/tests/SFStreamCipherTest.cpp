@@ -0,0 +1,151 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFStreamCipherTest.cpp
+*/
+
+
+#include "SFStreamCipherTest.h"
+#include <QBuffer>
+#include <QtTest/QtTest>
+#include "SFStreamCipher.h"
+
+namespace sf {
+
+static const int kSFTestChunkSize = 64;
+static const int kSFTestHeaderLength = 28; //magic, version, reserved bytes, chunk size and nonce
+static const int kSFTestRecordLength = 16 + kSFTestChunkSize + 32; //IV, cipher text and MAC of a full chunk
+
+static QByteArray clearTextOfSize(int size) {
+	QByteArray data(size, 0);
+	for (int i = 0; i < size; i++) {
+		data[i] = (char) (i * 31 + 7);
+	}
+	return data;
+}
+
+static QByteArray encrypted(const QByteArray & clearText, int chunkSize = kSFTestChunkSize) {
+	QByteArray source(clearText);
+	QBuffer in(&source);
+	in.open(QIODevice::ReadOnly);
+	QByteArray stream;
+	QBuffer out(&stream);
+	out.open(QIODevice::WriteOnly);
+	if (!SFStreamEncryptor::encrypt(&in, &out, chunkSize)) {
+		return QByteArray();
+	}
+	return stream;
+}
+
+static bool decrypted(const QByteArray & stream, QByteArray * pOutClearText) {
+	QByteArray source(stream);
+	QBuffer in(&source);
+	in.open(QIODevice::ReadOnly);
+	QByteArray clearText;
+	QBuffer out(&clearText);
+	out.open(QIODevice::WriteOnly);
+	if (!SFStreamDecryptor::decrypt(&in, &out)) {
+		return false;
+	}
+	*pOutClearText = clearText;
+	return true;
+}
+
+void SFStreamCipherTest::roundTrip_data() {
+	QTest::addColumn<int>("size");
+	int sizes[] = {0, 1, 15, 16, 17, kSFTestChunkSize - 1, kSFTestChunkSize, kSFTestChunkSize + 1, 3 * kSFTestChunkSize, 3 * kSFTestChunkSize + 5};
+	for (uint i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		QTest::newRow(qPrintable(QString("%1 bytes").arg(sizes[i]))) << sizes[i];
+	}
+}
+
+void SFStreamCipherTest::roundTrip() {
+	QFETCH(int, size);
+	QByteArray clearText = clearTextOfSize(size);
+	QByteArray stream = encrypted(clearText);
+	QVERIFY(stream.size() > kSFTestHeaderLength);
+	QVERIFY(!stream.contains(clearText) || size < 4);
+
+	QByteArray result;
+	QVERIFY(decrypted(stream, &result));
+	QCOMPARE(result, clearText);
+
+	//written in pieces of any size, the stream reads back the same
+	QByteArray pieces;
+	QBuffer out(&pieces);
+	out.open(QIODevice::WriteOnly);
+	SFStreamEncryptor encryptor;
+	QVERIFY(encryptor.begin(&out, kSFTestChunkSize));
+	for (int i = 0; i < size; i += 7) {
+		QVERIFY(encryptor.write(clearText.mid(i, 7)));
+	}
+	QVERIFY(encryptor.finish());
+	QCOMPARE(pieces.size(), stream.size());
+	QVERIFY(decrypted(pieces, &result));
+	QCOMPARE(result, clearText);
+}
+
+void SFStreamCipherTest::randomAccess() {
+	QByteArray clearText = clearTextOfSize(5 * kSFTestChunkSize + 9);
+	QByteArray stream = encrypted(clearText);
+	QBuffer in(&stream);
+	in.open(QIODevice::ReadOnly);
+	SFStreamDecryptor decryptor;
+	QVERIFY(decryptor.open(&in));
+	QCOMPARE(decryptor.chunkSize(), kSFTestChunkSize);
+	QCOMPARE(decryptor.chunkCount(), qint64(6));
+	int order[] = {3, 0, 5, 1, 4, 2};
+	for (uint i = 0; i < sizeof(order) / sizeof(order[0]); i++) {
+		QByteArray chunk;
+		QVERIFY(decryptor.readChunk(order[i], chunk));
+		QCOMPARE(chunk, clearText.mid(order[i] * kSFTestChunkSize, kSFTestChunkSize));
+	}
+	QByteArray chunk;
+	QVERIFY(!decryptor.readChunk(6, chunk));
+}
+
+void SFStreamCipherTest::tamperedBytes() {
+	QByteArray stream = encrypted(clearTextOfSize(2 * kSFTestChunkSize + 20));
+	//every byte of the header and of the records is covered, flipping any bit of it must be detected
+	for (int i = 0; i < stream.size(); i++) {
+		QByteArray tampered(stream);
+		tampered[i] = tampered.at(i) ^ 0x01;
+		QByteArray result;
+		QVERIFY2(!decrypted(tampered, &result), qPrintable(QString("byte %1").arg(i)));
+	}
+}
+
+void SFStreamCipherTest::reorderedAndTruncated() {
+	QByteArray clearText = clearTextOfSize(3 * kSFTestChunkSize);
+	QByteArray stream = encrypted(clearText);
+	QByteArray header = stream.left(kSFTestHeaderLength);
+	QByteArray first = stream.mid(kSFTestHeaderLength, kSFTestRecordLength);
+	QByteArray second = stream.mid(kSFTestHeaderLength + kSFTestRecordLength, kSFTestRecordLength);
+	QByteArray rest = stream.mid(kSFTestHeaderLength + 2 * kSFTestRecordLength);
+	QByteArray result;
+	QVERIFY(decrypted(header + first + second + rest, &result));
+	QCOMPARE(result, clearText);
+
+	QVERIFY(!decrypted(header + second + first + rest, &result));
+	//the last record is a padded one, without it the stream ends on a full chunk not flagged as final
+	QVERIFY(!decrypted(stream.left(stream.size() - rest.size()), &result));
+	QVERIFY(!decrypted(stream.left(stream.size() - 1), &result));
+	QVERIFY(!decrypted(header, &result));
+	//a record of another stream, encrypted with other keys
+	QByteArray other = encrypted(clearText);
+	QVERIFY(!decrypted(header + other.mid(kSFTestHeaderLength, kSFTestRecordLength) + second + rest, &result));
+}
+
+} /* namespace sf */
@@ -0,0 +1,41 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFStreamCipherTest.h
+*/
+
+
+#ifndef SFSTREAMCIPHERTEST_H_
+#define SFSTREAMCIPHERTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * Streams written by SFStreamEncryptor must read back as they were, and any change to them must be detected.
+ */
+class SFStreamCipherTest : public QObject {
+	Q_OBJECT
+private slots:
+	void roundTrip_data();
+	void roundTrip();
+	void randomAccess();
+	void tamperedBytes();
+	void reorderedAndTruncated();
+};
+
+} /* namespace sf */
+#endif /* SFSTREAMCIPHERTEST_H_ */
@@ -0,0 +1,187 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFStringPoolTest.cpp
+*/
+
+
+#include "SFStringPoolTest.h"
+#include <bb/data/JsonDataAccess>
+#include <QtTest/QtTest>
+#include "SFJsonIndexParser.h"
+#include "SFJsonStreamParser.h"
+#include "SFStringPool.h"
+#include "SFTestData.h"
+
+using namespace bb::data;
+
+namespace sf {
+
+static const int kSFRecordCount = 10000;
+
+enum {
+	DecodeWithJsonDataAccess,
+	DecodeWithIndexParser,
+	DecodeWithIndexParserStripped,
+	DecodeWithRecordsConsumer,
+	DecodeWithRecordsConsumerStripped
+};
+
+/* feeds the response in chunks, the way SFNetworkAccessTask does */
+static bool consumeInChunks(SFJsonRecordsConsumer & consumer, const QByteArray & json, int chunkSize) {
+	if (!consumer.begin(200, "application/json;charset=UTF-8")) {
+		return false;
+	}
+	for (int i = 0; i < json.size(); i += chunkSize) {
+		if (!consumer.consume(json.mid(i, chunkSize))) {
+			return false;
+		}
+	}
+	return consumer.finish();
+}
+
+static void verifyNoAttributes(const QVariantList & records) {
+	for (int i = 0; i < records.size(); i++) {
+		QVariantMap record = records.at(i).toMap();
+		QVERIFY(!record.contains("attributes"));
+		QVERIFY(!record.value("Owner").toMap().contains("attributes"));
+		QCOMPARE(record.value("Owner").toMap().value("Name").toString(), QString("Owner %1").arg(i % 7));
+		QCOMPARE(record.value("NumberOfEmployees").toInt(), i % 5000);
+	}
+}
+
+void SFStringPoolTest::intern() {
+	SFStringPool pool;
+	QByteArray name("Name");
+	QString first = pool.intern(name);
+	QString second = pool.intern(QByteArray("Name"));
+	QCOMPARE(first, QString("Name"));
+	QVERIFY(first.constData() == second.constData());
+	QString other = pool.intern("NumberOfEmployees", 17);
+	QVERIFY(other.constData() != first.constData());
+	QCOMPARE(pool.size(), 2);
+	QCOMPARE(pool.intern(QByteArray("\xc3\xa9t\xc3\xa9")), QString::fromUtf8("\xc3\xa9t\xc3\xa9"));
+	pool.clear();
+	QCOMPARE(pool.size(), 0);
+}
+
+void SFStringPoolTest::limits() {
+	//long strings are not worth a lookup, and a pool never grows past its maximum size
+	SFStringPool pool(2);
+	QByteArray longKey(200, 'k');
+	QCOMPARE(pool.intern(longKey), QString(longKey));
+	QCOMPARE(pool.size(), 0);
+	pool.intern(QByteArray("a"));
+	pool.intern(QByteArray("b"));
+	QString c1 = pool.intern(QByteArray("c"));
+	QString c2 = pool.intern(QByteArray("c"));
+	QCOMPARE(c1, QString("c"));
+	QCOMPARE(pool.size(), 2);
+	QVERIFY(c1.constData() != c2.constData());
+}
+
+void SFStringPoolTest::sharedKeysStreamParser() {
+	SFJsonRecordsConsumer consumer;
+	QVERIFY(consumeInChunks(consumer, sfTestQueryPage(3), 7));
+	QVariantList records = consumer.result().toMap().value("records").toList();
+	QCOMPARE(records.size(), 3);
+	QString first = records.at(0).toMap().constBegin().key();
+	QString last = records.at(2).toMap().constBegin().key();
+	QCOMPARE(first, last);
+	//interned, so both records hold the same string data
+	QVERIFY(first.constData() == last.constData());
+}
+
+void SFStringPoolTest::sharedKeysIndexParser_data() {
+	QTest::addColumn<int>("recordCount");
+	QTest::newRow("sequential") << 10;
+	QTest::newRow("parallel") << 5000;
+}
+
+void SFStringPoolTest::sharedKeysIndexParser() {
+	QFETCH(int, recordCount);
+	SFJsonIndexParser parser(sfTestQueryPage(recordCount));
+	QVERIFY(parser.parse());
+	QVariantList records = parser.result().toMap().value("records").toList();
+	QCOMPARE(records.size(), recordCount);
+	QVariantMap first = records.first().toMap();
+	QVariantMap last = records.last().toMap();
+	//also across the ranges materialized in different threads, and for the keys of nested records
+	QVERIFY(first.constBegin().key().constData() == last.constBegin().key().constData());
+	QString firstOwnerKey = first.value("Owner").toMap().constBegin().key();
+	QString lastOwnerKey = last.value("Owner").toMap().constBegin().key();
+	QCOMPARE(firstOwnerKey, lastOwnerKey);
+	QVERIFY(firstOwnerKey.constData() == lastOwnerKey.constData());
+}
+
+void SFStringPoolTest::stripAttributesStreamParser() {
+	SFJsonRecordsConsumer consumer;
+	consumer.setStripAttributes(true);
+	QVERIFY(consumeInChunks(consumer, sfTestQueryPage(5), 11));
+	QVariantList records = consumer.result().toMap().value("records").toList();
+	QCOMPARE(records.size(), 5);
+	verifyNoAttributes(records);
+}
+
+void SFStringPoolTest::stripAttributesIndexParser() {
+	SFJsonIndexParser parser(sfTestQueryPage(1000));
+	parser.setStripRecordAttributes(true);
+	QVERIFY(parser.parse());
+	QVariantMap content = parser.result().toMap();
+	QCOMPARE(content.value("totalSize").toInt(), 1000);
+	QVariantList records = content.value("records").toList();
+	QCOMPARE(records.size(), 1000);
+	verifyNoAttributes(records);
+}
+
+void SFStringPoolTest::recordsMemory_data() {
+	QTest::addColumn<int>("mode");
+	QTest::newRow("JsonDataAccess") << (int) DecodeWithJsonDataAccess;
+	QTest::newRow("SFJsonIndexParser, interned keys") << (int) DecodeWithIndexParser;
+	QTest::newRow("SFJsonIndexParser, interned keys, no attributes") << (int) DecodeWithIndexParserStripped;
+	QTest::newRow("SFJsonRecordsConsumer, interned keys") << (int) DecodeWithRecordsConsumer;
+	QTest::newRow("SFJsonRecordsConsumer, interned keys, no attributes") << (int) DecodeWithRecordsConsumerStripped;
+}
+
+/*
+ * The heap held by the decoded 10k records, in bytes. JsonDataAccess allocates every key of every record, the SDK
+ * parsers share them, and can drop the "attributes" object of every record.
+ */
+void SFStringPoolTest::recordsMemory() {
+	QFETCH(int, mode);
+	QByteArray json = sfTestQueryPage(kSFRecordCount);
+	qint64 before = sfTestHeapInUse();
+	QVariant result;
+	if (mode == DecodeWithJsonDataAccess) {
+		JsonDataAccess jda;
+		result = jda.loadFromBuffer(json);
+	} else if (mode == DecodeWithIndexParser || mode == DecodeWithIndexParserStripped) {
+		SFJsonIndexParser parser(json);
+		parser.setStripRecordAttributes(mode == DecodeWithIndexParserStripped);
+		QVERIFY(parser.parse());
+		result = parser.result();
+	} else {
+		SFJsonRecordsConsumer consumer;
+		consumer.setStripAttributes(mode == DecodeWithRecordsConsumerStripped);
+		QVERIFY(consumeInChunks(consumer, json, 16 * 1024));
+		result = consumer.result();
+	}
+	qint64 held = sfTestHeapInUse() - before;
+	QCOMPARE(result.toMap().value("records").toList().size(), kSFRecordCount);
+	qDebug() << "10k records hold" << held / 1024 << "KB," << held / kSFRecordCount << "bytes per record";
+	QTest::setBenchmarkResult(held, QTest::Events);
+}
+
+} /* namespace sf */
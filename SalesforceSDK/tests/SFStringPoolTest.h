@@ -0,0 +1,47 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFStringPoolTest.h
+*/
+
+
+#ifndef SFSTRINGPOOLTEST_H_
+#define SFSTRINGPOOLTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * Interned record keys and stripped record attributes, in both SDK parsers. The benchmark measures the heap held by
+ * 10k decoded records with JsonDataAccess, with interned keys, and with interned keys and no attributes.
+ */
+class SFStringPoolTest : public QObject {
+	Q_OBJECT
+private slots:
+	void intern();
+	void limits();
+	void sharedKeysStreamParser();
+	void sharedKeysIndexParser_data();
+	void sharedKeysIndexParser();
+	void stripAttributesStreamParser();
+	void stripAttributesIndexParser();
+
+	void recordsMemory_data();
+	void recordsMemory();
+};
+
+} /* namespace sf */
+#endif /* SFSTRINGPOOLTEST_H_ */
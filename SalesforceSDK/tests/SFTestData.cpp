@@ -0,0 +1,70 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFTestData.cpp
+*/
+
+
+#include "SFTestData.h"
+#include <malloc.h>
+
+namespace sf {
+
+static const int kSFTestRecordSize = 520; //about the size of a record of sfTestQueryPage()
+
+static QByteArray testRecord(int index) {
+	QByteArray id = QByteArray::number(index).rightJustified(15, '0');
+	id.replace(0, 3, "001");
+	QByteArray ownerId = QByteArray::number(index % 7).rightJustified(15, '0');
+	ownerId.replace(0, 3, "005");
+	QByteArray record;
+	record.reserve(kSFTestRecordSize);
+	record.append("{\"attributes\":{\"type\":\"Account\",\"url\":\"/services/data/v29.0/sobjects/Account/").append(id).append("\"},");
+	record.append("\"Id\":\"").append(id).append("\",");
+	record.append("\"Name\":\"Account \\\"").append(QByteArray::number(index)).append("\\\" \\u00e9t\\u00e9 \xe2\x82\xac\",");
+	record.append("\"AnnualRevenue\":").append(QByteArray::number(index * 1234.5, 'g', 17)).append(',');
+	record.append("\"NumberOfEmployees\":").append(QByteArray::number(index % 5000)).append(',');
+	record.append("\"IsDeleted\":").append(index % 2 ? "true" : "false").append(',');
+	record.append("\"Description\":null,");
+	record.append("\"CreatedDate\":\"2013-10-18T10:00:00.000+0000\",");
+	record.append("\"Owner\":{\"attributes\":{\"type\":\"User\",\"url\":\"/services/data/v29.0/sobjects/User/").append(ownerId).append("\"},");
+	record.append("\"Name\":\"Owner ").append(QByteArray::number(index % 7)).append("\"}}");
+	return record;
+}
+
+QByteArray sfTestQueryPage(int recordCount) {
+	QByteArray page;
+	page.reserve(recordCount * kSFTestRecordSize + 128);
+	page.append("{\"totalSize\":").append(QByteArray::number(recordCount)).append(",\"done\":true,\"records\":[");
+	for (int i = 0; i < recordCount; i++) {
+		if (i > 0) {
+			page.append(',');
+		}
+		page.append(testRecord(i));
+	}
+	page.append("]}");
+	return page;
+}
+
+QByteArray sfTestQueryPageOfSize(int bytes) {
+	return sfTestQueryPage(qMax(1, bytes / testRecord(0).size()));
+}
+
+qint64 sfTestHeapInUse() {
+	struct mallinfo info = mallinfo();
+	return info.uordblks;
+}
+
+} /* namespace sf */
@@ -0,0 +1,41 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFTestData.h
+*/
+
+
+#ifndef SFTESTDATA_H_
+#define SFTESTDATA_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QVariant>
+
+namespace sf {
+
+/*
+ * Documents and measurements shared by the tests.
+ */
+
+/* @return a query response with the given number of Account records, shaped like the ones of the REST API */
+QByteArray sfTestQueryPage(int recordCount);
+/* @return a query response of about the given size in bytes */
+QByteArray sfTestQueryPageOfSize(int bytes);
+/* @return the number of bytes currently allocated on the heap */
+qint64 sfTestHeapInUse();
+
+} /* namespace sf */
+#endif /* SFTESTDATA_H_ */
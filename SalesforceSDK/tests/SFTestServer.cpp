@@ -0,0 +1,292 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFTestServer.cpp
+*/
+
+
+#include "SFTestServer.h"
+#include <QEventLoop>
+#include <QNetworkReply>
+#include <QTcpSocket>
+#include <QTimer>
+#include "SFResult.h"
+
+namespace sf {
+
+static const QByteArray kSFHeaderEnd("\r\n\r\n");
+
+static QByteArray reasonPhrase(int status) {
+	switch (status) {
+	case 200: return "OK";
+	case 201: return "Created";
+	case 204: return "No Content";
+	case 304: return "Not Modified";
+	case 400: return "Bad Request";
+	case 401: return "Unauthorized";
+	case 404: return "Not Found";
+	default: return "Status";
+	}
+}
+
+/*
+ * SFTestServer
+ */
+SFTestServer::SFTestServer(QObject *parent) : QTcpServer(parent), mHoldResponses(false) {
+}
+
+SFTestServer::~SFTestServer() {
+}
+
+bool SFTestServer::start() {
+	return this->listen(QHostAddress::LocalHost, 0);
+}
+
+QUrl SFTestServer::url(const QString & path) const {
+	return QUrl(this->baseUrl() + path);
+}
+
+QString SFTestServer::baseUrl() const {
+	return QString("http://127.0.0.1:%1").arg(this->serverPort());
+}
+
+void SFTestServer::setResponse(const QByteArray & method, const QByteArray & pathPrefix, const Response & response) {
+	for (int i = 0; i < mRoutes.size(); i++) {
+		if (mRoutes.at(i).method == method && mRoutes.at(i).pathPrefix == pathPrefix) {
+			mRoutes[i].response = response;
+			return;
+		}
+	}
+	Route route;
+	route.method = method;
+	route.pathPrefix = pathPrefix;
+	route.response = response;
+	mRoutes.append(route);
+}
+
+void SFTestServer::setResponse(const QByteArray & method, const QByteArray & pathPrefix, int status, const QByteArray & body) {
+	Response response;
+	response.status = status;
+	response.body = body;
+	this->setResponse(method, pathPrefix, response);
+}
+
+void SFTestServer::queueResponse(const QByteArray & method, const QByteArray & pathPrefix, const Response & response) {
+	Route route;
+	route.method = method;
+	route.pathPrefix = pathPrefix;
+	route.response = response;
+	mQueuedRoutes.append(route);
+}
+
+QList<SFTestServer::Request> SFTestServer::requests(const QByteArray & method, const QByteArray & pathPrefix) const {
+	QList<Request> matching;
+	for (int i = 0; i < mRequests.size(); i++) {
+		if (mRequests.at(i).method == method && mRequests.at(i).path.startsWith(pathPrefix)) {
+			matching.append(mRequests.at(i));
+		}
+	}
+	return matching;
+}
+
+void SFTestServer::releaseResponses() {
+	QList<HeldResponse> held = mHeldResponses;
+	mHeldResponses.clear();
+	for (int i = 0; i < held.size(); i++) {
+		if (held.at(i).socket) {
+			this->reply(held.at(i).socket, held.at(i).response);
+		}
+	}
+}
+
+void SFTestServer::incomingConnection(int socketDescriptor) {
+	QTcpSocket *socket = new QTcpSocket(this);
+	if (!socket->setSocketDescriptor(socketDescriptor)) {
+		delete socket;
+		return;
+	}
+	mBuffers.insert(socket, QByteArray());
+	connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+	connect(socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+}
+
+void SFTestServer::onReadyRead() {
+	QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+	if (!socket || !mBuffers.contains(socket)) {
+		return;
+	}
+	QByteArray & buffer = mBuffers[socket];
+	buffer.append(socket->readAll());
+	//the client may send the next request on the same connection right away
+	Request request;
+	while (this->takeRequest(buffer, &request)) {
+		mRequests.append(request);
+		if (mHoldResponses) {
+			HeldResponse held;
+			held.socket = socket;
+			held.response = this->responseFor(request);
+			mHeldResponses.append(held);
+		} else {
+			this->reply(socket, this->responseFor(request));
+		}
+		emit requestReceived();
+	}
+}
+
+void SFTestServer::onDisconnected() {
+	QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+	if (socket) {
+		mBuffers.remove(socket);
+		socket->deleteLater();
+		emit connectionClosed();
+	}
+}
+
+bool SFTestServer::takeRequest(QByteArray & buffer, Request * pOutRequest) {
+	int headerEnd = buffer.indexOf(kSFHeaderEnd);
+	if (headerEnd < 0) {
+		return false;
+	}
+	QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+	QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+	if (requestLine.size() < 2) {
+		return false;
+	}
+	Request request;
+	request.method = requestLine.at(0);
+	request.path = requestLine.at(1);
+	for (int i = 1; i < lines.size(); i++) {
+		int colon = lines.at(i).indexOf(':');
+		if (colon > 0) {
+			request.headers.insert(lines.at(i).left(colon).trimmed().toLower(), lines.at(i).mid(colon + 1).trimmed());
+		}
+	}
+
+	int bodyStart = headerEnd + kSFHeaderEnd.size();
+	int consumed = 0;
+	if (request.headers.value("transfer-encoding").toLower() == "chunked") {
+		int position = bodyStart;
+		forever {
+			int lineEnd = buffer.indexOf("\r\n", position);
+			if (lineEnd < 0) {
+				return false;
+			}
+			bool ok = false;
+			int size = buffer.mid(position, lineEnd - position).split(';').first().trimmed().toInt(&ok, 16);
+			if (!ok) {
+				return false;
+			}
+			if (buffer.size() < lineEnd + 2 + size + 2) {
+				return false;
+			}
+			request.body.append(buffer.mid(lineEnd + 2, size));
+			position = lineEnd + 2 + size + 2;
+			if (size == 0) {
+				break;
+			}
+		}
+		consumed = position;
+	} else {
+		int length = request.headers.value("content-length", "0").toInt();
+		if (buffer.size() < bodyStart + length) {
+			return false;
+		}
+		request.body = buffer.mid(bodyStart, length);
+		consumed = bodyStart + length;
+	}
+	buffer.remove(0, consumed);
+	*pOutRequest = request;
+	return true;
+}
+
+SFTestServer::Response SFTestServer::responseFor(const Request & request) {
+	for (int i = 0; i < mQueuedRoutes.size(); i++) {
+		if (mQueuedRoutes.at(i).method == request.method && request.path.startsWith(mQueuedRoutes.at(i).pathPrefix)) {
+			return mQueuedRoutes.takeAt(i).response;
+		}
+	}
+	int best = -1;
+	for (int i = 0; i < mRoutes.size(); i++) {
+		const Route & route = mRoutes.at(i);
+		if (route.method == request.method && request.path.startsWith(route.pathPrefix)
+				&& (best < 0 || route.pathPrefix.size() > mRoutes.at(best).pathPrefix.size())) {
+			best = i;
+		}
+	}
+	if (best >= 0) {
+		return mRoutes.at(best).response;
+	}
+	Response notFound;
+	notFound.status = 404;
+	notFound.body = "[{\"errorCode\":\"NOT_FOUND\",\"message\":\"The requested resource does not exist\"}]";
+	return notFound;
+}
+
+void SFTestServer::reply(QTcpSocket *socket, const Response & response) {
+	QByteArray head;
+	head.append("HTTP/1.1 ").append(QByteArray::number(response.status)).append(' ').append(reasonPhrase(response.status)).append("\r\n");
+	if (response.status != 204 && response.status != 304) {
+		head.append("Content-Type: ").append(response.contentType).append("\r\n");
+		head.append("Content-Length: ").append(QByteArray::number(response.declaredLength < 0 ? response.body.size() : response.declaredLength)).append("\r\n");
+	}
+	for (int i = 0; i < response.headers.size(); i++) {
+		head.append(response.headers.at(i).first).append(": ").append(response.headers.at(i).second).append("\r\n");
+	}
+	head.append("\r\n");
+	socket->write(head);
+	if (response.status != 204 && response.status != 304) {
+		socket->write(response.body);
+	}
+}
+
+/*
+ * SFTestResultReceiver
+ */
+SFTestResultReceiver::SFTestResultReceiver() {
+	this->reset();
+}
+
+void SFTestResultReceiver::reset() {
+	received = false;
+	hasError = false;
+	code = 0;
+	message = QString();
+	payload = QVariant();
+	tags.clear();
+}
+
+void SFTestResultReceiver::onResult(sf::SFResult *result) {
+	received = true;
+	hasError = result->hasError();
+	code = result->code();
+	message = result->message();
+	tags = result->tags();
+	QNetworkReply *reply = qobject_cast<QNetworkReply*>(result->payload().value<QObject*>());
+	payload = reply ? QVariant(reply->readAll()) : result->payload();
+	emit resultReceived();
+}
+
+bool sfTestWait(QObject *sender, const char *signal, int timeout) {
+	QEventLoop loop;
+	QTimer timer;
+	timer.setSingleShot(true);
+	QObject::connect(sender, signal, &loop, SLOT(quit()));
+	QObject::connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+	timer.start(timeout);
+	loop.exec();
+	return timer.isActive();
+}
+
+} /* namespace sf */
@@ -0,0 +1,146 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFTestServer.h
+*/
+
+
+#ifndef SFTESTSERVER_H_
+#define SFTESTSERVER_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QTcpServer>
+#include <QUrl>
+#include <QVariant>
+
+class QTcpSocket;
+
+namespace sf {
+
+class SFResult;
+
+/*
+ * A stand-in HTTP/1.1 server on the loopback interface, with canned responses. It runs in the thread that creates it,
+ * which has to spin its event loop while the SDK talks to it, see sfTestWait().
+ */
+class SFTestServer : public QTcpServer {
+	Q_OBJECT
+public:
+	struct Request {
+		QByteArray method;
+		QByteArray path; //with the query string
+		QHash<QByteArray, QByteArray> headers; //names in lower case
+		QByteArray body;
+	};
+	struct Response {
+		int status;
+		QByteArray contentType;
+		QByteArray body;
+		QList<QPair<QByteArray, QByteArray> > headers;
+		int declaredLength; //the "Content-Length" sent when it isn't -1, a larger one leaves the response unfinished
+		Response() : status(200), contentType("application/json;charset=UTF-8"), declaredLength(-1) {}
+	};
+
+	explicit SFTestServer(QObject *parent = NULL);
+	virtual ~SFTestServer();
+
+	/* listen on a free port of 127.0.0.1 */
+	bool start();
+	/* @return the URL of a path on the server, e.g. "http://127.0.0.1:41235/services/data" */
+	QUrl url(const QString & path = QString()) const;
+	/* @return the URL of the server without path, e.g. "http://127.0.0.1:41235" */
+	QString baseUrl() const;
+
+	/* answer the requests whose method matches and whose path starts with @a pathPrefix. The longest prefix wins, others get a 404 */
+	void setResponse(const QByteArray & method, const QByteArray & pathPrefix, const Response & response);
+	void setResponse(const QByteArray & method, const QByteArray & pathPrefix, int status, const QByteArray & body);
+	/* answer the next matching request only, before the response set with setResponse() */
+	void queueResponse(const QByteArray & method, const QByteArray & pathPrefix, const Response & response);
+
+	const QList<Request> & requests() const { return mRequests; };
+	/* @return the requests whose method matches and whose path starts with @a pathPrefix */
+	QList<Request> requests(const QByteArray & method, const QByteArray & pathPrefix) const;
+	void clearRequests() { mRequests.clear(); };
+	/* record requests without answering them until releaseResponses() is called, e.g. to count the requests in flight */
+	void setHoldResponses(bool hold) { mHoldResponses = hold; };
+	/* answer the requests held so far */
+	void releaseResponses();
+
+signals:
+	void requestReceived();
+	void connectionClosed();
+
+protected:
+	void incomingConnection(int socketDescriptor);
+
+private slots:
+	void onReadyRead();
+	void onDisconnected();
+
+private:
+	struct Route {
+		QByteArray method;
+		QByteArray pathPrefix;
+		Response response;
+	};
+	struct HeldResponse {
+		QPointer<QTcpSocket> socket;
+		Response response;
+	};
+	QList<Route> mRoutes;
+	QList<Route> mQueuedRoutes;
+	QList<Request> mRequests;
+	QHash<QTcpSocket*, QByteArray> mBuffers;
+	bool mHoldResponses;
+	QList<HeldResponse> mHeldResponses;
+
+	bool takeRequest(QByteArray & buffer, Request * pOutRequest);
+	Response responseFor(const Request & request);
+	void reply(QTcpSocket *socket, const Response & response);
+};
+
+/*
+ * Collects the result of a task, which is deleted as soon as the result is delivered.
+ */
+class SFTestResultReceiver : public QObject {
+	Q_OBJECT
+public:
+	SFTestResultReceiver();
+	void reset();
+
+	bool received;
+	bool hasError;
+	int code;
+	QString message;
+	QVariant payload; //a network reply is replaced by its body
+	QVariantHash tags;
+
+signals:
+	void resultReceived();
+
+public slots:
+	void onResult(sf::SFResult *result);
+};
+
+/* spin the event loop until @a signal of @a sender is emitted, or the timeout expires. @return false on timeout */
+bool sfTestWait(QObject *sender, const char *signal, int timeout = 10000);
+
+} /* namespace sf */
+#endif /* SFTESTSERVER_H_ */
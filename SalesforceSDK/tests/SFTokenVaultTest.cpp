@@ -0,0 +1,175 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFTokenVaultTest.cpp
+*/
+
+
+#include "SFTokenVaultTest.h"
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <QThread>
+#include <QtTest/QtTest>
+#include "SFSecurityManager.h"
+#include "SFTokenVault.h"
+
+namespace sf {
+
+static const QString kSFTestKey = "sf_test_access_token";
+static const QString kSFTestOtherKey = "sf_test_refresh_token";
+static const QString kSFTestToken = "00Dx0000000BV7z!AR8AQBM8J_xr9kLqmZIRyQxZgLcM4HVi41aGtW0qW3JCzf5xdTGGGSoVim8FfJkZEqxbjaFbberKGk8v8AnYrvChG4qJbQo8";
+static const int kSFTestWrites = 200;
+
+static QString vaultPath() {
+	return QDir::home().absoluteFilePath("sf_token_store/sf_token_vault");
+}
+
+/* reads a token in a loop until stopped, every value must be one the writer stored */
+class SFTestTokenReader : public QThread {
+public:
+	SFTestTokenReader() : reads(0), badReads(0), mStop(0) {}
+	void stop() { mStop.fetchAndStoreOrdered(1); }
+	int reads;
+	int badReads;
+protected:
+	void run() {
+		SFTokenVault *vault = SFTokenVault::instance();
+		while (!mStop.fetchAndAddOrdered(0)) {
+			QString token = vault->token(kSFTestKey);
+			if (!token.isNull() && !token.startsWith("token ")) {
+				badReads++;
+			}
+			reads++;
+		}
+	}
+private:
+	QAtomicInt mStop;
+};
+
+void SFTokenVaultTest::cleanup() {
+	SFTokenVault::instance()->removeTokens(QStringList() << kSFTestKey << kSFTestOtherKey);
+}
+
+void SFTokenVaultTest::setAndRemove() {
+	SFTokenVault *vault = SFTokenVault::instance();
+	int generation = vault->generation();
+	QVERIFY(vault->setToken(kSFTestKey, kSFTestToken));
+	QVERIFY(vault->setToken(kSFTestOtherKey, "refresh"));
+	QCOMPARE(vault->token(kSFTestKey), kSFTestToken);
+	QVERIFY(vault->generation() != generation);
+	QVERIFY(vault->setToken(kSFTestOtherKey, QString()));
+	QVERIFY(vault->token(kSFTestOtherKey).isNull());
+	QVERIFY(vault->removeTokens(QStringList() << kSFTestKey));
+	QVERIFY(vault->token(kSFTestKey).isNull());
+}
+
+void SFTokenVaultTest::reloadFromDisk() {
+	SFTokenVault *vault = SFTokenVault::instance();
+	QVERIFY(vault->setToken(kSFTestKey, kSFTestToken));
+	//the vault is sealed, the token is not in clear text
+	QFile file(vaultPath());
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QByteArray content = file.readAll();
+	file.close();
+	QVERIFY(SFSecurityManager::isEnvelope(content));
+	QVERIFY(!content.contains(kSFTestToken.toUtf8()));
+	QVERIFY(!QFile::exists(vaultPath() + ".tmp"));
+	QVERIFY(!QFile::exists(vaultPath() + ".bak"));
+
+	vault->invalidate();
+	QCOMPARE(vault->token(kSFTestKey), kSFTestToken);
+}
+
+/* a write stopped after the current vault was moved aside, before the new one replaced it */
+void SFTokenVaultTest::interruptedWrite() {
+	SFTokenVault *vault = SFTokenVault::instance();
+	QVERIFY(vault->setToken(kSFTestKey, kSFTestToken));
+	QVERIFY(QFile::rename(vaultPath(), vaultPath() + ".bak"));
+	vault->invalidate();
+	QCOMPARE(vault->token(kSFTestKey), kSFTestToken);
+	QVERIFY(QFile::exists(vaultPath()));
+	QVERIFY(!QFile::exists(vaultPath() + ".bak"));
+}
+
+/* replaced snapshots stay valid for the readers that still hold them */
+void SFTokenVaultTest::concurrentReaders() {
+	SFTokenVault *vault = SFTokenVault::instance();
+	QList<SFTestTokenReader*> readers;
+	for (int i = 0; i < 4; i++) {
+		readers.append(new SFTestTokenReader());
+		readers.last()->start();
+	}
+	bool written = true;
+	for (int i = 0; i < kSFTestWrites && written; i++) {
+		written = vault->setToken(kSFTestKey, QString("token %1").arg(i));
+		if (i % 50 == 0) {
+			vault->invalidate();
+		}
+	}
+	int reads = 0;
+	int badReads = 0;
+	for (int i = 0; i < readers.size(); i++) {
+		readers.at(i)->stop();
+		readers.at(i)->wait();
+		reads += readers.at(i)->reads;
+		badReads += readers.at(i)->badReads;
+	}
+	qDeleteAll(readers);
+	QVERIFY(written);
+	QVERIFY(reads > 0);
+	QCOMPARE(badReads, 0);
+	QCOMPARE(vault->token(kSFTestKey), QString("token %1").arg(kSFTestWrites - 1));
+}
+
+void SFTokenVaultTest::tokenRead_data() {
+	QTest::addColumn<bool>("cached");
+	QTest::newRow("file read and decryption") << false;
+	QTest::newRow("SFTokenVault") << true;
+}
+
+/*
+ * One access token read, what every REST request does. It used to open the token file, read the hex text and decrypt it,
+ * the vault looks it up in memory.
+ */
+void SFTokenVaultTest::tokenRead() {
+	QFETCH(bool, cached);
+	SFTokenVault *vault = SFTokenVault::instance();
+	QString token;
+	if (cached) {
+		QVERIFY(vault->setToken(kSFTestKey, kSFTestToken));
+		QBENCHMARK {
+			token = vault->token(kSFTestKey);
+		}
+	} else {
+		//outside sf_token_store, where the vault would import it
+		QTemporaryFile legacyFile;
+		QVERIFY(legacyFile.open());
+		legacyFile.write(SFSecurityManager::instance()->encrypt(kSFTestToken).toLatin1());
+		legacyFile.close();
+		QBENCHMARK {
+			QFile tokenFile(legacyFile.fileName());
+			tokenFile.open(QIODevice::ReadOnly | QIODevice::Text);
+			QTextStream in(&tokenFile);
+			QString encryptedToken = in.readAll();
+			tokenFile.close();
+			token = SFSecurityManager::instance()->decrypt(encryptedToken);
+		}
+	}
+	QCOMPARE(token, kSFTestToken);
+}
+
+} /* namespace sf */
@@ -0,0 +1,46 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* SFTokenVaultTest.h
+*/
+
+
+#ifndef SFTOKENVAULTTEST_H_
+#define SFTOKENVAULTTEST_H_
+
+#include <QObject>
+
+namespace sf {
+
+/*
+ * The token vault: writes through to disk, survives an interrupted write, serves readers while tokens change, and the cost
+ * of a token read compared with the file read and decryption every read used to take.
+ */
+class SFTokenVaultTest : public QObject {
+	Q_OBJECT
+private slots:
+	void cleanup();
+
+	void setAndRemove();
+	void reloadFromDisk();
+	void interruptedWrite();
+	void concurrentReaders();
+
+	void tokenRead_data();
+	void tokenRead();
+};
+
+} /* namespace sf */
+#endif /* SFTOKENVAULTTEST_H_ */
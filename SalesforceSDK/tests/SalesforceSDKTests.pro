@@ -0,0 +1,96 @@
+# Unit tests and benchmarks of the SDK, linked against the debug build of the library.
+# Built with "make Simulator-Tests" or "make Device-Tests" from the SDK directory, see its Makefile.
+
+TEMPLATE = app
+TARGET = SalesforceSDKTests
+
+CONFIG += qt warn_on qtestlib console
+CONFIG -= app_bundle
+
+QT += network declarative
+QT -= gui
+
+SDKDIR = $$PWD/..
+
+INCLUDEPATH += $$quote($${SDKDIR}/include) \
+	$$quote($${SDKDIR}/include/core) \
+	$$quote($${SDKDIR}/include/oauth) \
+	$$quote($${SDKDIR}/include/encryption) \
+	$$quote($${SDKDIR}/include/rest)
+
+LIBS += -lbbcascades
+LIBS += -lbb
+LIBS += -lbbdata
+LIBS += -lbbdevice
+LIBS += -lbbplatform
+LIBS += -lhuapi
+LIBS += -lbbsystem
+LIBS += -lscreen
+
+QMAKE_CXXFLAGS += -Wno-psabi
+
+# the debug build of the library keeps all its symbols visible, which the tests of internal classes need
+device {
+	LIBS += -L$${SDKDIR}/arm/so.le-v7-g -lSalesforceSDK
+	PRE_TARGETDEPS += $$quote($${SDKDIR}/arm/so.le-v7-g/libSalesforceSDK.so)
+}
+simulator {
+	LIBS += -L$${SDKDIR}/x86/so-g -lSalesforceSDK
+	PRE_TARGETDEPS += $$quote($${SDKDIR}/x86/so-g/libSalesforceSDK.so)
+}
+
+HEADERS += SFTestData.h \
+	SFTestServer.h \
+	SFCryptoBackendTest.h \
+	SFNetworkAccessTaskTest.h \
+	SFRestAPITest.h \
+	SFBulkIngestJobTest.h \
+	SFSecurityManagerTest.h \
+	SFStreamCipherTest.h \
+	SFCodecTest.h \
+	SFJsonStreamParserTest.h \
+	SFJsonIndexParserTest.h \
+	SFStringPoolTest.h \
+	SFBodyEncoderTest.h \
+	SFCsvStreamParserTest.h \
+	SFBulkQueryJobTest.h \
+	SFTokenVaultTest.h \
+	SFRecordBatchTest.h \
+	SFRecordDecoderTest.h \
+	SFRequestSchedulerTest.h \
+	SFDescribeCacheTest.h \
+	SFQueryCursorTest.h \
+	SFJsonViewTest.h \
+	SFRequestTemplateTest.h \
+	SFCompositeRequestTest.h \
+	SFCollectionTaskTest.h
+
+SOURCES += main.cpp \
+	SFTestData.cpp \
+	SFTestServer.cpp \
+	SFCryptoBackendTest.cpp \
+	SFNetworkAccessTaskTest.cpp \
+	SFRestAPITest.cpp \
+	SFBulkIngestJobTest.cpp \
+	SFSecurityManagerTest.cpp \
+	SFStreamCipherTest.cpp \
+	SFCodecTest.cpp \
+	SFJsonStreamParserTest.cpp \
+	SFJsonIndexParserTest.cpp \
+	SFStringPoolTest.cpp \
+	SFBodyEncoderTest.cpp \
+	SFCsvStreamParserTest.cpp \
+	SFBulkQueryJobTest.cpp \
+	SFTokenVaultTest.cpp \
+	SFRecordBatchTest.cpp \
+	SFRecordDecoderTest.cpp \
+	SFRequestSchedulerTest.cpp \
+	SFDescribeCacheTest.cpp \
+	SFQueryCursorTest.cpp \
+	SFJsonViewTest.cpp \
+	SFRequestTemplateTest.cpp \
+	SFCompositeRequestTest.cpp \
+	SFCollectionTaskTest.cpp
+
+OBJECTS_DIR = .obj
+MOC_DIR = .moc
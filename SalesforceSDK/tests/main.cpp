@@ -0,0 +1,103 @@
+/*
+* Copyright 2013 BlackBerry Limited.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* main.cpp
+*/
+
+
+#include <QCoreApplication>
+#include <QtTest/QtTest>
+#include "SFCryptoBackendTest.h"
+#include "SFNetworkAccessTaskTest.h"
+#include "SFRestAPITest.h"
+#include "SFBulkIngestJobTest.h"
+
+#include "SFSecurityManagerTest.h"
+#include "SFStreamCipherTest.h"
+#include "SFCodecTest.h"
+#include "SFJsonStreamParserTest.h"
+#include "SFJsonIndexParserTest.h"
+#include "SFStringPoolTest.h"
+#include "SFBodyEncoderTest.h"
+#include "SFCsvStreamParserTest.h"
+#include "SFBulkQueryJobTest.h"
+#include "SFTokenVaultTest.h"
+#include "SFRecordBatchTest.h"
+#include "SFRecordDecoderTest.h"
+#include "SFRequestSchedulerTest.h"
+#include "SFDescribeCacheTest.h"
+#include "SFQueryCursorTest.h"
+#include "SFJsonViewTest.h"
+#include "SFRequestTemplateTest.h"
+#include "SFCompositeRequestTest.h"
+#include "SFCollectionTaskTest.h"
+/*
+ * Runs every test class in turn, with the usual QTest arguments, e.g. "-silent" or "-iterations 10".
+ * The exit code is the number of failed tests.
+ */
+int main(int argc, char *argv[]) {
+	QCoreApplication app(argc, argv);
+	app.setOrganizationName("SalesforceSDKTests");
+	app.setApplicationName("SalesforceSDKTests");
+
+	int failures = 0;
+	sf::SFCryptoBackendTest cryptoBackendTest;
+	failures += QTest::qExec(&cryptoBackendTest, argc, argv);
+	sf::SFNetworkAccessTaskTest networkAccessTaskTest;
+	failures += QTest::qExec(&networkAccessTaskTest, argc, argv);
+	sf::SFRestAPITest restAPITest;
+	failures += QTest::qExec(&restAPITest, argc, argv);
+	sf::SFBulkIngestJobTest bulkIngestJobTest;
+	failures += QTest::qExec(&bulkIngestJobTest, argc, argv);
+	sf::SFSecurityManagerTest securityManagerTest;
+	failures += QTest::qExec(&securityManagerTest, argc, argv);
+	sf::SFStreamCipherTest streamCipherTest;
+	failures += QTest::qExec(&streamCipherTest, argc, argv);
+	sf::SFCodecTest codecTest;
+	failures += QTest::qExec(&codecTest, argc, argv);
+	sf::SFJsonStreamParserTest jsonStreamParserTest;
+	failures += QTest::qExec(&jsonStreamParserTest, argc, argv);
+	sf::SFJsonIndexParserTest jsonIndexParserTest;
+	failures += QTest::qExec(&jsonIndexParserTest, argc, argv);
+	sf::SFStringPoolTest stringPoolTest;
+	failures += QTest::qExec(&stringPoolTest, argc, argv);
+	sf::SFBodyEncoderTest bodyEncoderTest;
+	failures += QTest::qExec(&bodyEncoderTest, argc, argv);
+	sf::SFCsvStreamParserTest csvStreamParserTest;
+	failures += QTest::qExec(&csvStreamParserTest, argc, argv);
+	sf::SFBulkQueryJobTest bulkQueryJobTest;
+	failures += QTest::qExec(&bulkQueryJobTest, argc, argv);
+	sf::SFTokenVaultTest tokenVaultTest;
+	failures += QTest::qExec(&tokenVaultTest, argc, argv);
+	sf::SFRecordBatchTest recordBatchTest;
+	failures += QTest::qExec(&recordBatchTest, argc, argv);
+	sf::SFRecordDecoderTest recordDecoderTest;
+	failures += QTest::qExec(&recordDecoderTest, argc, argv);
+	sf::SFRequestSchedulerTest requestSchedulerTest;
+	failures += QTest::qExec(&requestSchedulerTest, argc, argv);
+	sf::SFDescribeCacheTest describeCacheTest;
+	failures += QTest::qExec(&describeCacheTest, argc, argv);
+	sf::SFQueryCursorTest queryCursorTest;
+	failures += QTest::qExec(&queryCursorTest, argc, argv);
+	sf::SFJsonViewTest jsonViewTest;
+	failures += QTest::qExec(&jsonViewTest, argc, argv);
+	sf::SFRequestTemplateTest requestTemplateTest;
+	failures += QTest::qExec(&requestTemplateTest, argc, argv);
+	sf::SFCompositeRequestTest compositeRequestTest;
+	failures += QTest::qExec(&compositeRequestTest, argc, argv);
+	sf::SFCollectionTaskTest collectionTaskTest;
+	failures += QTest::qExec(&collectionTaskTest, argc, argv);
+	return failures;
+}